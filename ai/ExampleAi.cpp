@@ -0,0 +1,67 @@
+#include "PongAi.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+// Example AI plugin: follows the ball's path through its wall bounces like the IMPOSSIBLE AI, but recomputes it on
+// every tick. PONG_AI_EXAMPLE_WORK_US adds that much busy work per tick, to stand in for a heavier AI when trying
+// out budgets. Build with `make libpongai_example.so` and run `./output --ai ./libpongai_example.so`.
+
+namespace
+{
+	struct ExampleAi
+	{
+		std::chrono::microseconds work;
+	};
+
+	void* Create()
+	{
+		const char* work_us = std::getenv("PONG_AI_EXAMPLE_WORK_US");
+		return new ExampleAi{ std::chrono::microseconds(work_us != nullptr ? std::atoi(work_us) : 0) };
+	}
+
+	void Destroy(void* state)
+	{
+		delete static_cast<ExampleAi*>(state);
+	}
+
+	void Tick(void* state, const PongAiView* view, PongAiCommand* command)
+	{
+		const ExampleAi* ai = static_cast<const ExampleAi*>(state);
+		const std::chrono::steady_clock::time_point work_end = std::chrono::steady_clock::now() + ai->work;
+
+		while (std::chrono::steady_clock::now() < work_end)
+		{
+		}
+
+		const float half_ball = view->ball_size / 2.0f;
+		const float paddle_face = view->paddle_x + view->paddle_width;
+		float target_y = view->field_height / 2.0f;
+
+		// Only worth following while the ball comes this way; otherwise wait in the middle.
+		if (view->ball_vx < 0.0f)
+		{
+			const float ticks = (view->ball_x - paddle_face) / -view->ball_vx;
+			const float span = view->field_height - view->ball_size;
+			const float travel = std::fmod(std::fabs(view->ball_y + view->ball_vy * ticks), 2.0f * span);
+
+			// Unfold the wall bounces: the ball's y moves back and forth across the span.
+			target_y = (travel > span ? 2.0f * span - travel : travel) + half_ball;
+		}
+
+		const float paddle_mid = view->paddle_y + view->paddle_height / 2.0f;
+		const float distance = target_y - paddle_mid;
+
+		command->paddle_vy = std::fabs(distance) < view->max_speed ? distance : std::copysign(view->max_speed, distance);
+		command->target_x = paddle_face;
+		command->target_y = target_y;
+	}
+
+	const PongAiController example_ai = { PONG_AI_ABI_VERSION, "example", &Create, &Destroy, &Tick };
+}
+
+extern "C" const PongAiController* pong_ai_controller(void)
+{
+	return &example_ai;
+}
@@ -0,0 +1,72 @@
+#include "AiBenchmark.hpp"
+#include "AiHost.hpp"
+#include "AiPlugin.hpp"
+#include "Simulation.hpp"
+#include "SimulationBenchmark.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+	constexpr std::uint64_t budget_ticks = 60 * 60;
+	constexpr std::uint64_t paced_ticks = 60 * 10;
+
+	// Isolated controllers are played at 60 Hz, so a late tick has the time to return that it would have in a match.
+	void PlayMatch(AiController& controller, GameDifficulty difficulty, int budget_us, bool isolated)
+	{
+		const std::uint64_t ticks = isolated ? paced_ticks : budget_ticks;
+		std::chrono::steady_clock::time_point next_tick = std::chrono::steady_clock::now();
+
+		Simulation simulation;
+		simulation.Reset(GameMode::SINGLE_PLAYER, difficulty, 11);
+
+		AiHost host;
+		host.Start(controller, budget_us, isolated);
+		simulation.ai_controller_ = &host;
+
+		for (std::uint64_t tick = 0; tick < ticks; ++tick)
+		{
+			if (isolated)
+			{
+				std::this_thread::sleep_until(next_tick);
+				next_tick += std::chrono::nanoseconds(1000000000 / 60);
+			}
+
+			SimulationBenchmark::ApplyScriptedInput(simulation, tick);
+			simulation.Tick();
+		}
+
+		host.Stop();
+		printf("%s: scripted player %d, AI %d\n", controller.GetName(), simulation.player1_score_, simulation.player2_score_);
+		host.PrintReport(stdout);
+	}
+}
+
+bool AiBenchmark::Budget(const char* plugin_path, int budget_us)
+{
+	const GameDifficulty difficulties[] = { GameDifficulty::MEDIUM, GameDifficulty::IMPOSSIBLE };
+
+	for (const GameDifficulty difficulty : difficulties)
+	{
+		PlayMatch(*GetBuiltinAiController(difficulty), difficulty, budget_us, false);
+	}
+
+	if (plugin_path == nullptr)
+	{
+		return true;
+	}
+
+	AiPlugin plugin;
+
+	if (!plugin.Open(plugin_path))
+	{
+		return false;
+	}
+
+	PlayMatch(plugin, GameDifficulty::IMPOSSIBLE, budget_us, true);
+
+	return true;
+}
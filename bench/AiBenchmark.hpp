@@ -0,0 +1,12 @@
+#ifndef AI_BENCHMARK_HPP
+#define AI_BENCHMARK_HPP
+
+class AiBenchmark
+{
+public:
+	// Plays a scripted minute against the built-in controllers and, with plugin_path set, ten seconds at 60 Hz
+	// against that plugin, each through an AiHost with budget_us. Prints the scores and each controller's report.
+	static bool Budget(const char* plugin_path, int budget_us);
+};
+
+#endif
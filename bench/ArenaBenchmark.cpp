@@ -0,0 +1,57 @@
+#include "ArenaBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "FrameArena.hpp"
+
+#include <memory_resource>
+#include <vector>
+
+namespace
+{
+	struct Segment
+	{
+		float x1;
+		float y1;
+		float x2;
+		float y2;
+	};
+
+	// About what one debug frame collects: a few trajectory segments and the divider rects.
+	constexpr int segments_per_frame = 24;
+}
+
+bool ArenaBenchmark::Run(Benchmark& benchmark)
+{
+	benchmark.Run("FrameScratch/heap", [&]()
+		{
+			std::vector<Segment> segments;
+
+			for (int i = 0; i < segments_per_frame; ++i)
+			{
+				segments.push_back({ float(i), float(i), float(i + 1), float(i + 1) });
+			}
+
+			DoNotOptimize(segments.data());
+		});
+
+	FrameArena arena(64 * 1024);
+
+	benchmark.Run("FrameScratch/arena", [&]()
+		{
+			arena.Reset();
+			std::pmr::vector<Segment> segments(&arena);
+
+			for (int i = 0; i < segments_per_frame; ++i)
+			{
+				segments.push_back({ float(i), float(i), float(i + 1), float(i + 1) });
+			}
+
+			DoNotOptimize(segments.data());
+		});
+
+	if (arena.GetHighWaterMark() != 0)
+	{
+		arena.PrintReport(stdout, "FrameScratch/arena");
+	}
+
+	return true;
+}
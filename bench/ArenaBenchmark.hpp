@@ -0,0 +1,12 @@
+#ifndef ARENA_BENCHMARK_HPP
+#define ARENA_BENCHMARK_HPP
+
+class Benchmark;
+
+class ArenaBenchmark
+{
+public:
+	static bool Run(Benchmark& benchmark);
+};
+
+#endif
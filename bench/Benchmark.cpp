@@ -0,0 +1,145 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+namespace
+{
+	// Each timed sample runs the benchmarked call in a batch long enough to drown out the clock overhead.
+	constexpr std::chrono::nanoseconds min_sample_duration(20000);
+	constexpr std::size_t max_batch = std::size_t(1) << 20;
+	constexpr std::size_t cold_calls = 16;
+
+	double Percentile(const std::vector<double>& sorted, double percentile)
+	{
+		const double rank = percentile * static_cast<double>(sorted.size() - 1);
+		const std::size_t lower = static_cast<std::size_t>(std::floor(rank));
+		const std::size_t upper = std::min(lower + 1, sorted.size() - 1);
+		const double fraction = rank - static_cast<double>(lower);
+
+		return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+	}
+}
+
+Benchmark::Benchmark(std::size_t warmup_samples, std::size_t samples, const std::string& filter) : 
+	warmup_samples_(warmup_samples), 
+	samples_(std::max<std::size_t>(samples, 1)), 
+	filter_(filter)
+{
+}
+
+std::size_t Benchmark::CalibrateBatch(void (*call)(void*), void* context) const
+{
+	// Touch the code and data once so a cold first call does not settle the batch size at one.
+	for (std::size_t i = 0; i < cold_calls; ++i)
+	{
+		call(context);
+	}
+
+	std::size_t batch = 1;
+
+	while (batch < max_batch)
+	{
+		const Clock::time_point start = Clock::now();
+
+		for (std::size_t i = 0; i < batch; ++i)
+		{
+			call(context);
+		}
+
+		if (Clock::now() - start >= min_sample_duration)
+		{
+			break;
+		}
+
+		batch *= 2;
+	}
+
+	return batch;
+}
+
+void Benchmark::Measure(const std::string& name, void (*call)(void*), void* context)
+{
+	const std::size_t batch = CalibrateBatch(call, context);
+
+	for (std::size_t sample = 0; sample < warmup_samples_; ++sample)
+	{
+		for (std::size_t i = 0; i < batch; ++i)
+		{
+			call(context);
+		}
+	}
+
+	std::vector<double> sample_ns(samples_);
+
+	for (std::size_t sample = 0; sample < samples_; ++sample)
+	{
+		const Clock::time_point start = Clock::now();
+
+		for (std::size_t i = 0; i < batch; ++i)
+		{
+			call(context);
+		}
+
+		const Clock::time_point end = Clock::now();
+		sample_ns[sample] = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(batch);
+	}
+
+	std::sort(sample_ns.begin(), sample_ns.end());
+
+	BenchmarkResult result;
+	result.name = name;
+	result.samples = samples_;
+	result.batch = batch;
+	result.min_ns = sample_ns.front();
+	result.median_ns = Percentile(sample_ns, 0.5);
+	result.p99_ns = Percentile(sample_ns, 0.99);
+	result.mean_ns = std::accumulate(sample_ns.begin(), sample_ns.end(), 0.0) / static_cast<double>(sample_ns.size());
+
+	PrintRow(result);
+	results_.push_back(result);
+}
+
+const std::vector<BenchmarkResult>& Benchmark::GetResults() const
+{
+	return results_;
+}
+
+void Benchmark::PrintHeader()
+{
+	printf("%-48s %12s %12s %12s %12s\n", "benchmark", "min ns", "median ns", "p99 ns", "mean ns");
+}
+
+void Benchmark::PrintRow(const BenchmarkResult& result)
+{
+	printf("%-48s %12.2f %12.2f %12.2f %12.2f\n", result.name.c_str(), result.min_ns, result.median_ns, result.p99_ns, result.mean_ns);
+	fflush(stdout);
+}
+
+bool Benchmark::WriteJson(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+
+	if (file == nullptr)
+	{
+		printf("Unable to open %s for writing!\n", path);
+		return false;
+	}
+
+	fprintf(file, "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n");
+
+	for (std::size_t i = 0; i < results_.size(); ++i)
+	{
+		const BenchmarkResult& result = results_[i];
+
+		fprintf(file, "    { \"name\": \"%s\", \"samples\": %zu, \"batch\": %zu, \"min\": %.3f, \"median\": %.3f, \"p99\": %.3f, \"mean\": %.3f }%s\n", 
+			result.name.c_str(), result.samples, result.batch, result.min_ns, result.median_ns, result.p99_ns, result.mean_ns, i + 1 < results_.size() ? "," : "");
+	}
+
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+
+	return true;
+}
@@ -0,0 +1,68 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void ClobberMemory()
+{
+	asm volatile("" : : : "memory");
+}
+
+struct BenchmarkResult
+{
+	std::string name;
+	std::size_t samples;
+	std::size_t batch;
+	double min_ns;
+	double median_ns;
+	double p99_ns;
+	double mean_ns;
+};
+
+class Benchmark
+{
+private:
+	using Clock = std::chrono::steady_clock;
+
+	std::size_t warmup_samples_;
+	std::size_t samples_;
+	std::string filter_;
+	std::vector<BenchmarkResult> results_;
+
+	std::size_t CalibrateBatch(void (*call)(void*), void* context) const;
+
+	void Measure(const std::string& name, void (*call)(void*), void* context);
+
+public:
+	Benchmark(std::size_t warmup_samples, std::size_t samples, const std::string& filter = "");
+
+	template <typename F>
+	void Run(const std::string& name, F&& f)
+	{
+		if (!filter_.empty() && name.find(filter_) == std::string::npos)
+		{
+			return;
+		}
+
+		Measure(name, [](void* context) { (*static_cast<F*>(context))(); }, &f);
+	}
+
+	const std::vector<BenchmarkResult>& GetResults() const;
+
+	static void PrintHeader();
+
+	static void PrintRow(const BenchmarkResult& result);
+
+	bool WriteJson(const char* path) const;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "ChecksumBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "Simulation.hpp"
+#include "SimulationBenchmark.hpp"
+#include "StateChecksums.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	constexpr std::uint64_t match_ticks = 60 * 60 * 5;
+
+	// The smallest change a value can take.
+	void Nudge(Scalar& value)
+	{
+#if PONG_FIXED_POINT
+		++value.raw_;
+#else
+		value = std::nextafter(value, std::numeric_limits<float>::infinity());
+#endif
+	}
+}
+
+bool ChecksumBenchmark::Run(Benchmark& benchmark)
+{
+	Simulation simulation;
+	simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 3);
+
+	for (std::uint64_t tick = 0; tick < 600; ++tick)
+	{
+		SimulationBenchmark::ApplyScriptedInput(simulation, tick);
+		simulation.Tick();
+	}
+
+	const std::uint64_t hash = simulation.GetStateHash();
+
+	const std::vector<std::pair<const char*, std::function<void(Simulation&)>>> changes =
+	{
+		{ "tick_count_", [](Simulation& s) { ++s.tick_count_; } },
+		{ "ball_.rect_.x", [](Simulation& s) { Nudge(s.ball_.rect_.x); } },
+		{ "ball_.rect_.y", [](Simulation& s) { Nudge(s.ball_.rect_.y); } },
+		{ "ball_.rect_.w", [](Simulation& s) { Nudge(s.ball_.rect_.w); } },
+		{ "ball_.vx_", [](Simulation& s) { Nudge(s.ball_.vx_); } },
+		{ "ball_.vy_", [](Simulation& s) { Nudge(s.ball_.vy_); } },
+		{ "player1_paddle_.rect_.y", [](Simulation& s) { Nudge(s.player1_paddle_.rect_.y); } },
+		{ "player2_paddle_.rect_.h", [](Simulation& s) { Nudge(s.player2_paddle_.rect_.h); } },
+		{ "player2_paddle_.vy_", [](Simulation& s) { Nudge(s.player2_paddle_.vy_); } },
+		{ "intersection_point_.y", [](Simulation& s) { Nudge(s.intersection_point_.y); } },
+		{ "player1_score_", [](Simulation& s) { ++s.player1_score_; } },
+		{ "player2_score_", [](Simulation& s) { ++s.player2_score_; } },
+		{ "ball_resetting_", [](Simulation& s) { s.ball_resetting_ = !s.ball_resetting_; } },
+		{ "ball_reset_ticks_", [](Simulation& s) { ++s.ball_reset_ticks_; } },
+		{ "random_", [](Simulation& s) { s.random_.Next(); } },
+	};
+
+	for (const auto& change : changes)
+	{
+		Simulation changed = simulation;
+		change.second(changed);
+
+		if (changed.GetStateHash() == hash)
+		{
+			printf("Simulation::GetStateHash does not see a change of %s!\n", change.first);
+			return false;
+		}
+	}
+
+	benchmark.Run("Simulation::GetStateHash", [&]()
+		{
+			DoNotOptimize(simulation.GetStateHash());
+		});
+
+	StateChecksums checksums;
+	checksums.Start(simulation, 3);
+
+	benchmark.Run("StateChecksums::Record", [&]()
+		{
+			++simulation.tick_count_;
+			checksums.Record(simulation);
+		});
+
+	return true;
+}
+
+bool ChecksumBenchmark::Write(const char* path, std::uint64_t perturb_tick)
+{
+	Simulation simulation;
+	simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 3);
+
+	StateChecksums checksums;
+	checksums.Start(simulation, 3, match_ticks);
+
+	for (std::uint64_t tick = 0; tick < match_ticks; ++tick)
+	{
+		SimulationBenchmark::ApplyScriptedInput(simulation, tick);
+		simulation.Tick();
+
+		if (simulation.tick_count_ == perturb_tick)
+		{
+			Nudge(simulation.ball_.rect_.y);
+		}
+
+		checksums.Record(simulation);
+	}
+
+	return checksums.Save(path);
+}
@@ -0,0 +1,19 @@
+#ifndef CHECKSUM_BENCHMARK_HPP
+#define CHECKSUM_BENCHMARK_HPP
+
+#include <cstdint>
+
+class Benchmark;
+
+class ChecksumBenchmark
+{
+public:
+	// Checks that the state hash sees a one-bit change in every field it covers, then times hashing and recording.
+	static bool Run(Benchmark& benchmark);
+
+	// Saves the checksums of five minutes of a scripted match to path. With perturb_tick set, the ball is moved by the
+	// smallest step there is after that tick, so desync_check has a known divergence to find.
+	static bool Write(const char* path, std::uint64_t perturb_tick);
+};
+
+#endif
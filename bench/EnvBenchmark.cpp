@@ -0,0 +1,60 @@
+#include "EnvBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "PongEnv.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+bool EnvBenchmark::Run(Benchmark& benchmark)
+{
+	const int batch_sizes[] = { 1, 64, 1024 };
+
+	for (const int num_envs : batch_sizes)
+	{
+		std::vector<float> observations(static_cast<std::size_t>(num_envs) * PONG_ENV_OBSERVATION_SIZE);
+		std::vector<float> rewards(num_envs);
+		std::vector<std::uint8_t> dones(num_envs);
+		std::vector<std::int32_t> actions(num_envs);
+
+		PongEnv* env = pong_env_create(num_envs, PONG_ENV_DIFFICULTY_MEDIUM, 21, observations.data(), rewards.data(), dones.data());
+
+		if (env == nullptr)
+		{
+			printf("%s\n", "Unable to create the environment for benchmarking!");
+			return false;
+		}
+
+		pong_env_reset(env, 1);
+		std::uint64_t step = 0;
+
+		const std::string name = "pong_env_step/" + std::to_string(num_envs) + "_envs";
+		const std::size_t results = benchmark.GetResults().size();
+
+		benchmark.Run(name, [&]()
+			{
+				// A cheap deterministic policy: follow the ball, with a phase offset per env so they diverge.
+				for (int i = 0; i < num_envs; ++i)
+				{
+					const float* observation = &observations[static_cast<std::size_t>(i) * PONG_ENV_OBSERVATION_SIZE];
+					const bool wiggle = ((step + static_cast<std::uint64_t>(i)) % 7) == 0;
+					actions[i] = wiggle ? PONG_ENV_ACTION_STAY : (observation[1] < observation[4] ? PONG_ENV_ACTION_UP : PONG_ENV_ACTION_DOWN);
+				}
+
+				pong_env_step(env, actions.data());
+				++step;
+				DoNotOptimize(observations[0]);
+			});
+
+		if (benchmark.GetResults().size() > results)
+		{
+			const double steps_per_second = static_cast<double>(num_envs) * 1e9 / benchmark.GetResults().back().median_ns;
+			printf("%-48s %12.0f env-steps/sec per core\n", name.c_str(), steps_per_second);
+		}
+
+		pong_env_destroy(env);
+	}
+
+	return true;
+}
@@ -0,0 +1,12 @@
+#ifndef ENV_BENCHMARK_HPP
+#define ENV_BENCHMARK_HPP
+
+class Benchmark;
+
+class EnvBenchmark
+{
+public:
+	static bool Run(Benchmark& benchmark);
+};
+
+#endif
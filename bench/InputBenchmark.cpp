@@ -0,0 +1,342 @@
+#include "InputBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "Input.hpp"
+#include "Paddle.hpp"
+#include "Simulation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// An 8 kHz mouse moving through a 60 Hz frame, a key tapped with text input on and a click.
+	constexpr int motion_events = 8000 / 60;
+
+	std::vector<SDL_Event> MakeMouseHeavyFrame()
+	{
+		std::vector<SDL_Event> events;
+		SDL_Event e;
+
+		for (int i = 0; i < motion_events; ++i)
+		{
+			std::memset(&e, 0, sizeof(e));
+			e.type = SDL_MOUSEMOTION;
+			e.motion.x = 100 + i;
+			e.motion.y = 200 + (i / 2);
+			e.motion.xrel = 1;
+			events.push_back(e);
+
+			if (i == motion_events / 2)
+			{
+				std::memset(&e, 0, sizeof(e));
+				e.type = SDL_KEYDOWN;
+				e.key.keysym.scancode = SDL_GetScancodeFromKey(SDLK_SPACE);
+				e.key.keysym.sym = SDLK_SPACE;
+				events.push_back(e);
+
+				std::memset(&e, 0, sizeof(e));
+				e.type = SDL_TEXTINPUT;
+				events.push_back(e);
+
+				std::memset(&e, 0, sizeof(e));
+				e.type = SDL_KEYUP;
+				e.key.keysym.scancode = SDL_GetScancodeFromKey(SDLK_SPACE);
+				e.key.keysym.sym = SDLK_SPACE;
+				events.push_back(e);
+
+				std::memset(&e, 0, sizeof(e));
+				e.type = SDL_MOUSEBUTTONDOWN;
+				events.push_back(e);
+
+				e.type = SDL_MOUSEBUTTONUP;
+				events.push_back(e);
+			}
+		}
+
+		return events;
+	}
+
+	// What Game::HandleEvents does for a frame, with the filter standing in for SDL queueing the events.
+	void RunFrame(Input& input, const std::vector<SDL_Event>& events, InputFrame& frame)
+	{
+		input.BeginFrame(frame);
+
+		for (const SDL_Event& e : events)
+		{
+			if (input.Filter(e))
+			{
+				input.Dispatch(e, frame);
+			}
+		}
+
+		input.EndFrame(frame);
+	}
+
+	double GetMedianNs(const Benchmark& benchmark, const std::string& name)
+	{
+		for (const BenchmarkResult& result : benchmark.GetResults())
+		{
+			if (result.name == name)
+			{
+				return result.median_ns;
+			}
+		}
+
+		return 0.0;
+	}
+
+	constexpr double latency_seconds = 4.0;
+
+	// Shares no factor with a 60 Hz frame, so the keys land at every point of one.
+	constexpr int key_interval_ms = 23;
+
+	// The up arrow going down and up every key_interval_ms from start on, as the OS would queue it.
+	class ScriptedKeyboard
+	{
+	private:
+		std::uint64_t start_;
+		std::uint64_t interval_;
+		std::uint64_t keys_;
+		SDL_Event events_[2];
+
+	public:
+		explicit ScriptedKeyboard(std::uint64_t start) :
+			start_(start),
+			interval_(SDL_GetPerformanceFrequency() * key_interval_ms / 1000),
+			keys_(0)
+		{
+			std::memset(events_, 0, sizeof(events_));
+			events_[0].type = SDL_KEYDOWN;
+			events_[1].type = SDL_KEYUP;
+
+			for (SDL_Event& e : events_)
+			{
+				e.key.keysym.scancode = SDL_GetScancodeFromKey(SDLK_UP);
+				e.key.keysym.sym = SDLK_UP;
+			}
+		}
+
+		// Hands every key that went down or up by now to the event watch, as SDL_PumpEvents does.
+		void Pump(Input& input)
+		{
+			const std::uint64_t now = SDL_GetPerformanceCounter();
+
+			while (GetKeyTime(keys_) <= now)
+			{
+				input.Watch(events_[keys_ % 2]);
+				++keys_;
+			}
+		}
+
+		// When the key behind the index-th command went down or up; one command per key, in order.
+		std::uint64_t GetKeyTime(std::uint64_t index) const
+		{
+			return start_ + ((index + 1) * interval_);
+		}
+	};
+
+	struct LatencyStats
+	{
+		std::uint64_t commands_ = 0;
+		std::uint64_t reported_total_ = 0;
+		std::uint64_t reported_max_ = 0;
+		std::uint64_t actual_total_ = 0;
+		std::uint64_t actual_max_ = 0;
+
+		void PrintReport(const char* name) const
+		{
+			const double ms_per_count = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+			const double commands = static_cast<double>(std::max<std::uint64_t>(commands_, 1));
+
+			printf("%s: %llu paddle commands, key-to-tick latency reported mean %.2f ms, max %.2f ms; from the key press mean %.2f ms, max %.2f ms\n",
+				name, static_cast<unsigned long long>(commands_), static_cast<double>(reported_total_) * ms_per_count / commands,
+				static_cast<double>(reported_max_) * ms_per_count, static_cast<double>(actual_total_) * ms_per_count / commands,
+				static_cast<double>(actual_max_) * ms_per_count);
+		}
+	};
+
+	// What GamePlayState::ApplyPaddleCommands does at the start of a tick, keeping both latencies of each command.
+	void ApplyCommands(Input& input, Simulation& simulation, const ScriptedKeyboard& keyboard, LatencyStats& stats)
+	{
+		PaddleCommand command;
+
+		while (input.TryPop(command))
+		{
+			const std::uint64_t now = SDL_GetPerformanceCounter();
+			const std::uint64_t reported = now - command.timestamp_;
+			const std::uint64_t actual = now - keyboard.GetKeyTime(stats.commands_);
+
+			simulation.player1_paddle_.vy_ = Scalar(command.direction_ * Paddle::speed);
+
+			++stats.commands_;
+			stats.reported_total_ += reported;
+			stats.reported_max_ = std::max(stats.reported_max_, reported);
+			stats.actual_total_ += actual;
+			stats.actual_max_ = std::max(stats.actual_max_, actual);
+		}
+	}
+
+	void RunLatency(const char* name, int render_stall_ms, bool simulation_thread, bool pump_through_render)
+	{
+		const std::uint64_t frequency = SDL_GetPerformanceFrequency();
+		const std::uint64_t period = frequency / 60;
+		const std::uint64_t duration = static_cast<std::uint64_t>(latency_seconds * static_cast<double>(frequency));
+
+		Input input;
+		input.MapKeys();
+		input.SetCapturing(true);
+
+		Simulation simulation;
+		simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 1);
+
+		const std::uint64_t start = SDL_GetPerformanceCounter();
+		ScriptedKeyboard keyboard(start);
+		LatencyStats stats;
+		std::atomic<bool> running(true);
+		std::thread ticking_thread;
+
+		if (simulation_thread)
+		{
+			ticking_thread = std::thread([&]()
+				{
+					std::uint64_t next_tick = SDL_GetPerformanceCounter() + period;
+
+					while (running)
+					{
+						const std::uint64_t now = SDL_GetPerformanceCounter();
+
+						if (now < next_tick)
+						{
+							std::this_thread::sleep_for(std::chrono::microseconds((next_tick - now) * 1000000 / frequency));
+							continue;
+						}
+
+						ApplyCommands(input, simulation, keyboard, stats);
+						simulation.Tick();
+						next_tick += period;
+					}
+				});
+		}
+
+		std::uint64_t last_time = start;
+		std::uint64_t delta = 0;
+
+		while (last_time - start < duration)
+		{
+			// Game::HandleEvents.
+			keyboard.Pump(input);
+
+			if (!simulation_thread)
+			{
+				const std::uint64_t now = SDL_GetPerformanceCounter();
+				delta += now - last_time;
+				last_time = now;
+
+				while (delta >= period)
+				{
+					ApplyCommands(input, simulation, keyboard, stats);
+					simulation.Tick();
+					delta -= period;
+				}
+			}
+			else
+			{
+				last_time = SDL_GetPerformanceCounter();
+			}
+
+			// Game::Render with its stall.
+			if (pump_through_render)
+			{
+				const std::uint64_t stall_end = SDL_GetPerformanceCounter() + static_cast<std::uint64_t>(render_stall_ms) * frequency / 1000;
+				keyboard.Pump(input);
+
+				while (SDL_GetPerformanceCounter() < stall_end)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					keyboard.Pump(input);
+				}
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(render_stall_ms));
+			}
+		}
+
+		running = false;
+
+		if (ticking_thread.joinable())
+		{
+			ticking_thread.join();
+		}
+
+		stats.PrintReport(name);
+	}
+}
+
+bool InputBenchmark::Run(Benchmark& benchmark)
+{
+	const std::vector<SDL_Event> events = MakeMouseHeavyFrame();
+
+	Input input;
+	input.MapKeys();
+
+	InputFrame frame;
+
+	input.SetWantedEvents(input_events::pointer | input_events::buttons);
+	RunFrame(input, events, frame);
+
+	if (!frame.pointer_moved_ || frame.pointer_x_ != 100 + motion_events - 1 || !frame.WasPressed(InputAction::CLICK) ||
+		!frame.WasPressed(InputAction::PLAYBACK_PAUSE) || !frame.WasReleased(InputAction::PLAYBACK_PAUSE) || frame.IsHeld(InputAction::PLAYBACK_PAUSE) ||
+		frame.events_ != events.size() - 1)
+	{
+		printf("%s\n", "Unable to dispatch the menu frame as expected!");
+		return false;
+	}
+
+	input.SetWantedEvents(0);
+	RunFrame(input, events, frame);
+
+	if (frame.pointer_moved_ || frame.WasPressed(InputAction::CLICK) || !frame.WasPressed(InputAction::PLAYBACK_PAUSE) || frame.events_ != 2)
+	{
+		printf("%s\n", "Unable to dispatch the gameplay frame as expected!");
+		return false;
+	}
+
+	input.SetWantedEvents(input_events::pointer | input_events::buttons);
+	benchmark.Run("Input/mouse-heavy frame, menu", [&]()
+		{
+			RunFrame(input, events, frame);
+			DoNotOptimize(frame);
+		});
+
+	input.SetWantedEvents(0);
+	benchmark.Run("Input/mouse-heavy frame, gameplay", [&]()
+		{
+			RunFrame(input, events, frame);
+			DoNotOptimize(frame);
+		});
+
+	const double menu_ns = GetMedianNs(benchmark, "Input/mouse-heavy frame, menu");
+	const double gameplay_ns = GetMedianNs(benchmark, "Input/mouse-heavy frame, gameplay");
+
+	if (menu_ns > 0.0 && gameplay_ns > 0.0)
+	{
+		printf("Input: %zu events per frame; menus %.1f M events/s with 1 hover test instead of %d, gameplay %.1f M events/s with %zu of them dropped by the filter\n",
+			events.size(), static_cast<double>(events.size()) * 1e3 / menu_ns, motion_events, static_cast<double>(events.size()) * 1e3 / gameplay_ns, events.size() - 2);
+	}
+
+	return true;
+}
+
+void InputBenchmark::Latency(int render_stall_ms)
+{
+	RunLatency("Ticks on the render loop (--legacy-input)", render_stall_ms, false, true);
+	RunLatency("Simulation thread, events pumped once per frame", render_stall_ms, true, false);
+	RunLatency("Simulation thread, events pumped through the render", render_stall_ms, true, true);
+}
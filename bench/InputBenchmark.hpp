@@ -0,0 +1,20 @@
+#ifndef INPUT_BENCHMARK_HPP
+#define INPUT_BENCHMARK_HPP
+
+class Benchmark;
+
+class InputBenchmark
+{
+public:
+	// Feeds a mouse-heavy frame of events through the dispatcher as the menus and gameplay see it, checks what
+	// reaches the state and prints events per second.
+	static bool Run(Benchmark& benchmark);
+
+	// Presses and releases a paddle key on a fixed schedule for a few seconds while a stand-in render loop stalls
+	// render_stall_ms per frame: with ticks on the render loop as --legacy-input plays, and with a simulation thread
+	// whose events are pumped once per frame or all through the render, as Game::Render does. Prints the latency
+	// each arrangement reports next to the latency from the moment the key went down.
+	static void Latency(int render_stall_ms);
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "MenuBenchmark.hpp"
+#include "AtlasSprites.hpp"
+#include "Benchmark.hpp"
+#include "Constants.hpp"
+#include "Menu.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	// What every button hit-testing itself amounts to.
+	int HitTestEachButton(const Menu& menu, int button_count, int x, int y)
+	{
+		const SDL_Point point = { x, y };
+
+		for (int id = 0; id < button_count; ++id)
+		{
+			if (SDL_PointInRect(&point, &menu.GetWidget(id).bounds_))
+			{
+				return id;
+			}
+		}
+
+		return Menu::none;
+	}
+}
+
+bool MenuBenchmark::Run(Benchmark& benchmark)
+{
+	// The difficulty menu, which needs no game to lay out or hit-test.
+	Menu menu(nullptr);
+	menu.AddButton(atlas::easy, constants::screen_width / 2, constants::screen_height * 3 / 8);
+	menu.AddButton(atlas::medium, constants::screen_width / 2, constants::screen_height * 4 / 8);
+	menu.AddButton(atlas::hard, constants::screen_width / 2, constants::screen_height * 5 / 8);
+	menu.AddButton(atlas::impossible, constants::screen_width / 2, constants::screen_height * 6 / 8);
+
+	constexpr int button_count = 4;
+	std::vector<SDL_Point> sweep;
+	int hits = 0;
+
+	for (int y = 0; y < constants::screen_height; ++y)
+	{
+		for (int x = 0; x < constants::screen_width; ++x)
+		{
+			const int expected = HitTestEachButton(menu, button_count, x, y);
+
+			if (menu.HitTest(x, y) != expected)
+			{
+				printf("Unable to hit-test the menu at %d, %d: the grid says %d where the buttons say %d!\n", x, y, menu.HitTest(x, y), expected);
+				return false;
+			}
+
+			hits += expected != Menu::none ? 1 : 0;
+
+			if ((x % 8) == 0 && (y % 8) == 0)
+			{
+				sweep.push_back({ x, y });
+			}
+		}
+	}
+
+	menu.SetEnabled(1, false);
+
+	const SDL_Rect& disabled = menu.GetWidget(1).bounds_;
+
+	if (hits == 0 || menu.HitTest(disabled.x + (disabled.w / 2), disabled.y + (disabled.h / 2)) != Menu::none)
+	{
+		printf("%s\n", "Unable to hit-test the menu: a disabled button was hit!");
+		return false;
+	}
+
+	menu.SetEnabled(1, true);
+
+	benchmark.Run("Menu/hit test sweep, grid", [&]()
+		{
+			int found = 0;
+
+			for (const SDL_Point& point : sweep)
+			{
+				found += menu.HitTest(point.x, point.y);
+			}
+
+			DoNotOptimize(found);
+		});
+
+	benchmark.Run("Menu/hit test sweep, each button", [&]()
+		{
+			int found = 0;
+
+			for (const SDL_Point& point : sweep)
+			{
+				found += HitTestEachButton(menu, button_count, point.x, point.y);
+			}
+
+			DoNotOptimize(found);
+		});
+
+	return true;
+}
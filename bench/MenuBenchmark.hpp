@@ -0,0 +1,14 @@
+#ifndef MENU_BENCHMARK_HPP
+#define MENU_BENCHMARK_HPP
+
+class Benchmark;
+
+class MenuBenchmark
+{
+public:
+	// Checks the difficulty menu's grid hit test against a plain test of every button over the whole playfield, then
+	// times both over a sweep of pointer positions.
+	static bool Run(Benchmark& benchmark);
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "ObstacleBenchmark.hpp"
+#include "Arena.hpp"
+#include "Benchmark.hpp"
+#include "Ball.hpp"
+#include "Constants.hpp"
+#include "Random.hpp"
+#include "Scalar.hpp"
+#include "Simulation.hpp"
+#include "Utility.hpp"
+
+#include <string>
+
+namespace
+{
+	constexpr int obstacle_counts[] = { 0, 64, 1024, 4096 };
+	constexpr int linear_count = 4096;
+
+	// Obstacles stay out of the paddle lanes and out of a band through the serve, so the ball below flies freely.
+	constexpr int lane_width = 80;
+	constexpr int band_half_height = 40;
+	constexpr int max_obstacle_size = 12;
+
+	Scalar NextCoordinate(Random& random, int min, int max)
+	{
+		return Scalar(min) + random.NextUnit() * Scalar(max - min);
+	}
+
+	void FillArena(Arena& arena, int count, std::uint64_t seed)
+	{
+		Random random(seed);
+
+		const int band_top = (constants::screen_height / 2) - band_half_height - max_obstacle_size;
+		const int band_bottom = (constants::screen_height / 2) + band_half_height;
+
+		arena.Clear();
+
+		for (int i = 0; i < count; ++i)
+		{
+			const Scalar x = NextCoordinate(random, lane_width, constants::screen_width - lane_width - max_obstacle_size);
+			const Scalar y = random.Next() % 2 == 0 ? NextCoordinate(random, 0, band_top) : NextCoordinate(random, band_bottom, constants::screen_height - max_obstacle_size);
+			const Scalar w = NextCoordinate(random, 2, max_obstacle_size);
+			const Scalar h = NextCoordinate(random, 2, max_obstacle_size);
+
+			if (i % 2 == 0)
+			{
+				arena.AddBox({ x, y, w, h });
+			}
+			else
+			{
+				arena.AddSegment({ x, y }, { x + w, y + h });
+			}
+		}
+
+		arena.Build();
+	}
+
+	void AimBall(Ball& ball, Scalar x, Scalar y, Scalar vx, Scalar vy)
+	{
+		ball.rect_.x = x;
+		ball.rect_.y = y;
+		ball.vx_ = vx;
+		ball.vy_ = vy;
+		ball.UpdateDirectionRay();
+	}
+}
+
+bool ObstacleBenchmark::Run(Benchmark& benchmark)
+{
+	for (const int count : obstacle_counts)
+	{
+		Arena arena;
+		FillArena(arena, count, 42);
+
+		const std::string suffix = "/" + std::to_string(count);
+
+		// A ball-sized box in the free band, and one among the obstacles.
+		const Rect band_rect = { Scalar(400), Scalar((constants::screen_height / 2) - 7), Scalar(14), Scalar(14) };
+		const Rect field_rect = { Scalar(400), Scalar(100), Scalar(14), Scalar(14) };
+
+		benchmark.Run("Arena::FindOverlap/free" + suffix, [&]()
+			{
+				DoNotOptimize(arena.FindOverlap(band_rect));
+			});
+
+		benchmark.Run("Arena::FindOverlap/crowded" + suffix, [&]()
+			{
+				DoNotOptimize(arena.FindOverlap(field_rect));
+			});
+
+		// Straight into the obstacles from the serve, as a prediction after a paddle hit.
+		const Line ray(Scalar(constants::screen_width / 2), Scalar(constants::screen_height / 2), Scalar(constants::screen_width / 2 + 600), Scalar(-300));
+		ArenaHit hit;
+
+		benchmark.Run("Arena::CastRay" + suffix, [&]()
+			{
+				DoNotOptimize(arena.CastRay(ray, -1, hit));
+				DoNotOptimize(hit);
+			});
+
+		Simulation simulation;
+		simulation.SetArena(&arena);
+		simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 1);
+
+		AimBall(simulation.ball_, Scalar(400), Scalar((constants::screen_height / 2) - 7), Scalar(5), Scalar(0.5f));
+		const Ball free_ball = simulation.ball_;
+		Ball ball = free_ball;
+
+		benchmark.Run("Ball::Tick/obstacles" + suffix, [&]()
+			{
+				ball = free_ball;
+				ball.Tick();
+				DoNotOptimize(ball);
+			});
+
+		AimBall(simulation.ball_, Scalar(200), Scalar(500), Scalar(9), Scalar(-11));
+
+		benchmark.Run("Simulation::GetEdgeIntersectionPoint/impossible" + suffix, [&]()
+			{
+				simulation.GetEdgeIntersectionPoint(BallDirectionChange::PADDLE_HIT);
+				DoNotOptimize(simulation.intersection_point_);
+			});
+
+		// What every ball step would cost without the hierarchy.
+		if (count == linear_count)
+		{
+			benchmark.Run("Arena::FindOverlap/linear" + suffix, [&]()
+				{
+					std::int32_t found = -1;
+
+					for (std::size_t i = 0; i < arena.GetObstacleCount() && found < 0; ++i)
+					{
+						if (Arena::Overlaps(arena.GetObstacle(static_cast<std::int32_t>(i)), band_rect))
+						{
+							found = static_cast<std::int32_t>(i);
+						}
+					}
+
+					DoNotOptimize(found);
+				});
+		}
+	}
+
+	return true;
+}
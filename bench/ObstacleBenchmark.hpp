@@ -0,0 +1,12 @@
+#ifndef OBSTACLE_BENCHMARK_HPP
+#define OBSTACLE_BENCHMARK_HPP
+
+class Benchmark;
+
+class ObstacleBenchmark
+{
+public:
+	static bool Run(Benchmark& benchmark);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "PhysicsBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "Ball.hpp"
+#include "Paddle.hpp"
+#include "Constants.hpp"
+#include "Scalar.hpp"
+#include "Simulation.hpp"
+#include "Utility.hpp"
+
+#include <optional>
+
+namespace
+{
+	void AimBall(Ball& ball, Scalar x, Scalar y, Scalar vx, Scalar vy)
+	{
+		ball.rect_.x = x;
+		ball.rect_.y = y;
+		ball.vx_ = vx;
+		ball.vy_ = vy;
+		ball.UpdateDirectionRay();
+	}
+}
+
+bool PhysicsBenchmark::Run(Benchmark& benchmark)
+{
+	Simulation simulation;
+	simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::MEDIUM, 1);
+
+	// A steep shot towards the top wall makes the IMPOSSIBLE prediction reflect several times before reaching a goal line.
+	AimBall(simulation.ball_, Scalar(200), Scalar(500), Scalar(9), Scalar(-11));
+	const Ball aimed_ball = simulation.ball_;
+
+	const Line diagonal_ray(Scalar(100), Scalar(700), Scalar(900), Scalar(-300));
+	const Line parallel_ray(Scalar(0), Scalar(10), Scalar(constants::screen_width), Scalar(10));
+	const Vec2 point_on_edge = { Scalar(480), Scalar(0) };
+
+	benchmark.Run("Simulation::GetLinesIntersectionPoint/hit", [&]()
+		{
+			DoNotOptimize(simulation.GetLinesIntersectionPoint(top_edge, diagonal_ray));
+		});
+
+	benchmark.Run("Simulation::GetLinesIntersectionPoint/parallel", [&]()
+		{
+			DoNotOptimize(simulation.GetLinesIntersectionPoint(top_edge, parallel_ray));
+		});
+
+	benchmark.Run("Simulation::IsPointOnLine", [&]()
+		{
+			DoNotOptimize(simulation.IsPointOnLine(point_on_edge, top_edge));
+		});
+
+	benchmark.Run("Simulation::GetEdgeIntersectionPoint/medium", [&]()
+		{
+			simulation.GetEdgeIntersectionPoint(BallDirectionChange::PADDLE_HIT);
+			DoNotOptimize(simulation.intersection_point_);
+		});
+
+	simulation.ai_controller_ = GetBuiltinAiController(GameDifficulty::IMPOSSIBLE);
+
+	benchmark.Run("Simulation::GetEdgeIntersectionPoint/impossible", [&]()
+		{
+			simulation.GetEdgeIntersectionPoint(BallDirectionChange::PADDLE_HIT);
+			DoNotOptimize(simulation.intersection_point_);
+		});
+
+	// What the trajectory overlay adds to every change of direction while it is on, and to every snapshot.
+	benchmark.Run("Simulation::UpdateTrajectory", [&]()
+		{
+			simulation.UpdateTrajectory();
+			DoNotOptimize(simulation.trajectory_);
+		});
+
+	SimulationSnapshot snapshot;
+
+	benchmark.Run("Simulation::TakeSnapshot/trajectory", [&]()
+		{
+			simulation.TakeSnapshot(snapshot);
+			DoNotOptimize(snapshot);
+		});
+
+	simulation.ai_controller_ = GetBuiltinAiController(GameDifficulty::MEDIUM);
+
+	Ball ball = aimed_ball;
+	const Paddle& paddle = simulation.player1_paddle_;
+
+	Ball paddle_ball = aimed_ball;
+	AimBall(paddle_ball, paddle.rect_.x - paddle_ball.rect_.w, paddle.rect_.y + Scalar(20), Scalar(5), Scalar(1));
+
+	benchmark.Run("Ball::BounceBall", [&]()
+		{
+			ball = paddle_ball;
+			ball.BounceBall(paddle);
+			DoNotOptimize(ball);
+		});
+
+	Ball free_ball = aimed_ball;
+	AimBall(free_ball, Scalar(400), Scalar(300), Scalar(5), Scalar(2));
+
+	benchmark.Run("Ball::Tick/free_flight", [&]()
+		{
+			ball = free_ball;
+			ball.Tick();
+			DoNotOptimize(ball);
+		});
+
+	Ball wall_ball = aimed_ball;
+	AimBall(wall_ball, Scalar(400), Scalar(2), Scalar(5), Scalar(-4));
+
+	benchmark.Run("Ball::Tick/wall_bounce", [&]()
+		{
+			ball = wall_ball;
+			ball.Tick();
+			DoNotOptimize(ball);
+		});
+
+	benchmark.Run("Ball::Tick/paddle_hit", [&]()
+		{
+			ball = paddle_ball;
+			ball.Tick();
+			DoNotOptimize(ball);
+		});
+
+	return true;
+}
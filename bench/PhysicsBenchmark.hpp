@@ -0,0 +1,12 @@
+#ifndef PHYSICS_BENCHMARK_HPP
+#define PHYSICS_BENCHMARK_HPP
+
+class Benchmark;
+
+class PhysicsBenchmark
+{
+public:
+	static bool Run(Benchmark& benchmark);
+};
+
+#endif
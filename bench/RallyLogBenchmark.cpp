@@ -0,0 +1,160 @@
+#include "RallyLogBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "RallyLog.hpp"
+#include "Simulation.hpp"
+#include "SimulationBenchmark.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	constexpr const char* rally_log_path = "bench_rallies.pongrallies";
+	constexpr std::uint64_t checked_ticks = 60 * 60 * 10;
+}
+
+bool RallyLogBenchmark::Run(Benchmark& benchmark)
+{
+	RallyLog log;
+
+	if (!log.Open(rally_log_path, GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 7, 0, Simulation::reference_tick_rate, 1, 0))
+	{
+		return false;
+	}
+
+	// Ten minutes of a scripted match, counting what the log should end up with.
+	Simulation simulation;
+	simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 7);
+
+	std::uint64_t expected_hits = 0;
+	std::uint64_t expected_rallies = 0;
+
+	for (std::uint64_t tick = 0; tick < checked_ticks; ++tick)
+	{
+		SimulationBenchmark::ApplyScriptedInput(simulation, tick);
+		simulation.Tick();
+		log.Record(simulation);
+
+		for (std::size_t i = 0; i < simulation.event_count_; ++i)
+		{
+			expected_hits += simulation.events_[i].type_ == SimulationEventType::PADDLE_HIT ? 1 : 0;
+			expected_rallies += simulation.events_[i].type_ == SimulationEventType::GOAL ? 1 : 0;
+		}
+	}
+
+	const bool dropped = log.GetDroppedRows() > 0;
+	log.Close();
+
+	RallyLogReader reader;
+
+	if (!reader.Open(rally_log_path))
+	{
+		std::remove(rally_log_path);
+		return false;
+	}
+
+	std::uint64_t hits = 0;
+	std::uint64_t rallies = 0;
+	std::uint64_t rally_hits = 0;
+	RallyLogBlock block;
+
+	while (reader.Next(block))
+	{
+		if (block.table_ == RallyLogTable::HITS)
+		{
+			hits += block.rows_;
+		}
+		else
+		{
+			rallies += block.rows_;
+
+			for (std::uint32_t i = 0; i < block.rows_; ++i)
+			{
+				rally_hits += block.GetUint32(rally_log::rally_hits)[i];
+			}
+		}
+	}
+
+	reader.Close();
+
+	// Hits after the last goal belong to a rally that never ended, so they are in the hit table only.
+	if (!dropped && (hits != expected_hits || rallies != expected_rallies || rally_hits > hits))
+	{
+		printf("Rally log holds %llu hits and %llu rallies, the match had %llu and %llu!\n", static_cast<unsigned long long>(hits),
+			static_cast<unsigned long long>(rallies), static_cast<unsigned long long>(expected_hits), static_cast<unsigned long long>(expected_rallies));
+		std::remove(rally_log_path);
+		return false;
+	}
+
+	std::remove(rally_log_path);
+
+	// Recording thousands of times faster than a match does would outrun any disk, so the timed runs write nowhere.
+	if (!log.Open("/dev/null", GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 7, 0, Simulation::reference_tick_rate, 1, 0))
+	{
+		return false;
+	}
+
+	std::uint64_t tick = 0;
+
+	benchmark.Run("RallyLog::RecordHit", [&]()
+		{
+			log.RecordHit(++tick, 2, 0.5f, 12.0f, 3.0f);
+		});
+
+	simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 7);
+	tick = 0;
+
+	benchmark.Run("RallyLog::Record/tick", [&]()
+		{
+			SimulationBenchmark::ApplyScriptedInput(simulation, tick++);
+			simulation.Tick();
+			log.Record(simulation);
+		});
+
+	const std::uint64_t dropped_rows = log.GetDroppedRows();
+	log.Close();
+
+	if (dropped_rows > 0)
+	{
+		printf("RallyLog dropped %llu rows while timed; the timings include the cheaper dropping path.\n", static_cast<unsigned long long>(dropped_rows));
+	}
+
+	return true;
+}
+
+bool RallyLogBenchmark::Generate(const char* path, std::uint64_t rallies)
+{
+	Simulation simulation;
+	simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 11);
+
+	RallyLog log;
+
+	if (!log.Open(path, GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 11, 0, Simulation::reference_tick_rate, 1, 0))
+	{
+		return false;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::uint64_t goals = 0;
+
+	while (goals < rallies)
+	{
+		SimulationBenchmark::ApplyScriptedInput(simulation, simulation.tick_count_);
+		simulation.Tick();
+		log.Record(simulation);
+
+		for (std::size_t i = 0; i < simulation.event_count_; ++i)
+		{
+			goals += simulation.events_[i].type_ == SimulationEventType::GOAL ? 1 : 0;
+		}
+	}
+
+	const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const bool complete = log.GetDroppedRows() == 0;
+	log.Close();
+
+	printf("Logged %llu rallies in %llu ticks (%.1f hours of play) in %.1f s\n", static_cast<unsigned long long>(goals), static_cast<unsigned long long>(simulation.tick_count_),
+		static_cast<double>(simulation.tick_count_) / (Simulation::reference_tick_rate * 3600.0), elapsed_s);
+
+	return complete;
+}
@@ -0,0 +1,19 @@
+#ifndef RALLY_LOG_BENCHMARK_HPP
+#define RALLY_LOG_BENCHMARK_HPP
+
+#include <cstdint>
+
+class Benchmark;
+
+class RallyLogBenchmark
+{
+public:
+	// Times recording a hit and a tick's events, then reads the log back and checks every recorded row arrived.
+	static bool Run(Benchmark& benchmark);
+
+	// Plays a scripted IMPOSSIBLE match until it has logged the given number of rallies to path, for trying out
+	// rally_stats on a large log.
+	static bool Generate(const char* path, std::uint64_t rallies);
+};
+
+#endif
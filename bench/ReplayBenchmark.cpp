@@ -0,0 +1,105 @@
+#include "ReplayBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "Random.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
+#include "SimulationBenchmark.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	constexpr const char* replay_path = "bench_replay.pongreplay";
+	constexpr std::uint64_t replay_minutes = 10;
+	constexpr std::uint64_t replay_ticks = replay_minutes * 60 * 60;
+	constexpr std::uint64_t checked_seeks = 200;
+}
+
+bool ReplayBenchmark::Run(Benchmark& benchmark)
+{
+	// The scripted input changes direction every 23 ticks, far more often than a person does, so this is an upper bound.
+	std::vector<SimulationState> states(replay_ticks + 1);
+	ReplayWriter writer;
+
+	if (!writer.Open(replay_path, GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 7))
+	{
+		return false;
+	}
+
+	Simulation simulation;
+	simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 7);
+
+	for (std::uint64_t tick = 0; tick < replay_ticks; ++tick)
+	{
+		SimulationBenchmark::ApplyScriptedInput(simulation, tick);
+		writer.Record(simulation);
+		simulation.Tick();
+		simulation.SaveState(states[tick + 1]);
+	}
+
+	const std::uint64_t replay_size = writer.GetSize();
+
+	if (!writer.Close())
+	{
+		return false;
+	}
+
+	ReplayReader reader;
+
+	if (!reader.Open(replay_path))
+	{
+		std::remove(replay_path);
+		return false;
+	}
+
+	printf("Replay: %llu ticks, %llu keyframes, %llu bytes per minute of play\n", static_cast<unsigned long long>(reader.GetHeader().tick_count),
+		static_cast<unsigned long long>(reader.GetHeader().keyframe_count), static_cast<unsigned long long>(replay_size / replay_minutes));
+
+	Random random(3);
+	Simulation playback;
+
+	for (std::uint64_t i = 0; i < checked_seeks; ++i)
+	{
+		const std::uint64_t tick = 1 + random.Next() % replay_ticks;
+		reader.Seek(playback, tick);
+
+		SimulationState state;
+		playback.SaveState(state);
+
+		if (std::memcmp(&state, &states[tick], sizeof(state)) != 0)
+		{
+			printf("Replay seek to tick %llu does not match the recorded match!\n", static_cast<unsigned long long>(tick));
+			std::remove(replay_path);
+			return false;
+		}
+	}
+
+	benchmark.Run("ReplayReader::Seek/random", [&]()
+		{
+			reader.Seek(playback, random.Next() % replay_ticks);
+			DoNotOptimize(playback.ball_.rect_);
+		});
+
+	// One frame of 100x fast-forward.
+	benchmark.Run("ReplayReader::Step/100", [&]()
+		{
+			if (playback.tick_count_ + 100 > replay_ticks)
+			{
+				reader.Seek(playback, 0);
+			}
+
+			for (int i = 0; i < 100; ++i)
+			{
+				reader.Step(playback);
+			}
+
+			DoNotOptimize(playback.ball_.rect_);
+		});
+
+	reader.Close();
+	std::remove(replay_path);
+
+	return true;
+}
@@ -0,0 +1,13 @@
+#ifndef REPLAY_BENCHMARK_HPP
+#define REPLAY_BENCHMARK_HPP
+
+class Benchmark;
+
+class ReplayBenchmark
+{
+public:
+	// Records a scripted match, checks that seeking reproduces every tick of it, then times seeks and fast-forward.
+	static bool Run(Benchmark& benchmark);
+};
+
+#endif
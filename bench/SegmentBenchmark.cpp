@@ -0,0 +1,401 @@
+#include "SegmentBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "Random.hpp"
+#include "Scalar.hpp"
+#include "SegmentKernel.hpp"
+#include "Simulation.hpp"
+#include "Utility.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr int random_batches = 2000;
+	constexpr int random_batch_size = 61;
+	constexpr int random_rays_per_batch = 16;
+	constexpr int ulp_grid_size = 256;
+
+	struct RayCase
+	{
+		float start_x;
+		float start_y;
+		float end_x;
+		float end_y;
+	};
+
+	using Kernel = SegmentHit (*)(const SegmentBatch&, float, float, float, float);
+
+	float NextCoordinate(Random& random, float range)
+	{
+		return static_cast<float>(random.Next() >> 8) / static_cast<float>(1u << 24) * range;
+	}
+
+	float NudgeUlps(float value, int ulps)
+	{
+		for (; ulps > 0; --ulps)
+		{
+			value = std::nextafter(value, 1e30f);
+		}
+
+		for (; ulps < 0; ++ulps)
+		{
+			value = std::nextafter(value, -1e30f);
+		}
+
+		return value;
+	}
+
+	bool SameHit(const SegmentHit& a, const SegmentHit& b)
+	{
+		return a.index == b.index && std::memcmp(&a.t, &b.t, sizeof(a.t)) == 0 && std::memcmp(&a.x, &b.x, sizeof(a.x)) == 0 &&
+			std::memcmp(&a.y, &b.y, sizeof(a.y)) == 0;
+	}
+
+	class Checker
+	{
+	private:
+		int cases_;
+		int failures_;
+		bool has_avx_;
+
+	public:
+		Checker() :
+			cases_(0),
+			failures_(0),
+			has_avx_(segment_kernel::HasAvx())
+		{
+		}
+
+		// Runs every variant and requires all of them to agree; returns the scalar result.
+		SegmentHit Find(const SegmentBatch& segments, const RayCase& ray)
+		{
+			const SegmentHit scalar = segment_kernel::FindNearestHitScalar(segments, ray.start_x, ray.start_y, ray.end_x, ray.end_y);
+			const SegmentHit sse2 = segment_kernel::FindNearestHitSse2(segments, ray.start_x, ray.start_y, ray.end_x, ray.end_y);
+			const SegmentHit avx = has_avx_ ? segment_kernel::FindNearestHitAvx(segments, ray.start_x, ray.start_y, ray.end_x, ray.end_y) : scalar;
+
+			if (!SameHit(scalar, sse2) || !SameHit(scalar, avx))
+			{
+				Fail("variants disagree", ray, scalar);
+			}
+
+			return scalar;
+		}
+
+		void Expect(const char* name, const SegmentBatch& segments, const RayCase& ray, int index, float t = -1.0f)
+		{
+			++cases_;
+
+			const SegmentHit hit = Find(segments, ray);
+
+			if (hit.index != index || (t >= 0.0f && hit.t != t))
+			{
+				Fail(name, ray, hit);
+			}
+		}
+
+		void ExpectSign(const char* name, int sign, int expected)
+		{
+			++cases_;
+
+			if (sign != expected && failures_++ < 10)
+			{
+				printf("FAILED %s: orientation %d, expected %d\n", name, sign, expected);
+			}
+		}
+
+		void Fail(const char* name, const RayCase& ray, const SegmentHit& hit)
+		{
+			if (failures_++ < 10)
+			{
+				printf("FAILED %s: ray (%.9g, %.9g) -> (%.9g, %.9g) hit %d at t %.9g\n", name, ray.start_x, ray.start_y, ray.end_x, ray.end_y, hit.index, hit.t);
+			}
+		}
+
+		void CountCase()
+		{
+			++cases_;
+		}
+
+		int GetCases() const
+		{
+			return cases_;
+		}
+
+		int GetFailures() const
+		{
+			return failures_;
+		}
+	};
+
+	SegmentBatch SingleSegment(float ax, float ay, float bx, float by)
+	{
+		SegmentBatch segments;
+		segments.Add(ax, ay, bx, by);
+		return segments;
+	}
+
+	void CheckKnownCases(Checker& checker)
+	{
+		const SegmentBatch diagonal = SingleSegment(0.0f, 10.0f, 10.0f, 0.0f);
+		checker.Expect("crossing", diagonal, { 0.0f, 0.0f, 10.0f, 10.0f }, 0, 0.5f);
+		checker.Expect("crossing reversed segment", SingleSegment(10.0f, 0.0f, 0.0f, 10.0f), { 0.0f, 0.0f, 10.0f, 10.0f }, 0, 0.5f);
+		checker.Expect("short of the segment", diagonal, { 0.0f, 0.0f, 4.0f, 4.0f }, -1);
+
+		checker.Expect("parallel", SingleSegment(0.0f, 1.0f, 10.0f, 1.0f), { 0.0f, 0.0f, 10.0f, 0.0f }, -1);
+		checker.Expect("collinear overlapping", SingleSegment(5.0f, 0.0f, 15.0f, 0.0f), { 0.0f, 0.0f, 10.0f, 0.0f }, -1);
+		checker.Expect("collinear containing the ray", SingleSegment(-5.0f, 0.0f, 15.0f, 0.0f), { 0.0f, 0.0f, 10.0f, 0.0f }, -1);
+		checker.Expect("zero-length segment on the ray", SingleSegment(5.0f, 0.0f, 5.0f, 0.0f), { 0.0f, 0.0f, 10.0f, 0.0f }, -1);
+		checker.Expect("zero-length ray", diagonal, { 5.0f, 5.0f, 5.0f, 5.0f }, -1);
+
+		checker.Expect("segment end touching the ray", SingleSegment(5.0f, 0.0f, 5.0f, 5.0f), { 0.0f, 0.0f, 10.0f, 0.0f }, 0, 0.5f);
+		checker.Expect("ray end touching the segment", SingleSegment(5.0f, -5.0f, 5.0f, 5.0f), { 0.0f, 0.0f, 5.0f, 0.0f }, 0, 1.0f);
+		checker.Expect("ray starting on the segment", SingleSegment(0.0f, 0.0f, 10.0f, 0.0f), { 5.0f, 0.0f, 10.0f, 10.0f }, -1);
+		checker.Expect("shared endpoint", SingleSegment(10.0f, 10.0f, 20.0f, 0.0f), { 0.0f, 0.0f, 10.0f, 10.0f }, 0, 1.0f);
+
+		// The nearest of several, ties going to the lowest index, padding lanes never hitting.
+		SegmentBatch walls;
+		walls.Add(8.0f, -1.0f, 8.0f, 1.0f);
+		walls.Add(2.0f, -1.0f, 2.0f, 1.0f);
+		walls.Add(6.0f, -1.0f, 6.0f, 1.0f);
+		walls.Add(2.0f, 1.0f, 2.0f, -1.0f);
+		walls.Add(2.0f, 0.0f, 3.0f, 5.0f);
+		checker.Expect("nearest of several", walls, { 0.0f, 0.0f, 10.0f, 0.0f }, 1, 0.2f);
+		checker.Expect("nearest of several, reversed", walls, { 10.0f, 0.0f, 0.0f, 0.0f }, 0, 0.2f);
+		checker.Expect("origin outside the padding", walls, { -1.0f, -1.0f, -1.0f, 1.0f }, -1);
+
+		// The screen edges: a ray reflected off the top edge leaves it and reaches the next edge.
+		SegmentBatch screen;
+
+		for (const Line& edge : edges)
+		{
+			screen.Add(static_cast<float>(edge.start_point.x), static_cast<float>(edge.start_point.y), static_cast<float>(edge.end_point.x),
+				static_cast<float>(edge.end_point.y));
+		}
+
+		checker.Expect("reflected off the top edge", screen, { 400.0f, 0.0f, 400.0f + 2000.0f, 2000.0f }, 1);
+	}
+
+	// Points a few ulps around p on the line y = x through q and r, whose exact orientation against that line is the
+	// sign of y - x. Evaluated naively, a good share of these come out wrong or depend on the order of the points:
+	// in float already near the origin, in double once q and r are far enough away for the products to round.
+	template <typename T>
+	int CheckUlpGrid(Checker& checker, float p, float q, float r)
+	{
+		int naive_mistakes = 0;
+
+		for (int i = 0; i < ulp_grid_size; ++i)
+		{
+			for (int j = 0; j < ulp_grid_size; ++j)
+			{
+				const float px = NudgeUlps(p, i);
+				const float py = NudgeUlps(p, j);
+				const int expected = (py > px) - (py < px);
+
+				checker.ExpectSign("orientation p q r", segment_kernel::Orientation(px, py, q, q, r, r), expected);
+				checker.ExpectSign("orientation q r p", segment_kernel::Orientation(q, q, r, r, px, py), expected);
+				checker.ExpectSign("orientation r p q", segment_kernel::Orientation(r, r, px, py, q, q), expected);
+
+				const T naive = (T(q) - T(px)) * (T(r) - T(py)) - (T(q) - T(py)) * (T(r) - T(px));
+
+				if ((naive > T(0)) - (naive < T(0)) != expected)
+				{
+					++naive_mistakes;
+				}
+			}
+		}
+
+		return naive_mistakes;
+	}
+
+	// A ray starting or ending within ulps of p on the segment (a, a) - (b, b), crossing it at right angles.
+	void CheckNearSegment(Checker& checker, float a, float b, float p, float far)
+	{
+		const SegmentBatch segment = SingleSegment(a, a, b, b);
+
+		for (int i = -16; i <= 16; ++i)
+		{
+			for (int j = -16; j <= 16; ++j)
+			{
+				const float px = NudgeUlps(p, i);
+				const float py = NudgeUlps(p, j);
+
+				checker.Expect("ray starting ulps from the segment", segment, { px, py, p + far, p - far }, py > px ? 0 : -1);
+				checker.Expect("ray ending ulps from the segment", segment, { p + far, p - far, px, py }, py >= px ? 0 : -1);
+			}
+		}
+	}
+
+	// Random batches with many segments nearly parallel to the ray or sharing its endpoints, where the filter gives
+	// up and lanes fall back to exact arithmetic.
+	void CheckRandomBatches(Checker& checker)
+	{
+		Random random(43);
+		SegmentBatch segments;
+		segments.Reserve(random_batch_size);
+
+		for (int batch = 0; batch < random_batches; ++batch)
+		{
+			const RayCase ray = { NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f) };
+
+			segments.Clear();
+
+			for (int i = 0; i < random_batch_size; ++i)
+			{
+				switch (random.Next() % 4)
+				{
+				case 0:
+					segments.Add(NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f));
+					break;
+				case 1:
+				{
+					const int ulps = static_cast<int>(random.Next() % 9) - 4;
+					segments.Add(NudgeUlps(ray.start_x, ulps), ray.start_y, ray.end_x, NudgeUlps(ray.end_y, -ulps));
+					break;
+				}
+				case 2:
+				{
+					const float t = NextCoordinate(random, 1.0f);
+					const float x = ray.start_x + t * (ray.end_x - ray.start_x);
+					const float y = ray.start_y + t * (ray.end_y - ray.start_y);
+					segments.Add(x, y, NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f));
+					break;
+				}
+				default:
+					segments.Add(ray.end_x, ray.end_y, NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f));
+					break;
+				}
+			}
+
+			for (int i = 0; i < random_rays_per_batch; ++i)
+			{
+				const RayCase nudged = { ray.start_x, ray.start_y, NudgeUlps(ray.end_x, i % 5 - 2), NudgeUlps(ray.end_y, i / 5 - 1) };
+				const SegmentHit hit = checker.Find(segments, nudged);
+				checker.CountCase();
+
+				if (hit.index >= 0 && !(hit.t >= 0.0f && hit.t <= 1.0f))
+				{
+					checker.Fail("t outside the ray", nudged, hit);
+				}
+			}
+		}
+	}
+
+	SegmentBatch RandomBatch(std::size_t count, std::uint64_t seed)
+	{
+		Random random(seed);
+		SegmentBatch segments;
+		segments.Reserve(count);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			segments.Add(NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f));
+		}
+
+		return segments;
+	}
+}
+
+bool SegmentBenchmark::Run(Benchmark& benchmark)
+{
+	struct Variant
+	{
+		const char* name;
+		Kernel kernel;
+	};
+
+	std::vector<Variant> variants = { { "scalar", segment_kernel::FindNearestHitScalar }, { "sse2", segment_kernel::FindNearestHitSse2 } };
+
+	if (segment_kernel::HasAvx())
+	{
+		variants.push_back({ "avx", segment_kernel::FindNearestHitAvx });
+	}
+
+	constexpr std::size_t ray_count = 16;
+	Random random(7);
+	std::vector<RayCase> rays;
+
+	for (std::size_t i = 0; i < ray_count; ++i)
+	{
+		rays.push_back({ NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f), NextCoordinate(random, 1000.0f) });
+	}
+
+	for (const std::size_t count : { std::size_t(4), std::size_t(64), std::size_t(1024) })
+	{
+		const SegmentBatch segments = RandomBatch(count, count);
+
+		for (const Variant& variant : variants)
+		{
+			std::size_t next_ray = 0;
+
+			benchmark.Run(std::string("SegmentKernel/") + variant.name + "/" + std::to_string(count), [&]()
+				{
+					const RayCase& ray = rays[next_ray++ % ray_count];
+					DoNotOptimize(variant.kernel(segments, ray.start_x, ray.start_y, ray.end_x, ray.end_y));
+				});
+		}
+
+		// The same search one line pair at a time, for comparison.
+		std::vector<Line> lines;
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			lines.emplace_back(Scalar(segments.GetAx()[i]), Scalar(segments.GetAy()[i]), Scalar(segments.GetBx()[i]), Scalar(segments.GetBy()[i]));
+		}
+
+		std::size_t next_ray = 0;
+
+		benchmark.Run("Simulation::GetLinesIntersectionPoint/nearest of " + std::to_string(count), [&]()
+			{
+				const RayCase& ray_case = rays[next_ray++ % ray_count];
+				const Line ray(Scalar(ray_case.start_x), Scalar(ray_case.start_y), Scalar(ray_case.end_x), Scalar(ray_case.end_y));
+
+				std::optional<Vec2> nearest;
+				Scalar nearest_distance = Scalar(0);
+
+				for (const Line& line : lines)
+				{
+					const std::optional<Vec2> point = Simulation::GetLinesIntersectionPoint(line, ray);
+
+					if (!point.has_value())
+					{
+						continue;
+					}
+
+					const Scalar distance = PointsDistanceSquared(point->x, point->y, ray.start_point.x, ray.start_point.y);
+
+					if (!nearest.has_value() || distance < nearest_distance)
+					{
+						nearest = point;
+						nearest_distance = distance;
+					}
+				}
+
+				DoNotOptimize(nearest);
+			});
+	}
+
+	return true;
+}
+
+bool SegmentBenchmark::Check()
+{
+	Checker checker;
+
+	CheckKnownCases(checker);
+	const int naive_float_mistakes = CheckUlpGrid<float>(checker, 0.5f, 12.0f, 24.0f);
+	const int naive_double_mistakes = CheckUlpGrid<double>(checker, 1.0f, 0x1p30f, 0x1p31f);
+	CheckNearSegment(checker, 12.0f, 24.0f, 18.0f, 12.0f);
+	CheckNearSegment(checker, -0x1p30f, 0x1p30f, 1.0f, 1024.0f);
+	CheckRandomBatches(checker);
+
+	printf("Segment check %s: %d cases, %d failures (%s kernel); of %d ulp grid points, naive float orientation got %d wrong near the origin, naive double %d far from it\n",
+		checker.GetFailures() == 0 ? "passed" : "FAILED", checker.GetCases(), checker.GetFailures(), segment_kernel::HasAvx() ? "avx" : "sse2",
+		ulp_grid_size * ulp_grid_size, naive_float_mistakes, naive_double_mistakes);
+
+	return checker.GetFailures() == 0;
+}
@@ -0,0 +1,15 @@
+#ifndef SEGMENT_BENCHMARK_HPP
+#define SEGMENT_BENCHMARK_HPP
+
+class Benchmark;
+
+class SegmentBenchmark
+{
+public:
+	static bool Run(Benchmark& benchmark);
+
+	// Degenerate and nearly parallel cases with known answers, then random batches every kernel variant must agree on.
+	static bool Check();
+};
+
+#endif
@@ -0,0 +1,304 @@
+#include "SimulationBenchmark.hpp"
+#include "AllocationTracker.hpp"
+#include "Benchmark.hpp"
+#include "RallyLog.hpp"
+#include "Scalar.hpp"
+#include "Simulation.hpp"
+#include "TickStats.hpp"
+#include "TripleBuffer.hpp"
+
+#include <SDL.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	constexpr std::uint64_t digest_seeds = 16;
+	constexpr std::uint64_t digest_ticks = 60 * 60 * 5;
+	constexpr double tick_stability_seconds = 3.0;
+
+	std::uint64_t HashBytes(std::uint64_t hash, const void* data, std::size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	std::uint64_t HashScalar(std::uint64_t hash, Scalar value)
+	{
+#if PONG_FIXED_POINT
+		return HashBytes(hash, &value.raw_, sizeof(value.raw_));
+#else
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return HashBytes(hash, &bits, sizeof(bits));
+#endif
+	}
+
+	std::uint64_t HashSimulation(std::uint64_t hash, const Simulation& simulation)
+	{
+		const Scalar values[] = 
+		{ 
+			simulation.ball_.rect_.x, simulation.ball_.rect_.y, simulation.ball_.vx_, simulation.ball_.vy_, 
+			simulation.player1_paddle_.rect_.y, simulation.player2_paddle_.rect_.y, 
+			simulation.intersection_point_.x, simulation.intersection_point_.y 
+		};
+
+		for (const Scalar value : values)
+		{
+			hash = HashScalar(hash, value);
+		}
+
+		const int counters[] = { simulation.player1_score_, simulation.player2_score_, simulation.ball_reset_ticks_ };
+
+		return HashBytes(hash, counters, sizeof(counters));
+	}
+}
+
+void SimulationBenchmark::ApplyScriptedInput(Simulation& simulation, std::uint64_t tick)
+{
+	// Player 1 holds a direction for a while, switching every 23 ticks in a pattern that drifts with the tick count.
+	const std::uint64_t phase = (tick / 23) * 2654435761ULL;
+	const int direction = static_cast<int>((phase >> 7) % 3) - 1;
+
+	simulation.player1_paddle_.vy_ = Scalar(10 * direction);
+}
+
+std::uint64_t SimulationBenchmark::Digest()
+{
+	std::uint64_t hash = 14695981039346656037ULL;
+
+	const GameDifficulty difficulties[] = { GameDifficulty::EASY, GameDifficulty::MEDIUM, GameDifficulty::HARD, GameDifficulty::IMPOSSIBLE };
+
+	for (const GameDifficulty difficulty : difficulties)
+	{
+		for (std::uint64_t seed = 1; seed <= digest_seeds; ++seed)
+		{
+			Simulation simulation;
+			simulation.Reset(GameMode::SINGLE_PLAYER, difficulty, seed);
+
+			for (std::uint64_t tick = 0; tick < digest_ticks; ++tick)
+			{
+				ApplyScriptedInput(simulation, tick);
+				simulation.Tick();
+				hash = HashSimulation(hash, simulation);
+			}
+		}
+	}
+
+	return hash;
+}
+
+void SimulationBenchmark::TickRates()
+{
+	constexpr int match_seconds = 5 * 60;
+	constexpr double frame_ms = 1000.0 / 60.0;
+
+	const int tick_rates[] = { 60, 120, 240, 500 };
+	const int substep_counts[] = { 1, 4 };
+
+	printf("%8s %9s %9s %12s %9s %23s %6s\n", "rate", "substeps", "ns/tick", "ticks/s", "headroom", "us per 60 fps frame", "goals");
+
+	for (const int tick_rate : tick_rates)
+	{
+		for (const int substeps : substep_counts)
+		{
+			Simulation simulation;
+			simulation.SetTickRate(tick_rate, substeps);
+			simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 5);
+
+			const std::uint64_t ticks = static_cast<std::uint64_t>(match_seconds) * static_cast<std::uint64_t>(tick_rate);
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			for (std::uint64_t tick = 0; tick < ticks; ++tick)
+			{
+				// The script follows match time, so every rate plays the same inputs.
+				ApplyScriptedInput(simulation, tick * Simulation::reference_tick_rate / static_cast<std::uint64_t>(tick_rate));
+				simulation.Tick();
+			}
+
+			const double elapsed_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			const double tick_ns = elapsed_ns / static_cast<double>(ticks);
+			const double ticks_per_second = 1e9 / tick_ns;
+			const double ticks_per_frame = static_cast<double>(tick_rate) / 60.0;
+
+			printf("%6d Hz %9d %9.0f %12.0f %8.0fx %13.2f (%5.3f%%) %6d\n", tick_rate, substeps, tick_ns, ticks_per_second, ticks_per_second / tick_rate,
+				ticks_per_frame * tick_ns / 1e3, ticks_per_frame * tick_ns / 1e6 / frame_ms * 100.0, simulation.player1_score_ + simulation.player2_score_);
+		}
+	}
+}
+
+bool SimulationBenchmark::AllocationCheck()
+{
+	if (!AllocationTracker::IsEnabled())
+	{
+		printf("%s\n", "The allocation check needs a build with ALLOC_TRACKING=1 (make alloc-check).");
+		return false;
+	}
+
+	constexpr std::uint64_t warmup_ticks = 600;
+	constexpr std::uint64_t checked_ticks = 18000;
+
+	const GameDifficulty difficulties[] = { GameDifficulty::EASY, GameDifficulty::MEDIUM, GameDifficulty::HARD, GameDifficulty::IMPOSSIBLE };
+	Simulation simulation;
+
+	// Matches log their rallies too, as with --rally-dir.
+	RallyLog rally_log;
+
+	if (!rally_log.Open("/dev/null", GameMode::SINGLE_PLAYER, GameDifficulty::EASY, 1, 0, Simulation::reference_tick_rate, 1, 0))
+	{
+		return false;
+	}
+
+	AllocationTracker::SetPhase(AllocationPhase::TICK);
+
+	for (const GameDifficulty difficulty : difficulties)
+	{
+		simulation.Reset(GameMode::SINGLE_PLAYER, difficulty, 1);
+
+		for (std::uint64_t tick = 0; tick < warmup_ticks + checked_ticks; ++tick)
+		{
+			AllocationTracker::SetSteadyState(tick >= warmup_ticks);
+			ApplyScriptedInput(simulation, tick);
+			simulation.Tick();
+			rally_log.Record(simulation);
+			AllocationTracker::CountTick();
+		}
+
+		AllocationTracker::SetSteadyState(false);
+	}
+
+	AllocationTracker::SetPhase(AllocationPhase::OTHER);
+	rally_log.Close();
+	AllocationTracker::PrintReport(stdout);
+
+	const std::uint64_t steady_allocations = AllocationTracker::GetSteadyStateAllocations();
+
+	printf("Allocation check %s: %llu allocations in %llu steady-state ticks\n", steady_allocations == 0 ? "passed" : "FAILED",
+		static_cast<unsigned long long>(steady_allocations), static_cast<unsigned long long>(checked_ticks * 4));
+
+	return steady_allocations == 0;
+}
+
+void SimulationBenchmark::TickStability(int render_stall_ms)
+{
+	const std::uint64_t frequency = SDL_GetPerformanceFrequency();
+	const std::uint64_t period = frequency / 60;
+	const std::uint64_t duration = static_cast<std::uint64_t>(tick_stability_seconds * static_cast<double>(frequency));
+
+	{
+		Simulation simulation;
+		simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 1);
+		TickStats stats;
+
+		const std::uint64_t start = SDL_GetPerformanceCounter();
+		std::uint64_t last_time = start;
+		std::uint64_t delta = 0;
+
+		while (last_time - start < duration)
+		{
+			const std::uint64_t now = SDL_GetPerformanceCounter();
+			delta += now - last_time;
+			last_time = now;
+
+			while (delta >= period)
+			{
+				ApplyScriptedInput(simulation, simulation.tick_count_);
+				simulation.Tick();
+				stats.Record(SDL_GetPerformanceCounter());
+				delta -= period;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(render_stall_ms));
+		}
+
+		stats.PrintReport(stdout, "Ticks on the render loop");
+	}
+
+	{
+		Simulation simulation;
+		simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 1);
+		TickStats stats;
+		TripleBuffer<SimulationSnapshot> snapshots;
+		std::atomic<bool> running(true);
+
+		std::thread simulation_thread([&]()
+			{
+				std::uint64_t next_tick = SDL_GetPerformanceCounter() + period;
+
+				while (running)
+				{
+					const std::uint64_t now = SDL_GetPerformanceCounter();
+
+					if (now < next_tick)
+					{
+						std::this_thread::sleep_for(std::chrono::microseconds((next_tick - now) * 1000000 / frequency));
+						continue;
+					}
+
+					ApplyScriptedInput(simulation, simulation.tick_count_);
+					simulation.Tick();
+					simulation.TakeSnapshot(snapshots.GetWriteBuffer());
+					snapshots.Publish();
+					stats.Record(SDL_GetPerformanceCounter());
+					next_tick += period;
+				}
+			});
+
+		const std::uint64_t start = SDL_GetPerformanceCounter();
+		std::uint64_t frames = 0;
+
+		while (SDL_GetPerformanceCounter() - start < duration)
+		{
+			snapshots.Update();
+			DoNotOptimize(snapshots.GetReadBuffer().ball_rect_);
+			++frames;
+			std::this_thread::sleep_for(std::chrono::milliseconds(render_stall_ms));
+		}
+
+		running = false;
+		simulation_thread.join();
+
+		stats.PrintReport(stdout, "Ticks on a simulation thread");
+		printf("Render loop drew %llu frames from the triple buffer\n", static_cast<unsigned long long>(frames));
+	}
+}
+
+bool SimulationBenchmark::Run(Benchmark& benchmark)
+{
+#if PONG_FIXED_POINT
+	const char* scalar_name = "fixed";
+#else
+	const char* scalar_name = "float";
+#endif
+
+	const GameDifficulty difficulties[] = { GameDifficulty::MEDIUM, GameDifficulty::IMPOSSIBLE };
+	const char* difficulty_names[] = { "medium", "impossible" };
+
+	for (std::size_t i = 0; i < 2; ++i)
+	{
+		Simulation simulation;
+		simulation.Reset(GameMode::SINGLE_PLAYER, difficulties[i], 1);
+		std::uint64_t tick = 0;
+
+		benchmark.Run(std::string("Simulation::Tick/") + scalar_name + "/" + difficulty_names[i], [&]()
+			{
+				ApplyScriptedInput(simulation, tick++);
+				simulation.Tick();
+				DoNotOptimize(simulation.ball_.rect_);
+			});
+	}
+
+	return true;
+}
@@ -0,0 +1,32 @@
+#ifndef SIMULATION_BENCHMARK_HPP
+#define SIMULATION_BENCHMARK_HPP
+
+#include <cstdint>
+
+class Benchmark;
+class Simulation;
+
+class SimulationBenchmark
+{
+public:
+	static bool Run(Benchmark& benchmark);
+
+	// Hash of every tick of a fixed set of scripted, seeded matches. Two builds that print the same digest stayed in lockstep.
+	static std::uint64_t Digest();
+
+	// Runs scripted matches with the allocation tracker watching and fails if any tick after warmup allocates.
+	static bool AllocationCheck();
+
+	// Ticks a match for a few seconds while a stand-in render loop sleeps render_stall_ms per frame, once with
+	// ticks on the render loop as Game::Run does and once on a separate thread, and prints tick timing for both.
+	static void TickStability(int render_stall_ms);
+
+	// Plays five minutes of match time at 60, 120, 240 and 500 Hz, with and without physics sub-steps, as fast as
+	// possible. Prints the cost of a tick, how many times over each rate could be ticked, and the share of a 60 fps
+	// frame the ticks take.
+	static void TickRates();
+
+	static void ApplyScriptedInput(Simulation& simulation, std::uint64_t tick);
+};
+
+#endif
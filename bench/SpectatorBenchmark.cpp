@@ -0,0 +1,268 @@
+#include "SpectatorBenchmark.hpp"
+#include "Simulation.hpp"
+#include "SimulationBenchmark.hpp"
+#include "SpectatorServer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr int load_test_seconds = 5;
+	constexpr int slow_subscriber_interval = 10;
+
+	struct GameThreadCost
+	{
+		std::uint64_t ticks;
+		double cpu_ns_per_tick;
+		double publish_ns_per_tick;
+	};
+
+	double GetCpuTime(clockid_t clock)
+	{
+		timespec time;
+		clock_gettime(clock, &time);
+		return static_cast<double>(time.tv_sec) * 1e9 + static_cast<double>(time.tv_nsec);
+	}
+
+	// Ticks, snapshots and publishes at 60 Hz like the simulation thread does, timing only the ticking thread.
+	GameThreadCost PlayMatch(SpectatorServer& server, SimulationSnapshot& last_snapshot)
+	{
+		Simulation simulation;
+		simulation.Reset(GameMode::SINGLE_PLAYER, GameDifficulty::IMPOSSIBLE, 3);
+
+		const std::uint64_t ticks = static_cast<std::uint64_t>(load_test_seconds) * 60;
+		const std::chrono::steady_clock::duration period = std::chrono::nanoseconds(1000000000 / 60);
+		std::chrono::steady_clock::time_point next_tick = std::chrono::steady_clock::now();
+		double cpu_ns = 0.0;
+		double publish_ns = 0.0;
+
+		for (std::uint64_t tick = 0; tick < ticks; ++tick)
+		{
+			std::this_thread::sleep_until(next_tick);
+			next_tick += period;
+
+			const double cpu_start = GetCpuTime(CLOCK_THREAD_CPUTIME_ID);
+
+			SimulationBenchmark::ApplyScriptedInput(simulation, simulation.tick_count_);
+			simulation.Tick();
+			simulation.TakeSnapshot(last_snapshot);
+
+			const std::chrono::steady_clock::time_point publish_start = std::chrono::steady_clock::now();
+			server.Publish(last_snapshot);
+			publish_ns += static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - publish_start).count());
+
+			cpu_ns += GetCpuTime(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+		}
+
+		return { ticks, cpu_ns / static_cast<double>(ticks), publish_ns / static_cast<double>(ticks) };
+	}
+}
+
+bool SpectatorBenchmark::LoadTest(int subscribers)
+{
+#ifdef __linux__
+	const std::string path = "/tmp/pong-spectator-" + std::to_string(getpid()) + ".sock";
+	SpectatorServer server;
+
+	if (subscribers <= 0 || !server.Open("unix:" + path))
+	{
+		return false;
+	}
+
+	SimulationSnapshot last_snapshot;
+	const GameThreadCost idle = PlayMatch(server, last_snapshot);
+
+	// Subscribers connect blocking, then read non-blocking from one epoll loop on their own thread.
+	std::vector<int> fds;
+
+	for (int i = 0; i < subscribers; ++i)
+	{
+		sockaddr_un socket_address = {};
+		socket_address.sun_family = AF_UNIX;
+		std::memcpy(socket_address.sun_path, path.c_str(), path.size() + 1);
+
+		const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+		if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) != 0)
+		{
+			printf("Unable to connect spectator %d!\n", i);
+
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+
+			break;
+		}
+
+		fds.push_back(fd);
+	}
+
+	const std::chrono::steady_clock::time_point connect_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+	while (server.GetClientCount() < fds.size() && std::chrono::steady_clock::now() < connect_deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	std::atomic<bool> match_over(false);
+	std::atomic<bool> stop(false);
+	std::atomic<std::size_t> converged(0);
+	SpectatorState final_state = {};
+	std::vector<SpectatorState> states(fds.size(), SpectatorState());
+	std::vector<bool> has_state(fds.size(), false);
+	std::uint64_t decode_errors = 0;
+	std::uint64_t messages = 0;
+	double client_cpu_ns = 0.0;
+
+	std::thread client_thread([&]()
+		{
+			const double cpu_start = GetCpuTime(CLOCK_THREAD_CPUTIME_ID);
+			const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+			std::vector<std::vector<std::uint8_t>> buffers(fds.size());
+			std::vector<std::size_t> fill(fds.size(), 0);
+			bool slow_added = false;
+
+			const auto add = [&](std::size_t index)
+			{
+				buffers[index].resize(4096);
+				epoll_event event = {};
+				event.events = EPOLLIN;
+				event.data.u64 = index;
+				epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[index], &event);
+			};
+
+			for (std::size_t index = 0; index < fds.size(); ++index)
+			{
+				if (index % slow_subscriber_interval != slow_subscriber_interval - 1)
+				{
+					add(index);
+				}
+			}
+
+			std::vector<epoll_event> events(64);
+
+			while (!stop)
+			{
+				if (!slow_added && match_over)
+				{
+					for (std::size_t index = slow_subscriber_interval - 1; index < fds.size(); index += slow_subscriber_interval)
+					{
+						add(index);
+					}
+
+					slow_added = true;
+				}
+
+				const int count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), 10);
+
+				for (int i = 0; i < count; ++i)
+				{
+					const std::size_t index = static_cast<std::size_t>(events[i].data.u64);
+					std::vector<std::uint8_t>& buffer = buffers[index];
+					const ssize_t received = recv(fds[index], buffer.data() + fill[index], buffer.size() - fill[index], MSG_DONTWAIT);
+
+					if (received <= 0)
+					{
+						continue;
+					}
+
+					fill[index] += static_cast<std::size_t>(received);
+
+					std::size_t cursor = 0;
+
+					while (cursor < fill[index] && cursor + 1 + buffer[cursor] <= fill[index])
+					{
+						const std::size_t size = buffer[cursor];
+
+						// Only a full state can start a stream.
+						if ((!has_state[index] && (size == 0 || (buffer[cursor + 1] & spectator::full_state_bit) == 0)) ||
+							!spectator::DecodeMessage(buffer.data() + cursor + 1, size, states[index]))
+						{
+							++decode_errors;
+						}
+
+						has_state[index] = true;
+						++messages;
+						cursor += 1 + size;
+					}
+
+					std::memmove(buffer.data(), buffer.data() + cursor, fill[index] - cursor);
+					fill[index] -= cursor;
+				}
+
+				if (slow_added)
+				{
+					std::size_t final_count = 0;
+
+					for (const SpectatorState& state : states)
+					{
+						final_count += (state.tick == final_state.tick && state.fields == final_state.fields) ? 1 : 0;
+					}
+
+					converged = final_count;
+				}
+			}
+
+			close(epoll_fd);
+			client_cpu_ns = GetCpuTime(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+		});
+
+	const double process_cpu_start = GetCpuTime(CLOCK_PROCESS_CPUTIME_ID);
+	const GameThreadCost loaded = PlayMatch(server, last_snapshot);
+	const double game_cpu_ns = loaded.cpu_ns_per_tick * static_cast<double>(loaded.ticks);
+
+	final_state = spectator::Quantize(last_snapshot);
+	match_over = true;
+
+	// Give the slow subscribers time to drain and catch up.
+	const std::chrono::steady_clock::time_point catch_up_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+	while (converged < states.size() && std::chrono::steady_clock::now() < catch_up_deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	stop = true;
+	client_thread.join();
+
+	const double process_cpu_ns = GetCpuTime(CLOCK_PROCESS_CPUTIME_ID) - process_cpu_start;
+
+	for (const int fd : fds)
+	{
+		close(fd);
+	}
+
+	server.Close();
+
+	const double seconds = static_cast<double>(loaded.ticks) / 60.0;
+
+	printf("Ticking thread, no subscribers: %.0f ns CPU per tick, Publish %.0f ns\n", idle.cpu_ns_per_tick, idle.publish_ns_per_tick);
+	printf("Ticking thread, %zu subscribers: %.0f ns CPU per tick, Publish %.0f ns\n", fds.size(), loaded.cpu_ns_per_tick, loaded.publish_ns_per_tick);
+	printf("Server thread: about %.1f ms CPU per second of match (%.2f%% of a core)\n", (process_cpu_ns - game_cpu_ns - client_cpu_ns) / 1e6 / seconds,
+		(process_cpu_ns - game_cpu_ns - client_cpu_ns) / 1e7 / seconds);
+	printf("Subscribers decoded %llu messages, %llu errors; %zu of %zu reached the final state\n", static_cast<unsigned long long>(messages),
+		static_cast<unsigned long long>(decode_errors), converged.load(), states.size());
+
+	return decode_errors == 0 && converged.load() == states.size() && fds.size() == static_cast<std::size_t>(subscribers);
+#else
+	(void)subscribers;
+	printf("%s\n", "The spectator load test needs epoll and is only available on Linux.");
+	return false;
+#endif
+}
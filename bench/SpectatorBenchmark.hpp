@@ -0,0 +1,13 @@
+#ifndef SPECTATOR_BENCHMARK_HPP
+#define SPECTATOR_BENCHMARK_HPP
+
+class SpectatorBenchmark
+{
+public:
+	// Plays a scripted match at 60 Hz through a SpectatorServer with no subscribers, then again with subscribers
+	// connected over a Unix socket, one in ten of which does not read until the match is over. Reports the cost on
+	// the ticking thread and checks that every subscriber ends up with the final state.
+	static bool LoadTest(int subscribers);
+};
+
+#endif
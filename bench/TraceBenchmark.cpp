@@ -0,0 +1,27 @@
+#include "TraceBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "Trace.hpp"
+
+bool TraceBenchmark::Run(Benchmark& benchmark)
+{
+	int counter = 0;
+
+	benchmark.Run("TRACE_ZONE/disabled", [&]()
+		{
+			TRACE_ZONE("TraceBenchmark");
+			DoNotOptimize(++counter);
+		});
+
+	// Once the thread's ring is full further zones are counted as dropped; the clock reads dominate either way.
+	Trace::SetEnabled(true);
+
+	benchmark.Run("TRACE_ZONE/enabled", [&]()
+		{
+			TRACE_ZONE("TraceBenchmark");
+			DoNotOptimize(++counter);
+		});
+
+	Trace::SetEnabled(false);
+
+	return true;
+}
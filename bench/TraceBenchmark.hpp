@@ -0,0 +1,12 @@
+#ifndef TRACE_BENCHMARK_HPP
+#define TRACE_BENCHMARK_HPP
+
+class Benchmark;
+
+class TraceBenchmark
+{
+public:
+	static bool Run(Benchmark& benchmark);
+};
+
+#endif
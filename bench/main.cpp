@@ -0,0 +1,191 @@
+#include "AiBenchmark.hpp"
+#include "ArenaBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "ChecksumBenchmark.hpp"
+#include "EnvBenchmark.hpp"
+#include "InputBenchmark.hpp"
+#include "MenuBenchmark.hpp"
+#include "ObstacleBenchmark.hpp"
+#include "PhysicsBenchmark.hpp"
+#include "RallyLogBenchmark.hpp"
+#include "ReplayBenchmark.hpp"
+#include "SegmentBenchmark.hpp"
+#include "SimulationBenchmark.hpp"
+#include "SpectatorBenchmark.hpp"
+#include "TraceBenchmark.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+	std::size_t warmup_samples = 100;
+	std::size_t samples = 1000;
+	std::string filter;
+	const char* json_path = nullptr;
+	bool digest = false;
+	bool alloc_check = false;
+	int render_stall_ms = -1;
+	int input_stall_ms = -1;
+	int spectators = 0;
+	bool tick_rates = false;
+	bool segment_check = false;
+	bool ai_budget = false;
+	const char* ai_plugin_path = nullptr;
+	int ai_budget_us = 1000;
+	const char* checksum_path = nullptr;
+	std::uint64_t checksum_perturb_tick = 0;
+	const char* rally_log_path = nullptr;
+	std::uint64_t rally_log_rallies = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+		{
+			warmup_samples = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+		{
+			samples = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			json_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--digest") == 0)
+		{
+			digest = true;
+		}
+		else if (std::strcmp(argv[i], "--alloc-check") == 0)
+		{
+			alloc_check = true;
+		}
+		else if (std::strcmp(argv[i], "--tick-stability") == 0 && i + 1 < argc)
+		{
+			render_stall_ms = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--input-latency") == 0 && i + 1 < argc)
+		{
+			input_stall_ms = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--ai-budget") == 0 && i + 1 < argc)
+		{
+			ai_budget = true;
+			ai_budget_us = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--ai") == 0 && i + 1 < argc)
+		{
+			ai_budget = true;
+			ai_plugin_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--tick-rates") == 0)
+		{
+			tick_rates = true;
+		}
+		else if (std::strcmp(argv[i], "--segment-check") == 0)
+		{
+			segment_check = true;
+		}
+		else if (std::strcmp(argv[i], "--checksums") == 0 && i + 1 < argc)
+		{
+			checksum_path = argv[++i];
+
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				checksum_perturb_tick = std::strtoull(argv[++i], nullptr, 10);
+			}
+		}
+		else if (std::strcmp(argv[i], "--rally-log") == 0 && i + 2 < argc)
+		{
+			rally_log_path = argv[++i];
+			rally_log_rallies = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--spectator-load") == 0 && i + 1 < argc)
+		{
+			spectators = std::atoi(argv[++i]);
+		}
+		else
+		{
+			printf("Usage: %s [--warmup N] [--samples N] [--filter SUBSTRING] [--json PATH] [--digest] [--alloc-check] [--tick-stability STALL_MS] [--input-latency STALL_MS] [--tick-rates] [--segment-check] [--spectator-load SUBSCRIBERS] [--ai PLUGIN] [--ai-budget US] [--rally-log PATH RALLIES] [--checksums PATH [PERTURB_TICK]]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (digest)
+	{
+		printf("%016llx\n", static_cast<unsigned long long>(SimulationBenchmark::Digest()));
+		return 0;
+	}
+
+	if (alloc_check)
+	{
+		return SimulationBenchmark::AllocationCheck() ? 0 : 1;
+	}
+
+	if (render_stall_ms >= 0)
+	{
+		SimulationBenchmark::TickStability(render_stall_ms);
+		return 0;
+	}
+
+	if (input_stall_ms >= 0)
+	{
+		InputBenchmark::Latency(input_stall_ms);
+		return 0;
+	}
+
+	if (tick_rates)
+	{
+		SimulationBenchmark::TickRates();
+		return 0;
+	}
+
+	if (segment_check)
+	{
+		return SegmentBenchmark::Check() ? 0 : 1;
+	}
+
+	if (ai_budget)
+	{
+		return AiBenchmark::Budget(ai_plugin_path, ai_budget_us) ? 0 : 1;
+	}
+
+	if (checksum_path != nullptr)
+	{
+		return ChecksumBenchmark::Write(checksum_path, checksum_perturb_tick) ? 0 : 1;
+	}
+
+	if (rally_log_path != nullptr)
+	{
+		return RallyLogBenchmark::Generate(rally_log_path, rally_log_rallies) ? 0 : 1;
+	}
+
+	if (spectators > 0)
+	{
+		return SpectatorBenchmark::LoadTest(spectators) ? 0 : 1;
+	}
+
+	Benchmark benchmark(warmup_samples, samples, filter);
+	Benchmark::PrintHeader();
+
+	if (!PhysicsBenchmark::Run(benchmark) || !SimulationBenchmark::Run(benchmark) || !EnvBenchmark::Run(benchmark) || !TraceBenchmark::Run(benchmark) || !ArenaBenchmark::Run(benchmark) || !ReplayBenchmark::Run(benchmark) ||
+		!SegmentBenchmark::Run(benchmark) || !ObstacleBenchmark::Run(benchmark) || !RallyLogBenchmark::Run(benchmark) ||
+		!ChecksumBenchmark::Run(benchmark) || !InputBenchmark::Run(benchmark) || !MenuBenchmark::Run(benchmark))
+	{
+		return 1;
+	}
+
+	if (json_path != nullptr && !benchmark.WriteJson(json_path))
+	{
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include "PongEnv.h"
+#include "Constants.hpp"
+#include "Scalar.hpp"
+#include "Simulation.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace
+{
+	constexpr float max_ball_speed = 15.0f;
+
+	GameDifficulty ToGameDifficulty(int difficulty)
+	{
+		switch (difficulty)
+		{
+		case PONG_ENV_DIFFICULTY_EASY:
+			return GameDifficulty::EASY;
+		case PONG_ENV_DIFFICULTY_HARD:
+			return GameDifficulty::HARD;
+		case PONG_ENV_DIFFICULTY_IMPOSSIBLE:
+			return GameDifficulty::IMPOSSIBLE;
+		default:
+			return GameDifficulty::MEDIUM;
+		}
+	}
+}
+
+struct PongEnv
+{
+	int num_envs;
+	GameDifficulty difficulty;
+	int max_score;
+
+	// Simulations are never moved once created since each ball points back at its own simulation.
+	std::unique_ptr<Simulation[]> simulations;
+	std::unique_ptr<std::uint64_t[]> seeds;
+	std::unique_ptr<std::uint64_t[]> episodes;
+
+	float* observations;
+	float* rewards;
+	std::uint8_t* dones;
+
+	void ResetOne(int index)
+	{
+		// Consecutive episodes of one env get seeds that never collide with another env's.
+		const std::uint64_t seed = seeds[index] + episodes[index] * static_cast<std::uint64_t>(num_envs);
+		simulations[index].Reset(GameMode::SINGLE_PLAYER, difficulty, seed);
+		++episodes[index];
+	}
+
+	void WriteObservation(int index)
+	{
+		const Simulation& simulation = simulations[index];
+		float* observation = observations + static_cast<std::size_t>(index) * PONG_ENV_OBSERVATION_SIZE;
+
+		constexpr float width = static_cast<float>(constants::screen_width);
+		constexpr float height = static_cast<float>(constants::screen_height);
+
+		observation[0] = static_cast<float>(simulation.ball_.rect_.x) / width;
+		observation[1] = static_cast<float>(simulation.ball_.rect_.y) / height;
+		observation[2] = static_cast<float>(simulation.ball_.vx_) / max_ball_speed;
+		observation[3] = static_cast<float>(simulation.ball_.vy_) / max_ball_speed;
+		observation[4] = static_cast<float>(simulation.player1_paddle_.rect_.y) / height;
+		observation[5] = static_cast<float>(simulation.player2_paddle_.rect_.y) / height;
+		observation[6] = static_cast<float>(simulation.intersection_point_.y) / height;
+		observation[7] = simulation.ball_resetting_ ? 1.0f : 0.0f;
+	}
+};
+
+PongEnv* pong_env_create(int num_envs, int difficulty, int max_score, float* observations, float* rewards, uint8_t* dones)
+{
+	if (num_envs <= 0 || max_score <= 0 || observations == nullptr || rewards == nullptr || dones == nullptr)
+	{
+		return nullptr;
+	}
+
+	PongEnv* env = new PongEnv();
+	env->num_envs = num_envs;
+	env->difficulty = ToGameDifficulty(difficulty);
+	env->max_score = max_score;
+	env->simulations = std::make_unique<Simulation[]>(num_envs);
+	env->seeds = std::make_unique<std::uint64_t[]>(num_envs);
+	env->episodes = std::make_unique<std::uint64_t[]>(num_envs);
+	env->observations = observations;
+	env->rewards = rewards;
+	env->dones = dones;
+
+	pong_env_reset(env, 0);
+
+	return env;
+}
+
+void pong_env_destroy(PongEnv* env)
+{
+	delete env;
+}
+
+int pong_env_num_envs(const PongEnv* env)
+{
+	return env->num_envs;
+}
+
+void pong_env_reset(PongEnv* env, uint64_t seed)
+{
+	for (int i = 0; i < env->num_envs; ++i)
+	{
+		env->seeds[i] = seed + static_cast<std::uint64_t>(i);
+		env->episodes[i] = 0;
+		env->ResetOne(i);
+		env->WriteObservation(i);
+		env->rewards[i] = 0.0f;
+		env->dones[i] = 0;
+	}
+}
+
+void pong_env_step(PongEnv* env, const int32_t* actions)
+{
+	for (int i = 0; i < env->num_envs; ++i)
+	{
+		Simulation& simulation = env->simulations[i];
+
+		if (actions[i] == PONG_ENV_ACTION_UP)
+		{
+			simulation.player1_paddle_.vy_ = Scalar(-Paddle::speed);
+		}
+		else if (actions[i] == PONG_ENV_ACTION_DOWN)
+		{
+			simulation.player1_paddle_.vy_ = Scalar(Paddle::speed);
+		}
+		else
+		{
+			simulation.player1_paddle_.vy_ = Scalar(0);
+		}
+
+		const int player1_score = simulation.player1_score_;
+		const int player2_score = simulation.player2_score_;
+
+		simulation.Tick();
+
+		env->rewards[i] = static_cast<float>((simulation.player1_score_ - player1_score) - (simulation.player2_score_ - player2_score));
+		env->dones[i] = simulation.player1_score_ >= env->max_score || simulation.player2_score_ >= env->max_score;
+
+		if (env->dones[i])
+		{
+			env->ResetOne(i);
+		}
+
+		env->WriteObservation(i);
+	}
+}
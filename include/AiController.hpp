@@ -0,0 +1,96 @@
+#ifndef AI_CONTROLLER_HPP
+#define AI_CONTROLLER_HPP
+
+#include "Game.hpp"
+#include "Scalar.hpp"
+#include "Utility.hpp"
+
+#include <cstdint>
+
+class Arena;
+
+enum class BallDirectionChange
+{
+	SERVE, PADDLE_HIT, WALL_BOUNCE, OBSTACLE_BOUNCE
+};
+
+// The match as a controller sees it, from the side of the paddle it drives. Always a copy, so a controller can only
+// affect the match through what it returns.
+struct AiView
+{
+	std::uint64_t tick_;
+
+	Rect ball_rect_;
+	Scalar ball_vx_;
+	Scalar ball_vy_;
+	Line ball_direction_ray_;
+
+	// Where the ball's current direction ray leaves the field; unset while the ray starts outside of it.
+	bool has_ball_edge_crossing_;
+	Vec2 ball_edge_crossing_;
+
+	Rect paddle_rect_;
+	Rect opponent_paddle_rect_;
+	int score_;
+	int opponent_score_;
+
+	// Between a goal and the next serve.
+	bool serving_;
+
+	// The fastest the paddle may move, from the difficulty's tuning.
+	Scalar max_speed_;
+
+	// What the controller aimed at last.
+	Vec2 target_;
+
+	// The field's static obstacles; shared and never changing, so a view may point at it.
+	const Arena* arena_;
+};
+
+struct AiCommand
+{
+	Scalar paddle_vy_;
+	Vec2 target_;
+};
+
+// Drives the single-player opponent (player 2).
+class AiController
+{
+public:
+	virtual ~AiController() = default;
+
+	virtual const char* GetName() const = 0;
+
+	// Called from within the tick whenever the ball changes direction, with the view after the change. Returns what
+	// to aim at from now on.
+	virtual Vec2 Aim(const AiView& view, BallDirectionChange change) = 0;
+
+	// Called once per tick while the ball is in play, after the ball moved.
+	virtual AiCommand Tick(const AiView& view) = 0;
+};
+
+// EASY to HARD: heads for where the ball's current path leaves the field, re-aiming on every bounce. Built-in
+// controllers keep no state of their own, so one instance serves every simulation and replays reproduce them.
+class ChaseAiController : public AiController
+{
+public:
+	const char* GetName() const override;
+
+	Vec2 Aim(const AiView& view, BallDirectionChange change) override;
+
+	AiCommand Tick(const AiView& view) override;
+};
+
+// IMPOSSIBLE: on every serve and paddle hit, follows the ball's path through all its wall and obstacle bounces to
+// the goal line.
+class PredictingAiController : public ChaseAiController
+{
+public:
+	const char* GetName() const override;
+
+	Vec2 Aim(const AiView& view, BallDirectionChange change) override;
+};
+
+AiController* GetBuiltinAiController(GameDifficulty game_difficulty);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef AI_HOST_HPP
+#define AI_HOST_HPP
+
+#include "AiController.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// Runs one controller against a per-tick time budget and keeps its timings. A trusted controller runs inline on the
+// ticking thread: it is timed, and ticks over budget are counted. An isolated one runs on a thread of its own; a
+// tick it has not answered by the deadline is played with its latest command, and it gets no new ticks until the
+// late one returns, so no controller can hold up the match. A late answer is then used from the next tick on.
+class AiHost : public AiController
+{
+private:
+	AiController* controller_;
+	// The last started controller's name; the report outlives Stop, which lets go of the controller.
+	const char* name_;
+	std::chrono::microseconds budget_;
+	bool isolated_;
+
+	std::thread worker_thread_;
+	std::mutex mutex_;
+	std::condition_variable request_ready_;
+	std::condition_variable response_ready_;
+	bool running_;
+	std::uint64_t request_sequence_;
+	std::uint64_t response_sequence_;
+	AiView request_;
+	AiCommand response_;
+
+	// The latest answer the match has used, and which request it answered.
+	AiCommand last_command_;
+	std::uint64_t last_command_sequence_;
+
+	std::uint64_t ticks_;
+	std::uint64_t over_budget_ticks_;
+	std::uint64_t fallback_ticks_;
+	std::chrono::nanoseconds total_time_;
+	std::chrono::nanoseconds max_time_;
+
+	void WorkerLoop();
+
+	// For a tick without an answer in time. Called with mutex_ held.
+	AiCommand GetLatestCommand(const AiView& view);
+
+	void RecordTime(std::chrono::nanoseconds time);
+
+public:
+	AiHost();
+
+	~AiHost() override;
+
+	void Start(AiController& controller, int budget_us, bool isolated);
+
+	// Waits for an isolated controller to return from a late tick and lets go of the controller; its timings stay
+	// for PrintReport until the next Start.
+	void Stop();
+
+	bool IsStarted() const;
+
+	const char* GetName() const override;
+
+	Vec2 Aim(const AiView& view, BallDirectionChange change) override;
+
+	AiCommand Tick(const AiView& view) override;
+
+	void PrintReport(FILE* file) const;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef AI_PLUGIN_HPP
+#define AI_PLUGIN_HPP
+
+#include "AiController.hpp"
+#include "PongAi.h"
+
+#include <string>
+
+// An AI controller loaded from a shared library through PongAi.h. Plugins only see whole ticks: they are never
+// called from within one, so Aim keeps the current target and the plugin aims in its Tick.
+class AiPlugin : public AiController
+{
+private:
+	void* library_;
+	const PongAiController* controller_;
+	void* state_;
+	std::string name_;
+
+public:
+	AiPlugin();
+
+	~AiPlugin() override;
+
+	bool Open(const std::string& path);
+
+	void Close();
+
+	// Starts the plugin over with a fresh instance, for a new match.
+	void Restart();
+
+	const char* GetName() const override;
+
+	Vec2 Aim(const AiView& view, BallDirectionChange change) override;
+
+	AiCommand Tick(const AiView& view) override;
+};
+
+#endif
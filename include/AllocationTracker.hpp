@@ -0,0 +1,42 @@
+#ifndef ALLOCATION_TRACKER_HPP
+#define ALLOCATION_TRACKER_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+// Build with ALLOC_TRACKING=1 (-DPONG_ALLOC_TRACKING=1) to replace the global operator new/delete and SDL's
+// allocator with counting versions. Otherwise every call here is a no-op and nothing is replaced.
+#ifndef PONG_ALLOC_TRACKING
+#define PONG_ALLOC_TRACKING 0
+#endif
+
+enum class AllocationPhase
+{
+	OTHER, TICK, RENDER, COUNT
+};
+
+// Counts heap allocations per call site (a short backtrace) and per phase of the game loop. Phase and steady state
+// are per thread: only the thread that declares a steady state has its allocations held against it.
+class AllocationTracker
+{
+public:
+	static bool IsEnabled();
+
+	// Routes SDL_malloc and friends through the tracker; must run before SDL allocates anything.
+	static void HookSdl();
+
+	static void SetPhase(AllocationPhase phase);
+
+	static void CountTick();
+
+	static void CountFrame();
+
+	// Allocations made by this thread while its steady state is on are expected to be zero.
+	static void SetSteadyState(bool steady_state);
+
+	static std::uint64_t GetSteadyStateAllocations();
+
+	static void PrintReport(FILE* file);
+};
+
+#endif
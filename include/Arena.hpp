@@ -0,0 +1,146 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include "Scalar.hpp"
+#include "Utility.hpp"
+
+#if !PONG_FIXED_POINT
+#include "SegmentKernel.hpp"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ObstacleType
+{
+	SEGMENT, BOX
+};
+
+// Axis-aligned bounds, edges included.
+struct Bounds
+{
+	Scalar min_x;
+	Scalar min_y;
+	Scalar max_x;
+	Scalar max_y;
+};
+
+// A segment from a_ to b_, or a box with a_ as its top-left and b_ as its bottom-right corner.
+struct Obstacle
+{
+	ObstacleType type_;
+	Vec2 a_;
+	Vec2 b_;
+};
+
+struct ArenaHit
+{
+	std::int32_t obstacle_;
+	Vec2 point_;
+
+	// Perpendicular to the surface that was hit; not normalized.
+	Vec2 normal_;
+};
+
+// Static obstacles inside the playfield, loaded from a text file with one obstacle per line:
+//   segment X1 Y1 X2 Y2
+//   box X Y WIDTH HEIGHT
+// and # starting a comment. Loading builds a bounding volume hierarchy over them, so the ball's collision test and
+// the AI's ray casts only visit the few obstacles near them, however many the arena has. The field's edges are not
+// obstacles; Simulation handles them as before. An arena does not change once built, so any number of simulations
+// on any threads can share one.
+class Arena
+{
+private:
+	// A leaf holds count_ obstacles from first_or_right_ on. An inner node has count_ 0, its left child right after
+	// it and its right child at first_or_right_.
+	struct Node
+	{
+		Bounds bounds_;
+		std::uint32_t first_or_right_;
+		std::uint32_t count_;
+	};
+
+	static constexpr std::size_t max_leaf_obstacles = 4;
+	static constexpr std::size_t max_depth = 64;
+
+	std::string name_;
+
+	// In leaf order once built, so every leaf is one contiguous run.
+	std::vector<Obstacle> obstacles_;
+	std::vector<Node> nodes_;
+	std::uint64_t hash_;
+
+#if !PONG_FIXED_POINT
+	// Every edge of a leaf's obstacles, in obstacle order and a box's sides clockwise from the top, for the segment
+	// kernel; with the obstacle and outward normal of each edge. Indexed like nodes_; inner nodes keep theirs empty.
+	struct LeafEdges
+	{
+		SegmentBatch segments_;
+		std::vector<std::int32_t> obstacles_;
+		std::vector<Vec2> normals_;
+	};
+
+	std::vector<LeafEdges> leaf_edges_;
+
+	void BuildLeafEdges();
+#endif
+
+	std::uint32_t BuildNode(std::size_t begin, std::size_t end);
+
+	// Tests the ray against the leaf's obstacles one edge at a time, keeping a hit nearer than best_t.
+	void CastRayThroughLeaf(const Node& node, const Vec2& start, const Vec2& direction, std::int32_t ignore, bool& found, Scalar& best_t,
+		ArenaHit& hit) const;
+
+	bool Parse(const std::string& path, const std::string& text);
+
+public:
+	static constexpr std::size_t max_obstacles = 1 << 20;
+
+	Arena();
+
+	// The arena of the original game, for simulations nobody gave an arena.
+	static const Arena& GetEmpty();
+
+	// Replaces the obstacles with the file's and builds the hierarchy; on any error the arena is left empty.
+	bool Load(const std::string& path);
+
+	void Clear();
+
+	void AddSegment(const Vec2& a, const Vec2& b);
+
+	void AddBox(const Rect& box);
+
+	// Call once after adding obstacles directly; Load does it itself.
+	void Build();
+
+	bool IsEmpty() const;
+
+	const std::string& GetName() const;
+
+	std::size_t GetObstacleCount() const;
+
+	const Obstacle& GetObstacle(std::int32_t index) const;
+
+	std::size_t GetNodeCount() const;
+
+	// FNV-1a over the obstacles as the simulation sees them; 0 without obstacles. Replays use it to tell whether they
+	// are played in the arena they were recorded in.
+	std::uint64_t GetHash() const;
+
+	// The first obstacle overlapping rect, or -1. Touching does not count, as with the paddles.
+	std::int32_t FindOverlap(const Rect& rect) const;
+
+	// The obstacle ray reaches first, skipping the one at index ignore (the one a reflected ray starts from). Float
+	// builds test a leaf's edges with segment_kernel::FindNearestHit, except the leaf holding ignore; fixed point
+	// tests them one at a time in Scalar.
+	bool CastRay(const Line& ray, std::int32_t ignore, ArenaHit& hit) const;
+
+	static Bounds GetBounds(const Obstacle& obstacle);
+
+	static bool Overlaps(const Obstacle& obstacle, const Rect& rect);
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef AUDIO_HPP
+#define AUDIO_HPP
+
+#include "MpmcQueue.hpp"
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class Sound
+{
+	BUTTON_CLICK, PADDLE_HIT, WALL_BOUNCE, GOAL, COUNT
+};
+
+// Owns SDL_mixer and every sound the game plays. Sounds are synthesized into one PCM block when the mixer opens,
+// so nothing is decoded or generated later. Any thread may Post a sound; posts go through a lock-free queue
+// and are started on the game thread by Update, so gameplay code never touches the mixer or waits on its lock.
+class Audio
+{
+private:
+	static std::unique_ptr<Audio> audio_;
+
+	static constexpr int channel_count = 16;
+	static constexpr std::size_t queue_capacity = 64;
+	static constexpr std::size_t paddle_hit_variants = 16;
+	static constexpr std::size_t max_chunks = 32;
+
+	struct SoundEvent
+	{
+		std::size_t chunk;
+		std::uint64_t posted_counter;
+	};
+
+	// Post reads it on whichever thread posts.
+	std::atomic<bool> opened_;
+	int frequency_;
+	int channels_;
+	int buffer_size_;
+
+	std::vector<Sint16> pcm_;
+	std::array<Mix_Chunk*, max_chunks> chunks_;
+	std::size_t chunk_count_;
+	std::array<std::size_t, static_cast<std::size_t>(Sound::COUNT)> first_chunk_;
+	std::uint64_t synthesis_us_;
+
+	MpmcQueue<SoundEvent, queue_capacity> events_;
+	std::atomic<std::uint64_t> dropped_events_;
+
+	// Event-to-mix latency: the post time of the sound last started on each channel, consumed by the first mix that
+	// plays it.
+	std::array<std::atomic<std::uint64_t>, channel_count> channel_posted_counter_;
+	std::atomic<std::uint64_t> latency_samples_;
+	std::atomic<std::uint64_t> latency_total_us_;
+	std::atomic<std::uint64_t> latency_max_us_;
+
+	// Mix callback time, from the music hook that starts each mix to the post-mix hook that ends it.
+	std::atomic<std::uint64_t> callback_start_counter_;
+	std::atomic<std::uint64_t> callback_samples_;
+	std::atomic<std::uint64_t> callback_total_ns_;
+	std::atomic<std::uint64_t> callback_max_ns_;
+
+	void SynthesizeSounds();
+
+	static void BeginMix(void* user_data, Uint8* stream, int length);
+
+	static void EndMix(void* user_data, Uint8* stream, int length);
+
+	static void ChannelDone(int channel);
+
+	// Called with the mixer lock held, once channel has been mixed.
+	void RecordLatency(int channel, std::uint64_t now);
+
+public:
+	Audio();
+
+	~Audio();
+
+	static Audio* Instance();
+
+	bool Open(int buffer_size);
+
+	void Close();
+
+	// angle is the paddle reflection angle (45 to 135 degrees); a steeper bounce plays a higher blip.
+	void Post(Sound sound, int angle = 90);
+
+	void Update();
+
+	void PrintReport() const;
+};
+
+#endif
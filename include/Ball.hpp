@@ -1,28 +1,37 @@
 #ifndef BALL_HPP
 #define BALL_HPP
 
+#include "Scalar.hpp"
 #include "Utility.hpp"
 
 #include <SDL.h>
 
 class Game;
 class Paddle;
+class Simulation;
 
 class Ball
 {
 public:
 	Game* game_;	
-	SDL_FRect rect_;
+	Simulation* simulation_;
+	Rect rect_;
 	Line direction_ray_;
-	float vx_;
-	float vy_;
+	Scalar vx_;
+	Scalar vy_;
 
 	Ball();
 
 	void HandleEvent(SDL_Event* e);
 
+	// Moves the ball through one tick in Simulation::physics_substeps_ equal steps, colliding after each.
 	void Tick();
 
+	void Step(Scalar time_step);
+
+	// Bounces the ball off the first obstacle the step of dx, dy swept over.
+	void StepObstacles(Scalar dx, Scalar dy);
+
 	void Render();
 
 	bool CheckForCollision();
@@ -31,7 +40,9 @@ public:
 
 	void Reset();
 
-	SDL_FPoint GetRotatedPoint(const SDL_FPoint& point, const SDL_FPoint& pivot, int degrees);
+	void UpdateDirectionRay();
+
+	Vec2 GetRotatedPoint(const Vec2& point, const Vec2& pivot, int degrees);
 };
 
 #endif
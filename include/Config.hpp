@@ -0,0 +1,54 @@
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include "Tuning.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads Tuning from a "key = value" file and, on Linux, reloads it from a background inotify thread whenever
+// the file is saved. Each reload is parsed into a new immutable Tuning that is published with one atomic
+// pointer store, so readers check for changes with a single load and never parse, lock or see a half-written value.
+class Config
+{
+private:
+	static std::unique_ptr<Config> config_;
+
+	std::string path_;
+
+	// Every Tuning ever published stays alive until the Config is destroyed: a reader may still hold an older
+	// pointer, and a few dozen bytes per edit is cheaper than reclaiming them safely.
+	std::vector<std::unique_ptr<const Tuning>> published_;
+	std::atomic<const Tuning*> current_;
+
+	std::atomic<bool> watching_;
+	std::thread watcher_thread_;
+
+	bool Parse(const std::string& text, Tuning& tuning) const;
+
+	bool Reload();
+
+	void WatchLoop(int inotify_fd);
+
+public:
+	Config();
+
+	~Config();
+
+	static Config* Instance();
+
+	// A missing file keeps the defaults; the file is still watched so it can be created later.
+	bool Load(const std::string& path);
+
+	void StartWatching();
+
+	void StopWatching();
+
+	const Tuning* GetTuning() const;
+};
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef FIXED_HPP
+#define FIXED_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+__extension__ typedef __int128 FixedWide;
+
+// Signed fixed-point number with 16 fractional bits. Products and quotients go through 128-bit intermediates,
+// so every operation is plain integer math and gives the same bits on every compiler, optimization level and CPU.
+class Fixed
+{
+public:
+	static constexpr int fractional_bits = 16;
+	static constexpr std::int64_t one = std::int64_t(1) << fractional_bits;
+
+	std::int64_t raw_;
+
+	constexpr Fixed() : raw_(0)
+	{
+	}
+
+	constexpr Fixed(int value) : raw_(static_cast<std::int64_t>(value) * one)
+	{
+	}
+
+	// Only meant for compile-time constants such as 0.05f; conversions of computed floats would bring the drift back.
+	constexpr explicit Fixed(float value) : raw_(static_cast<std::int64_t>(static_cast<double>(value) * one))
+	{
+	}
+
+	constexpr explicit Fixed(double value) : raw_(static_cast<std::int64_t>(value * one))
+	{
+	}
+
+	static constexpr Fixed FromRaw(std::int64_t raw)
+	{
+		Fixed result;
+		result.raw_ = raw;
+		return result;
+	}
+
+	constexpr explicit operator int() const
+	{
+		return static_cast<int>(raw_ / one);
+	}
+
+	constexpr explicit operator float() const
+	{
+		return static_cast<float>(raw_) / static_cast<float>(one);
+	}
+
+	constexpr explicit operator double() const
+	{
+		return static_cast<double>(raw_) / static_cast<double>(one);
+	}
+
+	constexpr Fixed operator-() const
+	{
+		return FromRaw(-raw_);
+	}
+
+	constexpr Fixed& operator+=(Fixed other)
+	{
+		raw_ += other.raw_;
+		return *this;
+	}
+
+	constexpr Fixed& operator-=(Fixed other)
+	{
+		raw_ -= other.raw_;
+		return *this;
+	}
+
+	constexpr Fixed& operator*=(Fixed other)
+	{
+		raw_ = static_cast<std::int64_t>((static_cast<FixedWide>(raw_) * other.raw_) >> fractional_bits);
+		return *this;
+	}
+
+	constexpr Fixed& operator/=(Fixed other)
+	{
+		raw_ = static_cast<std::int64_t>((static_cast<FixedWide>(raw_) * one) / other.raw_);
+		return *this;
+	}
+
+	friend constexpr Fixed operator+(Fixed a, Fixed b)
+	{
+		return a += b;
+	}
+
+	friend constexpr Fixed operator-(Fixed a, Fixed b)
+	{
+		return a -= b;
+	}
+
+	friend constexpr Fixed operator*(Fixed a, Fixed b)
+	{
+		return a *= b;
+	}
+
+	friend constexpr Fixed operator/(Fixed a, Fixed b)
+	{
+		return a /= b;
+	}
+
+	friend constexpr bool operator==(Fixed a, Fixed b)
+	{
+		return a.raw_ == b.raw_;
+	}
+
+	friend constexpr bool operator!=(Fixed a, Fixed b)
+	{
+		return a.raw_ != b.raw_;
+	}
+
+	friend constexpr bool operator<(Fixed a, Fixed b)
+	{
+		return a.raw_ < b.raw_;
+	}
+
+	friend constexpr bool operator>(Fixed a, Fixed b)
+	{
+		return a.raw_ > b.raw_;
+	}
+
+	friend constexpr bool operator<=(Fixed a, Fixed b)
+	{
+		return a.raw_ <= b.raw_;
+	}
+
+	friend constexpr bool operator>=(Fixed a, Fixed b)
+	{
+		return a.raw_ >= b.raw_;
+	}
+};
+
+namespace std
+{
+	template <>
+	class numeric_limits<Fixed>
+	{
+	public:
+		static constexpr bool is_specialized = true;
+		static constexpr bool is_exact = true;
+
+		static constexpr Fixed min()
+		{
+			return Fixed::FromRaw(1);
+		}
+
+		static constexpr Fixed max()
+		{
+			return Fixed::FromRaw(numeric_limits<std::int64_t>::max());
+		}
+
+		static constexpr Fixed lowest()
+		{
+			return Fixed::FromRaw(numeric_limits<std::int64_t>::lowest());
+		}
+
+		static constexpr Fixed epsilon()
+		{
+			return Fixed::FromRaw(1);
+		}
+	};
+} // namespace std
+
+// sin(0..90 degrees) rounded to the nearest 1/65536, enough for the whole-degree angles the ball bounces at.
+inline constexpr std::array<std::int64_t, 91> fixed_quarter_sine =
+{
+	0, 1144, 2287, 3430, 4572, 5712, 6850, 7987, 9121, 10252, 11380, 12505, 13626, 14742, 15855, 16962,
+	18064, 19161, 20252, 21336, 22415, 23486, 24550, 25607, 26656, 27697, 28729, 29753, 30767, 31772, 32768,
+	33754, 34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243, 42126, 42995, 43852, 44695, 45525, 46341,
+	47143, 47930, 48703, 49461, 50203, 50931, 51643, 52339, 53020, 53684, 54332, 54963, 55578, 56175, 56756,
+	57319, 57865, 58393, 58903, 59396, 59870, 60326, 60764, 61183, 61584, 61966, 62328, 62672, 62997, 63303,
+	63589, 63856, 64104, 64332, 64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446, 65496, 65526, 65536
+};
+
+inline constexpr Fixed FixedSinDegrees(int degrees)
+{
+	degrees %= 360;
+
+	if (degrees < 0)
+	{
+		degrees += 360;
+	}
+
+	if (degrees <= 90)
+	{
+		return Fixed::FromRaw(fixed_quarter_sine[degrees]);
+	}
+	else if (degrees <= 180)
+	{
+		return Fixed::FromRaw(fixed_quarter_sine[180 - degrees]);
+	}
+	else if (degrees <= 270)
+	{
+		return Fixed::FromRaw(-fixed_quarter_sine[degrees - 180]);
+	}
+
+	return Fixed::FromRaw(-fixed_quarter_sine[360 - degrees]);
+}
+
+inline constexpr Fixed FixedCosDegrees(int degrees)
+{
+	return FixedSinDegrees(degrees + 90);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+
+// Bump allocator for data that lives no longer than one frame. Allocation moves an offset, deallocation does
+// nothing and Reset() at the frame boundary frees everything at once. As a std::pmr::memory_resource it backs
+// std::pmr containers directly; requests that do not fit go to the upstream resource and are counted, so the
+// high-water mark shows how big the arena needs to be.
+class FrameArena : public std::pmr::memory_resource
+{
+private:
+	std::unique_ptr<std::byte[]> buffer_;
+	std::size_t capacity_;
+	std::size_t offset_;
+	std::pmr::memory_resource* upstream_;
+
+	// Bytes handed out by upstream and not yet returned; they count towards the high-water mark.
+	std::size_t overflow_bytes_;
+	std::size_t high_water_mark_;
+	std::uint64_t overflow_allocations_;
+	std::uint64_t resets_;
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+	explicit FrameArena(std::size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+	FrameArena(const FrameArena&) = delete;
+
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Everything allocated since the last reset is gone; containers using the arena must not outlive this.
+	void Reset();
+
+	std::size_t GetCapacity() const;
+
+	std::size_t GetUsed() const;
+
+	std::size_t GetHighWaterMark() const;
+
+	std::uint64_t GetOverflowAllocations() const;
+
+	void PrintReport(FILE* file, const char* name) const;
+};
+
+#endif
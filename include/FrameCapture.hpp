@@ -0,0 +1,83 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include "SpscQueue.hpp"
+
+#include <SDL.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Header written in front of every frame, little-endian. Pixels follow as width * height tightly packed RGBA bytes.
+// Every frame carries its own size, which changes when the window is resized during the capture.
+struct FrameHeader
+{
+	char magic[4];
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t frame_number;
+	std::uint64_t timestamp_ns;
+	std::uint64_t dropped_frames;
+};
+
+// Reads every presented frame back into a fixed pool of buffers and streams them to a file or stdout from a writer
+// thread. The game loop never waits for the writer: when no buffer is free the frame is dropped and counted.
+class FrameCapture
+{
+private:
+	static constexpr std::size_t max_buffers = 8;
+
+	struct FrameBuffer
+	{
+		FrameHeader header;
+		std::vector<std::uint8_t> pixels;
+	};
+
+	FILE* file_;
+	bool owns_file_;
+
+	// The renderer output size of the last captured frame.
+	int width_;
+	int height_;
+
+	std::vector<FrameBuffer> buffers_;
+	SpscQueue<std::size_t, max_buffers> free_buffers_;
+	SpscQueue<std::size_t, max_buffers> filled_buffers_;
+
+	std::thread writer_thread_;
+	std::mutex writer_mutex_;
+	std::condition_variable writer_wakeup_;
+	std::atomic<bool> running_;
+
+	std::uint32_t frame_number_;
+	std::uint64_t dropped_frames_;
+	std::atomic<std::uint64_t> written_frames_;
+	std::atomic<bool> write_failed_;
+
+	void WriterLoop();
+
+	bool WriteFrame(const FrameBuffer& buffer);
+
+public:
+	FrameCapture();
+
+	~FrameCapture();
+
+	bool Open(const char* path, int width, int height, std::size_t buffer_count = 4);
+
+	void Close();
+
+	void Capture(SDL_Renderer* renderer);
+
+	std::uint64_t GetDroppedFrames() const;
+
+	std::uint64_t GetWrittenFrames() const;
+};
+
+#endif
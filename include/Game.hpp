@@ -1,7 +1,12 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
+#include "Arena.hpp"
 #include "Texture.hpp"
+#include "FrameArena.hpp"
+#include "FrameCapture.hpp"
+#include "ResolutionScaler.hpp"
+#include "Tuning.hpp"
 
 #include <SDL.h>
 #include <SDL_ttf.h>
@@ -9,8 +14,11 @@
 
 #include <memory>
 #include <stack>
+#include <string>
 
+class AiPlugin;
 class GameState;
+class SpectatorServer;
 
 enum class GameMode
 {
@@ -22,11 +30,78 @@ enum class GameDifficulty
 	EASY, MEDIUM, HARD, IMPOSSIBLE
 };
 
+struct GameOptions
+{
+	// Mixer buffer in sample frames; 512 at 44.1 kHz is about 12 ms against SDL_mixer's usual 2048 (46 ms).
+	int audio_buffer_size = 512;
+
+	// Tuning file, reloaded live when it changes.
+	std::string config_path = "res/pong.cfg";
+
+	// Frame time the dynamic resolution controller aims for; 0 renders straight to the window at full resolution.
+	float frame_budget_ms = 16.0f;
+
+	// Prints frame, tick and render scale statistics every second, plus every render scale decision.
+	bool telemetry = false;
+
+	// Where F9 (or exiting while tracing) writes the Chrome trace; trace_at_startup records from the first frame.
+	std::string trace_path = "trace.json";
+	bool trace_at_startup = false;
+
+	// Runs the match on its own thread at a steady rate; the game loop then only draws the latest snapshot.
+	bool simulation_thread = true;
+
+	// Ticks per second. The match plays at the same pace at any rate; higher rates respond sooner and collide finer.
+	int tick_rate = 60;
+
+	// Collision steps per ball tick.
+	int physics_substeps = 1;
+
+	// Applies paddle keys in HandleEvents as before instead of from the input queue, for latency comparisons.
+	bool legacy_input = false;
+
+	// Every match is recorded into this directory; empty records nothing.
+	std::string replay_dir = "replays";
+
+	// Every match, live or played back, saves the checksums and states of its last ticks here on exit, for
+	// desync_check; empty saves nothing.
+	std::string checksum_path;
+
+	// Every live match logs its rallies into this directory for rally_stats; empty logs nothing.
+	std::string rally_dir;
+
+	// Plays this replay instead of showing the menus.
+	std::string replay_path;
+
+	// "unix:PATH", "HOST:PORT" or "PORT" to stream every match to spectators; empty runs no server.
+	std::string spectator_address;
+
+	// Shared library driving the single-player opponent instead of the built-in AI for the chosen difficulty.
+	std::string ai_plugin_path;
+
+	// Time an AI controller may take per tick. A plugin that has not answered by then loses the tick.
+	int ai_budget_us = 1000;
+
+	// Obstacles every match is played with; empty plays on the open field.
+	std::string arena_path;
+
+	// Sleeps this long in every Render to stand in for slow render work such as a texture upload. Input is pumped
+	// every millisecond of it, as between the steps of real work.
+	int render_stall_ms = 0;
+};
+
 class Game
 {
 private:
 	bool initialized_;
 	bool running_;
+	GameOptions options_;
+	const Tuning* applied_tuning_;
+	bool trace_toggle_requested_;
+
+	void ApplyWindowTuning();
+
+	void ToggleTracing();
 
 public:
 	SDL_Window* window_;
@@ -35,8 +110,20 @@ public:
 	GameMode game_mode_;
 	GameDifficulty game_difficulty_;
 	std::stack<GameState*> states_;
+	std::unique_ptr<FrameCapture> frame_capture_;
+	std::unique_ptr<ResolutionScaler> resolution_scaler_;
+	std::unique_ptr<SpectatorServer> spectator_server_;
+	std::unique_ptr<AiPlugin> ai_plugin_;
+	Arena arena_;
+
+	// Every fixed image and label, packed at build time; see res/atlas.txt and AtlasSprites.hpp for the sprites.
+	Texture atlas_;
 
-	Game();
+	// Scratch memory for events, ticks and rendering of the current frame; reset at the top of every frame.
+	static constexpr std::size_t frame_arena_size = 64 * 1024;
+	FrameArena frame_arena_;
+
+	Game(const GameOptions& options = GameOptions());
 
 	~Game();
 
@@ -48,6 +135,10 @@ public:
 
 	void Stop();
 
+	bool StartFrameCapture(const char* path);
+
+	const GameOptions& GetOptions() const;
+
 	void ChangeState(GameState* state);
 	
 	void PushState(GameState* state);
@@ -0,0 +1,187 @@
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+#include "SpscQueue.hpp"
+
+#include <SDL.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+// What keys and clicks mean to the game, one bit each in an InputFrame's masks; see ActionBit.
+enum class InputAction
+{
+	QUIT, BACK, CLICK, TOGGLE_TRACE, TOGGLE_TRAJECTORY, PLAYBACK_PAUSE, PLAYBACK_SPEED, SEEK_BACK, SEEK_FORWARD, SEEK_START,
+	PLAYER1_UP, PLAYER1_DOWN, PLAYER2_UP, PLAYER2_DOWN
+};
+
+constexpr std::uint32_t ActionBit(InputAction action)
+{
+	return std::uint32_t(1) << static_cast<int>(action);
+}
+
+// Kinds of events a state can do without. Events of a kind the active state does not ask for are dropped by the SDL
+// event filter before they are queued; keyboard, window and quit events always go through, since SDL and the
+// event watches depend on them.
+namespace input_events
+{
+	// Mouse motion; a fast mouse sends hundreds of these per frame.
+	constexpr std::uint32_t pointer = 1 << 0;
+
+	// Mouse buttons and the wheel.
+	constexpr std::uint32_t buttons = 1 << 1;
+
+	// Text input and editing, which SDL sends alongside key presses while text input is on, as it is by default.
+	constexpr std::uint32_t text = 1 << 2;
+
+	// Fingers and gestures; SDL reports touches as mouse events as well.
+	constexpr std::uint32_t touch = 1 << 3;
+}
+
+// One frame's events, reduced to what the states read. Built by Input::Poll and handed to the active state.
+struct InputFrame
+{
+	// Actions whose key went down, auto-repeated or went up this frame, and those whose key is down at its end.
+	std::uint32_t pressed_;
+	std::uint32_t repeated_;
+	std::uint32_t released_;
+	std::uint32_t held_;
+
+	// Set when the mouse moved; the position is the last one, in window pixels.
+	bool pointer_moved_;
+	int pointer_x_;
+	int pointer_y_;
+
+	// Where the last click of the frame was released, in window pixels; see InputAction::CLICK.
+	int click_x_;
+	int click_y_;
+
+	// Events polled for this frame.
+	std::uint32_t events_;
+
+	bool WasPressed(InputAction action) const
+	{
+		return (pressed_ & ActionBit(action)) != 0;
+	}
+
+	bool WasPressedOrRepeated(InputAction action) const
+	{
+		return ((pressed_ | repeated_) & ActionBit(action)) != 0;
+	}
+
+	bool WasReleased(InputAction action) const
+	{
+		return (released_ & ActionBit(action)) != 0;
+	}
+
+	bool IsHeld(InputAction action) const
+	{
+		return (held_ & ActionBit(action)) != 0;
+	}
+};
+
+// A paddle key press or release, already translated from the SDL event. direction_ is -1 (up), 1 (down) or 0 (stop).
+struct PaddleCommand
+{
+	int player_;
+	int direction_;
+
+	// SDL_GetPerformanceCounter() when SDL queued the key event.
+	std::uint64_t timestamp_;
+};
+
+// The one place SDL events are read. Game polls once per frame into an InputFrame for the active state, with an
+// SDL event filter dropping the kinds of events that state does not want before they are queued. Keys become
+// actions through a table indexed by scancode, built from the keyboard layout.
+// Paddle keys are also turned into timestamped commands inside an SDL event watch, so they are captured the moment
+// SDL pumps them, whichever state happens to be polling. Commands go through an SPSC ring: the pumping thread
+// produces and the gameplay tick consumes, so the simulation never depends on when a state gets around to
+// HandleEvents. A watch only runs while events are pumped, so Game::Render pumps through a long frame as well (see
+// Pump); otherwise a key would wait for the next Poll however soon the simulation thread ticks.
+class Input
+{
+private:
+	static std::unique_ptr<Input> input_;
+
+	static constexpr std::size_t queue_capacity = 256;
+
+	bool opened_;
+	std::array<std::uint32_t, SDL_NUM_SCANCODES> key_actions_;
+	std::uint32_t held_actions_;
+	std::atomic<std::uint32_t> wanted_events_;
+
+	// The filter runs on any thread that pushes events, but the kinds it drops are only pushed while pumping, so
+	// the pumping thread alone writes the count.
+	std::atomic<std::uint64_t> events_dropped_;
+	std::uint64_t events_dispatched_;
+
+	std::atomic<bool> capturing_;
+	SpscQueue<PaddleCommand, queue_capacity> commands_;
+	std::atomic<std::uint64_t> dropped_commands_;
+
+	// Event-to-tick latency, recorded by the consumer only.
+	std::uint64_t latency_samples_;
+	std::uint64_t latency_total_us_;
+	std::uint64_t latency_max_us_;
+
+	static int EventFilter(void* user_data, SDL_Event* e);
+
+	static int EventWatch(void* user_data, SDL_Event* e);
+
+public:
+	Input();
+
+	~Input();
+
+	static Input* Instance();
+
+	void Open();
+
+	void Close();
+
+	// Rebuilds the key table for the current keyboard layout. Open and layout changes call it.
+	void MapKeys();
+
+	std::uint32_t GetKeyActions(SDL_Scancode scancode) const;
+
+	// Kinds of events (input_events) the active state wants from the next pump on.
+	void SetWantedEvents(std::uint32_t wanted_events);
+
+	// Whether the filter lets e through to the queue.
+	bool Filter(const SDL_Event& e);
+
+	// Empties the event queue into frame.
+	void Poll(InputFrame& frame);
+
+	// While paddle keys are captured, pumps SDL's events so the watch turns new keys into commands now. The events
+	// stay queued for the next Poll. Main thread only, like Poll.
+	void Pump();
+
+	// Poll's steps, for feeding events that do not come from the queue.
+	void BeginFrame(InputFrame& frame);
+
+	void Dispatch(const SDL_Event& e, InputFrame& frame);
+
+	void EndFrame(InputFrame& frame);
+
+	// What the event watch does with each event SDL queues: a paddle key becomes a command stamped now.
+	void Watch(const SDL_Event& e);
+
+	// Only gameplay wants paddle commands; while capture is off, key events are ignored.
+	void SetCapturing(bool capturing);
+
+	// Discards commands queued for a match that is no longer running.
+	void Clear();
+
+	bool TryPop(PaddleCommand& command);
+
+	// Called by the tick that first simulates with command.
+	void RecordApplied(const PaddleCommand& command);
+
+	void PrintReport(FILE* file) const;
+};
+
+#endif
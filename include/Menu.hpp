@@ -0,0 +1,87 @@
+#ifndef MENU_HPP
+#define MENU_HPP
+
+#include "Input.hpp"
+
+#include <SDL.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class Game;
+
+enum class WidgetState
+{
+	NORMAL, HOVER, DISABLED, COUNT
+};
+
+// A label from the atlas; clickable_ ones are buttons. bounds_ is in logical playfield coordinates.
+struct MenuWidget
+{
+	SDL_Rect sprite_;
+	SDL_Rect bounds_;
+	float scale_;
+	bool clickable_;
+	WidgetState state_;
+};
+
+// The widgets of a menu, laid out once when they are added and kept for as long as the menu lives. The pointer is
+// hit-tested with the frame's coordinates through a grid over the playfield whose cells hold a bitmask of the buttons
+// overlapping them, so a test looks at one cell and only the buttons in it. Every state of a widget draws the same
+// atlas sprite with its own precomputed tint, so hovering changes an index and draws nothing new.
+class Menu
+{
+private:
+	static constexpr int cell_size = 32;
+	static constexpr int grid_columns = 30;
+	static constexpr int grid_rows = 23;
+	static constexpr std::size_t max_widgets = 32;
+
+	Game* game_;
+	std::vector<MenuWidget> widgets_;
+	std::array<std::uint32_t, grid_columns * grid_rows> cells_;
+	int hovered_;
+	// The last pointer position seen, in logical coordinates, so enabling a button under it can hover it.
+	SDL_Point pointer_;
+
+	int AddWidget(const SDL_Rect& sprite, int center_x, int y, float scale, bool clickable);
+
+	void SetHovered(int id);
+
+	// Moves the hover to what is under the point and keeps the point for later state changes.
+	void MovePointer(const SDL_Point& point);
+
+	// The pointer's window position in logical coordinates.
+	SDL_Point ToLogical(int window_x, int window_y) const;
+
+public:
+	static constexpr int none = -1;
+
+	explicit Menu(Game* game);
+
+	// Adds a button centred on center_x with its top at y and returns its id; ids count up from 0 in the order
+	// widgets are added.
+	int AddButton(const SDL_Rect& sprite, int center_x, int y);
+
+	// Adds a label that is drawn but never hit.
+	int AddLabel(const SDL_Rect& sprite, int center_x, int y, float scale = 1.0f);
+
+	// Re-hovers from the last pointer position, so a button enabled under a resting pointer lights up at once.
+	void SetEnabled(int id, bool enabled);
+
+	const MenuWidget& GetWidget(int id) const;
+
+	// The enabled button at the logical point, or none.
+	int HitTest(int x, int y) const;
+
+	// Hovers whatever is under the mouse now, for Enter and Resume, before any motion has come in.
+	void SyncPointer();
+
+	// Moves the hover with the frame's pointer and returns the button clicked this frame, or none.
+	int HandleInput(const InputFrame& input);
+
+	void Render();
+};
+
+#endif
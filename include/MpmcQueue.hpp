@@ -0,0 +1,107 @@
+#ifndef MPMC_QUEUE_HPP
+#define MPMC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue (Vyukov's sequenced ring) that any number of threads may push to and pop from.
+// TryPush fails when the queue is full and TryPop fails when it is empty; neither ever blocks.
+template <typename T, std::size_t Capacity>
+class MpmcQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MpmcQueue capacity must be a power of two");
+
+private:
+	static constexpr std::size_t cache_line_size = 64;
+
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		T item;
+	};
+
+	std::array<Cell, Capacity> cells_;
+	alignas(cache_line_size) std::atomic<std::size_t> enqueue_position_;
+	alignas(cache_line_size) std::atomic<std::size_t> dequeue_position_;
+
+public:
+	MpmcQueue() : enqueue_position_(0), dequeue_position_(0)
+	{
+		for (std::size_t i = 0; i < Capacity; ++i)
+		{
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool TryPush(const T& item)
+	{
+		std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &cells_[position & (Capacity - 1)];
+			const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+			if (difference == 0)
+			{
+				if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = enqueue_position_.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->item = item;
+		cell->sequence.store(position + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	bool TryPop(T& item)
+	{
+		std::size_t position = dequeue_position_.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &cells_[position & (Capacity - 1)];
+			const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+
+			if (difference == 0)
+			{
+				if (dequeue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = dequeue_position_.load(std::memory_order_relaxed);
+			}
+		}
+
+		item = cell->item;
+		cell->sequence.store(position + Capacity, std::memory_order_release);
+
+		return true;
+	}
+};
+
+#endif
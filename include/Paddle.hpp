@@ -1,6 +1,8 @@
 #ifndef PADDLE_HPP
 #define PADDLE_HPP
 
+#include "Scalar.hpp"
+
 #include <SDL.h>
 
 class Game;
@@ -8,15 +10,19 @@ class Game;
 class Paddle
 {
 public:
+	// How fast a player's paddle moves, in pixels per 1/60 s like vy_.
+	static constexpr int speed = 10;
+
 	Game* game_;	
-	SDL_FRect rect_;
-	float vy_;
+	Rect rect_;
+	Scalar vy_;
 
 	Paddle();
 
 	void HandleEvent(SDL_Event* e);
 
-	void Tick();
+	// time_step is the fraction of a 60 Hz tick this tick covers; vy_ is in pixels per 1/60 s.
+	void Tick(Scalar time_step);
 
 	void Render();
 };
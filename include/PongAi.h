@@ -0,0 +1,83 @@
+#ifndef PONG_AI_H
+#define PONG_AI_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * AI controller plugins. A plugin is a shared library exporting pong_ai_controller(), loaded with `--ai PATH`; it
+ * drives player 2 (the left paddle) in single player. tick is called once per tick while the ball is in play, on
+ * the plugin's own thread, and must fill in the command within the budget given by `--ai-budget US`. A tick that
+ * misses it is played with the previous command, and the plugin gets no new ticks until the late one returns.
+ * The returned velocity is clamped to max_speed.
+ */
+
+#define PONG_AI_ABI_VERSION 1
+
+typedef struct PongAiView
+{
+	uint64_t tick;
+	float field_width;
+	float field_height;
+
+	float ball_x;
+	float ball_y;
+	float ball_size;
+	float ball_vx;
+	float ball_vy;
+
+	/* Where the ball's current path leaves the field; valid only if has_ball_edge_crossing is set. */
+	int32_t has_ball_edge_crossing;
+	float ball_edge_crossing_x;
+	float ball_edge_crossing_y;
+
+	/* Paddles as rectangles: top left corner, width, height. */
+	float paddle_x;
+	float paddle_y;
+	float paddle_width;
+	float paddle_height;
+	float opponent_paddle_x;
+	float opponent_paddle_y;
+	float opponent_paddle_width;
+	float opponent_paddle_height;
+
+	int32_t score;
+	int32_t opponent_score;
+	float max_speed;
+
+	/* The target of the previous command. */
+	float target_x;
+	float target_y;
+} PongAiView;
+
+typedef struct PongAiCommand
+{
+	/* Paddle velocity in pixels per 1/60 s at any tick rate, like every speed in the view; negative is up. */
+	float paddle_vy;
+
+	/* Where the paddle is heading, drawn by the debug overlay. */
+	float target_x;
+	float target_y;
+} PongAiCommand;
+
+typedef struct PongAiController
+{
+	uint32_t abi_version;
+	const char* name;
+
+	/* One instance per match; state is passed back to tick and destroy. */
+	void* (*create)(void);
+	void (*destroy)(void* state);
+	void (*tick)(void* state, const PongAiView* view, PongAiCommand* command);
+} PongAiController;
+
+const PongAiController* pong_ai_controller(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
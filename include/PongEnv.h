@@ -0,0 +1,60 @@
+#ifndef PONG_ENV_H
+#define PONG_ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Batched, Gym-style environment over the game's single-player simulation. The agent controls player 1 (the right
+ * paddle) against the built-in AI. All buffers are owned by the caller and must stay valid and in place for the
+ * lifetime of the environment; observations, rewards and dones are written straight into them on every reset and
+ * step, so nothing is allocated or copied per step.
+ */
+
+#define PONG_ENV_OBSERVATION_SIZE 8
+
+enum PongEnvAction
+{
+	PONG_ENV_ACTION_STAY = 0,
+	PONG_ENV_ACTION_UP = 1,
+	PONG_ENV_ACTION_DOWN = 2
+};
+
+enum PongEnvDifficulty
+{
+	PONG_ENV_DIFFICULTY_EASY = 0,
+	PONG_ENV_DIFFICULTY_MEDIUM = 1,
+	PONG_ENV_DIFFICULTY_HARD = 2,
+	PONG_ENV_DIFFICULTY_IMPOSSIBLE = 3
+};
+
+typedef struct PongEnv PongEnv;
+
+/*
+ * observations: num_envs * PONG_ENV_OBSERVATION_SIZE floats, laid out env by env:
+ *   ball x, ball y, ball vx, ball vy, own paddle y, opponent paddle y, predicted intersection y, serving flag.
+ *   Positions are normalized to [0, 1] by the field size and velocities by the ball's maximum speed.
+ * rewards: num_envs floats, +1 when the agent scores and -1 when the AI scores on that step.
+ * dones: num_envs bytes, set when an episode ends (either side reaching max_score); that env is then reset in place.
+ */
+PongEnv* pong_env_create(int num_envs, int difficulty, int max_score, float* observations, float* rewards, uint8_t* dones);
+
+void pong_env_destroy(PongEnv* env);
+
+int pong_env_num_envs(const PongEnv* env);
+
+/* Resets every env; env i is seeded with seed + i. */
+void pong_env_reset(PongEnv* env, uint64_t seed);
+
+/* actions: num_envs values of PongEnvAction. */
+void pong_env_step(PongEnv* env, const int32_t* actions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
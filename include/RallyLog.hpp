@@ -0,0 +1,198 @@
+#ifndef RALLY_LOG_HPP
+#define RALLY_LOG_HPP
+
+#include "Game.hpp"
+#include "SpscQueue.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Simulation;
+
+// Rally analytics files, in native byte order:
+//   RallyLogHeader
+//   blocks, each a RallyLogBlockHeader followed by its rows column by column, padded to a multiple of 8 bytes
+// Every paddle hit is a row of the hit table and every goal a row of the rally table; hits carry the number of their
+// rally, so the two join on it. Both tables have five 4-byte columns and one 1-byte column, in this order:
+//   hits:    rally, tick (since the serve), position (0 top to 1 bottom of the paddle), speed, ai_error, player
+//   rallies: rally, hits, ticks (serve to goal), max_speed, ai_error, scorer
+// Speeds are in pixels per 1/60 s. ai_error is in pixels, signed, and NaN where the AI was not involved.
+struct RallyLogHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint64_t seed;
+	std::uint8_t game_mode;
+	std::uint8_t game_difficulty;
+	std::uint8_t fixed_point;
+	std::uint8_t physics_substeps;
+	std::uint32_t tick_rate;
+	std::uint64_t arena_hash;
+};
+
+enum class RallyLogTable : std::uint32_t
+{
+	HITS, RALLIES
+};
+
+struct RallyLogBlockHeader
+{
+	RallyLogTable table;
+	std::uint32_t rows;
+};
+
+namespace rally_log
+{
+	constexpr std::size_t column_count = 6;
+	constexpr std::array<std::size_t, column_count> column_sizes = { 4, 4, 4, 4, 4, 1 };
+
+	// Hit table columns.
+	constexpr std::size_t hit_rally = 0;
+	constexpr std::size_t hit_tick = 1;
+	constexpr std::size_t hit_position = 2;
+	constexpr std::size_t hit_speed = 3;
+	constexpr std::size_t hit_ai_error = 4;
+	constexpr std::size_t hit_player = 5;
+
+	// Rally table columns.
+	constexpr std::size_t rally_rally = 0;
+	constexpr std::size_t rally_hits = 1;
+	constexpr std::size_t rally_ticks = 2;
+	constexpr std::size_t rally_max_speed = 3;
+	constexpr std::size_t rally_ai_error = 4;
+	constexpr std::size_t rally_scorer = 5;
+
+	// Bytes a block of rows takes on disk, its header included.
+	std::size_t GetBlockSize(std::uint32_t rows);
+}
+
+// Records the rallies of a match from the simulation's events. Rows go into preallocated column blocks on the
+// ticking thread and full blocks are written by a writer thread, so recording never waits on the disk and never
+// allocates. When no block is free the rows are dropped and counted, as FrameCapture drops frames.
+class RallyLog
+{
+private:
+	static constexpr std::size_t max_blocks = 8;
+	static constexpr std::size_t no_block = max_blocks;
+
+	struct Block
+	{
+		RallyLogTable table;
+		std::uint32_t rows;
+
+		// Column c starts at block_rows_ * 4 * c.
+		std::vector<unsigned char> data;
+	};
+
+	FILE* file_;
+	std::uint32_t block_rows_;
+
+	std::vector<Block> blocks_;
+	SpscQueue<std::size_t, max_blocks> free_blocks_;
+	SpscQueue<std::size_t, max_blocks> filled_blocks_;
+
+	// The block each table is filling, or no_block.
+	std::array<std::size_t, 2> current_blocks_;
+
+	std::thread writer_thread_;
+	std::mutex writer_mutex_;
+	std::condition_variable writer_wakeup_;
+	std::atomic<bool> running_;
+	std::atomic<bool> write_failed_;
+
+	// The rally being played.
+	std::uint32_t rally_;
+	std::uint32_t rally_hits_;
+	std::uint64_t rally_start_tick_;
+	float rally_max_speed_;
+
+	std::uint64_t hit_rows_;
+	std::uint64_t dropped_rows_;
+
+	// A row of the table's current block, or null when there is no block to put it in.
+	unsigned char* AddRow(RallyLogTable table, std::uint32_t& row);
+
+	void SetUint32(unsigned char* data, std::size_t column, std::uint32_t row, std::uint32_t value) const;
+
+	void SetFloat(unsigned char* data, std::size_t column, std::uint32_t row, float value) const;
+
+	void Submit(RallyLogTable table);
+
+	void WriterLoop();
+
+	bool WriteBlock(const Block& block);
+
+public:
+	static constexpr std::uint32_t default_block_rows = 4096;
+
+	RallyLog();
+
+	~RallyLog();
+
+	// The first rally starts at tick_count.
+	bool Open(const char* path, GameMode game_mode, GameDifficulty game_difficulty, std::uint64_t seed, std::uint64_t tick_count,
+		int tick_rate, int physics_substeps, std::uint64_t arena_hash, std::uint32_t block_rows = default_block_rows);
+
+	// Writes the rows recorded so far; the rally in progress is not logged.
+	void Close();
+
+	bool IsOpen() const;
+
+	// Call after every Simulation::Tick; logs the paddle hits and goals among its events.
+	void Record(const Simulation& simulation);
+
+	void RecordHit(std::uint64_t tick, int player, float position, float speed, float ai_error);
+
+	void RecordGoal(std::uint64_t tick, int scorer, float speed, float ai_error);
+
+	void RecordServe(std::uint64_t tick);
+
+	std::uint64_t GetDroppedRows() const;
+};
+
+// A block of a mapped rally log. Columns are aligned for their type, so they can be read in place.
+struct RallyLogBlock
+{
+	RallyLogTable table_;
+	std::uint32_t rows_;
+	std::array<const unsigned char*, rally_log::column_count> columns_;
+
+	const std::uint32_t* GetUint32(std::size_t column) const;
+
+	const float* GetFloat(std::size_t column) const;
+
+	const std::uint8_t* GetUint8(std::size_t column) const;
+};
+
+// Reads a rally log by memory-mapping it and walking its blocks.
+class RallyLogReader
+{
+private:
+	const unsigned char* data_;
+	std::size_t size_;
+	std::size_t cursor_;
+	RallyLogHeader header_;
+
+public:
+	RallyLogReader();
+
+	~RallyLogReader();
+
+	bool Open(const char* path);
+
+	void Close();
+
+	const RallyLogHeader& GetHeader() const;
+
+	// False at the end of the file, and at a block cut short by a crash.
+	bool Next(RallyLogBlock& block);
+};
+
+#endif
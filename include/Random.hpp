@@ -0,0 +1,51 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include "Scalar.hpp"
+
+#include <cstdint>
+
+// PCG32 generator. Unlike std::rand its sequence is fixed by the seed alone, so seeded matches replay identically.
+class Random
+{
+public:
+	std::uint64_t state_;
+	std::uint64_t increment_;
+
+	explicit Random(std::uint64_t seed = 0)
+	{
+		Seed(seed);
+	}
+
+	void Seed(std::uint64_t seed)
+	{
+		state_ = 0;
+		increment_ = (seed << 1u) | 1u;
+		Next();
+		state_ += seed;
+		Next();
+	}
+
+	std::uint32_t Next()
+	{
+		const std::uint64_t old_state = state_;
+		state_ = old_state * 6364136223846793005ULL + increment_;
+
+		const std::uint32_t xor_shifted = static_cast<std::uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+		const std::uint32_t rotation = static_cast<std::uint32_t>(old_state >> 59u);
+
+		return (xor_shifted >> rotation) | (xor_shifted << ((-rotation) & 31u));
+	}
+
+	// Uniform value in [0, 1).
+	Scalar NextUnit()
+	{
+#if PONG_FIXED_POINT
+		return Fixed::FromRaw(Next() & (Fixed::one - 1));
+#else
+		return static_cast<float>(Next() >> 8) / static_cast<float>(1u << 24);
+#endif
+	}
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include "Game.hpp"
+#include "Simulation.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Replay files, in native byte order:
+//   ReplayHeader
+//   for every keyframe: a SimulationState, then the input changes up to the next keyframe
+//   ReplayIndexEntry for every keyframe
+// An input change is the tick distance from the keyframe or the previous change as an unsigned LEB128, followed by
+// the velocities of both paddles as int8. Only ticks where a player-controlled paddle changed velocity are stored;
+// everything else, the AI included, follows from the seed. Keyframes come every keyframe_interval ticks, and also
+// whenever live tuning changed the simulation in a way the inputs cannot reproduce.
+struct ReplayHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint64_t seed;
+	std::uint8_t game_mode;
+	std::uint8_t game_difficulty;
+	std::uint8_t fixed_point;
+	std::uint8_t physics_substeps;
+	std::uint32_t state_size;
+	std::uint32_t keyframe_interval;
+	std::uint32_t tick_rate;
+	std::uint64_t tick_count;
+	std::uint64_t keyframe_count;
+	std::uint64_t index_offset;
+
+	// Arena::GetHash of the arena the match was played in; 0 on the open field.
+	std::uint64_t arena_hash;
+};
+
+struct ReplayIndexEntry
+{
+	std::uint64_t tick;
+	std::uint64_t offset;
+};
+
+// Records a match as it is played. Record is called once per tick, right before Simulation::Tick.
+class ReplayWriter
+{
+private:
+	FILE* file_;
+	ReplayHeader header_;
+	std::vector<ReplayIndexEntry> index_;
+	std::uint64_t offset_;
+	std::uint64_t last_change_tick_;
+	int player1_vy_;
+	int player2_vy_;
+	bool keyframe_requested_;
+	bool write_failed_;
+
+	void Write(const void* data, std::size_t size);
+
+public:
+	static constexpr std::uint32_t default_keyframe_interval = 600;
+
+	ReplayWriter();
+
+	~ReplayWriter();
+
+	bool Open(const char* path, GameMode game_mode, GameDifficulty game_difficulty, std::uint64_t seed, int tick_rate = Simulation::reference_tick_rate,
+		int physics_substeps = 1, std::uint64_t arena_hash = 0, std::uint32_t keyframe_interval = default_keyframe_interval);
+
+	// Writes the index and the final header; a replay that was never closed cannot be played.
+	bool Close();
+
+	bool IsOpen() const;
+
+	void Record(const Simulation& simulation);
+
+	// The next Record writes a full keyframe regardless of the interval.
+	void RequestKeyframe();
+
+	std::uint64_t GetSize() const;
+};
+
+// Plays a replay file through a Simulation. The file is memory-mapped, so opening is instant and seeking only
+// touches the keyframe it starts from and the inputs after it.
+class ReplayReader
+{
+private:
+	const unsigned char* data_;
+	std::size_t size_;
+	ReplayHeader header_;
+
+	// Playback position: the keyframe chunk being read, the next unread input change, and where the chunk ends.
+	std::uint64_t chunk_;
+	std::size_t cursor_;
+	std::size_t chunk_end_;
+	bool has_change_;
+	std::uint64_t change_tick_;
+	int change_player1_vy_;
+	int change_player2_vy_;
+
+	ReplayIndexEntry GetIndexEntry(std::uint64_t keyframe) const;
+
+	void LoadKeyframe(Simulation& simulation, std::uint64_t keyframe);
+
+	void ReadChange();
+
+public:
+	ReplayReader();
+
+	~ReplayReader();
+
+	bool Open(const char* path);
+
+	void Close();
+
+	bool IsOpen() const;
+
+	const ReplayHeader& GetHeader() const;
+
+	GameMode GetGameMode() const;
+
+	GameDifficulty GetGameDifficulty() const;
+
+	int GetTickRate() const;
+
+	// Puts simulation at tick (clamped to the end): loads the last keyframe at or before it and steps the rest.
+	void Seek(Simulation& simulation, std::uint64_t tick);
+
+	// Applies the inputs recorded for the simulation's current tick and ticks it once; false at the end.
+	bool Step(Simulation& simulation);
+};
+
+#endif
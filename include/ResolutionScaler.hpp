@@ -0,0 +1,57 @@
+#ifndef RESOLUTION_SCALER_HPP
+#define RESOLUTION_SCALER_HPP
+
+#include <SDL.h>
+
+// Renders each frame into an offscreen target at a fraction of the logical resolution and stretches it over
+// the window on present. The fraction follows a smoothed frame time: it steps down while frames run over the
+// budget and back up once there is clear headroom, so fill-rate bound software renderers keep their frame rate.
+class ResolutionScaler
+{
+private:
+	SDL_Renderer* renderer_;
+	SDL_Texture* target_;
+	int width_;
+	int height_;
+	float budget_ms_;
+	bool log_decisions_;
+
+	float scale_;
+	float average_frame_ms_;
+	int frames_since_change_;
+	int scale_changes_;
+
+	SDL_Rect GetScaledRect() const;
+
+	void SetScale(float scale, const char* reason);
+
+public:
+	static constexpr float min_scale = 0.25f;
+	static constexpr float scale_step = 0.125f;
+
+	ResolutionScaler();
+
+	~ResolutionScaler();
+
+	bool Open(SDL_Renderer* renderer, int width, int height, float budget_ms, bool log_decisions);
+
+	void Close();
+
+	// Redirects drawing into the target; between these two calls states draw in logical coordinates as usual.
+	void BeginFrame();
+
+	void EndFrame();
+
+	// Feeds the controller with the time of the frame just presented.
+	void Update(float frame_ms);
+
+	float GetScale() const;
+
+	float GetAverageFrameMs() const;
+
+	float GetBudgetMs() const;
+
+	int GetScaleChanges() const;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SCALAR_HPP
+#define SCALAR_HPP
+
+#include "Fixed.hpp"
+
+#include <SDL.h>
+
+// Build with -DPONG_FIXED_POINT=1 to run the ball and paddle simulation on Fixed instead of float.
+#ifndef PONG_FIXED_POINT
+#define PONG_FIXED_POINT 0
+#endif
+
+#if PONG_FIXED_POINT
+using Scalar = Fixed;
+#else
+using Scalar = float;
+#endif
+
+struct Vec2
+{
+	Scalar x;
+	Scalar y;
+};
+
+struct Rect
+{
+	Scalar x;
+	Scalar y;
+	Scalar w;
+	Scalar h;
+};
+
+inline SDL_FPoint ToFPoint(const Vec2& point)
+{
+	return { static_cast<float>(point.x), static_cast<float>(point.y) };
+}
+
+inline SDL_FRect ToFRect(const Rect& rect)
+{
+	return { static_cast<float>(rect.x), static_cast<float>(rect.y), static_cast<float>(rect.w), static_cast<float>(rect.h) };
+}
+
+// Same semantics as SDL_IntersectFRect: empty rects never intersect and touching edges do not count.
+inline bool IntersectRects(const Rect& a, const Rect& b, Rect& result)
+{
+	if (a.w <= Scalar(0) || a.h <= Scalar(0) || b.w <= Scalar(0) || b.h <= Scalar(0))
+	{
+		return false;
+	}
+
+	const Scalar left = a.x > b.x ? a.x : b.x;
+	const Scalar right = (a.x + a.w) < (b.x + b.w) ? (a.x + a.w) : (b.x + b.w);
+	const Scalar top = a.y > b.y ? a.y : b.y;
+	const Scalar bottom = (a.y + a.h) < (b.y + b.h) ? (a.y + a.h) : (b.y + b.h);
+
+	result = { left, top, right - left, bottom - top };
+
+	return result.w > Scalar(0) && result.h > Scalar(0);
+}
+
+inline bool RectsIntersect(const Rect& a, const Rect& b)
+{
+	Rect intersect;
+	return IntersectRects(a, b, intersect);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SEGMENT_KERNEL_HPP
+#define SEGMENT_KERNEL_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Segments in structure-of-arrays layout, so one vector load reads the same coordinate of several segments. The
+// arrays are padded with zero-length segments, which never hit, to a whole number of the widest vector.
+class SegmentBatch
+{
+private:
+	std::vector<float> ax_;
+	std::vector<float> ay_;
+	std::vector<float> bx_;
+	std::vector<float> by_;
+	std::size_t count_;
+
+public:
+	static constexpr std::size_t lane_padding = 8;
+
+	SegmentBatch();
+
+	void Clear();
+
+	void Reserve(std::size_t count);
+
+	void Add(float ax, float ay, float bx, float by);
+
+	std::size_t GetCount() const;
+
+	// Count rounded up to lane_padding; every array holds this many values.
+	std::size_t GetPaddedCount() const;
+
+	const float* GetAx() const;
+
+	const float* GetAy() const;
+
+	const float* GetBx() const;
+
+	const float* GetBy() const;
+};
+
+// index is -1 when the ray hits nothing. t is where along the ray the hit is, from 0 at its start to 1 at its end.
+struct SegmentHit
+{
+	int index;
+	float t;
+	float x;
+	float y;
+};
+
+// One ray (a segment from its start to its end point) against every segment of a batch, returning the nearest hit.
+// Hits are decided by the signs of four orientations, which are exact: a fast double precision filter certifies
+// the sign almost always, and the rare lanes it cannot certify (touching, collinear, nearly parallel) are redone
+// with exact expansion arithmetic. So there are no epsilons: touching counts as a hit, parallel and collinear
+// segments never hit, and neither does a segment the ray starts on, which lets a reflected ray leave the segment
+// it bounced off. Among equally near hits the lowest index wins. Every variant returns bit-identical results.
+namespace segment_kernel
+{
+	// Sign of the turn from p to q to r: 1 counterclockwise (in y-up coordinates), -1 clockwise, 0 collinear.
+	int Orientation(float px, float py, float qx, float qy, float rx, float ry);
+
+	SegmentHit FindNearestHitScalar(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y);
+
+	// Two lanes of doubles; the scalar kernel where SSE2 is not available.
+	SegmentHit FindNearestHitSse2(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y);
+
+	// Four lanes of doubles; only call when HasAvx().
+	SegmentHit FindNearestHitAvx(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y);
+
+	bool HasAvx();
+
+	// The widest variant this CPU runs, picked on the first call.
+	SegmentHit FindNearestHit(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y);
+}
+
+#endif
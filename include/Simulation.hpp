@@ -0,0 +1,223 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include "AiController.hpp"
+#include "Arena.hpp"
+#include "Constants.hpp"
+#include "Game.hpp"
+#include "Paddle.hpp"
+#include "Ball.hpp"
+#include "Random.hpp"
+#include "Scalar.hpp"
+#include "Tuning.hpp"
+#include "Utility.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+const Line top_edge = { Scalar(0), Scalar(0), Scalar(constants::screen_width), Scalar(0) };
+const Line right_edge = { Scalar(constants::screen_width), Scalar(0), Scalar(constants::screen_width), Scalar(constants::screen_height) };
+const Line bottom_edge = { Scalar(constants::screen_width), Scalar(constants::screen_height), Scalar(0), Scalar(constants::screen_height) };
+const Line left_edge = { Scalar(0), Scalar(constants::screen_height), Scalar(0), Scalar(0) };
+
+const std::array<Line, 4> edges = { top_edge, right_edge, bottom_edge, left_edge };
+
+enum class SimulationEventType
+{
+	SERVE, PADDLE_HIT, WALL_BOUNCE, GOAL
+};
+
+// Something audible or notable that happened during a tick. angle_ is the reflection angle of a paddle hit, 0 otherwise.
+// player_ is the player whose paddle hit the ball or who scored, 0 otherwise. position_ is where a paddle hit the ball,
+// from 0 at its top to 1 at its bottom. speed_ is the ball's speed after the event. ai_error_ is how far below where
+// the AI aimed the ball reached its side of the field, on player 2 hits and player 1 goals in single player, and NaN
+// otherwise. Only the rally log reads the last three, so they are plain floats.
+struct SimulationEvent
+{
+	SimulationEventType type_;
+	int angle_;
+	int player_;
+	float position_;
+	float speed_;
+	float ai_error_;
+};
+
+// What a frame needs to draw a match, copied out of the simulation after every tick.
+// The ball's predicted path as the IMPOSSIBLE AI sees it: the ball's centre, every obstacle and wall bounce, and the
+// goal line crossing, as one polyline. A path with more corners than fit is cut short.
+struct Trajectory
+{
+	static constexpr std::size_t max_points = 64;
+	std::array<Vec2, max_points> points_;
+	std::size_t count_;
+};
+
+struct SimulationSnapshot
+{
+	std::uint64_t tick_count_;
+	Rect ball_rect_;
+	Rect player1_paddle_rect_;
+	Rect player2_paddle_rect_;
+	int player1_score_;
+	int player2_score_;
+	Line ball_direction_ray_;
+	Vec2 intersection_point_;
+
+	// Empty unless the simulation traces trajectories; trajectory_version_ changes whenever the path does.
+	std::uint32_t trajectory_version_;
+	Trajectory trajectory_;
+};
+
+// Everything that decides how a match goes on from a given tick, for replay keyframes. Plain data, stored as is.
+struct SimulationState
+{
+	std::uint64_t tick_count_;
+	Rect ball_rect_;
+	Line ball_direction_ray_;
+	Scalar ball_vx_;
+	Scalar ball_vy_;
+	Rect player1_paddle_rect_;
+	Scalar player1_paddle_vy_;
+	Rect player2_paddle_rect_;
+	Scalar player2_paddle_vy_;
+	std::int32_t player1_score_;
+	std::int32_t player2_score_;
+	std::int32_t ball_resetting_;
+	std::int32_t ball_reset_ticks_;
+	Vec2 intersection_point_;
+	Vec2 ball_edge_crossing_;
+	std::int32_t has_ball_edge_crossing_;
+	std::uint64_t random_state_;
+	std::uint64_t random_increment_;
+	Tuning tuning_;
+};
+
+// Where a ray, bouncing off obstacles on the way, leaves the field. leg_ is the last straight part of the path, from
+// the last obstacle it bounced off (or the ray's own start) on, in the ray's length.
+struct PathCrossing
+{
+	Vec2 point_;
+	Line leg_;
+	int bounces_;
+};
+
+// Ball, paddles, scores and AI of one match, with no rendering or SDL state, so it can also run headless.
+class Simulation
+{
+public:
+	GameMode game_mode_;
+	GameDifficulty game_difficulty_;
+
+	Ball ball_;
+	Paddle player1_paddle_;
+	Paddle player2_paddle_;
+
+	int player1_score_;
+	int player2_score_;
+
+	bool ball_resetting_;
+	int ball_reset_ticks_;
+
+	// Where the AI is heading; Reset and every change of the ball's direction update it through ai_controller_.
+	Vec2 intersection_point_;
+
+	// Where the ball's current direction ray leaves the field, as of its last change of direction.
+	bool has_ball_edge_crossing_;
+	Vec2 ball_edge_crossing_;
+
+	// Drives player 2 in single player. Reset picks the built-in controller for the difficulty; set it after Reset
+	// to use another one.
+	AiController* ai_controller_;
+
+	Random random_;
+
+	Tuning tuning_;
+
+	// Static obstacles; never null. Like the tick rate, the arena is not part of SimulationState.
+	const Arena* arena_;
+
+	// Every speed is in pixels per 1/60 s, so a match plays at the same pace at any tick rate; time_step_ is the
+	// fraction of a 60 Hz tick that one tick covers. Like the game mode, the rate is not part of SimulationState.
+	static constexpr int reference_tick_rate = 60;
+	int tick_rate_;
+	int physics_substeps_;
+	Scalar time_step_;
+
+	// Ticks since the last Reset.
+	std::uint64_t tick_count_;
+
+	// Events of the last Tick only; cleared when the next one starts.
+	static constexpr std::size_t max_events_per_tick = 8;
+	std::array<SimulationEvent, max_events_per_tick> events_;
+	std::size_t event_count_;
+
+	// For the debug overlay, redone only when the ball changes direction and only while tracing. Like the arena, none
+	// of it is part of SimulationState.
+	bool trace_trajectory_;
+	std::uint32_t trajectory_version_;
+	Trajectory trajectory_;
+
+	Simulation();
+
+	void Reset(GameMode game_mode, GameDifficulty game_difficulty, std::uint64_t seed);
+
+	// Call before Reset. physics_substeps splits every ball tick into that many collision steps.
+	void SetTickRate(int tick_rate, int physics_substeps = 1);
+
+	// Call before Reset; null plays without obstacles. The arena must outlive the simulation.
+	void SetArena(const Arena* arena);
+
+	// A duration given in 60 Hz ticks, in ticks at the current rate.
+	int ScaleTicks(int reference_ticks) const;
+
+	void Tick();
+
+	// Takes effect from the next tick; paddles are resized in place around their current centre.
+	void ApplyTuning(const Tuning& tuning);
+
+	void PushEvent(SimulationEventType type, int angle = 0, int player = 0, float position = 0.0f);
+
+	void TakeSnapshot(SimulationSnapshot& snapshot) const;
+
+	void SaveState(SimulationState& state) const;
+
+	// Game mode and difficulty are not part of the state; Reset the simulation with the match's before loading.
+	void LoadState(const SimulationState& state);
+
+	void GetAiView(AiView& view) const;
+
+	// A hash of the ball, paddles, scores, reset counters, AI aim and random state, bit for bit, for finding the tick
+	// two runs part ways at. Cheap enough to take every tick.
+	std::uint64_t GetStateHash() const;
+
+	// Tracing from now on starts with the path the ball is on already.
+	void SetTrajectoryTracing(bool enabled);
+
+	void UpdateTrajectory();
+
+	static const std::optional<Vec2> GetLinesIntersectionPoint(const Line& line_1, const Line& line_2);
+
+	// Finds where the ball's new direction leaves the field and lets the AI re-aim.
+	void GetEdgeIntersectionPoint(BallDirectionChange change);
+
+	// The edge crossing of ray farthest from reference_point, the way the trajectory prediction has always chosen.
+	static const std::optional<Vec2> GetEdgeCrossPoint(const Line& ray, const Vec2 reference_point);
+
+	// GetEdgeCrossPoint for a field with obstacles: follows ray through up to max_path_bounces bounces off them. Where
+	// nothing is in the way, the result is GetEdgeCrossPoint's and leg_ is ray.
+	static constexpr int max_path_bounces = 16;
+	static const std::optional<PathCrossing> GetPathCrossPoint(const Arena& arena, const Line& ray, const Vec2 reference_point,
+		Trajectory* trajectory = nullptr);
+
+	// Follows ray through obstacle and wall bounces until it reaches a goal line, as the IMPOSSIBLE AI predicts the ball.
+	// Without a first edge crossing there is no prediction. Given a trajectory, the path's corners are added to it.
+	static const std::optional<Vec2> PredictGoalCrossing(const Arena& arena, const Line& ray, const Vec2 reference_point, Trajectory* trajectory);
+
+	// Velocity after bouncing off a surface with the given normal, which need not be normalized.
+	static Vec2 Reflect(const Vec2& velocity, const Vec2& normal);
+
+	static bool IsPointOnLine(const Vec2 point, const Line& line);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef SPECTATOR_SERVER_HPP
+#define SPECTATOR_SERVER_HPP
+
+#include "Simulation.hpp"
+#include "TripleBuffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Match state as spectators receive it: positions in 1/8 pixel units, everything else as is.
+struct SpectatorState
+{
+	static constexpr int field_count = 6;
+
+	std::uint32_t tick;
+
+	// ball x, ball y, player 1 paddle y, player 2 paddle y, player 1 score, player 2 score
+	std::array<std::int32_t, field_count> fields;
+};
+
+// Wire format, per message: one length byte, then the payload. The payload starts with a mask byte: bit 7 marks
+// a full state, bits 0-5 say which fields follow. Then comes the tick as an unsigned LEB128 (absolute in a full
+// state, the distance from the previous message otherwise), then every field in the mask as a zigzag LEB128
+// (absolute in a full state, the change from the previous message otherwise). Every client starts with a full state.
+namespace spectator
+{
+	constexpr std::uint8_t full_state_bit = 0x80;
+	constexpr int position_scale = 8;
+	constexpr std::size_t max_message_size = 64;
+
+	SpectatorState Quantize(const SimulationSnapshot& snapshot);
+
+	// Returns the message length, including the length byte.
+	std::size_t EncodeMessage(const SpectatorState& state, const SpectatorState* previous, std::uint8_t* message);
+
+	// Applies one message payload (without its length byte) to state; false if it is malformed.
+	bool DecodeMessage(const std::uint8_t* payload, std::size_t size, SpectatorState& state);
+}
+
+// Streams the match to any number of spectators from its own thread. The game publishes one snapshot per tick,
+// which costs a triple buffer copy and, while anyone is connected, one eventfd write. The server thread waits on
+// epoll, so nothing about a subscriber can block the game. A subscriber that cannot keep up is simply sent the
+// latest state once its socket drains, as a delta from the last state it did receive; the states in between are dropped.
+class SpectatorServer
+{
+private:
+	static constexpr std::size_t max_clients = 1024;
+
+	struct Client
+	{
+		int fd;
+		bool has_state;
+		bool stale;
+		bool waiting_for_output;
+		SpectatorState last_sent;
+		std::array<std::uint8_t, spectator::max_message_size> pending;
+		std::size_t pending_begin;
+		std::size_t pending_end;
+	};
+
+	std::string address_;
+	std::string unix_path_;
+	int listen_fd_;
+	int epoll_fd_;
+	int event_fd_;
+	std::thread server_thread_;
+	std::atomic<bool> running_;
+
+	TripleBuffer<SimulationSnapshot> snapshots_;
+	std::atomic<std::size_t> client_count_;
+	std::vector<Client> clients_;
+	std::vector<std::size_t> free_slots_;
+	SpectatorState latest_;
+	bool has_latest_;
+
+	std::uint64_t accepted_clients_;
+	std::uint64_t messages_sent_;
+	std::uint64_t bytes_sent_;
+	std::uint64_t dropped_states_;
+
+	bool Listen();
+
+	void ServerLoop();
+
+	void AcceptClients();
+
+	void CloseClient(std::size_t slot);
+
+	void SendLatest(std::size_t slot);
+
+	void FlushClient(std::size_t slot);
+
+public:
+	SpectatorServer();
+
+	~SpectatorServer();
+
+	// address is "unix:PATH", "HOST:PORT" or just "PORT" (listening on 127.0.0.1).
+	bool Open(const std::string& address);
+
+	void Close();
+
+	// Called by whichever thread ticks the match, once per tick.
+	void Publish(const SimulationSnapshot& snapshot);
+
+	std::size_t GetClientCount() const;
+
+	void PrintReport(FILE* file) const;
+};
+
+#endif
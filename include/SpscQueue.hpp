@@ -0,0 +1,63 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free ring for exactly one producer thread and one consumer thread. Neither side ever blocks:
+// TryPush fails when the ring is full and TryPop fails when it is empty.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+private:
+	static constexpr std::size_t cache_line_size = 64;
+
+	std::array<T, Capacity> items_;
+	alignas(cache_line_size) std::atomic<std::size_t> head_;
+	alignas(cache_line_size) std::atomic<std::size_t> tail_;
+
+public:
+	SpscQueue() : head_(0), tail_(0)
+	{
+	}
+
+	bool TryPush(const T& item)
+	{
+		const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+		if (tail - head_.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		items_[tail & (Capacity - 1)] = item;
+		tail_.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	bool TryPop(T& item)
+	{
+		const std::size_t head = head_.load(std::memory_order_relaxed);
+
+		if (head == tail_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		item = items_[head & (Capacity - 1)];
+		head_.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	std::size_t Size() const
+	{
+		return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+	}
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef STATE_CHECKSUMS_HPP
+#define STATE_CHECKSUMS_HPP
+
+#include "Simulation.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Checksum files, in native byte order:
+//   ChecksumHeader
+//   ChecksumEntry for every tick from first_tick on, count of them
+//   SimulationState for the same ticks
+// chain is the hash of the tick's state_hash with the previous tick's chain, so two runs' chains agree up to the first
+// tick they part ways at and differ from there on, which lets the first divergent tick be found by bisection.
+struct ChecksumHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint64_t seed;
+	std::uint8_t game_mode;
+	std::uint8_t game_difficulty;
+	std::uint8_t fixed_point;
+	std::uint8_t physics_substeps;
+	std::uint32_t state_size;
+	std::uint32_t tick_rate;
+	std::uint32_t reserved;
+	std::uint64_t arena_hash;
+	std::uint64_t first_tick;
+	std::uint64_t count;
+};
+
+struct ChecksumEntry
+{
+	std::uint64_t tick;
+	std::uint64_t state_hash;
+	std::uint64_t chain;
+};
+
+// Keeps the checksum and full state of the last capacity ticks of a match in a ring, to save when it ends. Only a
+// tick right after the last recorded one is taken, so a replay that seeks back carries on the chain once it plays
+// past where it was, and a seek ahead ends the recording.
+class StateChecksums
+{
+private:
+	ChecksumHeader header_;
+	std::vector<ChecksumEntry> entries_;
+	std::vector<SimulationState> states_;
+	std::uint64_t recorded_;
+	std::uint64_t chain_;
+	std::uint64_t last_tick_;
+
+public:
+	static constexpr std::size_t default_capacity = 1 << 13;
+
+	StateChecksums();
+
+	// Allocates the ring; recording starts with the tick after the simulation's current one. capacity is rounded up
+	// to a power of two. The current tick is left out because a live match and its replay only agree once the first
+	// inputs are in.
+	void Start(const Simulation& simulation, std::uint64_t seed, std::size_t capacity = default_capacity);
+
+	bool IsStarted() const;
+
+	// Call after every tick.
+	void Record(const Simulation& simulation);
+
+	// The chain as of the last recorded tick, for comparing with a peer's.
+	std::uint64_t GetChain() const;
+
+	bool Save(const char* path) const;
+
+	static std::uint64_t ChainHash(std::uint64_t chain, std::uint64_t state_hash);
+};
+
+#endif
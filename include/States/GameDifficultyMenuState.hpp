@@ -2,25 +2,24 @@
 #define GAME_DIFFICULTY_MENU_STATE_HPP
 
 #include "GameState.hpp"
-#include "Button.hpp"
+#include "Menu.hpp"
 
 #include <memory>
 #include <vector>
 
-#include <SDL_ttf.h>
-
 class GameDifficultyMenuState : public GameState
 {
 private:
 	static std::unique_ptr<GameDifficultyMenuState> game_difficulty_menu_state_;
 
 	Game* game_;
-	TTF_Font* font_;
 
-	std::unique_ptr<Button> easy_difficulty_button_;
-	std::unique_ptr<Button> medium_difficulty_button_;
-	std::unique_ptr<Button> hard_difficulty_button_;
-	std::unique_ptr<Button> impossible_difficulty_button_;
+	// Built on the first Enter and kept, layout and all.
+	std::unique_ptr<Menu> menu_;
+	int easy_difficulty_button_;
+	int medium_difficulty_button_;
+	int hard_difficulty_button_;
+	int impossible_difficulty_button_;
 
 public:
 	GameDifficultyMenuState() = default;
@@ -37,7 +36,9 @@ public:
 
 	void Resume() override;
 
-	void HandleEvents() override;
+	std::uint32_t GetInputEvents() const override;
+
+	void HandleEvents(const InputFrame& input) override;
 
 	void Tick() override;
 
@@ -2,25 +2,22 @@
 #define GAME_MODE_MENU_STATE_HPP
 
 #include "GameState.hpp"
-#include "Button.hpp"
+#include "Menu.hpp"
 
 #include <memory>
 #include <vector>
 
-#include <SDL_ttf.h>
-
 class GameModeMenuState : public GameState
 {
 private:
 	static std::unique_ptr<GameModeMenuState> game_menu_state_;
 
 	Game* game_;
-	TTF_Font* font_;
-	
-	std::unique_ptr<Texture> title_texture_;
 	
-	std::unique_ptr<Button> single_player_button_;
-	std::unique_ptr<Button> multi_player_button_;
+	// Built on the first Enter and kept, layout and all.
+	std::unique_ptr<Menu> menu_;
+	int single_player_button_;
+	int multi_player_button_;
 
 public:
 	GameModeMenuState() = default;
@@ -37,7 +34,9 @@ public:
 
 	void Resume() override;
 
-	void HandleEvents() override;
+	std::uint32_t GetInputEvents() const override;
+
+	void HandleEvents(const InputFrame& input) override;
 
 	void Tick() override;
 
@@ -1,51 +1,125 @@
 #ifndef GAME_PLAY_STATE_HPP
 #define GAME_PLAY_STATE_HPP
 
+#include "AiHost.hpp"
 #include "Constants.hpp"
 #include "GameState.hpp"
-#include "Paddle.hpp"
-#include "Ball.hpp"
+#include "RallyLog.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
+#include "StateChecksums.hpp"
+#include "TickStats.hpp"
+#include "TripleBuffer.hpp"
 #include "Utility.hpp"
 
+#include <atomic>
 #include <memory>
 #include <cmath>
 #include <array>
 #include <optional>
-
-const Line top_edge = { 0.0f, 0.0f, static_cast<float>(constants::screen_width), 0.0f };
-const Line right_edge = { static_cast<float>(constants::screen_width), 0.0f, static_cast<float>(constants::screen_width), static_cast<float>(constants::screen_height) };
-const Line bottom_edge = { static_cast<float>(constants::screen_width), static_cast<float>(constants::screen_height), 0.0f, static_cast<float>(constants::screen_height) };
-const Line left_edge = { 0.0f, static_cast<float>(constants::screen_height), 0.0f, 0.0f };
-
-const std::array<Line, 4> edges = { top_edge, right_edge, bottom_edge, left_edge };
+#include <thread>
+#include <vector>
 
 class GamePlayState : public GameState
 {
-	friend class Ball;
-
 private:
 	static std::unique_ptr<GamePlayState> game_play_state_;
 
 	Game* game_;
-	TTF_Font* font_;
 
-	Ball ball_;
+	// The arena's boxes, and its segments as pairs of end points.
+	std::vector<SDL_FRect> obstacle_boxes_;
+	std::vector<SDL_FPoint> obstacle_segments_;
+
+	const Tuning* applied_tuning_;
+
+	// Ticks since the match started or resumed; after a two second warmup the match counts as steady state.
+	int steady_state_ticks_;
+	std::atomic<int> ticks_since_enter_;
+
+	// With the simulation thread running, it alone touches simulation_ and the main thread only draws snapshots.
+	std::thread simulation_thread_;
+	std::atomic<bool> simulation_running_;
+	TripleBuffer<SimulationSnapshot> snapshots_;
+	TickStats tick_stats_;
+
+	// Drives player 2 in a live single-player match, against GameOptions::ai_budget_us.
+	AiHost ai_host_;
+
+	ReplayWriter replay_writer_;
+
+	// Written from whichever thread ticks the simulation; only live matches are logged.
+	RallyLog rally_log_;
+
+	// Recorded after every tick, live or played back, while GameOptions::checksum_path is set.
+	StateChecksums checksums_;
+
+	// Playback of GameOptions::replay_path: ticks step the replay instead of the live simulation.
+	static constexpr int fast_forward_speed = 100;
+	static constexpr int seek_step_reference_ticks = 600;
+	ReplayReader replay_reader_;
+	bool playback_;
+	bool playback_paused_;
+	int playback_speed_;
+
+	// Replay ticks owed to the game loop, times its tick rate, so a replay plays at its own rate whatever ours is.
+	int playback_tick_credit_;
+
+	// Toggled with F3 on the game loop; whichever thread ticks the simulation passes it on before the next snapshot.
+	std::atomic<bool> show_trajectory_;
+
+	// The last trajectory the overlay converted for the renderer, with its bounce and aim markers; redone only when
+	// a snapshot brings a new version.
+	std::uint32_t drawn_trajectory_version_;
+	std::size_t trajectory_point_count_;
+	std::array<SDL_FPoint, Trajectory::max_points> trajectory_points_;
+	std::size_t trajectory_marker_count_;
+	std::array<SDL_FRect, Trajectory::max_points + 1> trajectory_markers_;
+
+	void StartAi();
+
+	void StartRecording(std::uint64_t seed);
+
+	void StartRallyLog(std::uint64_t seed);
 
-	int player1_score_;
-	int player2_score_;
-	std::unique_ptr<Texture> player1_score_texture_;
-	std::unique_ptr<Texture> player2_score_texture_;
+	void HandlePlaybackInput(const InputFrame& input);
 
-	bool ball_resetting_;
-	int ball_reset_ticks_;
+	void SeekPlayback(std::uint64_t tick);
 
-	SDL_FPoint intersection_point_;
+	void TickPlayback();
+
+	void PostSimulationEvents();
+
+	void StartSimulationThread();
+
+	void StopSimulationThread();
+
+	void SimulationLoop();
+
+	void TickSimulation();
+
+	void PublishSnapshot();
 
 	void DrawDividerRects();
 
+	// The arena never changes, so its shapes are converted for the renderer once on Enter.
+	void BuildObstacleShapes();
+
+	void DrawObstacles();
+
+	void DrawTrajectory(const SimulationSnapshot& snapshot);
+
+	void DrawRect(const Rect& rect);
+
+	// Drains the input queue into paddle velocities right before the tick that uses them.
+	void ApplyPaddleCommands();
+
+	int GetScoreWidth(int score) const;
+
+	void RenderScore(int score, int x, int y);
+
 public:
-	Paddle player1_paddle_;
-	Paddle player2_paddle_;
+	Simulation simulation_;
 	
 	GamePlayState();
 
@@ -61,17 +135,13 @@ public:
 
 	void Resume() override;
 
-	void HandleEvents() override;
+	std::uint32_t GetInputEvents() const override;
+
+	void HandleEvents(const InputFrame& input) override;
 
 	void Tick() override;
 
 	void Render() override;
-
-	const std::optional<SDL_FPoint> GetLinesIntersectionPoint(const Line& line_1, const Line& line_2) const;
-
-	void GetEdgeIntersectionPoint();
-
-	bool IsPointOnLine(const SDL_FPoint point, const Line& line) const;
 };
 
 #endif
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define GAMESTATE_HPP
 
 #include "Game.hpp"
+#include "Input.hpp"
+
+#include <cstdint>
 
 class GameState
 {
@@ -18,7 +21,10 @@ public:
 
 	virtual void Resume() = 0;
 
-	virtual void HandleEvents() = 0;
+	// Kinds of events (input_events) the state reads; the others are dropped before SDL queues them.
+	virtual std::uint32_t GetInputEvents() const = 0;
+
+	virtual void HandleEvents(const InputFrame& input) = 0;
 
 	virtual void Tick() = 0;
 	
@@ -0,0 +1,22 @@
+#ifndef SYNTH_HPP
+#define SYNTH_HPP
+
+#include <SDL.h>
+
+#include <cstddef>
+
+// A square-wave blip that glides from start_hz to end_hz under a short attack and a linear decay.
+struct Blip
+{
+	float start_hz;
+	float end_hz;
+	int duration_ms;
+	float volume;
+};
+
+std::size_t BlipFrameCount(const Blip& blip, int frequency);
+
+// Writes BlipFrameCount frames of interleaved signed 16-bit samples, the same value on every channel.
+void SynthesizeBlip(const Blip& blip, int frequency, int channels, Sint16* output);
+
+#endif
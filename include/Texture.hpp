@@ -23,7 +23,10 @@ public:
 
 	bool LoadFromText(SDL_Renderer* renderer, TTF_Font* font, const char* text, const SDL_Color& text_color, int text_length = -1);
 
-	void Render(SDL_Renderer* renderer, int x, int y, SDL_Rect* clip = nullptr, double scale = 1.0);
+	// Tints every following Render; white draws the texture as it is.
+	void SetColor(const SDL_Color& color);
+
+	void Render(SDL_Renderer* renderer, int x, int y, const SDL_Rect* clip = nullptr, double scale = 1.0);
 };
 
 #endif
@@ -0,0 +1,34 @@
+#ifndef TICK_STATS_HPP
+#define TICK_STATS_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+// Spacing between consecutive ticks. A steady 60 Hz simulation keeps every interval near 16.7 ms; a tick loop
+// that waits on rendering shows long gaps followed by bursts of catch-up ticks.
+class TickStats
+{
+private:
+	std::uint64_t last_counter_;
+	std::uint64_t intervals_;
+	double total_ms_;
+	double total_squared_ms_;
+	double max_ms_;
+	double tick_period_ms_;
+
+	// Intervals over 1.5 periods, and catch-up intervals under half a period.
+	std::uint64_t late_ticks_;
+	std::uint64_t burst_ticks_;
+
+public:
+	TickStats();
+
+	void Reset(int tick_rate = 60);
+
+	// counter is SDL_GetPerformanceCounter() when the tick finished.
+	void Record(std::uint64_t counter);
+
+	void PrintReport(FILE* file, const char* name) const;
+};
+
+#endif
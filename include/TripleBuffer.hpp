@@ -0,0 +1,60 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of the latest value from one writer thread to one reader thread. The writer fills the back
+// slot and publishes it, the reader picks up the newest published slot; neither ever waits on the other, and the
+// reader never sees a slot that is still being written. Values published between two reads are skipped.
+template <typename T>
+class TripleBuffer
+{
+private:
+	static constexpr std::uint8_t index_mask = 0x3;
+	static constexpr std::uint8_t fresh_bit = 0x4;
+	static constexpr std::size_t cache_line_size = 64;
+
+	std::array<T, 3> slots_;
+
+	// Writer-owned and reader-owned slot indices; the shared middle index carries the fresh bit.
+	alignas(cache_line_size) std::uint8_t back_;
+	alignas(cache_line_size) std::atomic<std::uint8_t> middle_;
+	alignas(cache_line_size) std::uint8_t front_;
+
+public:
+	TripleBuffer() : slots_(), back_(0), middle_(1), front_(2)
+	{
+	}
+
+	T& GetWriteBuffer()
+	{
+		return slots_[back_];
+	}
+
+	void Publish()
+	{
+		back_ = middle_.exchange(static_cast<std::uint8_t>(back_ | fresh_bit), std::memory_order_acq_rel) & index_mask;
+	}
+
+	// Moves the read buffer to the newest published value; returns false if nothing new was published.
+	bool Update()
+	{
+		if ((middle_.load(std::memory_order_relaxed) & fresh_bit) == 0)
+		{
+			return false;
+		}
+
+		front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask;
+
+		return true;
+	}
+
+	const T& GetReadBuffer() const
+	{
+		return slots_[front_];
+	}
+};
+
+#endif
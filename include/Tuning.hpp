@@ -0,0 +1,26 @@
+#ifndef TUNING_HPP
+#define TUNING_HPP
+
+#include "Constants.hpp"
+
+#include <array>
+
+// Gameplay values that can be changed from the config file while the game runs. The defaults are the original ones.
+struct Tuning
+{
+	int paddle_width = 20;
+	int paddle_height = 100;
+	int paddle_x_offset = 30;
+
+	// AI paddle speed per GameDifficulty, in the enum's order.
+	std::array<int, 4> ai_speeds = { 5, 6, 7, 7 };
+
+	float speed_multiple = 15.0f;
+	float initial_speed = 5.0f;
+
+	// Window size only; the playfield stays constants::screen_width x screen_height and is scaled to fit.
+	int window_width = constants::screen_width;
+	int window_height = constants::screen_height;
+};
+
+#endif
@@ -1,7 +1,7 @@
 #ifndef UTILITY_HPP
 #define UTILITY_HPP
 
-#include <SDL.h>
+#include "Scalar.hpp"
 
 #include <cmath>
 #include <limits>
@@ -20,38 +20,49 @@ const std::tuple<T, T, T> GetLinearEquationCoefficients(T x_1, T y_1, T x_2, T y
 	return { A, B, C };
 }
 
-template <typename T, typename std::enable_if_t<std::is_floating_point<T>::value, bool> = true>
+template <typename T>
+struct IsRealNumber : std::bool_constant<std::is_floating_point<T>::value || std::is_same<T, Fixed>::value>
+{
+};
+
+template <typename T, typename std::enable_if_t<IsRealNumber<T>::value, bool> = true>
+T Abs(T value)
+{
+	return value < T(0) ? -value : value;
+}
+
+template <typename T, typename std::enable_if_t<IsRealNumber<T>::value, bool> = true>
 bool FloatingPointSame(T a, T b, T epsilon = std::numeric_limits<T>::epsilon())
 {
-	return std::fabs(a - b) <= ((std::fabs(a) > std::fabs(b) ? std::fabs(b) : std::fabs(a)) * epsilon);
+	return Abs(a - b) <= ((Abs(a) > Abs(b) ? Abs(b) : Abs(a)) * epsilon);
 }
 
-template <typename T, typename std::enable_if_t<std::is_floating_point<T>::value, bool> = true>
+template <typename T, typename std::enable_if_t<IsRealNumber<T>::value, bool> = true>
 bool FloatingPointGreaterThan(T a, T b, T epsilon = std::numeric_limits<T>::epsilon())
 {
-	return (a - b) > (std::fabs(a) < std::fabs(b) ? std::fabs(b) : std::fabs(a)) * epsilon;
+	return (a - b) > (Abs(a) < Abs(b) ? Abs(b) : Abs(a)) * epsilon;
 }
 
-template <typename T, typename std::enable_if_t<std::is_floating_point<T>::value, bool> = true>
+template <typename T, typename std::enable_if_t<IsRealNumber<T>::value, bool> = true>
 bool FloatingPointLessThan(T a, T b, T epsilon = std::numeric_limits<T>::epsilon())
 {
-	return (b - a) > ((std::fabs(a) < std::fabs(b) ? std::fabs(b) : std::fabs(a)) * epsilon);
+	return (b - a) > ((Abs(a) < Abs(b) ? Abs(b) : Abs(a)) * epsilon);
 }
 
 struct Line
 {
-	SDL_FPoint start_point;
-	SDL_FPoint end_point;
+	Vec2 start_point;
+	Vec2 end_point;
 
     Line()
     {
-        start_point.x = std::numeric_limits<float>::max();
-        end_point.y = std::numeric_limits<float>::max();
-        start_point.x = std::numeric_limits<float>::max();
-        end_point.y = std::numeric_limits<float>::max();
+        start_point.x = std::numeric_limits<Scalar>::max();
+        end_point.y = std::numeric_limits<Scalar>::max();
+        start_point.x = std::numeric_limits<Scalar>::max();
+        end_point.y = std::numeric_limits<Scalar>::max();
     }
 
-    Line(float sx, float sy, float ex, float ey)
+    Line(Scalar sx, Scalar sy, Scalar ex, Scalar ey)
     {
         start_point.x = sx;
         start_point.y = sy;
@@ -90,7 +101,14 @@ public:
 template <typename T, typename std::enable_if_t<std::is_floating_point<T>::value, bool> = true>
 inline T PointsDistance(T x1, T y1, T x2, T y2)
 {
-	return std::sqrtf(std::powf(x2 - x1, 2) + std::powf(y2 - y1, 2) * static_cast<T>(1.0));
+	return std::sqrt(std::pow(x2 - x1, 2) + std::pow(y2 - y1, 2) * static_cast<T>(1.0));
+}
+
+// Orders points the same way PointsDistance does without the square root, so it also works on Fixed.
+template <typename T, typename std::enable_if_t<IsRealNumber<T>::value, bool> = true>
+inline T PointsDistanceSquared(T x1, T y1, T x2, T y2)
+{
+	return ((x2 - x1) * (x2 - x1)) + ((y2 - y1) * (y2 - y1));
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "AiController.hpp"
+#include "Simulation.hpp"
+#include "Trace.hpp"
+
+namespace
+{
+	ChaseAiController chase_ai_controller;
+	PredictingAiController predicting_ai_controller;
+}
+
+const char* ChaseAiController::GetName() const
+{
+	return "chase";
+}
+
+Vec2 ChaseAiController::Aim(const AiView& view, BallDirectionChange change)
+{
+	(void)change;
+
+	return view.has_ball_edge_crossing_ ? view.ball_edge_crossing_ : view.target_;
+}
+
+AiCommand ChaseAiController::Tick(const AiView& view)
+{
+	const Scalar paddle_mid_point_y = view.paddle_rect_.y + (view.paddle_rect_.h / Scalar(2));
+	const Scalar dist = view.target_.y - paddle_mid_point_y;
+
+	AiCommand command;
+	command.target_ = view.target_;
+
+	if (!FloatingPointSame(paddle_mid_point_y, view.target_.y, Scalar(0.05f)))
+	{
+		command.paddle_vy_ = dist < Scalar(0) ? -view.max_speed_ : view.max_speed_;
+	}
+	else
+	{
+		command.paddle_vy_ = Scalar(0);
+	}
+
+	return command;
+}
+
+const char* PredictingAiController::GetName() const
+{
+	return "predicting";
+}
+
+Vec2 PredictingAiController::Aim(const AiView& view, BallDirectionChange change)
+{
+	TRACE_ZONE("PredictingAiController::Aim");
+
+	// The path from the last serve or hit already runs through every wall bounce.
+	if (change == BallDirectionChange::WALL_BOUNCE || !view.has_ball_edge_crossing_)
+	{
+		return view.target_;
+	}
+
+	return Simulation::PredictGoalCrossing(*view.arena_, view.ball_direction_ray_, view.target_, nullptr).value_or(view.target_);
+}
+
+AiController* GetBuiltinAiController(GameDifficulty game_difficulty)
+{
+	if (game_difficulty == GameDifficulty::IMPOSSIBLE)
+	{
+		return &predicting_ai_controller;
+	}
+
+	return &chase_ai_controller;
+}
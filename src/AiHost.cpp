@@ -0,0 +1,202 @@
+#include "AiHost.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+
+AiHost::AiHost() :
+	controller_(nullptr),
+	name_(nullptr),
+	budget_(0),
+	isolated_(false),
+	running_(false),
+	request_sequence_(0),
+	response_sequence_(0),
+	request_(),
+	response_(),
+	last_command_(),
+	last_command_sequence_(0),
+	ticks_(0),
+	over_budget_ticks_(0),
+	fallback_ticks_(0),
+	total_time_(0),
+	max_time_(0)
+{
+}
+
+AiHost::~AiHost()
+{
+	Stop();
+}
+
+void AiHost::Start(AiController& controller, int budget_us, bool isolated)
+{
+	Stop();
+
+	controller_ = &controller;
+	name_ = controller.GetName();
+	budget_ = std::chrono::microseconds(std::max(budget_us, 1));
+	isolated_ = isolated;
+
+	request_sequence_ = 0;
+	response_sequence_ = 0;
+	last_command_ = AiCommand();
+	last_command_sequence_ = 0;
+	ticks_ = 0;
+	over_budget_ticks_ = 0;
+	fallback_ticks_ = 0;
+	total_time_ = std::chrono::nanoseconds(0);
+	max_time_ = std::chrono::nanoseconds(0);
+
+	if (isolated_)
+	{
+		running_ = true;
+		worker_thread_ = std::thread(&AiHost::WorkerLoop, this);
+	}
+}
+
+void AiHost::Stop()
+{
+	if (worker_thread_.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			running_ = false;
+		}
+
+		request_ready_.notify_one();
+		worker_thread_.join();
+	}
+
+	controller_ = nullptr;
+}
+
+bool AiHost::IsStarted() const
+{
+	return controller_ != nullptr;
+}
+
+const char* AiHost::GetName() const
+{
+	return controller_->GetName();
+}
+
+Vec2 AiHost::Aim(const AiView& view, BallDirectionChange change)
+{
+	// Only trusted controllers are called from within a tick.
+	return isolated_ ? view.target_ : controller_->Aim(view, change);
+}
+
+AiCommand AiHost::Tick(const AiView& view)
+{
+	TRACE_ZONE("AiHost::Tick");
+
+	if (!isolated_)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		last_command_ = controller_->Tick(view);
+		RecordTime(std::chrono::steady_clock::now() - start);
+
+		return last_command_;
+	}
+
+	const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + budget_;
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	if (response_sequence_ != request_sequence_)
+	{
+		// Still working on a tick that already missed its deadline.
+		++fallback_ticks_;
+		return GetLatestCommand(view);
+	}
+
+	request_ = view;
+	++request_sequence_;
+	request_ready_.notify_one();
+
+	if (!response_ready_.wait_until(lock, deadline, [this]() { return response_sequence_ == request_sequence_; }))
+	{
+		++fallback_ticks_;
+		return GetLatestCommand(view);
+	}
+
+	last_command_ = response_;
+	last_command_sequence_ = response_sequence_;
+
+	return last_command_;
+}
+
+AiCommand AiHost::GetLatestCommand(const AiView& view)
+{
+	// Picks up the answer to a late tick once it arrived.
+	if (response_sequence_ != last_command_sequence_)
+	{
+		last_command_ = response_;
+		last_command_sequence_ = response_sequence_;
+	}
+
+	// Until a first answer there is nothing to go on: stand still and keep the target.
+	if (last_command_sequence_ == 0)
+	{
+		last_command_.target_ = view.target_;
+	}
+
+	return last_command_;
+}
+
+void AiHost::WorkerLoop()
+{
+	Trace::Instance()->SetThreadName("AI controller");
+
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	while (true)
+	{
+		request_ready_.wait(lock, [this]() { return !running_ || request_sequence_ != response_sequence_; });
+
+		if (!running_)
+		{
+			return;
+		}
+
+		const AiView view = request_;
+		const std::uint64_t sequence = request_sequence_;
+		lock.unlock();
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		const AiCommand command = controller_->Tick(view);
+		const std::chrono::nanoseconds time = std::chrono::steady_clock::now() - start;
+
+		lock.lock();
+		response_ = command;
+		response_sequence_ = sequence;
+		RecordTime(time);
+		response_ready_.notify_one();
+	}
+}
+
+void AiHost::RecordTime(std::chrono::nanoseconds time)
+{
+	++ticks_;
+	total_time_ += time;
+	max_time_ = std::max(max_time_, time);
+
+	if (time > budget_)
+	{
+		++over_budget_ticks_;
+	}
+}
+
+void AiHost::PrintReport(FILE* file) const
+{
+	if (name_ == nullptr)
+	{
+		return;
+	}
+
+	const double mean_us = ticks_ > 0 ? static_cast<double>(total_time_.count()) / 1000.0 / static_cast<double>(ticks_) : 0.0;
+
+	fprintf(file, "AI controller %s (%s): %llu ticks, mean %.1f us, max %.1f us, budget %lld us, %llu over budget, %llu played with its latest command\n",
+		name_, isolated_ ? "isolated" : "inline", static_cast<unsigned long long>(ticks_), mean_us,
+		static_cast<double>(max_time_.count()) / 1000.0, static_cast<long long>(budget_.count()),
+		static_cast<unsigned long long>(over_budget_ticks_), static_cast<unsigned long long>(fallback_ticks_));
+}
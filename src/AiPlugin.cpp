@@ -0,0 +1,144 @@
+#include "AiPlugin.hpp"
+#include "Constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#endif
+
+AiPlugin::AiPlugin() :
+	library_(nullptr),
+	controller_(nullptr),
+	state_(nullptr)
+{
+}
+
+AiPlugin::~AiPlugin()
+{
+	Close();
+}
+
+bool AiPlugin::Open(const std::string& path)
+{
+	Close();
+
+#ifdef __linux__
+	library_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+	if (library_ == nullptr)
+	{
+		printf("Unable to load AI plugin %s! dlopen Error: %s\n", path.c_str(), dlerror());
+		return false;
+	}
+
+	using EntryPoint = const PongAiController* (*)();
+	const EntryPoint entry_point = reinterpret_cast<EntryPoint>(dlsym(library_, "pong_ai_controller"));
+	controller_ = entry_point != nullptr ? entry_point() : nullptr;
+
+	if (controller_ == nullptr || controller_->abi_version != PONG_AI_ABI_VERSION || controller_->tick == nullptr)
+	{
+		printf("AI plugin %s does not export a pong_ai_controller of ABI version %d!\n", path.c_str(), PONG_AI_ABI_VERSION);
+		Close();
+		return false;
+	}
+
+	name_ = controller_->name != nullptr ? controller_->name : path;
+	Restart();
+
+	return true;
+#else
+	printf("%s\n", "AI plugins are only available on Linux.");
+	return false;
+#endif
+}
+
+void AiPlugin::Close()
+{
+#ifdef __linux__
+	if (state_ != nullptr && controller_->destroy != nullptr)
+	{
+		controller_->destroy(state_);
+	}
+
+	if (library_ != nullptr)
+	{
+		dlclose(library_);
+	}
+#endif
+
+	library_ = nullptr;
+	controller_ = nullptr;
+	state_ = nullptr;
+}
+
+void AiPlugin::Restart()
+{
+	if (controller_ == nullptr)
+	{
+		return;
+	}
+
+	if (state_ != nullptr && controller_->destroy != nullptr)
+	{
+		controller_->destroy(state_);
+	}
+
+	state_ = controller_->create != nullptr ? controller_->create() : nullptr;
+}
+
+const char* AiPlugin::GetName() const
+{
+	return name_.c_str();
+}
+
+Vec2 AiPlugin::Aim(const AiView& view, BallDirectionChange change)
+{
+	(void)change;
+
+	return view.target_;
+}
+
+AiCommand AiPlugin::Tick(const AiView& view)
+{
+	PongAiView plugin_view;
+	plugin_view.tick = view.tick_;
+	plugin_view.field_width = static_cast<float>(constants::screen_width);
+	plugin_view.field_height = static_cast<float>(constants::screen_height);
+	plugin_view.ball_x = static_cast<float>(view.ball_rect_.x);
+	plugin_view.ball_y = static_cast<float>(view.ball_rect_.y);
+	plugin_view.ball_size = static_cast<float>(view.ball_rect_.w);
+	plugin_view.ball_vx = static_cast<float>(view.ball_vx_);
+	plugin_view.ball_vy = static_cast<float>(view.ball_vy_);
+	plugin_view.has_ball_edge_crossing = view.has_ball_edge_crossing_ ? 1 : 0;
+	plugin_view.ball_edge_crossing_x = static_cast<float>(view.ball_edge_crossing_.x);
+	plugin_view.ball_edge_crossing_y = static_cast<float>(view.ball_edge_crossing_.y);
+	plugin_view.paddle_x = static_cast<float>(view.paddle_rect_.x);
+	plugin_view.paddle_y = static_cast<float>(view.paddle_rect_.y);
+	plugin_view.paddle_width = static_cast<float>(view.paddle_rect_.w);
+	plugin_view.paddle_height = static_cast<float>(view.paddle_rect_.h);
+	plugin_view.opponent_paddle_x = static_cast<float>(view.opponent_paddle_rect_.x);
+	plugin_view.opponent_paddle_y = static_cast<float>(view.opponent_paddle_rect_.y);
+	plugin_view.opponent_paddle_width = static_cast<float>(view.opponent_paddle_rect_.w);
+	plugin_view.opponent_paddle_height = static_cast<float>(view.opponent_paddle_rect_.h);
+	plugin_view.score = view.score_;
+	plugin_view.opponent_score = view.opponent_score_;
+	plugin_view.max_speed = static_cast<float>(view.max_speed_);
+	plugin_view.target_x = static_cast<float>(view.target_.x);
+	plugin_view.target_y = static_cast<float>(view.target_.y);
+
+	PongAiCommand plugin_command = { 0.0f, plugin_view.target_x, plugin_view.target_y };
+	controller_->tick(state_, &plugin_view, &plugin_command);
+
+	const float max_speed = plugin_view.max_speed;
+	const float paddle_vy = std::isfinite(plugin_command.paddle_vy) ? std::clamp(plugin_command.paddle_vy, -max_speed, max_speed) : 0.0f;
+
+	AiCommand command;
+	command.paddle_vy_ = Scalar(paddle_vy);
+	command.target_.x = std::isfinite(plugin_command.target_x) ? Scalar(std::clamp(plugin_command.target_x, 0.0f, plugin_view.field_width)) : view.target_.x;
+	command.target_.y = std::isfinite(plugin_command.target_y) ? Scalar(std::clamp(plugin_command.target_y, 0.0f, plugin_view.field_height)) : view.target_.y;
+
+	return command;
+}
@@ -0,0 +1,481 @@
+#include "AllocationTracker.hpp"
+
+#if PONG_ALLOC_TRACKING
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Call sites are backtraces, so tracking builds need glibc and should link with -rdynamic for readable symbols.
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+namespace
+{
+	constexpr int max_frames = 12;
+	constexpr std::size_t site_capacity = 2048;
+	constexpr std::size_t phase_count = static_cast<std::size_t>(AllocationPhase::COUNT);
+
+	// RecordAllocation, the allocating helper and operator new (or SDL_malloc) sit on top of every backtrace.
+	constexpr int skipped_frames = 3;
+
+	struct AllocationSite
+	{
+		std::atomic<std::uint64_t> key;
+		void* frames[max_frames];
+		int frame_count;
+		std::atomic<std::uint64_t> counts[phase_count];
+		std::atomic<std::uint64_t> steady_count;
+		std::atomic<std::uint64_t> bytes;
+	};
+
+	// Zero-initialized static storage only: operator new can run before any constructor in the program does.
+	AllocationSite sites[site_capacity];
+	std::atomic<std::uint64_t> phase_allocations[phase_count];
+	std::atomic<std::uint64_t> total_bytes;
+	std::atomic<std::uint64_t> total_frees;
+	std::atomic<std::uint64_t> steady_allocations;
+	std::atomic<std::uint64_t> untracked_sites;
+	std::atomic<std::uint64_t> ticks;
+	std::atomic<std::uint64_t> frames;
+
+	thread_local bool in_tracker = false;
+	thread_local AllocationPhase thread_phase = AllocationPhase::OTHER;
+	thread_local bool thread_steady_state = false;
+
+	AllocationSite* FindSite(void* const* stack, int frame_count)
+	{
+		std::uint64_t key = 14695981039346656037ULL;
+
+		for (int i = 0; i < frame_count; ++i)
+		{
+			key = (key ^ reinterpret_cast<std::uintptr_t>(stack[i])) * 1099511628211ULL;
+		}
+
+		key = key == 0 ? 1 : key;
+
+		for (std::size_t probe = 0; probe < site_capacity; ++probe)
+		{
+			AllocationSite& site = sites[(key + probe) % site_capacity];
+			std::uint64_t site_key = site.key.load(std::memory_order_acquire);
+
+			if (site_key == 0 && site.key.compare_exchange_strong(site_key, key, std::memory_order_acq_rel))
+			{
+				std::memcpy(site.frames, stack, sizeof(void*) * static_cast<std::size_t>(frame_count));
+				site.frame_count = frame_count;
+				return &site;
+			}
+
+			if (site_key == key)
+			{
+				return &site;
+			}
+		}
+
+		return nullptr;
+	}
+
+	__attribute__((noinline)) void RecordAllocation(std::size_t size)
+	{
+		// The tracker's own allocations (libgcc loading for backtrace, symbolizing the report) are not counted.
+		if (in_tracker)
+		{
+			return;
+		}
+
+		const std::size_t phase = static_cast<std::size_t>(thread_phase);
+
+		phase_allocations[phase].fetch_add(1, std::memory_order_relaxed);
+		total_bytes.fetch_add(size, std::memory_order_relaxed);
+
+		if (thread_steady_state)
+		{
+			steady_allocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		in_tracker = true;
+
+		void* stack[max_frames + skipped_frames];
+		const int frame_count = backtrace(stack, max_frames + skipped_frames) - skipped_frames;
+		AllocationSite* site = frame_count > 0 ? FindSite(stack + skipped_frames, frame_count) : nullptr;
+
+		if (site != nullptr)
+		{
+			site->counts[phase].fetch_add(1, std::memory_order_relaxed);
+			site->bytes.fetch_add(size, std::memory_order_relaxed);
+
+			if (thread_steady_state)
+			{
+				site->steady_count.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		else
+		{
+			untracked_sites.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		in_tracker = false;
+	}
+
+	void RecordFree(void* pointer)
+	{
+		if (pointer != nullptr)
+		{
+			total_frees.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	__attribute__((noinline)) void* Allocate(std::size_t size)
+	{
+		RecordAllocation(size);
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	__attribute__((noinline)) void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		RecordAllocation(size);
+
+		void* pointer = nullptr;
+		const std::size_t alignment_bytes = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+
+		return posix_memalign(&pointer, alignment_bytes, size == 0 ? 1 : size) == 0 ? pointer : nullptr;
+	}
+
+	void* TrackedSdlMalloc(size_t size)
+	{
+		RecordAllocation(size);
+		return std::malloc(size);
+	}
+
+	void* TrackedSdlCalloc(size_t count, size_t size)
+	{
+		RecordAllocation(count * size);
+		return std::calloc(count, size);
+	}
+
+	void* TrackedSdlRealloc(void* pointer, size_t size)
+	{
+		RecordAllocation(size);
+		return std::realloc(pointer, size);
+	}
+
+	void TrackedSdlFree(void* pointer)
+	{
+		RecordFree(pointer);
+		std::free(pointer);
+	}
+
+	// Writes the frame as a demangled symbol, or as module+offset when the symbol is not exported.
+	void PrintFrame(FILE* file, void* address)
+	{
+		Dl_info info;
+
+		if (dladdr(address, &info) == 0)
+		{
+			fprintf(file, "%p", address);
+			return;
+		}
+
+		if (info.dli_sname == nullptr)
+		{
+			fprintf(file, "%s+%#lx", info.dli_fname, static_cast<unsigned long>(reinterpret_cast<std::uintptr_t>(address) - reinterpret_cast<std::uintptr_t>(info.dli_fbase)));
+			return;
+		}
+
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+
+		fprintf(file, "%s", status == 0 ? demangled : info.dli_sname);
+		std::free(demangled);
+	}
+
+	// Standard library and SDL frames say how, not where; the first frame outside them is the call site.
+	bool IsLibraryFrame(void* address)
+	{
+		Dl_info info;
+
+		if (dladdr(address, &info) == 0 || info.dli_sname == nullptr)
+		{
+			return false;
+		}
+
+		const char* name = info.dli_sname;
+
+		return std::strncmp(name, "_ZNSt", 5) == 0 || std::strncmp(name, "_ZSt", 4) == 0 || std::strncmp(name, "_ZN9__gnu_cxx", 14) == 0 ||
+			std::strncmp(name, "_Znw", 4) == 0 || std::strncmp(name, "_Zna", 4) == 0 || std::strncmp(name, "SDL_", 4) == 0 ||
+			std::strncmp(name, "TTF_", 4) == 0 || std::strncmp(name, "IMG_", 4) == 0 || std::strncmp(name, "Mix_", 4) == 0;
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	void* pointer = Allocate(size);
+
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	void* pointer = Allocate(size);
+
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	void* pointer = AllocateAligned(size, alignment);
+
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	void* pointer = AllocateAligned(size, alignment);
+
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+	RecordFree(pointer);
+	std::free(pointer);
+}
+
+bool AllocationTracker::IsEnabled()
+{
+	return true;
+}
+
+void AllocationTracker::HookSdl()
+{
+	if (SDL_SetMemoryFunctions(&TrackedSdlMalloc, &TrackedSdlCalloc, &TrackedSdlRealloc, &TrackedSdlFree) < 0)
+	{
+		fprintf(stderr, "Unable to hook SDL's allocator! SDL Error: %s\n", SDL_GetError());
+	}
+}
+
+void AllocationTracker::SetPhase(AllocationPhase phase)
+{
+	thread_phase = phase;
+}
+
+void AllocationTracker::CountTick()
+{
+	ticks.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationTracker::CountFrame()
+{
+	frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationTracker::SetSteadyState(bool steady_state)
+{
+	thread_steady_state = steady_state;
+}
+
+std::uint64_t AllocationTracker::GetSteadyStateAllocations()
+{
+	return steady_allocations.load();
+}
+
+void AllocationTracker::PrintReport(FILE* file)
+{
+	const bool was_in_tracker = in_tracker;
+	in_tracker = true;
+
+	const std::uint64_t tick_count = ticks.load();
+	const std::uint64_t frame_count = frames.load();
+	const std::uint64_t tick_allocations = phase_allocations[static_cast<std::size_t>(AllocationPhase::TICK)].load();
+	const std::uint64_t render_allocations = phase_allocations[static_cast<std::size_t>(AllocationPhase::RENDER)].load();
+	const std::uint64_t other_allocations = phase_allocations[static_cast<std::size_t>(AllocationPhase::OTHER)].load();
+
+	fprintf(file, "Allocations: %llu (%llu bytes), %llu frees, %llu in steady state\n",
+		static_cast<unsigned long long>(tick_allocations + render_allocations + other_allocations), static_cast<unsigned long long>(total_bytes.load()),
+		static_cast<unsigned long long>(total_frees.load()), static_cast<unsigned long long>(steady_allocations.load()));
+	fprintf(file, "  tick:   %llu over %llu ticks (%.3f per tick)\n", static_cast<unsigned long long>(tick_allocations), static_cast<unsigned long long>(tick_count),
+		tick_count == 0 ? 0.0 : static_cast<double>(tick_allocations) / static_cast<double>(tick_count));
+	fprintf(file, "  render: %llu over %llu frames (%.3f per frame)\n", static_cast<unsigned long long>(render_allocations), static_cast<unsigned long long>(frame_count),
+		frame_count == 0 ? 0.0 : static_cast<double>(render_allocations) / static_cast<double>(frame_count));
+	fprintf(file, "  other:  %llu\n", static_cast<unsigned long long>(other_allocations));
+
+	static std::size_t order[site_capacity];
+	std::size_t site_count = 0;
+
+	for (std::size_t i = 0; i < site_capacity; ++i)
+	{
+		if (sites[i].key.load() != 0)
+		{
+			order[site_count++] = i;
+		}
+	}
+
+	// Steady-state offenders first, then the busiest tick and render sites.
+	const auto site_rank = [](const AllocationSite& site)
+		{
+			return site.steady_count.load() * 1000000 + site.counts[static_cast<std::size_t>(AllocationPhase::TICK)].load() + site.counts[static_cast<std::size_t>(AllocationPhase::RENDER)].load();
+		};
+
+	std::sort(order, order + site_count, [&site_rank](std::size_t a, std::size_t b)
+		{
+			return site_rank(sites[a]) > site_rank(sites[b]);
+		});
+
+	constexpr std::size_t printed_sites = 20;
+
+	fprintf(file, "  %8s %8s %8s %8s %10s  %s\n", "steady", "tick", "render", "other", "bytes", "call site");
+
+	for (std::size_t i = 0; i < std::min(site_count, printed_sites); ++i)
+	{
+		const AllocationSite& site = sites[order[i]];
+
+		fprintf(file, "  %8llu %8llu %8llu %8llu %10llu  ", static_cast<unsigned long long>(site.steady_count.load()),
+			static_cast<unsigned long long>(site.counts[static_cast<std::size_t>(AllocationPhase::TICK)].load()),
+			static_cast<unsigned long long>(site.counts[static_cast<std::size_t>(AllocationPhase::RENDER)].load()),
+			static_cast<unsigned long long>(site.counts[static_cast<std::size_t>(AllocationPhase::OTHER)].load()),
+			static_cast<unsigned long long>(site.bytes.load()));
+
+		int first_own_frame = 0;
+
+		while (first_own_frame + 1 < site.frame_count && IsLibraryFrame(site.frames[first_own_frame]))
+		{
+			++first_own_frame;
+		}
+
+		// The call site and two of its callers.
+		for (int frame = first_own_frame; frame < std::min(site.frame_count, first_own_frame + 3); ++frame)
+		{
+			if (frame != first_own_frame)
+			{
+				fprintf(file, "%s", " <- ");
+			}
+
+			PrintFrame(file, site.frames[frame]);
+		}
+
+		fprintf(file, "%s", "\n");
+	}
+
+	if (untracked_sites.load() != 0)
+	{
+		fprintf(file, "  %llu allocations did not fit in the call site table\n", static_cast<unsigned long long>(untracked_sites.load()));
+	}
+
+	in_tracker = was_in_tracker;
+}
+
+#else
+
+bool AllocationTracker::IsEnabled()
+{
+	return false;
+}
+
+void AllocationTracker::HookSdl()
+{
+}
+
+void AllocationTracker::SetPhase(AllocationPhase)
+{
+}
+
+void AllocationTracker::CountTick()
+{
+}
+
+void AllocationTracker::CountFrame()
+{
+}
+
+void AllocationTracker::SetSteadyState(bool)
+{
+}
+
+std::uint64_t AllocationTracker::GetSteadyStateAllocations()
+{
+	return 0;
+}
+
+void AllocationTracker::PrintReport(FILE* file)
+{
+	fprintf(file, "%s\n", "Allocation tracking is not compiled in; rebuild with ALLOC_TRACKING=1.");
+}
+
+#endif
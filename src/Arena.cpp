@@ -0,0 +1,624 @@
+#include "Arena.hpp"
+#include "Constants.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	constexpr int serve_area_size = 14;
+
+	std::uint64_t HashBytes(std::uint64_t hash, const void* data, std::size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	std::uint64_t HashScalar(std::uint64_t hash, Scalar value)
+	{
+#if PONG_FIXED_POINT
+		return HashBytes(hash, &value.raw_, sizeof(value.raw_));
+#else
+		return HashBytes(hash, &value, sizeof(value));
+#endif
+	}
+
+	Bounds Union(const Bounds& a, const Bounds& b)
+	{
+		return { std::min(a.min_x, b.min_x), std::min(a.min_y, b.min_y), std::max(a.max_x, b.max_x), std::max(a.max_y, b.max_y) };
+	}
+
+	// Twice the centre, which orders obstacles just the same without a division.
+	Scalar GetCentre(const Obstacle& obstacle, bool x_axis)
+	{
+		return x_axis ? obstacle.a_.x + obstacle.b_.x : obstacle.a_.y + obstacle.b_.y;
+	}
+
+	// Whether the segment from a to b touches bounds: the boxes overlap and the corners are not all strictly on one
+	// side of the segment's line.
+	bool SegmentTouchesBounds(const Vec2& a, const Vec2& b, const Bounds& bounds)
+	{
+		if (std::max(a.x, b.x) < bounds.min_x || std::min(a.x, b.x) > bounds.max_x || std::max(a.y, b.y) < bounds.min_y || std::min(a.y, b.y) > bounds.max_y)
+		{
+			return false;
+		}
+
+		const Scalar dx = b.x - a.x;
+		const Scalar dy = b.y - a.y;
+
+		const Scalar c1 = dx * (bounds.min_y - a.y) - dy * (bounds.min_x - a.x);
+		const Scalar c2 = dx * (bounds.min_y - a.y) - dy * (bounds.max_x - a.x);
+		const Scalar c3 = dx * (bounds.max_y - a.y) - dy * (bounds.min_x - a.x);
+		const Scalar c4 = dx * (bounds.max_y - a.y) - dy * (bounds.max_x - a.x);
+
+		const bool all_above = c1 > Scalar(0) && c2 > Scalar(0) && c3 > Scalar(0) && c4 > Scalar(0);
+		const bool all_below = c1 < Scalar(0) && c2 < Scalar(0) && c3 < Scalar(0) && c4 < Scalar(0);
+
+		return !all_above && !all_below;
+	}
+
+	// Where along the ray from start by direction it crosses the segment from a to b, as a fraction of direction.
+	bool IntersectSegment(const Vec2& start, const Vec2& direction, const Vec2& a, const Vec2& b, Scalar& t)
+	{
+		const Scalar segment_x = b.x - a.x;
+		const Scalar segment_y = b.y - a.y;
+		Scalar denominator = direction.x * segment_y - direction.y * segment_x;
+
+		if (denominator == Scalar(0))
+		{
+			return false;
+		}
+
+		const Scalar offset_x = a.x - start.x;
+		const Scalar offset_y = a.y - start.y;
+		Scalar t_numerator = offset_x * segment_y - offset_y * segment_x;
+		Scalar u_numerator = offset_x * direction.y - offset_y * direction.x;
+
+		if (denominator < Scalar(0))
+		{
+			denominator = -denominator;
+			t_numerator = -t_numerator;
+			u_numerator = -u_numerator;
+		}
+
+		if (t_numerator < Scalar(0) || t_numerator > denominator || u_numerator < Scalar(0) || u_numerator > denominator)
+		{
+			return false;
+		}
+
+		t = t_numerator / denominator;
+		return true;
+	}
+
+	std::string Trim(const std::string& text)
+	{
+		const std::size_t first = text.find_first_not_of(" \t\r");
+
+		if (first == std::string::npos)
+		{
+			return std::string();
+		}
+
+		return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+	}
+}
+
+Arena::Arena() :
+	hash_(0)
+{
+}
+
+const Arena& Arena::GetEmpty()
+{
+	static const Arena empty;
+	return empty;
+}
+
+bool Arena::Load(const std::string& path)
+{
+	TRACE_ZONE("Arena::Load");
+
+	Clear();
+
+	std::ifstream file(path);
+
+	if (!file)
+	{
+		fprintf(stderr, "Unable to open arena %s!\n", path.c_str());
+		return false;
+	}
+
+	std::stringstream text;
+	text << file.rdbuf();
+
+	if (!Parse(path, text.str()))
+	{
+		fprintf(stderr, "Unable to load arena %s!\n", path.c_str());
+		Clear();
+		return false;
+	}
+
+	name_ = path;
+	Build();
+
+	fprintf(stderr, "Loaded arena %s: %zu obstacles, %zu BVH nodes\n", path.c_str(), obstacles_.size(), nodes_.size());
+
+	return true;
+}
+
+bool Arena::Parse(const std::string& path, const std::string& text)
+{
+	std::istringstream lines(text);
+	std::string line;
+	int line_number = 0;
+	bool valid = true;
+
+	const Rect serve_area = { Scalar((constants::screen_width - serve_area_size) / 2), Scalar((constants::screen_height - serve_area_size) / 2),
+		Scalar(serve_area_size), Scalar(serve_area_size) };
+
+	while (std::getline(lines, line))
+	{
+		++line_number;
+
+		line = Trim(line.substr(0, line.find('#')));
+
+		if (line.empty())
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		std::string kind;
+		float values[4];
+		std::string extra;
+
+		fields >> kind >> values[0] >> values[1] >> values[2] >> values[3];
+
+		if (fields.fail() || (fields >> extra) || (kind != "segment" && kind != "box"))
+		{
+			fprintf(stderr, "%s:%d: expected segment X1 Y1 X2 Y2 or box X Y WIDTH HEIGHT\n", path.c_str(), line_number);
+			valid = false;
+			continue;
+		}
+
+		if (obstacles_.size() == max_obstacles)
+		{
+			fprintf(stderr, "%s:%d: more than %zu obstacles\n", path.c_str(), line_number, max_obstacles);
+			return false;
+		}
+
+		// Parsed once at load, so every build of the same file has the same obstacles, bit for bit.
+		const Vec2 a = { Scalar(values[0]), Scalar(values[1]) };
+		const Vec2 b = kind == "box" ? Vec2{ Scalar(values[0] + values[2]), Scalar(values[1] + values[3]) } : Vec2{ Scalar(values[2]), Scalar(values[3]) };
+
+		if (kind == "box" ? !(values[2] > 0.0f && values[3] > 0.0f) : (a.x == b.x && a.y == b.y))
+		{
+			fprintf(stderr, "%s:%d: the %s is empty\n", path.c_str(), line_number, kind.c_str());
+			valid = false;
+			continue;
+		}
+
+		const Obstacle obstacle = { kind == "box" ? ObstacleType::BOX : ObstacleType::SEGMENT, a, b };
+		const Bounds bounds = GetBounds(obstacle);
+
+		if (bounds.min_x < Scalar(0) || bounds.min_y < Scalar(0) || bounds.max_x > Scalar(constants::screen_width) || bounds.max_y > Scalar(constants::screen_height))
+		{
+			fprintf(stderr, "%s:%d: the %s leaves the field\n", path.c_str(), line_number, kind.c_str());
+			valid = false;
+			continue;
+		}
+
+		if (Overlaps(obstacle, serve_area))
+		{
+			fprintf(stderr, "%s:%d: the %s covers the serve in the centre\n", path.c_str(), line_number, kind.c_str());
+			valid = false;
+			continue;
+		}
+
+		obstacles_.push_back(obstacle);
+	}
+
+	return valid;
+}
+
+void Arena::Clear()
+{
+	name_.clear();
+	obstacles_.clear();
+	nodes_.clear();
+	hash_ = 0;
+
+#if !PONG_FIXED_POINT
+	leaf_edges_.clear();
+#endif
+}
+
+void Arena::AddSegment(const Vec2& a, const Vec2& b)
+{
+	obstacles_.push_back({ ObstacleType::SEGMENT, a, b });
+}
+
+void Arena::AddBox(const Rect& box)
+{
+	obstacles_.push_back({ ObstacleType::BOX, { box.x, box.y }, { box.x + box.w, box.y + box.h } });
+}
+
+void Arena::Build()
+{
+	nodes_.clear();
+	hash_ = 0;
+
+#if !PONG_FIXED_POINT
+	leaf_edges_.clear();
+#endif
+
+	if (obstacles_.empty())
+	{
+		return;
+	}
+
+	nodes_.reserve(2 * obstacles_.size() / max_leaf_obstacles + 1);
+	BuildNode(0, obstacles_.size());
+
+#if !PONG_FIXED_POINT
+	BuildLeafEdges();
+#endif
+
+	hash_ = 14695981039346656037ULL;
+
+	for (const Obstacle& obstacle : obstacles_)
+	{
+		const std::uint8_t type = static_cast<std::uint8_t>(obstacle.type_);
+		hash_ = HashBytes(hash_, &type, sizeof(type));
+		hash_ = HashScalar(hash_, obstacle.a_.x);
+		hash_ = HashScalar(hash_, obstacle.a_.y);
+		hash_ = HashScalar(hash_, obstacle.b_.x);
+		hash_ = HashScalar(hash_, obstacle.b_.y);
+	}
+}
+
+#if !PONG_FIXED_POINT
+void Arena::BuildLeafEdges()
+{
+	leaf_edges_.resize(nodes_.size());
+
+	for (std::size_t index = 0; index < nodes_.size(); ++index)
+	{
+		const Node& node = nodes_[index];
+		LeafEdges& edges = leaf_edges_[index];
+
+		if (node.count_ == 0)
+		{
+			continue;
+		}
+
+		edges.segments_.Reserve(node.count_ * 4);
+
+		for (std::uint32_t i = node.first_or_right_; i < node.first_or_right_ + node.count_; ++i)
+		{
+			const Obstacle& obstacle = obstacles_[i];
+
+			if (obstacle.type_ == ObstacleType::SEGMENT)
+			{
+				edges.segments_.Add(obstacle.a_.x, obstacle.a_.y, obstacle.b_.x, obstacle.b_.y);
+				edges.obstacles_.push_back(static_cast<std::int32_t>(i));
+				edges.normals_.push_back({ obstacle.a_.y - obstacle.b_.y, obstacle.b_.x - obstacle.a_.x });
+				continue;
+			}
+
+			const Vec2 corners[5] = { obstacle.a_, { obstacle.b_.x, obstacle.a_.y }, obstacle.b_, { obstacle.a_.x, obstacle.b_.y }, obstacle.a_ };
+			const Vec2 normals[4] = { { 0.0f, -1.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { -1.0f, 0.0f } };
+
+			for (int side = 0; side < 4; ++side)
+			{
+				edges.segments_.Add(corners[side].x, corners[side].y, corners[side + 1].x, corners[side + 1].y);
+				edges.obstacles_.push_back(static_cast<std::int32_t>(i));
+				edges.normals_.push_back(normals[side]);
+			}
+		}
+	}
+}
+#endif
+
+std::uint32_t Arena::BuildNode(std::size_t begin, std::size_t end)
+{
+	const std::uint32_t index = static_cast<std::uint32_t>(nodes_.size());
+	nodes_.push_back({});
+
+	Bounds bounds = GetBounds(obstacles_[begin]);
+	Bounds centres = { GetCentre(obstacles_[begin], true), GetCentre(obstacles_[begin], false), GetCentre(obstacles_[begin], true), GetCentre(obstacles_[begin], false) };
+
+	for (std::size_t i = begin + 1; i < end; ++i)
+	{
+		bounds = Union(bounds, GetBounds(obstacles_[i]));
+
+		const Scalar centre_x = GetCentre(obstacles_[i], true);
+		const Scalar centre_y = GetCentre(obstacles_[i], false);
+		centres = Union(centres, { centre_x, centre_y, centre_x, centre_y });
+	}
+
+	if (end - begin <= max_leaf_obstacles)
+	{
+		nodes_[index] = { bounds, static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end - begin) };
+		return index;
+	}
+
+	// Halves at the median centre along the longer side of the centres' bounds. A stable sort keeps the file's order
+	// among equal centres, so the tree, and with it which obstacle a query finds first, is the same everywhere.
+	const bool x_axis = centres.max_x - centres.min_x >= centres.max_y - centres.min_y;
+
+	std::stable_sort(obstacles_.begin() + begin, obstacles_.begin() + end,
+		[x_axis](const Obstacle& a, const Obstacle& b) { return GetCentre(a, x_axis) < GetCentre(b, x_axis); });
+
+	const std::size_t middle = begin + (end - begin) / 2;
+
+	BuildNode(begin, middle);
+	const std::uint32_t right = BuildNode(middle, end);
+
+	nodes_[index] = { bounds, right, 0 };
+	return index;
+}
+
+bool Arena::IsEmpty() const
+{
+	return obstacles_.empty();
+}
+
+const std::string& Arena::GetName() const
+{
+	return name_;
+}
+
+std::size_t Arena::GetObstacleCount() const
+{
+	return obstacles_.size();
+}
+
+const Obstacle& Arena::GetObstacle(std::int32_t index) const
+{
+	return obstacles_[static_cast<std::size_t>(index)];
+}
+
+std::size_t Arena::GetNodeCount() const
+{
+	return nodes_.size();
+}
+
+std::uint64_t Arena::GetHash() const
+{
+	return hash_;
+}
+
+std::int32_t Arena::FindOverlap(const Rect& rect) const
+{
+	if (nodes_.empty())
+	{
+		return -1;
+	}
+
+	const Bounds query = { rect.x, rect.y, rect.x + rect.w, rect.y + rect.h };
+
+	std::uint32_t stack[max_depth];
+	std::size_t stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0)
+	{
+		const std::uint32_t index = stack[--stack_size];
+		const Node& node = nodes_[index];
+
+		// Bounds that only touch the query cannot hold an overlapping obstacle either.
+		if (node.bounds_.max_x <= query.min_x || node.bounds_.min_x >= query.max_x || node.bounds_.max_y <= query.min_y || node.bounds_.min_y >= query.max_y)
+		{
+			continue;
+		}
+
+		if (node.count_ > 0)
+		{
+			for (std::uint32_t i = node.first_or_right_; i < node.first_or_right_ + node.count_; ++i)
+			{
+				if (Overlaps(obstacles_[i], rect))
+				{
+					return static_cast<std::int32_t>(i);
+				}
+			}
+
+			continue;
+		}
+
+		stack[stack_size++] = node.first_or_right_;
+		stack[stack_size++] = index + 1;
+	}
+
+	return -1;
+}
+
+bool Arena::CastRay(const Line& ray, std::int32_t ignore, ArenaHit& hit) const
+{
+	TRACE_ZONE("Arena::CastRay");
+
+	if (nodes_.empty())
+	{
+		return false;
+	}
+
+	const Vec2 start = ray.start_point;
+	const Vec2 direction = { ray.end_point.x - ray.start_point.x, ray.end_point.y - ray.start_point.y };
+
+	// Shortened to the nearest hit so far, so nodes beyond it are skipped.
+	Scalar best_t = Scalar(1);
+	Vec2 end = ray.end_point;
+	bool found = false;
+
+	std::uint32_t stack[max_depth];
+	std::size_t stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0)
+	{
+		const std::uint32_t index = stack[--stack_size];
+		const Node& node = nodes_[index];
+
+		if (!SegmentTouchesBounds(start, end, node.bounds_))
+		{
+			continue;
+		}
+
+		if (node.count_ == 0)
+		{
+			// Nearer child on top, so its hits shorten the ray before the other child is tested.
+			const Bounds& left = nodes_[index + 1].bounds_;
+			const Bounds& right = nodes_[node.first_or_right_].bounds_;
+			const Scalar left_distance = PointsDistanceSquared((left.min_x + left.max_x) / Scalar(2), (left.min_y + left.max_y) / Scalar(2), start.x, start.y);
+			const Scalar right_distance = PointsDistanceSquared((right.min_x + right.max_x) / Scalar(2), (right.min_y + right.max_y) / Scalar(2), start.x, start.y);
+
+			if (left_distance <= right_distance)
+			{
+				stack[stack_size++] = node.first_or_right_;
+				stack[stack_size++] = index + 1;
+			}
+			else
+			{
+				stack[stack_size++] = index + 1;
+				stack[stack_size++] = node.first_or_right_;
+			}
+
+			continue;
+		}
+
+#if !PONG_FIXED_POINT
+		// The kernel cannot skip an obstacle, so the leaf a reflected ray starts in is tested one edge at a time.
+		const bool holds_ignore = ignore >= static_cast<std::int32_t>(node.first_or_right_) && ignore < static_cast<std::int32_t>(node.first_or_right_ + node.count_);
+
+		if (!holds_ignore)
+		{
+			const LeafEdges& edges = leaf_edges_[index];
+			const SegmentHit edge_hit = segment_kernel::FindNearestHit(edges.segments_, start.x, start.y, ray.end_point.x, ray.end_point.y);
+
+			if (edge_hit.index >= 0 && (!found || edge_hit.t < best_t))
+			{
+				found = true;
+				best_t = edge_hit.t;
+				hit.obstacle_ = edges.obstacles_[static_cast<std::size_t>(edge_hit.index)];
+				hit.normal_ = edges.normals_[static_cast<std::size_t>(edge_hit.index)];
+			}
+		}
+		else
+		{
+			CastRayThroughLeaf(node, start, direction, ignore, found, best_t, hit);
+		}
+#else
+		CastRayThroughLeaf(node, start, direction, ignore, found, best_t, hit);
+#endif
+
+		if (found)
+		{
+			end = { start.x + direction.x * best_t, start.y + direction.y * best_t };
+		}
+	}
+
+	if (found)
+	{
+		hit.point_ = end;
+	}
+
+	return found;
+}
+
+void Arena::CastRayThroughLeaf(const Node& node, const Vec2& start, const Vec2& direction, std::int32_t ignore, bool& found, Scalar& best_t,
+	ArenaHit& hit) const
+{
+	for (std::uint32_t i = node.first_or_right_; i < node.first_or_right_ + node.count_; ++i)
+	{
+		if (static_cast<std::int32_t>(i) == ignore)
+		{
+			continue;
+		}
+
+		const Obstacle& obstacle = obstacles_[i];
+		Scalar t;
+
+		if (obstacle.type_ == ObstacleType::SEGMENT)
+		{
+			if (IntersectSegment(start, direction, obstacle.a_, obstacle.b_, t) && (!found || t < best_t))
+			{
+				found = true;
+				best_t = t;
+				hit.obstacle_ = static_cast<std::int32_t>(i);
+				hit.normal_ = { obstacle.a_.y - obstacle.b_.y, obstacle.b_.x - obstacle.a_.x };
+			}
+
+			continue;
+		}
+
+		// A box's sides, clockwise from the top, with their outward normals.
+		const Vec2 top_left = obstacle.a_;
+		const Vec2 top_right = { obstacle.b_.x, obstacle.a_.y };
+		const Vec2 bottom_right = obstacle.b_;
+		const Vec2 bottom_left = { obstacle.a_.x, obstacle.b_.y };
+
+		const Vec2 corners[5] = { top_left, top_right, bottom_right, bottom_left, top_left };
+		const Vec2 normals[4] = { { Scalar(0), Scalar(-1) }, { Scalar(1), Scalar(0) }, { Scalar(0), Scalar(1) }, { Scalar(-1), Scalar(0) } };
+
+		for (int side = 0; side < 4; ++side)
+		{
+			if (IntersectSegment(start, direction, corners[side], corners[side + 1], t) && (!found || t < best_t))
+			{
+				found = true;
+				best_t = t;
+				hit.obstacle_ = static_cast<std::int32_t>(i);
+				hit.normal_ = normals[side];
+			}
+		}
+	}
+}
+
+Bounds Arena::GetBounds(const Obstacle& obstacle)
+{
+	return { std::min(obstacle.a_.x, obstacle.b_.x), std::min(obstacle.a_.y, obstacle.b_.y), std::max(obstacle.a_.x, obstacle.b_.x), std::max(obstacle.a_.y, obstacle.b_.y) };
+}
+
+bool Arena::Overlaps(const Obstacle& obstacle, const Rect& rect)
+{
+	if (obstacle.type_ == ObstacleType::BOX)
+	{
+		return RectsIntersect(rect, { obstacle.a_.x, obstacle.a_.y, obstacle.b_.x - obstacle.a_.x, obstacle.b_.y - obstacle.a_.y });
+	}
+
+	const Bounds bounds = GetBounds(obstacle);
+
+	if (bounds.max_x <= rect.x || bounds.min_x >= rect.x + rect.w || bounds.max_y <= rect.y || bounds.min_y >= rect.y + rect.h)
+	{
+		return false;
+	}
+
+	// Inside the bounds, the segment crosses the rect when its corners are strictly on both sides of its line.
+
+	const Scalar dx = obstacle.b_.x - obstacle.a_.x;
+	const Scalar dy = obstacle.b_.y - obstacle.a_.y;
+	const Scalar left = rect.x - obstacle.a_.x;
+	const Scalar right = rect.x + rect.w - obstacle.a_.x;
+	const Scalar top = rect.y - obstacle.a_.y;
+	const Scalar bottom = rect.y + rect.h - obstacle.a_.y;
+
+	const Scalar c1 = dx * top - dy * left;
+	const Scalar c2 = dx * top - dy * right;
+	const Scalar c3 = dx * bottom - dy * left;
+	const Scalar c4 = dx * bottom - dy * right;
+
+	const Scalar lowest = std::min(std::min(c1, c2), std::min(c3, c4));
+	const Scalar highest = std::max(std::max(c1, c2), std::max(c3, c4));
+
+	return lowest < Scalar(0) && highest > Scalar(0);
+}
@@ -0,0 +1,311 @@
+#include "Audio.hpp"
+#include "Synth.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+std::unique_ptr<Audio> Audio::audio_ = std::make_unique<Audio>();
+
+namespace
+{
+	constexpr Blip button_click_blip = { 1000.0f, 1000.0f, 15, 0.2f };
+	constexpr Blip paddle_hit_blip = { 440.0f, 440.0f, 60, 0.25f };
+	constexpr Blip wall_bounce_blip = { 220.0f, 220.0f, 50, 0.2f };
+	constexpr Blip goal_blip = { 490.0f, 245.0f, 250, 0.25f };
+
+	void UpdateMax(std::atomic<std::uint64_t>& maximum, std::uint64_t value)
+	{
+		std::uint64_t current = maximum.load(std::memory_order_relaxed);
+
+		while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+		{
+		}
+	}
+}
+
+Audio::Audio() :
+	opened_(false),
+	frequency_(0),
+	channels_(0),
+	buffer_size_(0),
+	chunk_count_(0),
+	synthesis_us_(0),
+	dropped_events_(0),
+	latency_samples_(0),
+	latency_total_us_(0),
+	latency_max_us_(0),
+	callback_start_counter_(0),
+	callback_samples_(0),
+	callback_total_ns_(0),
+	callback_max_ns_(0)
+{
+	chunks_.fill(nullptr);
+	first_chunk_.fill(0);
+
+	for (std::atomic<std::uint64_t>& posted_counter : channel_posted_counter_)
+	{
+		posted_counter.store(0, std::memory_order_relaxed);
+	}
+}
+
+Audio::~Audio()
+{
+	Close();
+}
+
+Audio* Audio::Instance()
+{
+	return audio_.get();
+}
+
+bool Audio::Open(int buffer_size)
+{
+	Close();
+
+	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, buffer_size) < 0)
+	{
+		printf("SDL_mixer could not be initialized! SDL_mixer Error: %s\n", Mix_GetError());
+		return false;
+	}
+
+	// Mix_OpenAudio may change the rate and channel count but keeps the format, so the PCM is always 16-bit.
+	Uint16 format;
+	Mix_QuerySpec(&frequency_, &format, &channels_);
+	buffer_size_ = buffer_size;
+	opened_ = true;
+
+	Mix_AllocateChannels(channel_count);
+
+	const std::uint64_t synthesis_start = SDL_GetPerformanceCounter();
+	SynthesizeSounds();
+	synthesis_us_ = (SDL_GetPerformanceCounter() - synthesis_start) * 1000000 / SDL_GetPerformanceFrequency();
+
+	Mix_HookMusic(&Audio::BeginMix, this);
+	Mix_SetPostMix(&Audio::EndMix, this);
+	Mix_ChannelFinished(&Audio::ChannelDone);
+
+	return true;
+}
+
+void Audio::SynthesizeSounds()
+{
+	Blip blips[max_chunks];
+	std::size_t count = 0;
+
+	first_chunk_[static_cast<std::size_t>(Sound::BUTTON_CLICK)] = count;
+	blips[count++] = button_click_blip;
+
+	// Flat returns get the base pitch and the steepest ones an octave above it.
+	first_chunk_[static_cast<std::size_t>(Sound::PADDLE_HIT)] = count;
+
+	for (std::size_t i = 0; i < paddle_hit_variants; ++i)
+	{
+		Blip blip = paddle_hit_blip;
+		const float pitch = 1.0f + static_cast<float>(i) / static_cast<float>(paddle_hit_variants - 1);
+		blip.start_hz *= pitch;
+		blip.end_hz *= pitch;
+		blips[count++] = blip;
+	}
+
+	first_chunk_[static_cast<std::size_t>(Sound::WALL_BOUNCE)] = count;
+	blips[count++] = wall_bounce_blip;
+
+	first_chunk_[static_cast<std::size_t>(Sound::GOAL)] = count;
+	blips[count++] = goal_blip;
+
+	std::size_t total_frames = 0;
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		total_frames += BlipFrameCount(blips[i], frequency_);
+	}
+
+	// One block for every variant, sized up front so the chunks can point straight into it.
+	pcm_.assign(total_frames * static_cast<std::size_t>(channels_), 0);
+	Sint16* output = pcm_.data();
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const std::size_t samples = BlipFrameCount(blips[i], frequency_) * static_cast<std::size_t>(channels_);
+
+		SynthesizeBlip(blips[i], frequency_, channels_, output);
+		chunks_[i] = Mix_QuickLoad_RAW(reinterpret_cast<Uint8*>(output), static_cast<Uint32>(samples * sizeof(Sint16)));
+		output += samples;
+	}
+
+	chunk_count_ = count;
+}
+
+void Audio::Close()
+{
+	if (!opened_)
+	{
+		return;
+	}
+
+	Mix_HookMusic(nullptr, nullptr);
+	Mix_SetPostMix(nullptr, nullptr);
+	Mix_ChannelFinished(nullptr);
+	Mix_HaltChannel(-1);
+	Mix_CloseAudio();
+	opened_ = false;
+
+	PrintReport();
+
+	// QuickLoad chunks do not own their samples; pcm_ is released after them.
+	for (std::size_t i = 0; i < chunk_count_; ++i)
+	{
+		Mix_FreeChunk(chunks_[i]);
+		chunks_[i] = nullptr;
+	}
+
+	chunk_count_ = 0;
+
+	pcm_.clear();
+	pcm_.shrink_to_fit();
+
+	SoundEvent event;
+
+	while (events_.TryPop(event))
+	{
+	}
+}
+
+void Audio::Post(Sound sound, int angle)
+{
+	if (!opened_)
+	{
+		return;
+	}
+
+	std::size_t chunk = first_chunk_[static_cast<std::size_t>(sound)];
+
+	if (sound == Sound::PADDLE_HIT)
+	{
+		const int steepness = std::min(std::abs(angle - 90), 45);
+		chunk += static_cast<std::size_t>(steepness) * (paddle_hit_variants - 1) / 45;
+	}
+
+	if (!events_.TryPush({ chunk, SDL_GetPerformanceCounter() }))
+	{
+		dropped_events_.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void Audio::Update()
+{
+	TRACE_ZONE("Audio::Update");
+
+	SoundEvent event;
+
+	while (events_.TryPop(event))
+	{
+		// The post time goes in before the sound can be mixed; the mixer lock is released by the time Mix_PlayChannel
+		// returns, so storing it afterwards could miss the first mix. A mix in between leaves it alone, since the
+		// channel is not playing yet. A per-sound Mix_RegisterEffect probe would allocate on every play.
+		const int channel = Mix_GroupAvailable(-1);
+
+		if (channel < 0 || channel >= channel_count)
+		{
+			continue;
+		}
+
+		channel_posted_counter_[channel].store(event.posted_counter, std::memory_order_release);
+
+		if (Mix_PlayChannel(channel, chunks_[event.chunk], 0) < 0)
+		{
+			channel_posted_counter_[channel].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void Audio::BeginMix(void* user_data, Uint8* stream, int length)
+{
+	Audio* audio = static_cast<Audio*>(user_data);
+
+	// Standing in for music, the hook owns the stream first and has to clear it before the channels mix in.
+	std::memset(stream, 0, static_cast<std::size_t>(length));
+	audio->callback_start_counter_.store(SDL_GetPerformanceCounter(), std::memory_order_relaxed);
+}
+
+void Audio::EndMix(void* user_data, Uint8* stream, int length)
+{
+	(void)stream;
+	(void)length;
+
+	Audio* audio = static_cast<Audio*>(user_data);
+	const std::uint64_t now = SDL_GetPerformanceCounter();
+	const std::uint64_t frequency = SDL_GetPerformanceFrequency();
+
+	// A channel still playing after this mix has been mixed; one whose sound ended within it was taken by ChannelDone.
+	for (int channel = 0; channel < channel_count; ++channel)
+	{
+		if (audio->channel_posted_counter_[channel].load(std::memory_order_acquire) != 0 && Mix_Playing(channel) != 0)
+		{
+			audio->RecordLatency(channel, now);
+		}
+	}
+
+	const std::uint64_t callback_ns = (now - audio->callback_start_counter_.load(std::memory_order_relaxed)) * 1000000000 / frequency;
+
+	audio->callback_samples_.fetch_add(1, std::memory_order_relaxed);
+	audio->callback_total_ns_.fetch_add(callback_ns, std::memory_order_relaxed);
+	UpdateMax(audio->callback_max_ns_, callback_ns);
+}
+
+// Runs inside the mix when a sound ends, which for a short one can be the first mix it is in.
+void Audio::ChannelDone(int channel)
+{
+	if (channel >= 0 && channel < channel_count)
+	{
+		Audio::Instance()->RecordLatency(channel, SDL_GetPerformanceCounter());
+	}
+}
+
+void Audio::RecordLatency(int channel, std::uint64_t now)
+{
+	const std::uint64_t posted_counter = channel_posted_counter_[channel].exchange(0, std::memory_order_acq_rel);
+
+	if (posted_counter == 0)
+	{
+		return;
+	}
+
+	const std::uint64_t latency_us = (now - posted_counter) * 1000000 / SDL_GetPerformanceFrequency();
+
+	latency_samples_.fetch_add(1, std::memory_order_relaxed);
+	latency_total_us_.fetch_add(latency_us, std::memory_order_relaxed);
+	UpdateMax(latency_max_us_, latency_us);
+}
+
+void Audio::PrintReport() const
+{
+	fprintf(stderr, "Audio: %zu sounds synthesized in %.3f ms, %zu KiB of PCM\n",
+		chunk_count_, static_cast<double>(synthesis_us_) / 1000.0, pcm_.size() * sizeof(Sint16) / 1024);
+
+	const std::uint64_t callbacks = callback_samples_.load();
+
+	if (callbacks != 0)
+	{
+		fprintf(stderr, "Audio: %llu mix callbacks, mean %.1f us, max %.1f us\n", static_cast<unsigned long long>(callbacks),
+			static_cast<double>(callback_total_ns_.load()) / static_cast<double>(callbacks) / 1000.0, static_cast<double>(callback_max_ns_.load()) / 1000.0);
+	}
+
+	const std::uint64_t samples = latency_samples_.load();
+
+	if (samples == 0 || frequency_ == 0)
+	{
+		return;
+	}
+
+	// The mix callback fills one buffer ahead of the device, so that much is added on top of the measured time.
+	const double buffer_ms = 1000.0 * static_cast<double>(buffer_size_) / static_cast<double>(frequency_);
+	const double mean_ms = static_cast<double>(latency_total_us_.load()) / static_cast<double>(samples) / 1000.0;
+	const double max_ms = static_cast<double>(latency_max_us_.load()) / 1000.0;
+
+	fprintf(stderr, "Audio: %llu sounds, event-to-mix mean %.2f ms, max %.2f ms, +%.2f ms device buffer (%d samples), %llu events dropped\n",
+		static_cast<unsigned long long>(samples), mean_ms, max_ms, buffer_ms, buffer_size_, static_cast<unsigned long long>(dropped_events_.load()));
+}
@@ -2,25 +2,24 @@
 #include "Game.hpp"
 #include "Paddle.hpp"
 #include "Constants.hpp"
-#include "States/GamePlayState.hpp"
+#include "Simulation.hpp"
+#include "Trace.hpp"
 
 #include <SDL.h>
 
 #include <iostream>
 #include <cmath>
 #include <algorithm>
-#include <cstdlib>
-#include <ctime>
 
-Ball::Ball() : game_(nullptr)
+Ball::Ball() : game_(nullptr), simulation_(nullptr)
 {
-	rect_.x = 0.0f;
-	rect_.y = 0.0f;
-	rect_.w = 0.0f;
-	rect_.h = 0.0f;
+	rect_.x = Scalar(0);
+	rect_.y = Scalar(0);
+	rect_.w = Scalar(0);
+	rect_.h = Scalar(0);
 
-	vx_ = 0.0f;
-	vy_ = 0.0f;
+	vx_ = Scalar(0);
+	vy_ = Scalar(0);
 }
 
 void Ball::HandleEvent(SDL_Event* e)
@@ -30,123 +29,225 @@ void Ball::HandleEvent(SDL_Event* e)
 
 void Ball::Tick()
 {
-	rect_.x += vx_;
-	rect_.y += vy_;
+	TRACE_ZONE("Ball::Tick");
 
-	SDL_FRect intersect;
+	const int substeps = simulation_->physics_substeps_;
+	const Scalar time_step = substeps == 1 ? simulation_->time_step_ : simulation_->time_step_ / Scalar(substeps);
+
+	for (int i = 0; i < substeps; ++i)
+	{
+		Step(time_step);
+	}
+}
+
+void Ball::Step(Scalar time_step)
+{
+	// Velocities are in pixels per 1/60 s; at 60 Hz without sub-steps time_step is exactly 1.
+	const Scalar dx = vx_ * time_step;
+	const Scalar dy = vy_ * time_step;
+
+	rect_.x += dx;
+	rect_.y += dy;
+
+	Rect intersect;
 	
-	if (SDL_HasIntersectionF(&rect_, &GamePlayState::Instance()->player1_paddle_.rect_))
+	if (RectsIntersect(rect_, simulation_->player1_paddle_.rect_))
 	{
-		rect_.x -= vx_;
-		rect_.y -= vy_;
+		rect_.x -= dx;
+		rect_.y -= dy;
 
-		if (SDL_IntersectFRect(&rect_, &GamePlayState::Instance()->player1_paddle_.rect_, &intersect))
+		if (IntersectRects(rect_, simulation_->player1_paddle_.rect_, intersect))
 		{
-			rect_.x -= intersect.w / 2.0f;
-			rect_.y -= intersect.h / 2.0;
+			rect_.x -= intersect.w / Scalar(2);
+			rect_.y -= intersect.h / Scalar(2);
 		}
 
-		BounceBall(GamePlayState::Instance()->player1_paddle_);
+		BounceBall(simulation_->player1_paddle_);
 	}
 	
-	if (SDL_HasIntersectionF(&rect_, &GamePlayState::Instance()->player2_paddle_.rect_))
+	if (RectsIntersect(rect_, simulation_->player2_paddle_.rect_))
 	{
-		rect_.x -= vx_;
-		rect_.y -= vy_;
+		rect_.x -= dx;
+		rect_.y -= dy;
 
-		if (SDL_IntersectFRect(&rect_, &GamePlayState::Instance()->player2_paddle_.rect_, &intersect))
+		if (IntersectRects(rect_, simulation_->player2_paddle_.rect_, intersect))
 		{
-			rect_.x -= intersect.w / 2.0f;
-			rect_.y -= intersect.h / 2.0f;
+			rect_.x -= intersect.w / Scalar(2);
+			rect_.y -= intersect.h / Scalar(2);
 		}
 
-		BounceBall(GamePlayState::Instance()->player2_paddle_);
+		BounceBall(simulation_->player2_paddle_);
+	}
+
+	if (!simulation_->arena_->IsEmpty())
+	{
+		StepObstacles(dx, dy);
 	}
 
-	if (rect_.y + rect_.w > constants::screen_height || rect_.y < 0)
+	if (rect_.y + rect_.w > Scalar(constants::screen_height) || rect_.y < Scalar(0))
 	{
-		rect_.y -= vy_;
+		rect_.y -= dy;
 		vy_ = -vy_;
 
-		direction_ray_.start_point.x = rect_.x + (rect_.w / 2);
-		direction_ray_.start_point.y = rect_.y + (rect_.h / 2);
-		direction_ray_.end_point.x = rect_.x + (rect_.w / 2) + ((constants::screen_width + constants::screen_height) * vx_);
-		direction_ray_.end_point.y = rect_.y + (rect_.h / 2) + ((constants::screen_width + constants::screen_height) * vy_);
+		simulation_->PushEvent(SimulationEventType::WALL_BOUNCE);
+
+		UpdateDirectionRay();
 		
-		if (game_->game_difficulty_ != GameDifficulty::IMPOSSIBLE)
+		simulation_->GetEdgeIntersectionPoint(BallDirectionChange::WALL_BOUNCE);
+	}
+}
+
+void Ball::StepObstacles(Scalar dx, Scalar dy)
+{
+	TRACE_ZONE("Ball::StepObstacles");
+
+	// The whole area swept this step, so a fast ball cannot pass through a thin segment.
+	Rect swept = rect_;
+	swept.x = std::min(rect_.x, rect_.x - dx);
+	swept.y = std::min(rect_.y, rect_.y - dy);
+	swept.w = rect_.w + (dx < Scalar(0) ? -dx : dx);
+	swept.h = rect_.h + (dy < Scalar(0) ? -dy : dy);
+
+	const std::int32_t index = simulation_->arena_->FindOverlap(swept);
+
+	if (index < 0)
+	{
+		return;
+	}
+
+	const Obstacle& obstacle = simulation_->arena_->GetObstacle(index);
+	const Vec2 normal = { obstacle.a_.y - obstacle.b_.y, obstacle.b_.x - obstacle.a_.x };
+
+	rect_.x -= dx;
+	rect_.y -= dy;
+
+	if (obstacle.type_ == ObstacleType::SEGMENT)
+	{
+		// The swept box also catches a segment the ball is leaving, like right after bouncing off it.
+		const Scalar side = normal.x * (rect_.x + (rect_.w / Scalar(2)) - obstacle.a_.x) + normal.y * (rect_.y + (rect_.h / Scalar(2)) - obstacle.a_.y);
+		const Scalar approach = normal.x * vx_ + normal.y * vy_;
+
+		if ((side < Scalar(0)) == (approach < Scalar(0)) || approach == Scalar(0))
+		{
+			rect_.x += dx;
+			rect_.y += dy;
+			return;
+		}
+
+		const Vec2 velocity = Simulation::Reflect({ vx_, vy_ }, normal);
+
+		vx_ = velocity.x;
+		vy_ = velocity.y;
+	}
+	else
+	{
+		// Bounce off the side the ball came from; off both at a corner.
+		const bool apart_x = rect_.x + rect_.w <= obstacle.a_.x || rect_.x >= obstacle.b_.x;
+		const bool apart_y = rect_.y + rect_.h <= obstacle.a_.y || rect_.y >= obstacle.b_.y;
+
+		if (apart_x || !apart_y)
+		{
+			vx_ = -vx_;
+		}
+
+		if (apart_y || !apart_x)
 		{
-			GamePlayState::Instance()->GetEdgeIntersectionPoint();
+			vy_ = -vy_;
 		}
 	}
+
+	simulation_->PushEvent(SimulationEventType::WALL_BOUNCE);
+
+	UpdateDirectionRay();
+
+	// The ball's box bounces where the predicted path's centre ray may not, so predictions start over from here.
+	simulation_->GetEdgeIntersectionPoint(BallDirectionChange::OBSTACLE_BOUNCE);
 }
 
 void Ball::Render()
 {
+	const SDL_FRect render_rect = ToFRect(rect_);
+
 	SDL_SetRenderDrawColor(game_->renderer_, 0xD3, 0xD3, 0xD3, 0xFF);
-	SDL_RenderFillRectF(game_->renderer_, &rect_);
+	SDL_RenderFillRectF(game_->renderer_, &render_rect);
 }
 
 void Ball::BounceBall(const Paddle& paddle)
 {
-	const int mid_level = rect_.y + (rect_.w / 2.0f);
-	const double collision_point_normalized = std::clamp(static_cast<double>(mid_level - paddle.rect_.y) / static_cast<double>(paddle.rect_.h), 0.0, 1.0);
+	TRACE_ZONE("Ball::BounceBall");
+
+	const int mid_level = static_cast<int>(rect_.y + (rect_.w / Scalar(2)));
+	const Scalar collision_point_normalized = std::clamp((Scalar(mid_level) - paddle.rect_.y) / paddle.rect_.h, Scalar(0), Scalar(1));
 
 	constexpr int right_angle = 90;
-	const double reflection_angle = ((right_angle / 2) + (right_angle * collision_point_normalized));
+	const int reflection_angle = static_cast<int>(Scalar(right_angle / 2) + (Scalar(right_angle) * collision_point_normalized));
 	
-	SDL_FPoint reflection_vector;
-	reflection_vector.x = 0.0;
-	reflection_vector.y = 1.0;
+	Vec2 reflection_vector;
+	reflection_vector.x = Scalar(0);
+	reflection_vector.y = Scalar(1);
 
-	SDL_FPoint pivot;
-	pivot.x = 0.0;
-	pivot.y = 0.0;
+	Vec2 pivot;
+	pivot.x = Scalar(0);
+	pivot.y = Scalar(0);
 
 	reflection_vector = GetRotatedPoint(reflection_vector, pivot, reflection_angle);
 
-	constexpr float speed_multiple = 15.0;
+	const Scalar speed_multiple = Scalar(simulation_->tuning_.speed_multiple);
 	
-	vx_ = vx_ > 0 ? reflection_vector.x : -reflection_vector.x;
+	vx_ = vx_ > Scalar(0) ? reflection_vector.x : -reflection_vector.x;
 	vy_ = -reflection_vector.y;
 
-	direction_ray_.start_point.x = rect_.x + (rect_.w / 2);
-	direction_ray_.start_point.y = rect_.y + (rect_.h / 2);
-	direction_ray_.end_point.x = rect_.x + (rect_.w / 2) + ((constants::screen_width + constants::screen_height) * vx_);
-	direction_ray_.end_point.y = rect_.y + (rect_.h / 2) + ((constants::screen_width + constants::screen_height) * vy_);
+	UpdateDirectionRay();
 
 	vx_ *= speed_multiple;
 	vy_ *= speed_multiple;
+
+	const int player = &paddle == &simulation_->player1_paddle_ ? 1 : 2;
+	simulation_->PushEvent(SimulationEventType::PADDLE_HIT, reflection_angle, player, static_cast<float>(collision_point_normalized));
 	
-	GamePlayState::Instance()->GetEdgeIntersectionPoint();
+	simulation_->GetEdgeIntersectionPoint(BallDirectionChange::PADDLE_HIT);
 }
 
 void Ball::Reset()
 {
-	constexpr int ball_side_size = 14;
+	TRACE_ZONE("Ball::Reset");
 
-	rect_.x = static_cast<float>((constants::screen_width / 2) - (ball_side_size / 2));
-	rect_.y = static_cast<float>((constants::screen_height / 2) - (ball_side_size / 2));
+	constexpr int ball_side_size = 14;
 
-	std::srand(std::time(nullptr));
-	std::rand();
+	rect_.x = Scalar((constants::screen_width / 2) - (ball_side_size / 2));
+	rect_.y = Scalar((constants::screen_height / 2) - (ball_side_size / 2));
 
-	constexpr float initial_speed = 5.0f;
+	const Scalar initial_speed = Scalar(simulation_->tuning_.initial_speed);
 
-	vx_ = (std::rand() % 2 == 0) ? initial_speed : -initial_speed;
-	vy_ = ((static_cast<float>(std::rand()) / RAND_MAX) - 0.5f) * initial_speed;
+	vx_ = (simulation_->random_.Next() % 2 == 0) ? initial_speed : -initial_speed;
+	vy_ = (simulation_->random_.NextUnit() - Scalar(0.5f)) * initial_speed;
 	
-	direction_ray_.start_point.x = rect_.x + (rect_.w / 2);
-	direction_ray_.start_point.y = rect_.y + (rect_.h / 2);
-	direction_ray_.end_point.x = rect_.x + (rect_.w / 2) + ((constants::screen_width + constants::screen_height) * vx_);
-	direction_ray_.end_point.y = rect_.y + (rect_.h / 2) + ((constants::screen_width + constants::screen_height) * vy_);
+	UpdateDirectionRay();
+
+	simulation_->PushEvent(SimulationEventType::SERVE);
+
+	simulation_->GetEdgeIntersectionPoint(BallDirectionChange::SERVE);
+}
 
-	GamePlayState::Instance()->GetEdgeIntersectionPoint();
+void Ball::UpdateDirectionRay()
+{
+	direction_ray_.start_point.x = rect_.x + (rect_.w / Scalar(2));
+	direction_ray_.start_point.y = rect_.y + (rect_.h / Scalar(2));
+	direction_ray_.end_point.x = rect_.x + (rect_.w / Scalar(2)) + (Scalar(constants::screen_width + constants::screen_height) * vx_);
+	direction_ray_.end_point.y = rect_.y + (rect_.h / Scalar(2)) + (Scalar(constants::screen_width + constants::screen_height) * vy_);
 }
 
-SDL_FPoint Ball::GetRotatedPoint(const SDL_FPoint& point, const SDL_FPoint& pivot, int degrees)
+Vec2 Ball::GetRotatedPoint(const Vec2& point, const Vec2& pivot, int degrees)
 {
-	SDL_FPoint result_point = point;
+	Vec2 result_point = point;
+
+#if PONG_FIXED_POINT
+	const Scalar sin_degrees = FixedSinDegrees(degrees);
+	const Scalar cos_degrees = FixedCosDegrees(degrees);
 
+	const Scalar new_x = (result_point.x - pivot.x) * cos_degrees - (result_point.y - pivot.y) * sin_degrees;
+	const Scalar new_y = (result_point.x - pivot.x) * sin_degrees + (result_point.y - pivot.y) * cos_degrees;
+#else
 	const double pi = std::acos(-1);
 	const double deg_to_rad = static_cast<double>(degrees) * pi / 180.0;
 	const double sin_degrees = std::sin(deg_to_rad);
@@ -154,6 +255,7 @@ SDL_FPoint Ball::GetRotatedPoint(const SDL_FPoint& point, const SDL_FPoint& pivo
 
 	const double new_x = (result_point.x - pivot.x) * cos_degrees - (result_point.y - pivot.y) * sin_degrees;
 	const double new_y = (result_point.x - pivot.x) * sin_degrees + (result_point.y - pivot.y) * cos_degrees;
+#endif
 
 	result_point.x = new_x + pivot.x;
 	result_point.y = new_y + pivot.y;
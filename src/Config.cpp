@@ -0,0 +1,302 @@
+#include "Config.hpp"
+#include "Trace.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<Config> Config::config_ = std::make_unique<Config>();
+
+namespace
+{
+	std::string Trim(const std::string& text)
+	{
+		const std::size_t first = text.find_first_not_of(" \t\r");
+
+		if (first == std::string::npos)
+		{
+			return std::string();
+		}
+
+		return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+	}
+
+	bool ParseInt(const std::string& value, int min, int max, int& result)
+	{
+		char* end = nullptr;
+		const long parsed = std::strtol(value.c_str(), &end, 10);
+
+		if (end == value.c_str() || *end != '\0' || parsed < min || parsed > max)
+		{
+			return false;
+		}
+
+		result = static_cast<int>(parsed);
+		return true;
+	}
+
+	bool ParseFloat(const std::string& value, float min, float max, float& result)
+	{
+		char* end = nullptr;
+		const float parsed = std::strtof(value.c_str(), &end);
+
+		if (end == value.c_str() || *end != '\0' || !(parsed >= min && parsed <= max))
+		{
+			return false;
+		}
+
+		result = parsed;
+		return true;
+	}
+}
+
+Config::Config() : current_(nullptr), watching_(false)
+{
+	published_.emplace_back(std::make_unique<const Tuning>());
+	current_.store(published_.back().get());
+}
+
+Config::~Config()
+{
+	StopWatching();
+}
+
+Config* Config::Instance()
+{
+	return config_.get();
+}
+
+bool Config::Load(const std::string& path)
+{
+	path_ = path;
+
+	return Reload();
+}
+
+bool Config::Reload()
+{
+	TRACE_ZONE("Config::Reload");
+
+	std::ifstream file(path_);
+
+	if (!file)
+	{
+		fprintf(stderr, "Config file %s not found, using the current values.\n", path_.c_str());
+		return false;
+	}
+
+	std::stringstream text;
+	text << file.rdbuf();
+
+	// Keys missing from the file fall back to the defaults, so the file alone decides the values.
+	Tuning tuning;
+
+	if (!Parse(text.str(), tuning))
+	{
+		fprintf(stderr, "Config file %s has errors, keeping the current values.\n", path_.c_str());
+		return false;
+	}
+
+	published_.emplace_back(std::make_unique<const Tuning>(tuning));
+	current_.store(published_.back().get(), std::memory_order_release);
+
+	fprintf(stderr, "Loaded config file %s\n", path_.c_str());
+
+	return true;
+}
+
+bool Config::Parse(const std::string& text, Tuning& tuning) const
+{
+	std::istringstream lines(text);
+	std::string line;
+	int line_number = 0;
+	bool valid = true;
+
+	while (std::getline(lines, line))
+	{
+		++line_number;
+
+		line = Trim(line.substr(0, line.find('#')));
+
+		if (line.empty())
+		{
+			continue;
+		}
+
+		const std::size_t separator = line.find('=');
+
+		if (separator == std::string::npos)
+		{
+			fprintf(stderr, "%s:%d: expected key = value\n", path_.c_str(), line_number);
+			valid = false;
+			continue;
+		}
+
+		const std::string key = Trim(line.substr(0, separator));
+		const std::string value = Trim(line.substr(separator + 1));
+		bool parsed = false;
+
+		if (key == "paddle_width")
+		{
+			parsed = ParseInt(value, 1, constants::screen_width / 4, tuning.paddle_width);
+		}
+		else if (key == "paddle_height")
+		{
+			parsed = ParseInt(value, 1, constants::screen_height, tuning.paddle_height);
+		}
+		else if (key == "paddle_x_offset")
+		{
+			parsed = ParseInt(value, 0, constants::screen_width / 4, tuning.paddle_x_offset);
+		}
+		else if (key == "ai_speed_easy")
+		{
+			parsed = ParseInt(value, 0, 100, tuning.ai_speeds[0]);
+		}
+		else if (key == "ai_speed_medium")
+		{
+			parsed = ParseInt(value, 0, 100, tuning.ai_speeds[1]);
+		}
+		else if (key == "ai_speed_hard")
+		{
+			parsed = ParseInt(value, 0, 100, tuning.ai_speeds[2]);
+		}
+		else if (key == "ai_speed_impossible")
+		{
+			parsed = ParseInt(value, 0, 100, tuning.ai_speeds[3]);
+		}
+		else if (key == "speed_multiple")
+		{
+			parsed = ParseFloat(value, 0.1f, 100.0f, tuning.speed_multiple);
+		}
+		else if (key == "initial_speed")
+		{
+			parsed = ParseFloat(value, 0.1f, 100.0f, tuning.initial_speed);
+		}
+		else if (key == "window_width")
+		{
+			parsed = ParseInt(value, 160, 7680, tuning.window_width);
+		}
+		else if (key == "window_height")
+		{
+			parsed = ParseInt(value, 120, 4320, tuning.window_height);
+		}
+		else
+		{
+			fprintf(stderr, "%s:%d: unknown key %s\n", path_.c_str(), line_number, key.c_str());
+			valid = false;
+			continue;
+		}
+
+		if (!parsed)
+		{
+			fprintf(stderr, "%s:%d: invalid value %s for %s\n", path_.c_str(), line_number, value.c_str(), key.c_str());
+			valid = false;
+		}
+	}
+
+	return valid;
+}
+
+void Config::StartWatching()
+{
+#ifdef __linux__
+	if (watching_ || path_.empty())
+	{
+		return;
+	}
+
+	const int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (inotify_fd < 0)
+	{
+		fprintf(stderr, "%s\n", "Unable to watch the config file, live reload is disabled.");
+		return;
+	}
+
+	// Editors often save by renaming a new file over the old one, which only shows up on the directory.
+	const std::size_t slash = path_.find_last_of('/');
+	const std::string directory = slash == std::string::npos ? "." : path_.substr(0, slash + 1);
+
+	if (inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		fprintf(stderr, "Unable to watch %s, live reload is disabled.\n", directory.c_str());
+		close(inotify_fd);
+		return;
+	}
+
+	watching_ = true;
+	watcher_thread_ = std::thread(&Config::WatchLoop, this, inotify_fd);
+#endif
+}
+
+void Config::StopWatching()
+{
+	if (!watching_)
+	{
+		return;
+	}
+
+	watching_ = false;
+	watcher_thread_.join();
+}
+
+void Config::WatchLoop(int inotify_fd)
+{
+#ifdef __linux__
+	Trace::Instance()->SetThreadName("Config watcher");
+
+	const std::size_t slash = path_.find_last_of('/');
+	const std::string file_name = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+
+	alignas(inotify_event) char buffer[4096];
+	pollfd poll_fd = { inotify_fd, POLLIN, 0 };
+
+	while (watching_)
+	{
+		// The timeout only bounds how long StopWatching waits for the thread to notice.
+		if (poll(&poll_fd, 1, 200) <= 0)
+		{
+			continue;
+		}
+
+		bool changed = false;
+		ssize_t length;
+
+		while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* event_position = buffer; event_position < buffer + length; )
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(event_position);
+
+				if (event->len > 0 && file_name == event->name)
+				{
+					changed = true;
+				}
+
+				event_position += sizeof(inotify_event) + event->len;
+			}
+		}
+
+		if (changed)
+		{
+			Reload();
+		}
+	}
+
+	close(inotify_fd);
+#else
+	(void)inotify_fd;
+#endif
+}
+
+const Tuning* Config::GetTuning() const
+{
+	return current_.load(std::memory_order_acquire);
+}
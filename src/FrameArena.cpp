@@ -0,0 +1,87 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+
+FrameArena::FrameArena(std::size_t capacity, std::pmr::memory_resource* upstream) :
+	buffer_(std::make_unique<std::byte[]>(capacity)),
+	capacity_(capacity),
+	offset_(0),
+	upstream_(upstream),
+	overflow_bytes_(0),
+	high_water_mark_(0),
+	overflow_allocations_(0),
+	resets_(0)
+{
+}
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer_.get());
+	const std::uintptr_t aligned = (base + offset_ + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+	const std::size_t aligned_offset = static_cast<std::size_t>(aligned - base);
+
+	if (aligned_offset + bytes > capacity_)
+	{
+		++overflow_allocations_;
+		overflow_bytes_ += bytes;
+		high_water_mark_ = std::max(high_water_mark_, offset_ + overflow_bytes_);
+
+		return upstream_->allocate(bytes, alignment);
+	}
+
+	offset_ = aligned_offset + bytes;
+	high_water_mark_ = std::max(high_water_mark_, offset_ + overflow_bytes_);
+
+	return reinterpret_cast<void*>(aligned);
+}
+
+void FrameArena::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+	const std::byte* pointer = static_cast<const std::byte*>(p);
+
+	// Arena memory comes back all at once in Reset().
+	if (pointer >= buffer_.get() && pointer < buffer_.get() + capacity_)
+	{
+		return;
+	}
+
+	overflow_bytes_ -= bytes;
+	upstream_->deallocate(p, bytes, alignment);
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+void FrameArena::Reset()
+{
+	offset_ = 0;
+	++resets_;
+}
+
+std::size_t FrameArena::GetCapacity() const
+{
+	return capacity_;
+}
+
+std::size_t FrameArena::GetUsed() const
+{
+	return offset_;
+}
+
+std::size_t FrameArena::GetHighWaterMark() const
+{
+	return high_water_mark_;
+}
+
+std::uint64_t FrameArena::GetOverflowAllocations() const
+{
+	return overflow_allocations_;
+}
+
+void FrameArena::PrintReport(FILE* file, const char* name) const
+{
+	fprintf(file, "%s: high-water mark %zu of %zu bytes over %llu resets, %llu allocations overflowed to the heap\n", name, high_water_mark_, capacity_,
+		static_cast<unsigned long long>(resets_), static_cast<unsigned long long>(overflow_allocations_));
+}
@@ -0,0 +1,226 @@
+#include "FrameCapture.hpp"
+#include "Trace.hpp"
+
+#include <SDL.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+
+static_assert(sizeof(FrameHeader) == 32, "FrameHeader must stay tightly packed");
+
+FrameCapture::FrameCapture() :
+	file_(nullptr),
+	owns_file_(false),
+	width_(0),
+	height_(0),
+	running_(false),
+	frame_number_(0),
+	dropped_frames_(0),
+	written_frames_(0),
+	write_failed_(false)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+	Close();
+}
+
+bool FrameCapture::Open(const char* path, int width, int height, std::size_t buffer_count)
+{
+	Close();
+
+	if (std::strcmp(path, "-") == 0)
+	{
+		file_ = stdout;
+		owns_file_ = false;
+	}
+	else
+	{
+		file_ = fopen(path, "wb");
+		owns_file_ = true;
+	}
+
+	if (file_ == nullptr)
+	{
+		fprintf(stderr, "Unable to open %s for frame capture!\n", path);
+		return false;
+	}
+
+#ifdef SIGPIPE
+	// An encoder that exits early should end the capture, not the game.
+	std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+	width_ = width;
+	height_ = height;
+
+	buffer_count = buffer_count < 2 ? 2 : (buffer_count > max_buffers ? max_buffers : buffer_count);
+	buffers_.resize(buffer_count);
+
+	for (std::size_t i = 0; i < buffers_.size(); ++i)
+	{
+		buffers_[i].pixels.resize(static_cast<std::size_t>(width_) * static_cast<std::size_t>(height_) * 4);
+		free_buffers_.TryPush(i);
+	}
+
+	frame_number_ = 0;
+	dropped_frames_ = 0;
+	written_frames_ = 0;
+	write_failed_ = false;
+	running_ = true;
+	writer_thread_ = std::thread(&FrameCapture::WriterLoop, this);
+
+	return true;
+}
+
+void FrameCapture::Close()
+{
+	if (!running_)
+	{
+		return;
+	}
+
+	running_ = false;
+	writer_wakeup_.notify_one();
+	writer_thread_.join();
+
+	fflush(file_);
+
+	if (owns_file_)
+	{
+		fclose(file_);
+	}
+
+	file_ = nullptr;
+
+	fprintf(stderr, "Frame capture: %llu frames written, %llu dropped\n", static_cast<unsigned long long>(written_frames_.load()), static_cast<unsigned long long>(dropped_frames_));
+
+	std::size_t index;
+
+	while (free_buffers_.TryPop(index))
+	{
+	}
+
+	buffers_.clear();
+}
+
+void FrameCapture::Capture(SDL_Renderer* renderer)
+{
+	TRACE_ZONE("FrameCapture::Capture");
+
+	if (!running_)
+	{
+		return;
+	}
+
+	std::size_t index;
+
+	if (write_failed_ || !free_buffers_.TryPop(index))
+	{
+		++dropped_frames_;
+		return;
+	}
+
+	// The output size follows live window size changes, so it is checked every frame; a free buffer belongs to this
+	// thread alone and is resized to fit, which only allocates when the window grows.
+	int width = 0;
+	int height = 0;
+
+	if (SDL_GetRendererOutputSize(renderer, &width, &height) < 0 || width <= 0 || height <= 0)
+	{
+		fprintf(stderr, "Unable to query the frame size! SDL Error: %s\n", SDL_GetError());
+		free_buffers_.TryPush(index);
+		++dropped_frames_;
+		return;
+	}
+
+	if (width != width_ || height != height_)
+	{
+		fprintf(stderr, "Frame capture: frames are %dx%d from frame %u on\n", width, height, frame_number_);
+		width_ = width;
+		height_ = height;
+	}
+
+	FrameBuffer& buffer = buffers_[index];
+	buffer.pixels.resize(static_cast<std::size_t>(width_) * static_cast<std::size_t>(height_) * 4);
+
+	if (SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, buffer.pixels.data(), width_ * 4) < 0)
+	{
+		fprintf(stderr, "Unable to read back frame! SDL Error: %s\n", SDL_GetError());
+		free_buffers_.TryPush(index);
+		++dropped_frames_;
+		return;
+	}
+
+	std::memcpy(buffer.header.magic, "PFRM", sizeof(buffer.header.magic));
+	buffer.header.width = static_cast<std::uint32_t>(width_);
+	buffer.header.height = static_cast<std::uint32_t>(height_);
+	buffer.header.frame_number = frame_number_++;
+	buffer.header.timestamp_ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	buffer.header.dropped_frames = dropped_frames_;
+
+	filled_buffers_.TryPush(index);
+	writer_wakeup_.notify_one();
+}
+
+void FrameCapture::WriterLoop()
+{
+	Trace::Instance()->SetThreadName("Frame capture writer");
+
+	std::size_t index;
+
+	while (true)
+	{
+		if (filled_buffers_.TryPop(index))
+		{
+			if (!write_failed_ && !WriteFrame(buffers_[index]))
+			{
+				fprintf(stderr, "%s\n", "Frame capture output closed, dropping the remaining frames.");
+				write_failed_ = true;
+			}
+
+			free_buffers_.TryPush(index);
+			continue;
+		}
+
+		if (!running_)
+		{
+			break;
+		}
+
+		// The game loop only notifies, it never takes this lock, so a wakeup can be missed; the timeout covers that.
+		std::unique_lock<std::mutex> lock(writer_mutex_);
+		writer_wakeup_.wait_for(lock, std::chrono::milliseconds(5));
+	}
+}
+
+bool FrameCapture::WriteFrame(const FrameBuffer& buffer)
+{
+	TRACE_ZONE("FrameCapture::WriteFrame");
+
+	if (fwrite(&buffer.header, sizeof(buffer.header), 1, file_) != 1)
+	{
+		return false;
+	}
+
+	if (fwrite(buffer.pixels.data(), 1, buffer.pixels.size(), file_) != buffer.pixels.size())
+	{
+		return false;
+	}
+
+	++written_frames_;
+
+	return true;
+}
+
+std::uint64_t FrameCapture::GetDroppedFrames() const
+{
+	return dropped_frames_;
+}
+
+std::uint64_t FrameCapture::GetWrittenFrames() const
+{
+	return written_frames_;
+}
@@ -1,9 +1,17 @@
 #include "Game.hpp"
+#include "AiPlugin.hpp"
+#include "AllocationTracker.hpp"
+#include "AtlasSprites.hpp"
+#include "Audio.hpp"
+#include "Config.hpp"
 #include "Constants.hpp"
+#include "Input.hpp"
+#include "SpectatorServer.hpp"
 #include "States/GameState.hpp"
 #include "States/GamePlayState.hpp"
 #include "States/GameModeMenuState.hpp"
 #include "States/GameDifficultyMenuState.hpp"
+#include "Trace.hpp"
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -13,13 +21,21 @@
 #include <cstdint>
 #include <iostream>
 
-Game::Game() : 
+Game::Game(const GameOptions& options) : 
 	initialized_(false), 
 	running_(false), 
+	options_(options), 
+	applied_tuning_(nullptr), 
+	trace_toggle_requested_(false), 
 	window_(nullptr), 
 	renderer_(nullptr), 
 	game_mode_(GameMode::SINGLE_PLAYER), 
-	game_difficulty_(GameDifficulty::MEDIUM)
+	game_difficulty_(GameDifficulty::MEDIUM), 
+	frame_capture_(nullptr), 
+	resolution_scaler_(nullptr), 
+	spectator_server_(nullptr), 
+	ai_plugin_(nullptr), 
+	frame_arena_(frame_arena_size)
 {
 	initialized_ = Initialize();
 }
@@ -37,18 +53,28 @@ Game::~Game()
 
 bool Game::Initialize()
 {
+	AllocationTracker::HookSdl();
+
 	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 	{
 		printf("SDL could not be initialized! SDL Error: %s\n", SDL_GetError());
 		return false;
 	}
 
+	Trace::Instance()->SetThreadName("Main");
+	Trace::SetEnabled(options_.trace_at_startup);
+	Input::Instance()->Open();
+
 	if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0"))
 	{
 		printf("%s\n", "Warning: Texture filtering is not enabled!");
 	}
 
-	window_ = SDL_CreateWindow(constants::game_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, constants::screen_width, constants::screen_height, SDL_WINDOW_SHOWN);
+	Config::Instance()->Load(options_.config_path);
+	Config::Instance()->StartWatching();
+	applied_tuning_ = Config::Instance()->GetTuning();
+
+	window_ = SDL_CreateWindow(constants::game_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, applied_tuning_->window_width, applied_tuning_->window_height, SDL_WINDOW_SHOWN);
 
 	if (window_ == nullptr)
 	{
@@ -64,6 +90,23 @@ bool Game::Initialize()
 		return false;
 	}
 
+	// Everything is drawn in playfield coordinates and scaled to whatever window size the config asks for.
+	if (SDL_RenderSetLogicalSize(renderer_, constants::screen_width, constants::screen_height) < 0)
+	{
+		printf("Logical render size could not be set! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+
+	if (options_.frame_budget_ms > 0.0f)
+	{
+		resolution_scaler_ = std::make_unique<ResolutionScaler>();
+
+		if (!resolution_scaler_->Open(renderer_, constants::screen_width, constants::screen_height, options_.frame_budget_ms, options_.telemetry))
+		{
+			resolution_scaler_.reset();
+		}
+	}
+
 	constexpr int img_flags = IMG_INIT_PNG;
 
 	if (!(IMG_Init(img_flags) & img_flags))
@@ -78,17 +121,68 @@ bool Game::Initialize()
 		return false;
 	}
 
-	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
+	if (!atlas_.LoadFromPath(renderer_, atlas::path))
+	{
+		return false;
+	}
+
+	if (!Audio::Instance()->Open(options_.audio_buffer_size))
 	{
-		printf("SDL_mixer could not be initialized! SDL_mixer Error: %s\n", Mix_GetError());
 		return false;
 	}
 
+	if (!options_.arena_path.empty() && !arena_.Load(options_.arena_path))
+	{
+		return false;
+	}
+
+	if (!options_.ai_plugin_path.empty())
+	{
+		ai_plugin_ = std::make_unique<AiPlugin>();
+
+		if (!ai_plugin_->Open(options_.ai_plugin_path))
+		{
+			return false;
+		}
+	}
+
+	if (!options_.spectator_address.empty())
+	{
+		spectator_server_ = std::make_unique<SpectatorServer>();
+
+		if (!spectator_server_->Open(options_.spectator_address))
+		{
+			spectator_server_.reset();
+		}
+	}
+
 	return true;
 }
 
 void Game::Finalize()
 {
+	if (AllocationTracker::IsEnabled())
+	{
+		AllocationTracker::PrintReport(stderr);
+	}
+
+	if (Trace::IsEnabled())
+	{
+		ToggleTracing();
+	}
+
+	frame_arena_.PrintReport(stderr, "Frame arena");
+	Input::Instance()->Close();
+
+	frame_capture_.reset();
+	resolution_scaler_.reset();
+	spectator_server_.reset();
+	ai_plugin_.reset();
+	Audio::Instance()->Close();
+	Config::Instance()->StopWatching();
+
+	atlas_.FreeTexture();
+
 	SDL_DestroyWindow(window_);
 	window_ = nullptr;
 
@@ -103,6 +197,8 @@ void Game::Finalize()
 
 void Game::ChangeState(GameState* state)
 {
+	TRACE_ZONE("Game::ChangeState");
+
 	if (!states_.empty())
 	{
 		states_.top()->Exit();
@@ -115,6 +211,8 @@ void Game::ChangeState(GameState* state)
 	
 void Game::PushState(GameState* state)
 {
+	TRACE_ZONE("Game::PushState");
+
 	if (!states_.empty())
 	{
 		states_.top()->Pause();
@@ -126,6 +224,8 @@ void Game::PushState(GameState* state)
 
 void Game::PopState()
 {
+	TRACE_ZONE("Game::PopState");
+
 	if (!states_.empty())
 	{
 		states_.top()->Exit();
@@ -146,9 +246,17 @@ void Game::Run()
 	}
 
 	running_ = true;
-	ChangeState(GameModeMenuState::Instance());
+	// A replay goes straight to the match; its header decides the mode and difficulty.
+	if (options_.replay_path.empty())
+	{
+		ChangeState(GameModeMenuState::Instance());
+	}
+	else
+	{
+		ChangeState(GamePlayState::Instance());
+	}
 
-	constexpr long double ms = 1.0 / 60.0;
+	const long double ms = 1.0 / static_cast<long double>(options_.tick_rate);
 	std::uint64_t last_time = SDL_GetPerformanceCounter();
 	long double delta = 0.0;
 
@@ -159,51 +267,215 @@ void Game::Run()
 
 	while (running_)
 	{
+		TRACE_ZONE("Game::Frame");
+
 		const std::uint64_t now = SDL_GetPerformanceCounter();
 		const long double elapsed = static_cast<long double>(now - last_time) / static_cast<long double>(SDL_GetPerformanceFrequency());
 
 		last_time = now;
 		delta += elapsed;
 
+		frame_arena_.Reset();
+
+		ApplyWindowTuning();
 		HandleEvents();
 
+		AllocationTracker::SetPhase(AllocationPhase::TICK);
+
 		while (delta >= ms)
 		{
 			Tick();
 			delta -= ms;
 			++ticks;
+			AllocationTracker::CountTick();
 		}
 
+		AllocationTracker::SetPhase(AllocationPhase::OTHER);
+
+		Audio::Instance()->Update();
+
 		//printf("%Lf\n", delta / ms);
+		AllocationTracker::SetPhase(AllocationPhase::RENDER);
 		Render();
 		++frames;
+		AllocationTracker::CountFrame();
+		AllocationTracker::SetPhase(AllocationPhase::OTHER);
+
+		if (trace_toggle_requested_)
+		{
+			trace_toggle_requested_ = false;
+			ToggleTracing();
+		}
 
 		if (SDL_GetTicks() - timer > 1000)
 		{
 			timer += 1000;
-			//printf("Frames: %d, Ticks: %d\n", frames, ticks);
+
+			if (options_.telemetry)
+			{
+				if (resolution_scaler_ != nullptr)
+				{
+					fprintf(stderr, "Frames: %d, Ticks: %d, Render scale: %.3f, Frame time: %.2f ms (budget %.2f ms), Scale changes: %d, Arena high-water: %zu bytes\n", frames, ticks,
+						resolution_scaler_->GetScale(), resolution_scaler_->GetAverageFrameMs(), resolution_scaler_->GetBudgetMs(), resolution_scaler_->GetScaleChanges(), frame_arena_.GetHighWaterMark());
+				}
+				else
+				{
+					fprintf(stderr, "Frames: %d, Ticks: %d, Arena high-water: %zu bytes\n", frames, ticks, frame_arena_.GetHighWaterMark());
+				}
+			}
+
 			frames = 0;
 			ticks = 0;
 		}
 	}
 }
 
+void Game::ApplyWindowTuning()
+{
+	const Tuning* tuning = Config::Instance()->GetTuning();
+
+	if (tuning == applied_tuning_)
+	{
+		return;
+	}
+
+	if (tuning->window_width != applied_tuning_->window_width || tuning->window_height != applied_tuning_->window_height)
+	{
+		SDL_SetWindowSize(window_, tuning->window_width, tuning->window_height);
+	}
+
+	applied_tuning_ = tuning;
+}
+
+void Game::ToggleTracing()
+{
+	if (!Trace::IsEnabled())
+	{
+		fprintf(stderr, "%s\n", "Tracing started, press F9 again to write the trace.");
+		Trace::SetEnabled(true);
+		return;
+	}
+
+	Trace::SetEnabled(false);
+	Trace::Instance()->Flush(options_.trace_path.c_str());
+}
+
 void Game::Stop()
 {
 	running_ = false;
 }
 
+bool Game::StartFrameCapture(const char* path)
+{
+	if (!initialized_)
+	{
+		return false;
+	}
+
+	int width = 0;
+	int height = 0;
+
+	if (SDL_GetRendererOutputSize(renderer_, &width, &height) < 0)
+	{
+		fprintf(stderr, "Unable to query renderer output size! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+
+	frame_capture_ = std::make_unique<FrameCapture>();
+
+	if (!frame_capture_->Open(path, width, height))
+	{
+		frame_capture_.reset();
+		return false;
+	}
+
+	return true;
+}
+
+const GameOptions& Game::GetOptions() const
+{
+	return options_;
+}
+
 void Game::HandleEvents()
 {
-	states_.top()->HandleEvents();
+	TRACE_ZONE("Game::HandleEvents");
+
+	GameState* state = states_.top();
+	InputFrame input;
+
+	Input::Instance()->SetWantedEvents(state->GetInputEvents());
+	Input::Instance()->Poll(input);
+
+	if (input.WasPressed(InputAction::QUIT))
+	{
+		Stop();
+	}
+
+	// F9 works in every state; the toggle itself waits for the end of the frame.
+	if (input.WasPressed(InputAction::TOGGLE_TRACE))
+	{
+		trace_toggle_requested_ = true;
+	}
+
+	state->HandleEvents(input);
 }
 
 void Game::Tick()
 {
+	TRACE_ZONE("Game::Tick");
+
 	states_.top()->Tick();
 }
 
 void Game::Render()
 {
+	TRACE_ZONE("Game::Render");
+
+	const std::uint64_t frame_start = SDL_GetPerformanceCounter();
+
+	if (resolution_scaler_ != nullptr)
+	{
+		resolution_scaler_->BeginFrame();
+	}
+
 	states_.top()->Render();
+
+	// Keys pressed while the frame was drawn reach the simulation thread now rather than after the present.
+	Input::Instance()->Pump();
+
+	if (options_.render_stall_ms > 0)
+	{
+		TRACE_ZONE("Game::RenderStall");
+
+		// Render work between steps of which input is pumped, as above; a key waits about a millisecond.
+		const std::uint64_t stall_end = SDL_GetPerformanceCounter() + static_cast<std::uint64_t>(options_.render_stall_ms) * SDL_GetPerformanceFrequency() / 1000;
+
+		while (SDL_GetPerformanceCounter() < stall_end)
+		{
+			SDL_Delay(1);
+			Input::Instance()->Pump();
+		}
+	}
+
+	if (resolution_scaler_ != nullptr)
+	{
+		resolution_scaler_->EndFrame();
+	}
+
+	if (frame_capture_ != nullptr)
+	{
+		frame_capture_->Capture(renderer_);
+	}
+
+	{
+		TRACE_ZONE("SDL_RenderPresent");
+		SDL_RenderPresent(renderer_);
+	}
+
+	if (resolution_scaler_ != nullptr)
+	{
+		const float frame_ms = static_cast<float>(SDL_GetPerformanceCounter() - frame_start) * 1000.0f / static_cast<float>(SDL_GetPerformanceFrequency());
+		resolution_scaler_->Update(frame_ms);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "Input.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	struct KeyBinding
+	{
+		SDL_Keycode key;
+		InputAction action;
+	};
+
+	// Bound by keycode, so the keys keep the letters they are labelled with on any layout.
+	constexpr KeyBinding key_bindings[] =
+	{
+		{ SDLK_ESCAPE, InputAction::BACK },
+		{ SDLK_F9, InputAction::TOGGLE_TRACE },
+		{ SDLK_F3, InputAction::TOGGLE_TRAJECTORY },
+		{ SDLK_SPACE, InputAction::PLAYBACK_PAUSE },
+		{ SDLK_f, InputAction::PLAYBACK_SPEED },
+		{ SDLK_LEFT, InputAction::SEEK_BACK },
+		{ SDLK_RIGHT, InputAction::SEEK_FORWARD },
+		{ SDLK_HOME, InputAction::SEEK_START },
+		{ SDLK_UP, InputAction::PLAYER1_UP },
+		{ SDLK_DOWN, InputAction::PLAYER1_DOWN },
+		{ SDLK_w, InputAction::PLAYER2_UP },
+		{ SDLK_s, InputAction::PLAYER2_DOWN },
+	};
+
+	// The input_events kind of an event type; 0 for the kinds that always go through.
+	std::uint32_t GetEventKind(std::uint32_t type)
+	{
+		switch (type)
+		{
+		case SDL_MOUSEMOTION:
+			return input_events::pointer;
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEWHEEL:
+			return input_events::buttons;
+		case SDL_TEXTEDITING:
+		case SDL_TEXTINPUT:
+			return input_events::text;
+		case SDL_FINGERDOWN:
+		case SDL_FINGERUP:
+		case SDL_FINGERMOTION:
+		case SDL_DOLLARGESTURE:
+		case SDL_DOLLARRECORD:
+		case SDL_MULTIGESTURE:
+			return input_events::touch;
+		default:
+			return 0;
+		}
+	}
+}
+
+std::unique_ptr<Input> Input::input_ = std::make_unique<Input>();
+
+Input::Input() :
+	opened_(false),
+	held_actions_(0),
+	wanted_events_(input_events::pointer | input_events::buttons | input_events::text | input_events::touch),
+	events_dropped_(0),
+	events_dispatched_(0),
+	capturing_(false),
+	dropped_commands_(0),
+	latency_samples_(0),
+	latency_total_us_(0),
+	latency_max_us_(0)
+{
+	key_actions_.fill(0);
+}
+
+Input::~Input()
+{
+	Close();
+}
+
+Input* Input::Instance()
+{
+	return input_.get();
+}
+
+void Input::Open()
+{
+	Close();
+
+	MapKeys();
+
+	SDL_SetEventFilter(&Input::EventFilter, this);
+	SDL_AddEventWatch(&Input::EventWatch, this);
+	opened_ = true;
+}
+
+void Input::Close()
+{
+	if (!opened_)
+	{
+		return;
+	}
+
+	SDL_DelEventWatch(&Input::EventWatch, this);
+	SDL_SetEventFilter(nullptr, nullptr);
+	opened_ = false;
+	capturing_ = false;
+
+	PrintReport(stderr);
+	Clear();
+
+	held_actions_ = 0;
+	events_dropped_ = 0;
+	events_dispatched_ = 0;
+	dropped_commands_ = 0;
+	latency_samples_ = 0;
+	latency_total_us_ = 0;
+	latency_max_us_ = 0;
+}
+
+void Input::MapKeys()
+{
+	key_actions_.fill(0);
+
+	for (const KeyBinding& binding : key_bindings)
+	{
+		const SDL_Scancode scancode = SDL_GetScancodeFromKey(binding.key);
+
+		if (scancode != SDL_SCANCODE_UNKNOWN)
+		{
+			key_actions_[scancode] |= ActionBit(binding.action);
+		}
+	}
+}
+
+std::uint32_t Input::GetKeyActions(SDL_Scancode scancode) const
+{
+	return static_cast<std::size_t>(scancode) < key_actions_.size() ? key_actions_[scancode] : 0;
+}
+
+void Input::SetWantedEvents(std::uint32_t wanted_events)
+{
+	wanted_events_.store(wanted_events, std::memory_order_relaxed);
+}
+
+bool Input::Filter(const SDL_Event& e)
+{
+	if ((GetEventKind(e.type) & ~wanted_events_.load(std::memory_order_relaxed)) != 0)
+	{
+		events_dropped_.store(events_dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+void Input::Poll(InputFrame& frame)
+{
+	BeginFrame(frame);
+
+	SDL_Event e;
+
+	while (SDL_PollEvent(&e) != 0)
+	{
+		Dispatch(e, frame);
+	}
+
+	EndFrame(frame);
+}
+
+void Input::Pump()
+{
+	if (capturing_.load(std::memory_order_relaxed))
+	{
+		SDL_PumpEvents();
+	}
+}
+
+void Input::BeginFrame(InputFrame& frame)
+{
+	frame.pressed_ = 0;
+	frame.repeated_ = 0;
+	frame.released_ = 0;
+	frame.held_ = held_actions_;
+	frame.pointer_moved_ = false;
+	frame.events_ = 0;
+}
+
+void Input::Dispatch(const SDL_Event& e, InputFrame& frame)
+{
+	++frame.events_;
+
+	switch (e.type)
+	{
+	case SDL_QUIT:
+		frame.pressed_ |= ActionBit(InputAction::QUIT);
+		break;
+	case SDL_KEYDOWN:
+	{
+		const std::uint32_t actions = GetKeyActions(e.key.keysym.scancode);
+
+		if (e.key.repeat != 0)
+		{
+			frame.repeated_ |= actions;
+		}
+		else
+		{
+			frame.pressed_ |= actions;
+		}
+
+		held_actions_ |= actions;
+		break;
+	}
+	case SDL_KEYUP:
+	{
+		const std::uint32_t actions = GetKeyActions(e.key.keysym.scancode);
+
+		frame.released_ |= actions;
+		held_actions_ &= ~actions;
+		break;
+	}
+	case SDL_MOUSEMOTION:
+		// Only the last position counts, so a frame of motion costs the state one hover test instead of one per event.
+		frame.pointer_moved_ = true;
+		frame.pointer_x_ = e.motion.x;
+		frame.pointer_y_ = e.motion.y;
+		break;
+	case SDL_MOUSEBUTTONUP:
+		frame.pressed_ |= ActionBit(InputAction::CLICK);
+		frame.click_x_ = e.button.x;
+		frame.click_y_ = e.button.y;
+		break;
+	case SDL_KEYMAPCHANGED:
+		MapKeys();
+		break;
+	default:
+		break;
+	}
+}
+
+void Input::EndFrame(InputFrame& frame)
+{
+	frame.held_ = held_actions_;
+	events_dispatched_ += frame.events_;
+}
+
+void Input::SetCapturing(bool capturing)
+{
+	capturing_ = capturing;
+}
+
+void Input::Clear()
+{
+	PaddleCommand command;
+
+	while (commands_.TryPop(command))
+	{
+	}
+}
+
+bool Input::TryPop(PaddleCommand& command)
+{
+	return commands_.TryPop(command);
+}
+
+void Input::RecordApplied(const PaddleCommand& command)
+{
+	const std::uint64_t now = SDL_GetPerformanceCounter();
+	const std::uint64_t latency_us = (now - command.timestamp_) * 1000000 / SDL_GetPerformanceFrequency();
+
+	++latency_samples_;
+	latency_total_us_ += latency_us;
+	latency_max_us_ = std::max(latency_max_us_, latency_us);
+}
+
+void Input::PrintReport(FILE* file) const
+{
+	fprintf(file, "Input: %llu events dispatched, %llu dropped by the filter before queueing\n", static_cast<unsigned long long>(events_dispatched_),
+		static_cast<unsigned long long>(events_dropped_.load()));
+
+	if (latency_samples_ == 0)
+	{
+		fprintf(file, "%s\n", "Input: no paddle commands");
+		return;
+	}
+
+	fprintf(file, "Input: %llu paddle commands, key-to-tick latency mean %.2f ms, max %.2f ms, %llu dropped\n", static_cast<unsigned long long>(latency_samples_),
+		static_cast<double>(latency_total_us_) / static_cast<double>(latency_samples_) / 1000.0, static_cast<double>(latency_max_us_) / 1000.0,
+		static_cast<unsigned long long>(dropped_commands_.load()));
+}
+
+// Runs before the event watches, on whichever thread pushes the event; returning 0 drops the event.
+int Input::EventFilter(void* user_data, SDL_Event* e)
+{
+	return static_cast<Input*>(user_data)->Filter(*e) ? 1 : 0;
+}
+
+// Runs inside SDL_PumpEvents on the thread that pumps, as each event is queued.
+int Input::EventWatch(void* user_data, SDL_Event* e)
+{
+	static_cast<Input*>(user_data)->Watch(*e);
+	return 0;
+}
+
+void Input::Watch(const SDL_Event& e)
+{
+	if (!capturing_.load(std::memory_order_relaxed) || (e.type != SDL_KEYDOWN && e.type != SDL_KEYUP) || e.key.repeat != 0)
+	{
+		return;
+	}
+
+	const std::uint32_t actions = GetKeyActions(e.key.keysym.scancode);
+	PaddleCommand command = { 0, 0, SDL_GetPerformanceCounter() };
+
+	if ((actions & (ActionBit(InputAction::PLAYER1_UP) | ActionBit(InputAction::PLAYER1_DOWN))) != 0)
+	{
+		command.player_ = 1;
+		command.direction_ = (actions & ActionBit(InputAction::PLAYER1_UP)) != 0 ? -1 : 1;
+	}
+	else if ((actions & (ActionBit(InputAction::PLAYER2_UP) | ActionBit(InputAction::PLAYER2_DOWN))) != 0)
+	{
+		command.player_ = 2;
+		command.direction_ = (actions & ActionBit(InputAction::PLAYER2_UP)) != 0 ? -1 : 1;
+	}
+	else
+	{
+		return;
+	}
+
+	// Releasing either key stops the paddle, as it always has.
+	if (e.type == SDL_KEYUP)
+	{
+		command.direction_ = 0;
+	}
+
+	if (!commands_.TryPush(command))
+	{
+		++dropped_commands_;
+	}
+}
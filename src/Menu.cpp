@@ -0,0 +1,201 @@
+#include "Menu.hpp"
+#include "Audio.hpp"
+#include "Constants.hpp"
+#include "Game.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	// Tints of every widget state, in WidgetState order.
+	constexpr std::array<SDL_Color, static_cast<std::size_t>(WidgetState::COUNT)> state_tints =
+	{ {
+		{ 0xFF, 0xFF, 0xFF, 0xFF },
+		{ 0xFF, 0x00, 0x00, 0xFF },
+		{ 0x00, 0x00, 0x00, 0x19 },
+	} };
+}
+
+Menu::Menu(Game* game) :
+	game_(game),
+	hovered_(none),
+	pointer_({ -1, -1 })
+{
+	static_assert(grid_columns * cell_size >= constants::screen_width && grid_rows * cell_size >= constants::screen_height, "The grid must cover the playfield");
+
+	cells_.fill(0);
+}
+
+int Menu::AddButton(const SDL_Rect& sprite, int center_x, int y)
+{
+	return AddWidget(sprite, center_x, y, 1.0f, true);
+}
+
+int Menu::AddLabel(const SDL_Rect& sprite, int center_x, int y, float scale)
+{
+	return AddWidget(sprite, center_x, y, scale, false);
+}
+
+int Menu::AddWidget(const SDL_Rect& sprite, int center_x, int y, float scale, bool clickable)
+{
+	if (widgets_.size() >= max_widgets)
+	{
+		fprintf(stderr, "Unable to add a widget: a menu holds %zu at most!\n", max_widgets);
+		return none;
+	}
+
+	const int width = static_cast<int>(static_cast<float>(sprite.w) * scale);
+	const int height = static_cast<int>(static_cast<float>(sprite.h) * scale);
+	const int id = static_cast<int>(widgets_.size());
+
+	widgets_.push_back({ sprite, { center_x - (width / 2), y, width, height }, scale, clickable, WidgetState::NORMAL });
+
+	if (!clickable)
+	{
+		return id;
+	}
+
+	const SDL_Rect& bounds = widgets_.back().bounds_;
+	const int first_column = std::clamp(bounds.x / cell_size, 0, grid_columns - 1);
+	const int last_column = std::clamp((bounds.x + bounds.w - 1) / cell_size, 0, grid_columns - 1);
+	const int first_row = std::clamp(bounds.y / cell_size, 0, grid_rows - 1);
+	const int last_row = std::clamp((bounds.y + bounds.h - 1) / cell_size, 0, grid_rows - 1);
+
+	for (int row = first_row; row <= last_row; ++row)
+	{
+		for (int column = first_column; column <= last_column; ++column)
+		{
+			cells_[(row * grid_columns) + column] |= std::uint32_t(1) << id;
+		}
+	}
+
+	return id;
+}
+
+void Menu::SetEnabled(int id, bool enabled)
+{
+	MenuWidget& widget = widgets_[id];
+
+	if (!enabled)
+	{
+		widget.state_ = WidgetState::DISABLED;
+
+		if (hovered_ == id)
+		{
+			hovered_ = none;
+		}
+	}
+	else if (widget.state_ == WidgetState::DISABLED)
+	{
+		widget.state_ = WidgetState::NORMAL;
+	}
+
+	SetHovered(HitTest(pointer_.x, pointer_.y));
+}
+
+const MenuWidget& Menu::GetWidget(int id) const
+{
+	return widgets_[id];
+}
+
+int Menu::HitTest(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= grid_columns * cell_size || y >= grid_rows * cell_size)
+	{
+		return none;
+	}
+
+	const SDL_Point point = { x, y };
+	std::uint32_t candidates = cells_[((y / cell_size) * grid_columns) + (x / cell_size)];
+
+	while (candidates != 0)
+	{
+		const int id = __builtin_ctz(candidates);
+		candidates &= candidates - 1;
+
+		if (widgets_[id].state_ != WidgetState::DISABLED && SDL_PointInRect(&point, &widgets_[id].bounds_))
+		{
+			return id;
+		}
+	}
+
+	return none;
+}
+
+void Menu::SetHovered(int id)
+{
+	if (id == hovered_)
+	{
+		return;
+	}
+
+	if (hovered_ != none)
+	{
+		widgets_[hovered_].state_ = WidgetState::NORMAL;
+	}
+
+	if (id != none)
+	{
+		widgets_[id].state_ = WidgetState::HOVER;
+	}
+
+	hovered_ = id;
+}
+
+void Menu::MovePointer(const SDL_Point& point)
+{
+	pointer_ = point;
+	SetHovered(HitTest(point.x, point.y));
+}
+
+SDL_Point Menu::ToLogical(int window_x, int window_y) const
+{
+	// Frames report window pixels while widgets are laid out in logical playfield coordinates.
+	float logical_x;
+	float logical_y;
+	SDL_RenderWindowToLogical(game_->renderer_, window_x, window_y, &logical_x, &logical_y);
+
+	return { static_cast<int>(logical_x), static_cast<int>(logical_y) };
+}
+
+void Menu::SyncPointer()
+{
+	int window_x;
+	int window_y;
+	SDL_GetMouseState(&window_x, &window_y);
+
+	MovePointer(ToLogical(window_x, window_y));
+}
+
+int Menu::HandleInput(const InputFrame& input)
+{
+	if (input.pointer_moved_)
+	{
+		MovePointer(ToLogical(input.pointer_x_, input.pointer_y_));
+	}
+
+	if (!input.WasPressed(InputAction::CLICK))
+	{
+		return none;
+	}
+
+	const SDL_Point point = ToLogical(input.click_x_, input.click_y_);
+	const int clicked = HitTest(point.x, point.y);
+
+	if (clicked != none)
+	{
+		Audio::Instance()->Post(Sound::BUTTON_CLICK);
+	}
+
+	return clicked;
+}
+
+void Menu::Render()
+{
+	for (const MenuWidget& widget : widgets_)
+	{
+		game_->atlas_.SetColor(state_tints[static_cast<std::size_t>(widget.state_)]);
+		game_->atlas_.Render(game_->renderer_, widget.bounds_.x, widget.bounds_.y, &widget.sprite_, widget.scale_);
+	}
+}
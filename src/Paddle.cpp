@@ -6,12 +6,12 @@
 
 Paddle::Paddle() :
 	game_(nullptr),
-	vy_(0.0f)
+	vy_(Scalar(0))
 {
-	rect_.x = 0.0f;
-	rect_.y = 0.0f;
-	rect_.w = 0.0f;
-	rect_.h = 0.0f;
+	rect_.x = Scalar(0);
+	rect_.y = Scalar(0);
+	rect_.w = Scalar(0);
+	rect_.h = Scalar(0);
 }
 
 void Paddle::HandleEvent(SDL_Event* e)
@@ -19,22 +19,24 @@ void Paddle::HandleEvent(SDL_Event* e)
 	(void)e;
 }
 
-void Paddle::Tick()
+void Paddle::Tick(Scalar time_step)
 {
-	rect_.y += vy_;
+	rect_.y += vy_ * time_step;
 
-	if (rect_.y < 0)
+	if (rect_.y < Scalar(0))
 	{
-		rect_.y = 0;
+		rect_.y = Scalar(0);
 	}
-	else if (rect_.y > constants::screen_height - rect_.h)
+	else if (rect_.y > Scalar(constants::screen_height) - rect_.h)
 	{
-		rect_.y = constants::screen_height - rect_.h;
+		rect_.y = Scalar(constants::screen_height) - rect_.h;
 	}
 }
 
 void Paddle::Render()
 {
+	const SDL_FRect render_rect = ToFRect(rect_);
+
 	SDL_SetRenderDrawColor(game_->renderer_, 0xD3, 0xD3, 0xD3, 0xFF);
-	SDL_RenderFillRectF(game_->renderer_, &rect_);
+	SDL_RenderFillRectF(game_->renderer_, &render_rect);
 }
\ No newline at end of file
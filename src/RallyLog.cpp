@@ -0,0 +1,486 @@
+#include "RallyLog.hpp"
+#include "Simulation.hpp"
+#include "Trace.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	constexpr char rally_log_magic[4] = { 'P', 'R', 'L', 'Y' };
+	constexpr std::uint32_t rally_log_version = 1;
+	constexpr std::size_t block_alignment = 8;
+
+	std::size_t TableIndex(RallyLogTable table)
+	{
+		return static_cast<std::size_t>(table);
+	}
+}
+
+static_assert(sizeof(RallyLogHeader) == 32, "RallyLogHeader must stay tightly packed");
+static_assert(sizeof(RallyLogBlockHeader) == 8, "RallyLogBlockHeader must stay tightly packed");
+
+std::size_t rally_log::GetBlockSize(std::uint32_t rows)
+{
+	std::size_t size = sizeof(RallyLogBlockHeader);
+
+	for (const std::size_t column_size : column_sizes)
+	{
+		size += column_size * rows;
+	}
+
+	return (size + block_alignment - 1) / block_alignment * block_alignment;
+}
+
+RallyLog::RallyLog() :
+	file_(nullptr),
+	block_rows_(default_block_rows),
+	current_blocks_({ no_block, no_block }),
+	running_(false),
+	write_failed_(false),
+	rally_(0),
+	rally_hits_(0),
+	rally_start_tick_(0),
+	rally_max_speed_(0.0f),
+	hit_rows_(0),
+	dropped_rows_(0)
+{
+}
+
+RallyLog::~RallyLog()
+{
+	Close();
+}
+
+bool RallyLog::Open(const char* path, GameMode game_mode, GameDifficulty game_difficulty, std::uint64_t seed, std::uint64_t tick_count,
+	int tick_rate, int physics_substeps, std::uint64_t arena_hash, std::uint32_t block_rows)
+{
+	Close();
+
+	file_ = fopen(path, "wb");
+
+	if (file_ == nullptr)
+	{
+		fprintf(stderr, "Unable to open %s for the rally log!\n", path);
+		return false;
+	}
+
+	RallyLogHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, rally_log_magic, sizeof(header.magic));
+	header.version = rally_log_version;
+	header.seed = seed;
+	header.game_mode = static_cast<std::uint8_t>(game_mode);
+	header.game_difficulty = static_cast<std::uint8_t>(game_difficulty);
+	header.fixed_point = PONG_FIXED_POINT;
+	header.physics_substeps = static_cast<std::uint8_t>(physics_substeps);
+	header.tick_rate = static_cast<std::uint32_t>(tick_rate);
+	header.arena_hash = arena_hash;
+
+	// Written here rather than by the writer thread, so the stream's buffer is allocated before the match starts.
+	if (fwrite(&header, sizeof(header), 1, file_) != 1)
+	{
+		fprintf(stderr, "Unable to write the rally log header to %s!\n", path);
+		fclose(file_);
+		file_ = nullptr;
+		return false;
+	}
+
+	block_rows_ = std::max<std::uint32_t>(block_rows, 1);
+	blocks_.resize(max_blocks);
+
+	for (std::size_t i = 0; i < blocks_.size(); ++i)
+	{
+		blocks_[i].rows = 0;
+		blocks_[i].data.resize(static_cast<std::size_t>(block_rows_) * 4 * rally_log::column_count);
+		free_blocks_.TryPush(i);
+	}
+
+	current_blocks_ = { no_block, no_block };
+	rally_ = 0;
+	rally_hits_ = 0;
+	rally_start_tick_ = tick_count;
+	rally_max_speed_ = 0.0f;
+	hit_rows_ = 0;
+	dropped_rows_ = 0;
+	write_failed_ = false;
+	running_ = true;
+	writer_thread_ = std::thread(&RallyLog::WriterLoop, this);
+
+	return true;
+}
+
+void RallyLog::Close()
+{
+	if (!running_)
+	{
+		return;
+	}
+
+	Submit(RallyLogTable::HITS);
+	Submit(RallyLogTable::RALLIES);
+
+	running_ = false;
+	writer_wakeup_.notify_one();
+	writer_thread_.join();
+
+	fclose(file_);
+	file_ = nullptr;
+
+	fprintf(stderr, "Rally log: %u rallies, %llu hits, %llu rows dropped\n", rally_, static_cast<unsigned long long>(hit_rows_), static_cast<unsigned long long>(dropped_rows_));
+
+	std::size_t index;
+
+	while (free_blocks_.TryPop(index))
+	{
+	}
+
+	blocks_.clear();
+}
+
+bool RallyLog::IsOpen() const
+{
+	return running_;
+}
+
+void RallyLog::Record(const Simulation& simulation)
+{
+	if (!running_)
+	{
+		return;
+	}
+
+	for (std::size_t i = 0; i < simulation.event_count_; ++i)
+	{
+		const SimulationEvent& event = simulation.events_[i];
+
+		switch (event.type_)
+		{
+		case SimulationEventType::SERVE:
+			RecordServe(simulation.tick_count_);
+			break;
+		case SimulationEventType::PADDLE_HIT:
+			RecordHit(simulation.tick_count_, event.player_, event.position_, event.speed_, event.ai_error_);
+			break;
+		case SimulationEventType::GOAL:
+			RecordGoal(simulation.tick_count_, event.player_, event.speed_, event.ai_error_);
+			break;
+		case SimulationEventType::WALL_BOUNCE:
+			break;
+		}
+	}
+}
+
+void RallyLog::RecordHit(std::uint64_t tick, int player, float position, float speed, float ai_error)
+{
+	++rally_hits_;
+	rally_max_speed_ = std::max(rally_max_speed_, speed);
+
+	std::uint32_t row;
+	unsigned char* data = AddRow(RallyLogTable::HITS, row);
+
+	if (data == nullptr)
+	{
+		return;
+	}
+
+	SetUint32(data, rally_log::hit_rally, row, rally_);
+	SetUint32(data, rally_log::hit_tick, row, static_cast<std::uint32_t>(tick - rally_start_tick_));
+	SetFloat(data, rally_log::hit_position, row, position);
+	SetFloat(data, rally_log::hit_speed, row, speed);
+	SetFloat(data, rally_log::hit_ai_error, row, ai_error);
+	data[(static_cast<std::size_t>(block_rows_) * 4 * rally_log::hit_player) + row] = static_cast<std::uint8_t>(player);
+
+	++hit_rows_;
+
+	if (row + 1 == block_rows_)
+	{
+		Submit(RallyLogTable::HITS);
+	}
+}
+
+void RallyLog::RecordGoal(std::uint64_t tick, int scorer, float speed, float ai_error)
+{
+	std::uint32_t row;
+	unsigned char* data = AddRow(RallyLogTable::RALLIES, row);
+
+	if (data != nullptr)
+	{
+		SetUint32(data, rally_log::rally_rally, row, rally_);
+		SetUint32(data, rally_log::rally_hits, row, rally_hits_);
+		SetUint32(data, rally_log::rally_ticks, row, static_cast<std::uint32_t>(tick - rally_start_tick_));
+		SetFloat(data, rally_log::rally_max_speed, row, std::max(rally_max_speed_, speed));
+		SetFloat(data, rally_log::rally_ai_error, row, ai_error);
+		data[(static_cast<std::size_t>(block_rows_) * 4 * rally_log::rally_scorer) + row] = static_cast<std::uint8_t>(scorer);
+
+		if (row + 1 == block_rows_)
+		{
+			Submit(RallyLogTable::RALLIES);
+		}
+	}
+
+	// The next rally counts from its serve; until then from the goal.
+	++rally_;
+	rally_hits_ = 0;
+	rally_start_tick_ = tick;
+	rally_max_speed_ = 0.0f;
+}
+
+void RallyLog::RecordServe(std::uint64_t tick)
+{
+	rally_hits_ = 0;
+	rally_start_tick_ = tick;
+	rally_max_speed_ = 0.0f;
+}
+
+std::uint64_t RallyLog::GetDroppedRows() const
+{
+	return dropped_rows_;
+}
+
+unsigned char* RallyLog::AddRow(RallyLogTable table, std::uint32_t& row)
+{
+	std::size_t& index = current_blocks_[TableIndex(table)];
+
+	if (index == no_block)
+	{
+		if (write_failed_ || !free_blocks_.TryPop(index))
+		{
+			// The wakeup for the last full block may have been missed; without one the writer would sleep it out.
+			index = no_block;
+			++dropped_rows_;
+			writer_wakeup_.notify_one();
+			return nullptr;
+		}
+
+		blocks_[index].table = table;
+		blocks_[index].rows = 0;
+	}
+
+	Block& block = blocks_[index];
+	row = block.rows++;
+
+	return block.data.data();
+}
+
+void RallyLog::SetUint32(unsigned char* data, std::size_t column, std::uint32_t row, std::uint32_t value) const
+{
+	std::memcpy(data + (static_cast<std::size_t>(block_rows_) * 4 * column) + (static_cast<std::size_t>(row) * 4), &value, sizeof(value));
+}
+
+void RallyLog::SetFloat(unsigned char* data, std::size_t column, std::uint32_t row, float value) const
+{
+	std::memcpy(data + (static_cast<std::size_t>(block_rows_) * 4 * column) + (static_cast<std::size_t>(row) * 4), &value, sizeof(value));
+}
+
+void RallyLog::Submit(RallyLogTable table)
+{
+	std::size_t& index = current_blocks_[TableIndex(table)];
+
+	if (index == no_block)
+	{
+		return;
+	}
+
+	// Every block is either free, filling or filled, so there is always room in the queue.
+	filled_blocks_.TryPush(index);
+	index = no_block;
+	writer_wakeup_.notify_one();
+}
+
+void RallyLog::WriterLoop()
+{
+	Trace::Instance()->SetThreadName("Rally log writer");
+
+	std::size_t index;
+
+	while (true)
+	{
+		if (filled_blocks_.TryPop(index))
+		{
+			if (!write_failed_ && !WriteBlock(blocks_[index]))
+			{
+				fprintf(stderr, "%s\n", "Unable to write the rally log, dropping the remaining rows!");
+				write_failed_ = true;
+			}
+
+			free_blocks_.TryPush(index);
+			continue;
+		}
+
+		if (!running_)
+		{
+			break;
+		}
+
+		// The ticking thread only notifies, it never takes this lock, so a wakeup can be missed; the timeout covers that.
+		std::unique_lock<std::mutex> lock(writer_mutex_);
+		writer_wakeup_.wait_for(lock, std::chrono::milliseconds(5));
+	}
+}
+
+bool RallyLog::WriteBlock(const Block& block)
+{
+	TRACE_ZONE("RallyLog::WriteBlock");
+
+	const RallyLogBlockHeader header = { block.table, block.rows };
+
+	if (fwrite(&header, sizeof(header), 1, file_) != 1)
+	{
+		return false;
+	}
+
+	// Only the filled part of every column goes to disk, so a block cut short at Close is no bigger than its rows.
+	std::size_t written = sizeof(header);
+
+	for (std::size_t column = 0; column < rally_log::column_count; ++column)
+	{
+		const std::size_t size = rally_log::column_sizes[column] * block.rows;
+
+		if (size > 0 && fwrite(block.data.data() + (static_cast<std::size_t>(block_rows_) * 4 * column), 1, size, file_) != size)
+		{
+			return false;
+		}
+
+		written += size;
+	}
+
+	static constexpr unsigned char padding[block_alignment] = {};
+	const std::size_t padding_size = rally_log::GetBlockSize(block.rows) - written;
+
+	return padding_size == 0 || fwrite(padding, 1, padding_size, file_) == padding_size;
+}
+
+const std::uint32_t* RallyLogBlock::GetUint32(std::size_t column) const
+{
+	return reinterpret_cast<const std::uint32_t*>(columns_[column]);
+}
+
+const float* RallyLogBlock::GetFloat(std::size_t column) const
+{
+	return reinterpret_cast<const float*>(columns_[column]);
+}
+
+const std::uint8_t* RallyLogBlock::GetUint8(std::size_t column) const
+{
+	return columns_[column];
+}
+
+RallyLogReader::RallyLogReader() :
+	data_(nullptr),
+	size_(0),
+	cursor_(0)
+{
+	std::memset(&header_, 0, sizeof(header_));
+}
+
+RallyLogReader::~RallyLogReader()
+{
+	Close();
+}
+
+bool RallyLogReader::Open(const char* path)
+{
+	Close();
+
+	const int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+	{
+		fprintf(stderr, "Unable to open rally log %s!\n", path);
+		return false;
+	}
+
+	struct stat file_stat;
+
+	if (fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < sizeof(RallyLogHeader))
+	{
+		fprintf(stderr, "Rally log %s is too short!\n", path);
+		close(fd);
+		return false;
+	}
+
+	size_ = static_cast<std::size_t>(file_stat.st_size);
+	void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+	{
+		fprintf(stderr, "Unable to map rally log %s!\n", path);
+		size_ = 0;
+		return false;
+	}
+
+	data_ = static_cast<const unsigned char*>(mapping);
+	std::memcpy(&header_, data_, sizeof(header_));
+
+	if (std::memcmp(header_.magic, rally_log_magic, sizeof(rally_log_magic)) != 0 || header_.version != rally_log_version)
+	{
+		fprintf(stderr, "Unable to read %s: it is not a rally log of this version!\n", path);
+		Close();
+		return false;
+	}
+
+	// Aggregates read every column front to back exactly once.
+	madvise(mapping, size_, MADV_SEQUENTIAL);
+
+	cursor_ = sizeof(RallyLogHeader);
+
+	return true;
+}
+
+void RallyLogReader::Close()
+{
+	if (data_ != nullptr)
+	{
+		munmap(const_cast<unsigned char*>(data_), size_);
+	}
+
+	data_ = nullptr;
+	size_ = 0;
+	cursor_ = 0;
+}
+
+const RallyLogHeader& RallyLogReader::GetHeader() const
+{
+	return header_;
+}
+
+bool RallyLogReader::Next(RallyLogBlock& block)
+{
+	if (data_ == nullptr || size_ - cursor_ < sizeof(RallyLogBlockHeader))
+	{
+		return false;
+	}
+
+	RallyLogBlockHeader header;
+	std::memcpy(&header, data_ + cursor_, sizeof(header));
+
+	const std::size_t block_size = rally_log::GetBlockSize(header.rows);
+
+	if (block_size > size_ - cursor_ || (header.table != RallyLogTable::HITS && header.table != RallyLogTable::RALLIES))
+	{
+		return false;
+	}
+
+	block.table_ = header.table;
+	block.rows_ = header.rows;
+
+	const unsigned char* column = data_ + cursor_ + sizeof(header);
+
+	for (std::size_t i = 0; i < rally_log::column_count; ++i)
+	{
+		block.columns_[i] = column;
+		column += rally_log::column_sizes[i] * header.rows;
+	}
+
+	cursor_ += block_size;
+
+	return true;
+}
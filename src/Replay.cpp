@@ -0,0 +1,441 @@
+#include "Replay.hpp"
+#include "Trace.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr char replay_magic[4] = { 'P', 'R', 'P', 'L' };
+	constexpr std::uint32_t replay_version = 4;
+
+	// A long match is a few hours at most; reserving the index up front keeps recording allocation-free.
+	constexpr std::size_t reserved_keyframes = 4096;
+
+	static_assert(sizeof(ReplayHeader) == 64, "ReplayHeader must stay tightly packed");
+	static_assert(sizeof(ReplayIndexEntry) == 16, "ReplayIndexEntry must stay tightly packed");
+}
+
+ReplayWriter::ReplayWriter() :
+	file_(nullptr),
+	header_(),
+	offset_(0),
+	last_change_tick_(0),
+	player1_vy_(0),
+	player2_vy_(0),
+	keyframe_requested_(false),
+	write_failed_(false)
+{
+}
+
+ReplayWriter::~ReplayWriter()
+{
+	Close();
+}
+
+bool ReplayWriter::Open(const char* path, GameMode game_mode, GameDifficulty game_difficulty, std::uint64_t seed, int tick_rate, int physics_substeps,
+	std::uint64_t arena_hash, std::uint32_t keyframe_interval)
+{
+	Close();
+
+	file_ = fopen(path, "wb");
+
+	if (file_ == nullptr)
+	{
+		fprintf(stderr, "Unable to open %s for recording the replay!\n", path);
+		return false;
+	}
+
+	std::memset(&header_, 0, sizeof(header_));
+	std::memcpy(header_.magic, replay_magic, sizeof(header_.magic));
+	header_.version = replay_version;
+	header_.seed = seed;
+	header_.game_mode = static_cast<std::uint8_t>(game_mode);
+	header_.game_difficulty = static_cast<std::uint8_t>(game_difficulty);
+	header_.fixed_point = PONG_FIXED_POINT;
+	header_.physics_substeps = static_cast<std::uint8_t>(physics_substeps);
+	header_.tick_rate = static_cast<std::uint32_t>(tick_rate);
+	header_.state_size = sizeof(SimulationState);
+	header_.keyframe_interval = keyframe_interval == 0 ? default_keyframe_interval : keyframe_interval;
+	header_.arena_hash = arena_hash;
+
+	index_.clear();
+	index_.reserve(reserved_keyframes);
+	offset_ = 0;
+	last_change_tick_ = 0;
+	player1_vy_ = 0;
+	player2_vy_ = 0;
+	keyframe_requested_ = true;
+	write_failed_ = false;
+
+	// Rewritten with the final counts by Close.
+	Write(&header_, sizeof(header_));
+
+	return !write_failed_;
+}
+
+bool ReplayWriter::Close()
+{
+	if (file_ == nullptr)
+	{
+		return false;
+	}
+
+	header_.keyframe_count = index_.size();
+	header_.index_offset = offset_;
+
+	Write(index_.data(), index_.size() * sizeof(ReplayIndexEntry));
+
+	if (fseek(file_, 0, SEEK_SET) != 0 || fwrite(&header_, sizeof(header_), 1, file_) != 1)
+	{
+		write_failed_ = true;
+	}
+
+	if (fclose(file_) != 0)
+	{
+		write_failed_ = true;
+	}
+
+	file_ = nullptr;
+
+	if (write_failed_)
+	{
+		fprintf(stderr, "%s\n", "Writing the replay failed, the file is incomplete.");
+	}
+
+	return !write_failed_;
+}
+
+bool ReplayWriter::IsOpen() const
+{
+	return file_ != nullptr;
+}
+
+void ReplayWriter::Write(const void* data, std::size_t size)
+{
+	if (write_failed_ || size == 0)
+	{
+		return;
+	}
+
+	if (fwrite(data, 1, size, file_) != size)
+	{
+		write_failed_ = true;
+		return;
+	}
+
+	offset_ += size;
+}
+
+void ReplayWriter::Record(const Simulation& simulation)
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	TRACE_ZONE("ReplayWriter::Record");
+
+	const std::uint64_t tick = simulation.tick_count_;
+	const int player1_vy = static_cast<int>(simulation.player1_paddle_.vy_);
+	const int player2_vy = simulation.game_mode_ == GameMode::MULTI_PLAYER ? static_cast<int>(simulation.player2_paddle_.vy_) : 0;
+
+	if (keyframe_requested_ || tick % header_.keyframe_interval == 0)
+	{
+		SimulationState state;
+		simulation.SaveState(state);
+
+		index_.push_back({ tick, offset_ });
+		Write(&state, sizeof(state));
+
+		// The keyframe already holds this tick's velocities; changes are counted from here.
+		keyframe_requested_ = false;
+		last_change_tick_ = tick;
+		player1_vy_ = player1_vy;
+		player2_vy_ = player2_vy;
+	}
+	else if (player1_vy != player1_vy_ || player2_vy != player2_vy_)
+	{
+		unsigned char change[12];
+		std::size_t length = 0;
+		std::uint64_t delta = tick - last_change_tick_;
+
+		do
+		{
+			const unsigned char byte = static_cast<unsigned char>(delta & 0x7F);
+			delta >>= 7;
+			change[length++] = delta != 0 ? static_cast<unsigned char>(byte | 0x80) : byte;
+		} while (delta != 0);
+
+		change[length++] = static_cast<unsigned char>(static_cast<std::int8_t>(player1_vy));
+		change[length++] = static_cast<unsigned char>(static_cast<std::int8_t>(player2_vy));
+
+		Write(change, length);
+
+		last_change_tick_ = tick;
+		player1_vy_ = player1_vy;
+		player2_vy_ = player2_vy;
+	}
+
+	header_.tick_count = tick + 1;
+}
+
+void ReplayWriter::RequestKeyframe()
+{
+	keyframe_requested_ = true;
+}
+
+std::uint64_t ReplayWriter::GetSize() const
+{
+	return offset_;
+}
+
+ReplayReader::ReplayReader() :
+	data_(nullptr),
+	size_(0),
+	header_(),
+	chunk_(0),
+	cursor_(0),
+	chunk_end_(0),
+	has_change_(false),
+	change_tick_(0),
+	change_player1_vy_(0),
+	change_player2_vy_(0)
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+	Close();
+}
+
+bool ReplayReader::Open(const char* path)
+{
+	Close();
+
+	const int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+	{
+		fprintf(stderr, "Unable to open replay %s!\n", path);
+		return false;
+	}
+
+	struct stat file_stat;
+
+	if (fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < sizeof(ReplayHeader))
+	{
+		fprintf(stderr, "Replay %s is too short!\n", path);
+		close(fd);
+		return false;
+	}
+
+	size_ = static_cast<std::size_t>(file_stat.st_size);
+	void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+	{
+		fprintf(stderr, "Unable to map replay %s!\n", path);
+		size_ = 0;
+		return false;
+	}
+
+	data_ = static_cast<const unsigned char*>(mapping);
+	std::memcpy(&header_, data_, sizeof(header_));
+
+	const char* error = nullptr;
+
+	if (std::memcmp(header_.magic, replay_magic, sizeof(replay_magic)) != 0 || header_.version != replay_version)
+	{
+		error = "is not a replay of this version";
+	}
+	else if (header_.fixed_point != PONG_FIXED_POINT || header_.state_size != sizeof(SimulationState) || header_.tick_rate == 0 || header_.physics_substeps == 0)
+	{
+		error = "was recorded by a build with different physics";
+	}
+	else if (header_.keyframe_count == 0 || header_.index_offset > size_ || (size_ - header_.index_offset) / sizeof(ReplayIndexEntry) < header_.keyframe_count)
+	{
+		error = "has no complete index";
+	}
+	else
+	{
+		for (std::uint64_t i = 0; i < header_.keyframe_count && error == nullptr; ++i)
+		{
+			const ReplayIndexEntry entry = GetIndexEntry(i);
+
+			if (entry.offset < sizeof(ReplayHeader) || entry.offset + sizeof(SimulationState) > header_.index_offset || entry.tick > header_.tick_count ||
+				(i > 0 && entry.tick <= GetIndexEntry(i - 1).tick))
+			{
+				error = "has a damaged index";
+			}
+		}
+	}
+
+	if (error != nullptr)
+	{
+		fprintf(stderr, "Replay %s %s!\n", path, error);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void ReplayReader::Close()
+{
+	if (data_ != nullptr)
+	{
+		munmap(const_cast<unsigned char*>(data_), size_);
+	}
+
+	data_ = nullptr;
+	size_ = 0;
+	has_change_ = false;
+}
+
+bool ReplayReader::IsOpen() const
+{
+	return data_ != nullptr;
+}
+
+const ReplayHeader& ReplayReader::GetHeader() const
+{
+	return header_;
+}
+
+GameMode ReplayReader::GetGameMode() const
+{
+	return static_cast<GameMode>(header_.game_mode);
+}
+
+GameDifficulty ReplayReader::GetGameDifficulty() const
+{
+	return static_cast<GameDifficulty>(header_.game_difficulty);
+}
+
+int ReplayReader::GetTickRate() const
+{
+	return static_cast<int>(header_.tick_rate);
+}
+
+ReplayIndexEntry ReplayReader::GetIndexEntry(std::uint64_t keyframe) const
+{
+	ReplayIndexEntry entry;
+	std::memcpy(&entry, data_ + header_.index_offset + keyframe * sizeof(ReplayIndexEntry), sizeof(entry));
+	return entry;
+}
+
+void ReplayReader::LoadKeyframe(Simulation& simulation, std::uint64_t keyframe)
+{
+	const ReplayIndexEntry entry = GetIndexEntry(keyframe);
+
+	SimulationState state;
+	std::memcpy(&state, data_ + entry.offset, sizeof(state));
+	simulation.LoadState(state);
+
+	chunk_ = keyframe;
+	cursor_ = entry.offset + sizeof(state);
+	chunk_end_ = keyframe + 1 < header_.keyframe_count ? GetIndexEntry(keyframe + 1).offset : header_.index_offset;
+	change_tick_ = entry.tick;
+
+	ReadChange();
+}
+
+void ReplayReader::ReadChange()
+{
+	has_change_ = false;
+
+	std::uint64_t delta = 0;
+	int shift = 0;
+
+	while (cursor_ < chunk_end_ && shift < 64)
+	{
+		const unsigned char byte = data_[cursor_++];
+		delta |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		shift += 7;
+
+		if ((byte & 0x80) == 0)
+		{
+			if (chunk_end_ - cursor_ < 2)
+			{
+				return;
+			}
+
+			change_player1_vy_ = static_cast<std::int8_t>(data_[cursor_++]);
+			change_player2_vy_ = static_cast<std::int8_t>(data_[cursor_++]);
+			change_tick_ += delta;
+			has_change_ = true;
+			return;
+		}
+	}
+}
+
+void ReplayReader::Seek(Simulation& simulation, std::uint64_t tick)
+{
+	TRACE_ZONE("ReplayReader::Seek");
+
+	tick = std::min(tick, header_.tick_count);
+
+	// Last keyframe at or before tick.
+	std::uint64_t low = 0;
+	std::uint64_t high = header_.keyframe_count;
+
+	while (high - low > 1)
+	{
+		const std::uint64_t middle = low + (high - low) / 2;
+
+		if (GetIndexEntry(middle).tick <= tick)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	simulation.SetTickRate(GetTickRate(), header_.physics_substeps);
+	simulation.Reset(GetGameMode(), GetGameDifficulty(), header_.seed);
+	LoadKeyframe(simulation, low);
+
+	while (simulation.tick_count_ < tick && Step(simulation))
+	{
+	}
+}
+
+bool ReplayReader::Step(Simulation& simulation)
+{
+	const std::uint64_t tick = simulation.tick_count_;
+
+	if (tick >= header_.tick_count)
+	{
+		return false;
+	}
+
+	// A keyframe on this tick may carry a tuning change, so it is loaded rather than stepped over.
+	if (chunk_ + 1 < header_.keyframe_count && GetIndexEntry(chunk_ + 1).tick == tick)
+	{
+		LoadKeyframe(simulation, chunk_ + 1);
+	}
+	else if (has_change_ && change_tick_ == tick)
+	{
+		simulation.player1_paddle_.vy_ = Scalar(change_player1_vy_);
+
+		if (simulation.game_mode_ == GameMode::MULTI_PLAYER)
+		{
+			simulation.player2_paddle_.vy_ = Scalar(change_player2_vy_);
+		}
+
+		ReadChange();
+	}
+
+	simulation.Tick();
+
+	return true;
+}
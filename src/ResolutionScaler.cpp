@@ -0,0 +1,164 @@
+#include "ResolutionScaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	// Frames to wait after a change before judging the new scale, and the smoothing of the frame time.
+	constexpr int settle_frames = 30;
+	constexpr float average_weight = 0.1f;
+
+	// Scaling up only once frames would still fit the budget at the next step's larger area.
+	constexpr float upscale_headroom = 0.7f;
+}
+
+ResolutionScaler::ResolutionScaler() :
+	renderer_(nullptr),
+	target_(nullptr),
+	width_(0),
+	height_(0),
+	budget_ms_(0.0f),
+	log_decisions_(false),
+	scale_(1.0f),
+	average_frame_ms_(0.0f),
+	frames_since_change_(0),
+	scale_changes_(0)
+{
+}
+
+ResolutionScaler::~ResolutionScaler()
+{
+	Close();
+}
+
+bool ResolutionScaler::Open(SDL_Renderer* renderer, int width, int height, float budget_ms, bool log_decisions)
+{
+	Close();
+
+	if (!SDL_RenderTargetSupported(renderer))
+	{
+		fprintf(stderr, "%s\n", "Renderer does not support render targets, dynamic resolution is disabled.");
+		return false;
+	}
+
+	target_ = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+
+	if (target_ == nullptr)
+	{
+		fprintf(stderr, "Unable to create render target! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+
+	// Smooths the upscale; the hint set for the rest of the game keeps nearest filtering elsewhere.
+	SDL_SetTextureScaleMode(target_, SDL_ScaleModeLinear);
+
+	renderer_ = renderer;
+	width_ = width;
+	height_ = height;
+	budget_ms_ = budget_ms;
+	log_decisions_ = log_decisions;
+	scale_ = 1.0f;
+	average_frame_ms_ = 0.0f;
+	frames_since_change_ = 0;
+	scale_changes_ = 0;
+
+	return true;
+}
+
+void ResolutionScaler::Close()
+{
+	if (target_ != nullptr)
+	{
+		SDL_DestroyTexture(target_);
+		target_ = nullptr;
+	}
+
+	renderer_ = nullptr;
+}
+
+SDL_Rect ResolutionScaler::GetScaledRect() const
+{
+	return { 0, 0, static_cast<int>(std::lround(width_ * scale_)), static_cast<int>(std::lround(height_ * scale_)) };
+}
+
+void ResolutionScaler::BeginFrame()
+{
+	SDL_SetRenderTarget(renderer_, target_);
+
+	// Scale and viewport belong to the target and are restored for the window when it is unbound.
+	SDL_RenderSetScale(renderer_, scale_, scale_);
+}
+
+void ResolutionScaler::EndFrame()
+{
+	SDL_SetRenderTarget(renderer_, nullptr);
+
+	const SDL_Rect source = GetScaledRect();
+
+	SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0x00, 0xFF);
+	SDL_RenderClear(renderer_);
+	SDL_RenderCopy(renderer_, target_, &source, nullptr);
+}
+
+void ResolutionScaler::Update(float frame_ms)
+{
+	average_frame_ms_ = average_frame_ms_ == 0.0f ? frame_ms : average_frame_ms_ + average_weight * (frame_ms - average_frame_ms_);
+
+	if (++frames_since_change_ < settle_frames)
+	{
+		return;
+	}
+
+	if (average_frame_ms_ > budget_ms_ && scale_ > min_scale)
+	{
+		// Fill cost goes with the area, so jump straight to the scale whose area should fit, rounded to a step.
+		const float fitting_scale = scale_ * std::sqrt(budget_ms_ / average_frame_ms_);
+		const float stepped_scale = std::floor(fitting_scale / scale_step) * scale_step;
+
+		SetScale(std::clamp(std::min(stepped_scale, scale_ - scale_step), min_scale, 1.0f), "over budget");
+	}
+	else if (scale_ < 1.0f)
+	{
+		const float next_scale = std::min(scale_ + scale_step, 1.0f);
+		const float predicted_ms = average_frame_ms_ * (next_scale * next_scale) / (scale_ * scale_);
+
+		if (predicted_ms < budget_ms_ * upscale_headroom)
+		{
+			SetScale(next_scale, "headroom");
+		}
+	}
+}
+
+void ResolutionScaler::SetScale(float scale, const char* reason)
+{
+	if (log_decisions_)
+	{
+		fprintf(stderr, "Render scale %.3f -> %.3f (%s: %.2f ms average, %.2f ms budget)\n", scale_, scale, reason, average_frame_ms_, budget_ms_);
+	}
+
+	scale_ = scale;
+	frames_since_change_ = 0;
+	++scale_changes_;
+}
+
+float ResolutionScaler::GetScale() const
+{
+	return scale_;
+}
+
+float ResolutionScaler::GetAverageFrameMs() const
+{
+	return average_frame_ms_;
+}
+
+float ResolutionScaler::GetBudgetMs() const
+{
+	return budget_ms_;
+}
+
+int ResolutionScaler::GetScaleChanges() const
+{
+	return scale_changes_;
+}
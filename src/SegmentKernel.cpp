@@ -0,0 +1,575 @@
+#include "SegmentKernel.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define PONG_SEGMENT_KERNEL_X86 1
+#define PONG_TARGET_AVX __attribute__((target("avx")))
+#else
+#define PONG_SEGMENT_KERNEL_X86 0
+#endif
+
+// Contracting a product and a difference into an FMA would make the estimates differ between the variants.
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+SegmentBatch::SegmentBatch() :
+	count_(0)
+{
+}
+
+void SegmentBatch::Clear()
+{
+	ax_.clear();
+	ay_.clear();
+	bx_.clear();
+	by_.clear();
+	count_ = 0;
+}
+
+void SegmentBatch::Reserve(std::size_t count)
+{
+	const std::size_t padded_count = (count + lane_padding - 1) / lane_padding * lane_padding;
+
+	ax_.reserve(padded_count);
+	ay_.reserve(padded_count);
+	bx_.reserve(padded_count);
+	by_.reserve(padded_count);
+}
+
+void SegmentBatch::Add(float ax, float ay, float bx, float by)
+{
+	// Drop the padding, append, and pad again with zeros.
+	ax_.resize(count_);
+	ay_.resize(count_);
+	bx_.resize(count_);
+	by_.resize(count_);
+
+	ax_.push_back(ax);
+	ay_.push_back(ay);
+	bx_.push_back(bx);
+	by_.push_back(by);
+	++count_;
+
+	const std::size_t padded_count = GetPaddedCount();
+
+	ax_.resize(padded_count);
+	ay_.resize(padded_count);
+	bx_.resize(padded_count);
+	by_.resize(padded_count);
+}
+
+std::size_t SegmentBatch::GetCount() const
+{
+	return count_;
+}
+
+std::size_t SegmentBatch::GetPaddedCount() const
+{
+	return (count_ + lane_padding - 1) / lane_padding * lane_padding;
+}
+
+const float* SegmentBatch::GetAx() const
+{
+	return ax_.data();
+}
+
+const float* SegmentBatch::GetAy() const
+{
+	return ay_.data();
+}
+
+const float* SegmentBatch::GetBx() const
+{
+	return bx_.data();
+}
+
+const float* SegmentBatch::GetBy() const
+{
+	return by_.data();
+}
+
+namespace
+{
+	// Shewchuk's bound for the orientation determinant evaluated in double precision: when the estimate is at least
+	// this far from zero, relative to the two products, its sign is the sign of the exact determinant.
+	constexpr double orientation_error_bound = (3.0 + 16.0 * 0x1p-53) * 0x1p-53;
+
+	struct OrientationEstimate
+	{
+		double det;
+		bool certain;
+	};
+
+	OrientationEstimate EstimateOrientation(double px, double py, double qx, double qy, double rx, double ry)
+	{
+		const double left = (qx - px) * (ry - py);
+		const double right = (qy - py) * (rx - px);
+		const double det = left - right;
+
+		return { det, std::fabs(det) >= orientation_error_bound * (std::fabs(left) + std::fabs(right)) };
+	}
+
+	// Error-free transformations: sum + error and product + error are exactly a + b and a * b.
+	void TwoSum(double a, double b, double& sum, double& error)
+	{
+		sum = a + b;
+		const double b_virtual = sum - a;
+		const double a_virtual = sum - b_virtual;
+		error = (a - a_virtual) + (b - b_virtual);
+	}
+
+	void TwoProduct(double a, double b, double& product, double& error)
+	{
+		product = a * b;
+		error = std::fma(a, b, -product);
+	}
+
+	// The determinant as a sum of 16 exact terms, accumulated into a nonoverlapping expansion; its sign is the sign
+	// of its largest component, which is the last nonzero one.
+	int ExactOrientation(double px, double py, double qx, double qy, double rx, double ry)
+	{
+		double a[2];
+		double b[2];
+		double c[2];
+		double d[2];
+
+		TwoSum(qx, -px, a[1], a[0]);
+		TwoSum(ry, -py, b[1], b[0]);
+		TwoSum(qy, -py, c[1], c[0]);
+		TwoSum(rx, -px, d[1], d[0]);
+
+		double terms[16];
+		int term_count = 0;
+
+		for (int i = 0; i < 2; ++i)
+		{
+			for (int j = 0; j < 2; ++j)
+			{
+				TwoProduct(a[i], b[j], terms[term_count], terms[term_count + 1]);
+				TwoProduct(-c[i], d[j], terms[term_count + 2], terms[term_count + 3]);
+				term_count += 4;
+			}
+		}
+
+		double expansion[16];
+		int length = 0;
+
+		for (int i = 0; i < term_count; ++i)
+		{
+			double q = terms[i];
+
+			for (int j = 0; j < length; ++j)
+			{
+				double sum;
+				double error;
+				TwoSum(q, expansion[j], sum, error);
+				expansion[j] = error;
+				q = sum;
+			}
+
+			expansion[length++] = q;
+		}
+
+		for (int i = length - 1; i >= 0; --i)
+		{
+			if (expansion[i] != 0.0)
+			{
+				return expansion[i] > 0.0 ? 1 : -1;
+			}
+		}
+
+		return 0;
+	}
+
+	int OrientationSign(double px, double py, double qx, double qy, double rx, double ry, const OrientationEstimate& estimate)
+	{
+		if (!estimate.certain)
+		{
+			return ExactOrientation(px, py, qx, qy, rx, ry);
+		}
+
+		return (estimate.det > 0.0) - (estimate.det < 0.0);
+	}
+
+	// The vector kernels build the same values lane by lane, so the operations here must stay in this order.
+	double GetCrossingT(double d1, double d2)
+	{
+		const double sum = std::fabs(d1) + std::fabs(d2);
+		return sum > 0.0 ? std::fabs(d1) / sum : 0.0;
+	}
+
+	// The ray's start and end strictly on different sides of the segment's line, or the end on it, and the segment's
+	// ends not both strictly on the same side of the ray's line. s1 == 0 rules out the ray starting on the line, and
+	// with it parallel, collinear and zero-length segments.
+	bool IsHit(int s1, int s2, int s3, int s4)
+	{
+		return s1 != 0 && s2 != s1 && s3 * s4 <= 0;
+	}
+
+	struct Ray
+	{
+		double start_x;
+		double start_y;
+		double end_x;
+		double end_y;
+	};
+
+	// d1 .. d4 as the kernels number them: the ray's start and end against the segment, then the segment's ends
+	// against the ray.
+	void GetSigns(const SegmentBatch& segments, std::size_t i, const Ray& ray, int signs[4], double& d1, double& d2)
+	{
+		const double ax = segments.GetAx()[i];
+		const double ay = segments.GetAy()[i];
+		const double bx = segments.GetBx()[i];
+		const double by = segments.GetBy()[i];
+
+		const OrientationEstimate e1 = EstimateOrientation(ax, ay, bx, by, ray.start_x, ray.start_y);
+		const OrientationEstimate e2 = EstimateOrientation(ax, ay, bx, by, ray.end_x, ray.end_y);
+		const OrientationEstimate e3 = EstimateOrientation(ray.start_x, ray.start_y, ray.end_x, ray.end_y, ax, ay);
+		const OrientationEstimate e4 = EstimateOrientation(ray.start_x, ray.start_y, ray.end_x, ray.end_y, bx, by);
+
+		signs[0] = OrientationSign(ax, ay, bx, by, ray.start_x, ray.start_y, e1);
+		signs[1] = OrientationSign(ax, ay, bx, by, ray.end_x, ray.end_y, e2);
+		signs[2] = OrientationSign(ray.start_x, ray.start_y, ray.end_x, ray.end_y, ax, ay, e3);
+		signs[3] = OrientationSign(ray.start_x, ray.start_y, ray.end_x, ray.end_y, bx, by, e4);
+
+		d1 = e1.det;
+		d2 = e2.det;
+	}
+
+	SegmentHit MakeHit(int index, double t, const Ray& ray)
+	{
+		if (index < 0)
+		{
+			return { -1, 0.0f, 0.0f, 0.0f };
+		}
+
+		return { index, static_cast<float>(t), static_cast<float>(ray.start_x + t * (ray.end_x - ray.start_x)),
+			static_cast<float>(ray.start_y + t * (ray.end_y - ray.start_y)) };
+	}
+
+	// Lowest t across the lanes, the lowest index among equal ones. Each lane already kept its lowest index.
+	SegmentHit ReduceLanes(const double* t, const double* index, int lane_count, const Ray& ray)
+	{
+		double best_t = std::numeric_limits<double>::infinity();
+		int best_index = -1;
+
+		for (int lane = 0; lane < lane_count; ++lane)
+		{
+			if (index[lane] < 0.0)
+			{
+				continue;
+			}
+
+			const int lane_index = static_cast<int>(index[lane]);
+
+			if (t[lane] < best_t || (t[lane] == best_t && lane_index < best_index))
+			{
+				best_t = t[lane];
+				best_index = lane_index;
+			}
+		}
+
+		return MakeHit(best_index, best_t, ray);
+	}
+
+#if PONG_SEGMENT_KERNEL_X86
+	struct Orientation2
+	{
+		__m128d det;
+		__m128d uncertain;
+	};
+
+	inline Orientation2 EstimateOrientation2(__m128d px, __m128d py, __m128d qx, __m128d qy, __m128d rx, __m128d ry)
+	{
+		const __m128d sign_bit = _mm_set1_pd(-0.0);
+		const __m128d left = _mm_mul_pd(_mm_sub_pd(qx, px), _mm_sub_pd(ry, py));
+		const __m128d right = _mm_mul_pd(_mm_sub_pd(qy, py), _mm_sub_pd(rx, px));
+		const __m128d det = _mm_sub_pd(left, right);
+		const __m128d bound = _mm_mul_pd(_mm_set1_pd(orientation_error_bound), _mm_add_pd(_mm_andnot_pd(sign_bit, left), _mm_andnot_pd(sign_bit, right)));
+
+		return { det, _mm_cmplt_pd(_mm_andnot_pd(sign_bit, det), bound) };
+	}
+
+	inline __m128d Sign2(__m128d value)
+	{
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d one = _mm_set1_pd(1.0);
+		return _mm_sub_pd(_mm_and_pd(_mm_cmpgt_pd(value, zero), one), _mm_and_pd(_mm_cmplt_pd(value, zero), one));
+	}
+
+	inline __m128d Load2(const float* values)
+	{
+		return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values))));
+	}
+
+	struct Orientation4
+	{
+		__m256d det;
+		__m256d uncertain;
+	};
+
+	PONG_TARGET_AVX inline Orientation4 EstimateOrientation4(__m256d px, __m256d py, __m256d qx, __m256d qy, __m256d rx, __m256d ry)
+	{
+		const __m256d sign_bit = _mm256_set1_pd(-0.0);
+		const __m256d left = _mm256_mul_pd(_mm256_sub_pd(qx, px), _mm256_sub_pd(ry, py));
+		const __m256d right = _mm256_mul_pd(_mm256_sub_pd(qy, py), _mm256_sub_pd(rx, px));
+		const __m256d det = _mm256_sub_pd(left, right);
+		const __m256d bound = _mm256_mul_pd(_mm256_set1_pd(orientation_error_bound),
+			_mm256_add_pd(_mm256_andnot_pd(sign_bit, left), _mm256_andnot_pd(sign_bit, right)));
+
+		return { det, _mm256_cmp_pd(_mm256_andnot_pd(sign_bit, det), bound, _CMP_LT_OQ) };
+	}
+
+	PONG_TARGET_AVX inline __m256d Sign4(__m256d value)
+	{
+		const __m256d zero = _mm256_setzero_pd();
+		const __m256d one = _mm256_set1_pd(1.0);
+		return _mm256_sub_pd(_mm256_and_pd(_mm256_cmp_pd(value, zero, _CMP_GT_OQ), one), _mm256_and_pd(_mm256_cmp_pd(value, zero, _CMP_LT_OQ), one));
+	}
+#endif
+}
+
+namespace segment_kernel
+{
+	int Orientation(float px, float py, float qx, float qy, float rx, float ry)
+	{
+		const OrientationEstimate estimate = EstimateOrientation(px, py, qx, qy, rx, ry);
+		return OrientationSign(px, py, qx, qy, rx, ry, estimate);
+	}
+
+	SegmentHit FindNearestHitScalar(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y)
+	{
+		const Ray ray = { start_x, start_y, end_x, end_y };
+
+		double best_t = std::numeric_limits<double>::infinity();
+		int best_index = -1;
+
+		for (std::size_t i = 0; i < segments.GetCount(); ++i)
+		{
+			int signs[4];
+			double d1;
+			double d2;
+			GetSigns(segments, i, ray, signs, d1, d2);
+
+			if (!IsHit(signs[0], signs[1], signs[2], signs[3]))
+			{
+				continue;
+			}
+
+			const double t = GetCrossingT(d1, d2);
+
+			if (t < best_t)
+			{
+				best_t = t;
+				best_index = static_cast<int>(i);
+			}
+		}
+
+		return MakeHit(best_index, best_t, ray);
+	}
+
+	SegmentHit FindNearestHitSse2(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y)
+	{
+#if PONG_SEGMENT_KERNEL_X86
+		const Ray ray = { start_x, start_y, end_x, end_y };
+
+		const __m128d sx = _mm_set1_pd(ray.start_x);
+		const __m128d sy = _mm_set1_pd(ray.start_y);
+		const __m128d ex = _mm_set1_pd(ray.end_x);
+		const __m128d ey = _mm_set1_pd(ray.end_y);
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d sign_bit = _mm_set1_pd(-0.0);
+
+		__m128d best_t = _mm_set1_pd(std::numeric_limits<double>::infinity());
+		__m128d best_index = _mm_set1_pd(-1.0);
+		__m128d index = _mm_set_pd(1.0, 0.0);
+		const __m128d index_step = _mm_set1_pd(2.0);
+
+		for (std::size_t i = 0; i < segments.GetPaddedCount(); i += 2)
+		{
+			const __m128d ax = Load2(segments.GetAx() + i);
+			const __m128d ay = Load2(segments.GetAy() + i);
+			const __m128d bx = Load2(segments.GetBx() + i);
+			const __m128d by = Load2(segments.GetBy() + i);
+
+			const Orientation2 o1 = EstimateOrientation2(ax, ay, bx, by, sx, sy);
+			const Orientation2 o2 = EstimateOrientation2(ax, ay, bx, by, ex, ey);
+			const Orientation2 o3 = EstimateOrientation2(sx, sy, ex, ey, ax, ay);
+			const Orientation2 o4 = EstimateOrientation2(sx, sy, ex, ey, bx, by);
+
+			__m128d s1 = Sign2(o1.det);
+			__m128d s2 = Sign2(o2.det);
+			__m128d s3 = Sign2(o3.det);
+			__m128d s4 = Sign2(o4.det);
+
+			const int uncertain = _mm_movemask_pd(_mm_or_pd(_mm_or_pd(o1.uncertain, o2.uncertain), _mm_or_pd(o3.uncertain, o4.uncertain)));
+
+			// Rare: touching, collinear or nearly parallel. Those lanes get exact signs.
+			if (uncertain != 0)
+			{
+				alignas(16) double signs[4][2];
+				_mm_store_pd(signs[0], s1);
+				_mm_store_pd(signs[1], s2);
+				_mm_store_pd(signs[2], s3);
+				_mm_store_pd(signs[3], s4);
+
+				for (int lane = 0; lane < 2; ++lane)
+				{
+					if ((uncertain & (1 << lane)) != 0 && i + lane < segments.GetCount())
+					{
+						int lane_signs[4];
+						double d1;
+						double d2;
+						GetSigns(segments, i + lane, ray, lane_signs, d1, d2);
+
+						for (int k = 0; k < 4; ++k)
+						{
+							signs[k][lane] = lane_signs[k];
+						}
+					}
+				}
+
+				s1 = _mm_load_pd(signs[0]);
+				s2 = _mm_load_pd(signs[1]);
+				s3 = _mm_load_pd(signs[2]);
+				s4 = _mm_load_pd(signs[3]);
+			}
+
+			const __m128d hit = _mm_and_pd(_mm_and_pd(_mm_cmpneq_pd(s1, zero), _mm_cmpneq_pd(s2, s1)), _mm_cmple_pd(_mm_mul_pd(s3, s4), zero));
+
+			const __m128d abs_d1 = _mm_andnot_pd(sign_bit, o1.det);
+			const __m128d sum = _mm_add_pd(abs_d1, _mm_andnot_pd(sign_bit, o2.det));
+			const __m128d t = _mm_and_pd(_mm_div_pd(abs_d1, sum), _mm_cmpgt_pd(sum, zero));
+
+			const __m128d better = _mm_and_pd(hit, _mm_cmplt_pd(t, best_t));
+			best_t = _mm_or_pd(_mm_and_pd(better, t), _mm_andnot_pd(better, best_t));
+			best_index = _mm_or_pd(_mm_and_pd(better, index), _mm_andnot_pd(better, best_index));
+			index = _mm_add_pd(index, index_step);
+		}
+
+		alignas(16) double lane_t[2];
+		alignas(16) double lane_index[2];
+		_mm_store_pd(lane_t, best_t);
+		_mm_store_pd(lane_index, best_index);
+
+		return ReduceLanes(lane_t, lane_index, 2, ray);
+#else
+		return FindNearestHitScalar(segments, start_x, start_y, end_x, end_y);
+#endif
+	}
+
+#if PONG_SEGMENT_KERNEL_X86
+	PONG_TARGET_AVX SegmentHit FindNearestHitAvx(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y)
+	{
+		const Ray ray = { start_x, start_y, end_x, end_y };
+
+		const __m256d sx = _mm256_set1_pd(ray.start_x);
+		const __m256d sy = _mm256_set1_pd(ray.start_y);
+		const __m256d ex = _mm256_set1_pd(ray.end_x);
+		const __m256d ey = _mm256_set1_pd(ray.end_y);
+		const __m256d zero = _mm256_setzero_pd();
+		const __m256d sign_bit = _mm256_set1_pd(-0.0);
+
+		__m256d best_t = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+		__m256d best_index = _mm256_set1_pd(-1.0);
+		__m256d index = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+		const __m256d index_step = _mm256_set1_pd(4.0);
+
+		for (std::size_t i = 0; i < segments.GetPaddedCount(); i += 4)
+		{
+			const __m256d ax = _mm256_cvtps_pd(_mm_loadu_ps(segments.GetAx() + i));
+			const __m256d ay = _mm256_cvtps_pd(_mm_loadu_ps(segments.GetAy() + i));
+			const __m256d bx = _mm256_cvtps_pd(_mm_loadu_ps(segments.GetBx() + i));
+			const __m256d by = _mm256_cvtps_pd(_mm_loadu_ps(segments.GetBy() + i));
+
+			const Orientation4 o1 = EstimateOrientation4(ax, ay, bx, by, sx, sy);
+			const Orientation4 o2 = EstimateOrientation4(ax, ay, bx, by, ex, ey);
+			const Orientation4 o3 = EstimateOrientation4(sx, sy, ex, ey, ax, ay);
+			const Orientation4 o4 = EstimateOrientation4(sx, sy, ex, ey, bx, by);
+
+			__m256d s1 = Sign4(o1.det);
+			__m256d s2 = Sign4(o2.det);
+			__m256d s3 = Sign4(o3.det);
+			__m256d s4 = Sign4(o4.det);
+
+			const int uncertain = _mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd(o1.uncertain, o2.uncertain), _mm256_or_pd(o3.uncertain, o4.uncertain)));
+
+			if (uncertain != 0)
+			{
+				alignas(32) double signs[4][4];
+				_mm256_store_pd(signs[0], s1);
+				_mm256_store_pd(signs[1], s2);
+				_mm256_store_pd(signs[2], s3);
+				_mm256_store_pd(signs[3], s4);
+
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					if ((uncertain & (1 << lane)) != 0 && i + lane < segments.GetCount())
+					{
+						int lane_signs[4];
+						double d1;
+						double d2;
+						GetSigns(segments, i + lane, ray, lane_signs, d1, d2);
+
+						for (int k = 0; k < 4; ++k)
+						{
+							signs[k][lane] = lane_signs[k];
+						}
+					}
+				}
+
+				s1 = _mm256_load_pd(signs[0]);
+				s2 = _mm256_load_pd(signs[1]);
+				s3 = _mm256_load_pd(signs[2]);
+				s4 = _mm256_load_pd(signs[3]);
+			}
+
+			const __m256d hit = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(s1, zero, _CMP_NEQ_OQ), _mm256_cmp_pd(s2, s1, _CMP_NEQ_OQ)),
+				_mm256_cmp_pd(_mm256_mul_pd(s3, s4), zero, _CMP_LE_OQ));
+
+			const __m256d abs_d1 = _mm256_andnot_pd(sign_bit, o1.det);
+			const __m256d sum = _mm256_add_pd(abs_d1, _mm256_andnot_pd(sign_bit, o2.det));
+			const __m256d t = _mm256_and_pd(_mm256_div_pd(abs_d1, sum), _mm256_cmp_pd(sum, zero, _CMP_GT_OQ));
+
+			const __m256d better = _mm256_and_pd(hit, _mm256_cmp_pd(t, best_t, _CMP_LT_OQ));
+			best_t = _mm256_blendv_pd(best_t, t, better);
+			best_index = _mm256_blendv_pd(best_index, index, better);
+			index = _mm256_add_pd(index, index_step);
+		}
+
+		alignas(32) double lane_t[4];
+		alignas(32) double lane_index[4];
+		_mm256_store_pd(lane_t, best_t);
+		_mm256_store_pd(lane_index, best_index);
+
+		return ReduceLanes(lane_t, lane_index, 4, ray);
+	}
+
+	bool HasAvx()
+	{
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx");
+	}
+#else
+	SegmentHit FindNearestHitAvx(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y)
+	{
+		return FindNearestHitScalar(segments, start_x, start_y, end_x, end_y);
+	}
+
+	bool HasAvx()
+	{
+		return false;
+	}
+#endif
+
+	SegmentHit FindNearestHit(const SegmentBatch& segments, float start_x, float start_y, float end_x, float end_y)
+	{
+		static const auto kernel = HasAvx() ? FindNearestHitAvx : FindNearestHitSse2;
+		return kernel(segments, start_x, start_y, end_x, end_y);
+	}
+}
@@ -0,0 +1,559 @@
+#include "Simulation.hpp"
+#include "Constants.hpp"
+#include "Utility.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+
+namespace
+{
+	std::uint64_t MixHash(std::uint64_t hash, std::uint64_t value)
+	{
+		hash = (hash ^ value) * 0x9E3779B97F4A7C15ULL;
+		return hash ^ (hash >> 29);
+	}
+
+	// Floats go two to a word; fixed-point values fill one each.
+	std::uint64_t MixScalars(std::uint64_t hash, Scalar a, Scalar b)
+	{
+#if PONG_FIXED_POINT
+		return MixHash(MixHash(hash, static_cast<std::uint64_t>(a.raw_)), static_cast<std::uint64_t>(b.raw_));
+#else
+		std::uint32_t bits[2];
+		std::memcpy(&bits[0], &a, sizeof(bits[0]));
+		std::memcpy(&bits[1], &b, sizeof(bits[1]));
+		return MixHash(hash, bits[0] | (static_cast<std::uint64_t>(bits[1]) << 32));
+#endif
+	}
+
+	std::uint64_t MixInts(std::uint64_t hash, int a, int b)
+	{
+		return MixHash(hash, static_cast<std::uint32_t>(a) | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(b)) << 32));
+	}
+
+	void AddTrajectoryPoint(Trajectory* trajectory, const Vec2& point)
+	{
+		if (trajectory != nullptr && trajectory->count_ < Trajectory::max_points)
+		{
+			trajectory->points_[trajectory->count_++] = point;
+		}
+	}
+}
+
+Simulation::Simulation() :
+	game_mode_(GameMode::SINGLE_PLAYER),
+	game_difficulty_(GameDifficulty::MEDIUM),
+	player1_score_(0),
+	player2_score_(0),
+	ball_resetting_(false),
+	ball_reset_ticks_(0),
+	has_ball_edge_crossing_(false),
+	ai_controller_(nullptr),
+	arena_(&Arena::GetEmpty()),
+	tick_rate_(reference_tick_rate),
+	physics_substeps_(1),
+	time_step_(Scalar(1)),
+	tick_count_(0),
+	event_count_(0),
+	trace_trajectory_(false),
+	trajectory_version_(0)
+{
+	intersection_point_.x = Scalar(0);
+	intersection_point_.y = Scalar(0);
+	ball_edge_crossing_ = intersection_point_;
+	trajectory_.count_ = 0;
+}
+
+void Simulation::Reset(GameMode game_mode, GameDifficulty game_difficulty, std::uint64_t seed)
+{
+	game_mode_ = game_mode;
+	game_difficulty_ = game_difficulty;
+	ai_controller_ = GetBuiltinAiController(game_difficulty);
+	random_.Seed(seed);
+
+	constexpr int ball_side_size = 14;
+
+	ball_.simulation_ = this;
+
+	ball_.rect_.x = Scalar((constants::screen_width / 2) - (ball_side_size / 2));
+	ball_.rect_.y = Scalar((constants::screen_height / 2) - (ball_side_size / 2));
+	ball_.rect_.w = Scalar(ball_side_size);
+	ball_.rect_.h = ball_.rect_.w;
+
+	ball_.vx_ = Scalar(tuning_.initial_speed);
+	ball_.vy_ = Scalar(0);
+	ball_.UpdateDirectionRay();
+
+	player1_score_ = 0;
+	player2_score_ = 0;
+
+	player1_paddle_.rect_.x = Scalar(constants::screen_width - tuning_.paddle_width - tuning_.paddle_x_offset);
+	player1_paddle_.rect_.y = Scalar((constants::screen_height / 2) - (tuning_.paddle_height / 2));
+	player1_paddle_.rect_.w = Scalar(tuning_.paddle_width);
+	player1_paddle_.rect_.h = Scalar(tuning_.paddle_height);
+	player1_paddle_.vy_ = Scalar(0);
+
+	player2_paddle_.rect_.x = Scalar(tuning_.paddle_x_offset);
+	player2_paddle_.rect_.y = Scalar((constants::screen_height / 2) - (tuning_.paddle_height / 2));
+	player2_paddle_.rect_.w = Scalar(tuning_.paddle_width);
+	player2_paddle_.rect_.h = Scalar(tuning_.paddle_height);
+	player2_paddle_.vy_ = Scalar(0);
+
+	ball_resetting_ = false;
+	ball_reset_ticks_ = ScaleTicks(60);
+	tick_count_ = 0;
+	event_count_ = 0;
+
+	GetEdgeIntersectionPoint(BallDirectionChange::SERVE);
+}
+
+void Simulation::Tick()
+{
+	TRACE_ZONE("Simulation::Tick");
+
+	event_count_ = 0;
+	++tick_count_;
+
+	if (game_mode_ == GameMode::SINGLE_PLAYER)
+	{
+		if (ball_reset_ticks_ == 0)
+		{
+			ball_reset_ticks_ = ScaleTicks(30);
+			ball_resetting_ = false;
+			ball_.Reset();
+		}
+
+		if (ball_resetting_)
+		{
+			--ball_reset_ticks_;
+			player1_paddle_.Tick(time_step_);
+			player2_paddle_.Tick(time_step_);
+			return;
+		}
+
+		ball_.Tick();
+
+		if (ball_.rect_.x + ball_.rect_.w < Scalar(0))
+		{
+			++player1_score_;
+			ball_resetting_ = true;
+			PushEvent(SimulationEventType::GOAL, 0, 1);
+		}
+		else if (ball_.rect_.x > Scalar(constants::screen_width))
+		{
+			++player2_score_;
+			ball_resetting_ = true;
+			PushEvent(SimulationEventType::GOAL, 0, 2);
+		}
+
+		AiView view;
+		GetAiView(view);
+
+		const AiCommand command = ai_controller_->Tick(view);
+		player2_paddle_.vy_ = command.paddle_vy_;
+		intersection_point_ = command.target_;
+	}
+
+	player1_paddle_.Tick(time_step_);
+	player2_paddle_.Tick(time_step_);
+}
+
+void Simulation::SetTickRate(int tick_rate, int physics_substeps)
+{
+	tick_rate_ = std::max(tick_rate, 1);
+	physics_substeps_ = std::max(physics_substeps, 1);
+	time_step_ = Scalar(reference_tick_rate) / Scalar(tick_rate_);
+}
+
+void Simulation::SetArena(const Arena* arena)
+{
+	arena_ = arena != nullptr ? arena : &Arena::GetEmpty();
+}
+
+int Simulation::ScaleTicks(int reference_ticks) const
+{
+	return static_cast<int>((static_cast<std::int64_t>(reference_ticks) * tick_rate_ + reference_tick_rate / 2) / reference_tick_rate);
+}
+
+void Simulation::ApplyTuning(const Tuning& tuning)
+{
+	tuning_ = tuning;
+
+	for (Paddle* paddle : { &player1_paddle_, &player2_paddle_ })
+	{
+		const Scalar mid_point_y = paddle->rect_.y + (paddle->rect_.h / Scalar(2));
+
+		paddle->rect_.w = Scalar(tuning_.paddle_width);
+		paddle->rect_.h = Scalar(tuning_.paddle_height);
+		paddle->rect_.y = std::clamp(mid_point_y - (paddle->rect_.h / Scalar(2)), Scalar(0), Scalar(constants::screen_height) - paddle->rect_.h);
+	}
+
+	player1_paddle_.rect_.x = Scalar(constants::screen_width - tuning_.paddle_width - tuning_.paddle_x_offset);
+	player2_paddle_.rect_.x = Scalar(tuning_.paddle_x_offset);
+}
+
+void Simulation::PushEvent(SimulationEventType type, int angle, int player, float position)
+{
+	if (event_count_ >= events_.size())
+	{
+		return;
+	}
+
+	const float vx = static_cast<float>(ball_.vx_);
+	const float vy = static_cast<float>(ball_.vy_);
+
+	// Player 2's side is the left one; that is where the AI's aim is put to the test.
+	const bool ai_side = game_mode_ == GameMode::SINGLE_PLAYER && ((type == SimulationEventType::PADDLE_HIT && player == 2) || (type == SimulationEventType::GOAL && player == 1));
+	const float ai_error = ai_side ? static_cast<float>(ball_.rect_.y + (ball_.rect_.h / Scalar(2)) - intersection_point_.y) : std::numeric_limits<float>::quiet_NaN();
+
+	events_[event_count_++] = { type, angle, player, position, std::sqrt((vx * vx) + (vy * vy)), ai_error };
+}
+
+void Simulation::TakeSnapshot(SimulationSnapshot& snapshot) const
+{
+	snapshot.tick_count_ = tick_count_;
+	snapshot.ball_rect_ = ball_.rect_;
+	snapshot.player1_paddle_rect_ = player1_paddle_.rect_;
+	snapshot.player2_paddle_rect_ = player2_paddle_.rect_;
+	snapshot.player1_score_ = player1_score_;
+	snapshot.player2_score_ = player2_score_;
+	snapshot.ball_direction_ray_ = ball_.direction_ray_;
+	snapshot.intersection_point_ = intersection_point_;
+	snapshot.trajectory_version_ = trajectory_version_;
+	snapshot.trajectory_.count_ = trajectory_.count_;
+	std::copy_n(trajectory_.points_.begin(), trajectory_.count_, snapshot.trajectory_.points_.begin());
+}
+
+std::uint64_t Simulation::GetStateHash() const
+{
+	std::uint64_t hash = MixHash(0x243F6A8885A308D3ULL, tick_count_);
+	hash = MixScalars(hash, ball_.rect_.x, ball_.rect_.y);
+	hash = MixScalars(hash, ball_.rect_.w, ball_.rect_.h);
+	hash = MixScalars(hash, ball_.vx_, ball_.vy_);
+
+	for (const Paddle* paddle : { &player1_paddle_, &player2_paddle_ })
+	{
+		hash = MixScalars(hash, paddle->rect_.x, paddle->rect_.y);
+		hash = MixScalars(hash, paddle->rect_.w, paddle->rect_.h);
+	}
+
+	hash = MixScalars(hash, player1_paddle_.vy_, player2_paddle_.vy_);
+	hash = MixScalars(hash, intersection_point_.x, intersection_point_.y);
+	hash = MixInts(hash, player1_score_, player2_score_);
+	hash = MixInts(hash, ball_reset_ticks_, ball_resetting_ ? 1 : 0);
+	hash = MixHash(hash, random_.state_);
+
+	return MixHash(hash, random_.increment_);
+}
+
+void Simulation::SaveState(SimulationState& state) const
+{
+	// Padding is cleared too, so identical states are identical bytes on disk.
+	std::memset(static_cast<void*>(&state), 0, sizeof(state));
+
+	state.tick_count_ = tick_count_;
+	state.ball_rect_ = ball_.rect_;
+	state.ball_direction_ray_ = ball_.direction_ray_;
+	state.ball_vx_ = ball_.vx_;
+	state.ball_vy_ = ball_.vy_;
+	state.player1_paddle_rect_ = player1_paddle_.rect_;
+	state.player1_paddle_vy_ = player1_paddle_.vy_;
+	state.player2_paddle_rect_ = player2_paddle_.rect_;
+	state.player2_paddle_vy_ = player2_paddle_.vy_;
+	state.player1_score_ = player1_score_;
+	state.player2_score_ = player2_score_;
+	state.ball_resetting_ = ball_resetting_ ? 1 : 0;
+	state.ball_reset_ticks_ = ball_reset_ticks_;
+	state.intersection_point_ = intersection_point_;
+	state.ball_edge_crossing_ = ball_edge_crossing_;
+	state.has_ball_edge_crossing_ = has_ball_edge_crossing_ ? 1 : 0;
+	state.random_state_ = random_.state_;
+	state.random_increment_ = random_.increment_;
+	state.tuning_ = tuning_;
+}
+
+void Simulation::LoadState(const SimulationState& state)
+{
+	tick_count_ = state.tick_count_;
+	ball_.rect_ = state.ball_rect_;
+	ball_.direction_ray_ = state.ball_direction_ray_;
+	ball_.vx_ = state.ball_vx_;
+	ball_.vy_ = state.ball_vy_;
+	player1_paddle_.rect_ = state.player1_paddle_rect_;
+	player1_paddle_.vy_ = state.player1_paddle_vy_;
+	player2_paddle_.rect_ = state.player2_paddle_rect_;
+	player2_paddle_.vy_ = state.player2_paddle_vy_;
+	player1_score_ = state.player1_score_;
+	player2_score_ = state.player2_score_;
+	ball_resetting_ = state.ball_resetting_ != 0;
+	ball_reset_ticks_ = state.ball_reset_ticks_;
+	intersection_point_ = state.intersection_point_;
+	ball_edge_crossing_ = state.ball_edge_crossing_;
+	has_ball_edge_crossing_ = state.has_ball_edge_crossing_ != 0;
+	random_.state_ = state.random_state_;
+	random_.increment_ = state.random_increment_;
+	tuning_ = state.tuning_;
+	event_count_ = 0;
+
+	if (trace_trajectory_)
+	{
+		UpdateTrajectory();
+	}
+}
+
+void Simulation::SetTrajectoryTracing(bool enabled)
+{
+	trace_trajectory_ = enabled;
+
+	if (enabled)
+	{
+		UpdateTrajectory();
+	}
+	else
+	{
+		trajectory_.count_ = 0;
+		++trajectory_version_;
+	}
+}
+
+void Simulation::UpdateTrajectory()
+{
+	TRACE_ZONE("Simulation::UpdateTrajectory");
+
+	trajectory_.count_ = 0;
+
+	// A ball already past the field's edge has no path left to draw.
+	if (!PredictGoalCrossing(*arena_, ball_.direction_ray_, intersection_point_, &trajectory_).has_value())
+	{
+		trajectory_.count_ = 0;
+	}
+
+	++trajectory_version_;
+}
+
+void Simulation::GetAiView(AiView& view) const
+{
+	view.tick_ = tick_count_;
+	view.ball_rect_ = ball_.rect_;
+	view.ball_vx_ = ball_.vx_;
+	view.ball_vy_ = ball_.vy_;
+	view.ball_direction_ray_ = ball_.direction_ray_;
+	view.has_ball_edge_crossing_ = has_ball_edge_crossing_;
+	view.ball_edge_crossing_ = ball_edge_crossing_;
+	view.paddle_rect_ = player2_paddle_.rect_;
+	view.opponent_paddle_rect_ = player1_paddle_.rect_;
+	view.score_ = player2_score_;
+	view.opponent_score_ = player1_score_;
+	view.serving_ = ball_resetting_;
+	view.max_speed_ = Scalar(tuning_.ai_speeds[static_cast<std::size_t>(game_difficulty_)]);
+	view.target_ = intersection_point_;
+	view.arena_ = arena_;
+}
+
+const std::optional<Vec2> Simulation::GetLinesIntersectionPoint(const Line& line_1, const Line& line_2)
+{
+	const auto line_1_coefficients = GetLinearEquationCoefficients(line_1.start_point.x, line_1.start_point.y, line_1.end_point.x, line_1.end_point.y);
+    const auto line_2_coefficients = GetLinearEquationCoefficients(line_2.start_point.x, line_2.start_point.y, line_2.end_point.x, line_2.end_point.y);
+
+    const Scalar& A1 = std::get<0>(line_1_coefficients);
+    const Scalar& B1 = std::get<1>(line_1_coefficients);
+    const Scalar& C1 = std::get<2>(line_1_coefficients);
+
+    const Scalar& A2 = std::get<0>(line_2_coefficients);
+    const Scalar& B2 = std::get<1>(line_2_coefficients);
+    const Scalar& C2 = std::get<2>(line_2_coefficients);
+
+    const Scalar det = A1 * B2 - A2 * B1;
+
+    if (det != Scalar(0))
+    {
+        const Scalar x = (B2 * C1 - B1 * C2) / det;
+        const Scalar y = (A1 * C2 - A2 * C1) / det;
+		const Vec2 intersection_point = { x, y };
+
+        if (IsPointOnLine(intersection_point, line_1) && IsPointOnLine(intersection_point, line_2))
+        {
+			return intersection_point;
+        }
+    }
+
+	return std::nullopt;
+}
+
+void Simulation::GetEdgeIntersectionPoint(BallDirectionChange change)
+{
+	TRACE_ZONE("Simulation::GetEdgeIntersectionPoint");
+
+	const std::optional<PathCrossing> cross_point_opt = GetPathCrossPoint(*arena_, ball_.direction_ray_, intersection_point_);
+
+	// A wall bounce on the tick the ball crosses a goal line starts the ray outside the field; keep the last crossing.
+	has_ball_edge_crossing_ = cross_point_opt.has_value();
+
+	if (has_ball_edge_crossing_)
+	{
+		ball_edge_crossing_ = cross_point_opt->point_;
+	}
+
+	if (trace_trajectory_)
+	{
+		UpdateTrajectory();
+	}
+
+	AiView view;
+	GetAiView(view);
+	intersection_point_ = ai_controller_->Aim(view, change);
+}
+
+const std::optional<Vec2> Simulation::GetEdgeCrossPoint(const Line& ray, const Vec2 reference_point)
+{
+	std::optional<Vec2> farthest_cross;
+	Scalar farthest_distance = Scalar(0);
+
+	// Same pick as std::min_element with a "farther than" comparison, without collecting the crosses first.
+	for (std::size_t i = 0; i < edges.size(); ++i)
+	{
+		const std::optional<Vec2> cross_point_opt = GetLinesIntersectionPoint(edges[i], ray);
+
+		if (!cross_point_opt.has_value())
+		{
+			continue;
+		}
+
+		const Scalar distance = PointsDistanceSquared(cross_point_opt->x, cross_point_opt->y, reference_point.x, reference_point.y);
+
+		if (!farthest_cross.has_value() || distance > farthest_distance)
+		{
+			farthest_cross = cross_point_opt;
+			farthest_distance = distance;
+		}
+	}
+
+	return farthest_cross;
+}
+
+const std::optional<PathCrossing> Simulation::GetPathCrossPoint(const Arena& arena, const Line& ray, const Vec2 reference_point, Trajectory* trajectory)
+{
+	PathCrossing crossing;
+	crossing.leg_ = ray;
+	crossing.bounces_ = 0;
+
+	std::optional<Vec2> edge_cross_opt = GetEdgeCrossPoint(ray, reference_point);
+	std::int32_t last_obstacle = -1;
+	ArenaHit hit;
+
+	while (crossing.bounces_ < max_path_bounces && arena.CastRay(crossing.leg_, last_obstacle, hit))
+	{
+		const Vec2 start = crossing.leg_.start_point;
+
+		// An obstacle past the field's edge is never reached.
+		if (edge_cross_opt.has_value() &&
+			PointsDistanceSquared(edge_cross_opt->x, edge_cross_opt->y, start.x, start.y) < PointsDistanceSquared(hit.point_.x, hit.point_.y, start.x, start.y))
+		{
+			break;
+		}
+
+		const Vec2 direction = Reflect({ crossing.leg_.end_point.x - start.x, crossing.leg_.end_point.y - start.y }, hit.normal_);
+
+		crossing.leg_.start_point = hit.point_;
+		crossing.leg_.end_point = { hit.point_.x + direction.x, hit.point_.y + direction.y };
+		++crossing.bounces_;
+
+		AddTrajectoryPoint(trajectory, hit.point_);
+
+		last_obstacle = hit.obstacle_;
+		edge_cross_opt = GetEdgeCrossPoint(crossing.leg_, hit.point_);
+	}
+
+	if (!edge_cross_opt.has_value())
+	{
+		return std::nullopt;
+	}
+
+	crossing.point_ = edge_cross_opt.value();
+	return crossing;
+}
+
+const std::optional<Vec2> Simulation::PredictGoalCrossing(const Arena& arena, const Line& ray, const Vec2 reference_point, Trajectory* trajectory)
+{
+	AddTrajectoryPoint(trajectory, ray.start_point);
+
+	// The same path the simulation found the edge crossing on; past obstacles it continues from their last bounce.
+	const std::optional<PathCrossing> path_opt = GetPathCrossPoint(arena, ray, reference_point, trajectory);
+
+	if (!path_opt.has_value())
+	{
+		return std::nullopt;
+	}
+
+	const Vec2 edge_crossing = path_opt->point_;
+	const Scalar epsilon = Scalar(0.01f);
+	const Scalar ray_length = Scalar(constants::screen_width + constants::screen_height);
+	Vec2 intersect_copy = edge_crossing;
+	Line reflected_line = path_opt->leg_;
+	Vec2 reflected_vector = { edge_crossing.x - reflected_line.start_point.x, edge_crossing.y - reflected_line.start_point.y };
+
+	AddTrajectoryPoint(trajectory, edge_crossing);
+
+	// Obstacles can trap a path between them; past max_path_bounces bounces of either kind the prediction settles for
+	// where it got.
+	int obstacle_bounces = path_opt->bounces_;
+
+	for (int bounce = 0; bounce < max_path_bounces && obstacle_bounces < max_path_bounces &&
+		!FloatingPointSame(intersect_copy.x, Scalar(0), epsilon) && !FloatingPointSame(intersect_copy.x, Scalar(constants::screen_width), epsilon); ++bounce)
+	{
+		reflected_line.start_point = intersect_copy;
+		reflected_line.end_point = intersect_copy;
+
+		reflected_vector.y = -reflected_vector.y;
+
+		reflected_line.end_point.x = reflected_line.end_point.x + ((constants::screen_width + constants::screen_height) * reflected_vector.x);
+		reflected_line.end_point.y = reflected_line.end_point.y + ((constants::screen_width + constants::screen_height) * reflected_vector.y);
+
+		const std::optional<PathCrossing> reflected_cross_opt = GetPathCrossPoint(arena, reflected_line, edge_crossing, trajectory);
+
+		if (!reflected_cross_opt.has_value())
+		{
+			break;
+		}
+
+		intersect_copy = reflected_cross_opt->point_;
+		obstacle_bounces += reflected_cross_opt->bounces_;
+
+		AddTrajectoryPoint(trajectory, intersect_copy);
+
+		// Obstacles turned the path; go on in the direction it left the last one.
+		if (reflected_cross_opt->bounces_ > 0)
+		{
+			const Line& leg = reflected_cross_opt->leg_;
+			reflected_vector = { (leg.end_point.x - leg.start_point.x) / ray_length, (leg.end_point.y - leg.start_point.y) / ray_length };
+		}
+	}
+
+	return intersect_copy;
+}
+
+Vec2 Simulation::Reflect(const Vec2& velocity, const Vec2& normal)
+{
+	const Scalar length_squared = normal.x * normal.x + normal.y * normal.y;
+	const Scalar scale = Scalar(2) * (velocity.x * normal.x + velocity.y * normal.y) / length_squared;
+
+	return { velocity.x - normal.x * scale, velocity.y - normal.y * scale };
+}
+
+bool Simulation::IsPointOnLine(const Vec2 point, const Line& line)
+{
+	const Scalar epsilon = Scalar(0.01f);
+
+	const bool x_on_line = (FloatingPointLessThan(std::min(line.start_point.x, line.end_point.x), point.x, epsilon) || FloatingPointSame(std::min(line.start_point.x, line.end_point.x), point.x, epsilon)) &&
+							(FloatingPointLessThan(point.x, std::max(line.start_point.x, line.end_point.x), epsilon) || FloatingPointSame(point.x, std::max(line.start_point.x, line.end_point.x), epsilon));
+
+	const bool y_on_line = (FloatingPointLessThan(std::min(line.start_point.y, line.end_point.y), point.y, epsilon) || FloatingPointSame(std::min(line.start_point.y, line.end_point.y), point.y, epsilon)) &&
+							(FloatingPointLessThan(point.y, std::max(line.start_point.y, line.end_point.y), epsilon) || FloatingPointSame(point.y, std::max(line.start_point.y, line.end_point.y), epsilon));
+
+	return x_on_line && y_on_line;
+}
@@ -0,0 +1,602 @@
+#include "SpectatorServer.hpp"
+#include "Trace.hpp"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Keeps what a slow subscriber can have queued to a few seconds of states, so what it reads is never far behind.
+	constexpr int client_send_buffer = 4096;
+
+	std::int32_t QuantizePosition(Scalar value)
+	{
+		return static_cast<std::int32_t>(std::lround(static_cast<float>(value) * spectator::position_scale));
+	}
+
+	std::size_t WriteVarint(std::uint64_t value, std::uint8_t* out)
+	{
+		std::size_t length = 0;
+
+		do
+		{
+			const std::uint8_t byte = static_cast<std::uint8_t>(value & 0x7F);
+			value >>= 7;
+			out[length++] = value != 0 ? static_cast<std::uint8_t>(byte | 0x80) : byte;
+		} while (value != 0);
+
+		return length;
+	}
+
+	bool ReadVarint(const std::uint8_t* data, std::size_t size, std::size_t& cursor, std::uint64_t& value)
+	{
+		value = 0;
+
+		for (int shift = 0; shift < 64 && cursor < size; shift += 7)
+		{
+			const std::uint8_t byte = data[cursor++];
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	std::uint64_t ZigZag(std::int64_t value)
+	{
+		return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+	}
+
+	std::int64_t UnZigZag(std::uint64_t value)
+	{
+		return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+	}
+}
+
+SpectatorState spectator::Quantize(const SimulationSnapshot& snapshot)
+{
+	SpectatorState state;
+
+	state.tick = static_cast<std::uint32_t>(snapshot.tick_count_);
+	state.fields[0] = QuantizePosition(snapshot.ball_rect_.x);
+	state.fields[1] = QuantizePosition(snapshot.ball_rect_.y);
+	state.fields[2] = QuantizePosition(snapshot.player1_paddle_rect_.y);
+	state.fields[3] = QuantizePosition(snapshot.player2_paddle_rect_.y);
+	state.fields[4] = snapshot.player1_score_;
+	state.fields[5] = snapshot.player2_score_;
+
+	return state;
+}
+
+std::size_t spectator::EncodeMessage(const SpectatorState& state, const SpectatorState* previous, std::uint8_t* message)
+{
+	std::uint8_t* payload = message + 1;
+	std::size_t length = 1;
+	std::uint8_t mask = 0;
+
+	if (previous == nullptr)
+	{
+		mask = static_cast<std::uint8_t>(full_state_bit | ((1 << SpectatorState::field_count) - 1));
+		length += WriteVarint(state.tick, payload + length);
+
+		for (int i = 0; i < SpectatorState::field_count; ++i)
+		{
+			length += WriteVarint(ZigZag(state.fields[i]), payload + length);
+		}
+	}
+	else
+	{
+		length += WriteVarint(state.tick - previous->tick, payload + length);
+
+		for (int i = 0; i < SpectatorState::field_count; ++i)
+		{
+			if (state.fields[i] != previous->fields[i])
+			{
+				mask = static_cast<std::uint8_t>(mask | (1 << i));
+				length += WriteVarint(ZigZag(static_cast<std::int64_t>(state.fields[i]) - previous->fields[i]), payload + length);
+			}
+		}
+	}
+
+	payload[0] = mask;
+	message[0] = static_cast<std::uint8_t>(length);
+
+	return length + 1;
+}
+
+bool spectator::DecodeMessage(const std::uint8_t* payload, std::size_t size, SpectatorState& state)
+{
+	if (size == 0)
+	{
+		return false;
+	}
+
+	const std::uint8_t mask = payload[0];
+	const bool full_state = (mask & full_state_bit) != 0;
+	std::size_t cursor = 1;
+	std::uint64_t value;
+
+	if (!ReadVarint(payload, size, cursor, value))
+	{
+		return false;
+	}
+
+	state.tick = full_state ? static_cast<std::uint32_t>(value) : static_cast<std::uint32_t>(state.tick + value);
+
+	for (int i = 0; i < SpectatorState::field_count; ++i)
+	{
+		if ((mask & (1 << i)) == 0)
+		{
+			continue;
+		}
+
+		if (!ReadVarint(payload, size, cursor, value))
+		{
+			return false;
+		}
+
+		const std::int64_t field = UnZigZag(value);
+		state.fields[i] = full_state ? static_cast<std::int32_t>(field) : static_cast<std::int32_t>(state.fields[i] + field);
+	}
+
+	return cursor == size;
+}
+
+SpectatorServer::SpectatorServer() :
+	listen_fd_(-1),
+	epoll_fd_(-1),
+	event_fd_(-1),
+	running_(false),
+	client_count_(0),
+	latest_(),
+	has_latest_(false),
+	accepted_clients_(0),
+	messages_sent_(0),
+	bytes_sent_(0),
+	dropped_states_(0)
+{
+}
+
+SpectatorServer::~SpectatorServer()
+{
+	Close();
+}
+
+bool SpectatorServer::Open(const std::string& address)
+{
+	Close();
+
+#ifdef __linux__
+	address_ = address;
+
+	if (!Listen())
+	{
+		fprintf(stderr, "Unable to listen for spectators on %s!\n", address.c_str());
+		Close();
+		return false;
+	}
+
+	epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (epoll_fd_ < 0 || event_fd_ < 0)
+	{
+		fprintf(stderr, "%s\n", "Unable to create the spectator server's epoll instance!");
+		Close();
+		return false;
+	}
+
+	epoll_event listen_event = {};
+	listen_event.events = EPOLLIN;
+	listen_event.data.u64 = max_clients;
+	epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &listen_event);
+
+	epoll_event wakeup_event = {};
+	wakeup_event.events = EPOLLIN;
+	wakeup_event.data.u64 = max_clients + 1;
+	epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &wakeup_event);
+
+	clients_.assign(max_clients, Client());
+	free_slots_.clear();
+
+	for (std::size_t slot = max_clients; slot > 0; --slot)
+	{
+		clients_[slot - 1].fd = -1;
+		free_slots_.push_back(slot - 1);
+	}
+
+	has_latest_ = false;
+	accepted_clients_ = 0;
+	messages_sent_ = 0;
+	bytes_sent_ = 0;
+	dropped_states_ = 0;
+
+	running_ = true;
+	server_thread_ = std::thread(&SpectatorServer::ServerLoop, this);
+
+	fprintf(stderr, "Spectator server listening on %s\n", address.c_str());
+
+	return true;
+#else
+	fprintf(stderr, "%s\n", "The spectator server needs epoll and is only available on Linux.");
+	(void)address;
+	return false;
+#endif
+}
+
+bool SpectatorServer::Listen()
+{
+#ifdef __linux__
+	if (address_.compare(0, 5, "unix:") == 0)
+	{
+		unix_path_ = address_.substr(5);
+
+		sockaddr_un socket_address = {};
+		socket_address.sun_family = AF_UNIX;
+
+		if (unix_path_.empty() || unix_path_.size() >= sizeof(socket_address.sun_path))
+		{
+			return false;
+		}
+
+		std::memcpy(socket_address.sun_path, unix_path_.c_str(), unix_path_.size() + 1);
+
+		listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+		// A socket file left behind by a previous run would make bind fail.
+		unlink(unix_path_.c_str());
+
+		return listen_fd_ >= 0 && bind(listen_fd_, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) == 0 && listen(listen_fd_, SOMAXCONN) == 0;
+	}
+
+	const std::size_t colon = address_.find_last_of(':');
+	const std::string host = colon == std::string::npos ? "127.0.0.1" : address_.substr(0, colon);
+	const int port = std::atoi(address_.c_str() + (colon == std::string::npos ? 0 : colon + 1));
+
+	sockaddr_in socket_address = {};
+	socket_address.sin_family = AF_INET;
+	socket_address.sin_port = htons(static_cast<std::uint16_t>(port));
+
+	if (port <= 0 || port > 65535 || inet_pton(AF_INET, host.c_str(), &socket_address.sin_addr) != 1)
+	{
+		return false;
+	}
+
+	listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (listen_fd_ < 0)
+	{
+		return false;
+	}
+
+	const int reuse = 1;
+	setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	return bind(listen_fd_, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) == 0 && listen(listen_fd_, SOMAXCONN) == 0;
+#else
+	return false;
+#endif
+}
+
+void SpectatorServer::Close()
+{
+#ifdef __linux__
+	if (running_)
+	{
+		running_ = false;
+
+		const std::uint64_t wakeup = 1;
+		[[maybe_unused]] const ssize_t written = write(event_fd_, &wakeup, sizeof(wakeup));
+
+		server_thread_.join();
+
+		for (std::size_t slot = 0; slot < clients_.size(); ++slot)
+		{
+			if (clients_[slot].fd >= 0)
+			{
+				CloseClient(slot);
+			}
+		}
+
+		PrintReport(stderr);
+	}
+
+	for (int* fd : { &listen_fd_, &epoll_fd_, &event_fd_ })
+	{
+		if (*fd >= 0)
+		{
+			close(*fd);
+			*fd = -1;
+		}
+	}
+
+	if (!unix_path_.empty())
+	{
+		unlink(unix_path_.c_str());
+		unix_path_.clear();
+	}
+#endif
+}
+
+void SpectatorServer::Publish(const SimulationSnapshot& snapshot)
+{
+#ifdef __linux__
+	// Nobody is watching: no copy and no wakeup. A new subscriber gets its first state with the next tick.
+	if (client_count_.load(std::memory_order_relaxed) == 0)
+	{
+		return;
+	}
+
+	snapshots_.GetWriteBuffer() = snapshot;
+	snapshots_.Publish();
+
+	const std::uint64_t wakeup = 1;
+	[[maybe_unused]] const ssize_t written = write(event_fd_, &wakeup, sizeof(wakeup));
+#else
+	(void)snapshot;
+#endif
+}
+
+std::size_t SpectatorServer::GetClientCount() const
+{
+	return client_count_.load(std::memory_order_relaxed);
+}
+
+void SpectatorServer::PrintReport(FILE* file) const
+{
+	fprintf(file, "Spectator server: %llu subscribers served, %llu messages (%llu bytes), %llu states dropped for slow subscribers\n",
+		static_cast<unsigned long long>(accepted_clients_), static_cast<unsigned long long>(messages_sent_), static_cast<unsigned long long>(bytes_sent_),
+		static_cast<unsigned long long>(dropped_states_));
+}
+
+void SpectatorServer::ServerLoop()
+{
+#ifdef __linux__
+	Trace::Instance()->SetThreadName("Spectator server");
+
+	std::array<epoll_event, 64> events;
+
+	while (running_)
+	{
+		const int count = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), 100);
+
+		for (int i = 0; i < count; ++i)
+		{
+			const std::uint64_t token = events[i].data.u64;
+
+			if (token == max_clients)
+			{
+				AcceptClients();
+				continue;
+			}
+
+			if (token == max_clients + 1)
+			{
+				TRACE_ZONE("SpectatorServer::Broadcast");
+
+				std::uint64_t wakeups;
+				[[maybe_unused]] const ssize_t read_size = read(event_fd_, &wakeups, sizeof(wakeups));
+
+				if (!snapshots_.Update())
+				{
+					continue;
+				}
+
+				latest_ = spectator::Quantize(snapshots_.GetReadBuffer());
+				has_latest_ = true;
+
+				for (std::size_t slot = 0; slot < clients_.size(); ++slot)
+				{
+					Client& client = clients_[slot];
+
+					if (client.fd < 0)
+					{
+						continue;
+					}
+
+					// Still flushing an older state: this one is skipped and the client gets whatever is latest once it drains.
+					if (client.pending_begin != client.pending_end)
+					{
+						client.stale = true;
+						++dropped_states_;
+						continue;
+					}
+
+					SendLatest(slot);
+				}
+
+				continue;
+			}
+
+			const std::size_t slot = static_cast<std::size_t>(token);
+
+			if (clients_[slot].fd < 0)
+			{
+				continue;
+			}
+
+			if ((events[i].events & (EPOLLHUP | EPOLLERR)) != 0)
+			{
+				CloseClient(slot);
+				continue;
+			}
+
+			if ((events[i].events & EPOLLIN) != 0)
+			{
+				// Subscribers have nothing to say; anything they send is discarded, and end of stream closes them.
+				std::uint8_t discard[256];
+				const ssize_t received = recv(clients_[slot].fd, discard, sizeof(discard), 0);
+
+				if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+				{
+					CloseClient(slot);
+					continue;
+				}
+			}
+
+			if ((events[i].events & EPOLLOUT) != 0)
+			{
+				FlushClient(slot);
+			}
+		}
+	}
+#endif
+}
+
+void SpectatorServer::AcceptClients()
+{
+#ifdef __linux__
+	while (true)
+	{
+		const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (fd < 0)
+		{
+			return;
+		}
+
+		if (free_slots_.empty())
+		{
+			close(fd);
+			continue;
+		}
+
+		const int no_delay = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+		setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &client_send_buffer, sizeof(client_send_buffer));
+
+		const std::size_t slot = free_slots_.back();
+		free_slots_.pop_back();
+
+		Client& client = clients_[slot];
+		client.fd = fd;
+		client.has_state = false;
+		client.stale = false;
+		client.waiting_for_output = false;
+		client.pending_begin = 0;
+		client.pending_end = 0;
+
+		epoll_event client_event = {};
+		client_event.events = EPOLLIN;
+		client_event.data.u64 = slot;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &client_event);
+
+		++accepted_clients_;
+		client_count_.fetch_add(1, std::memory_order_relaxed);
+	}
+#endif
+}
+
+void SpectatorServer::CloseClient(std::size_t slot)
+{
+#ifdef __linux__
+	Client& client = clients_[slot];
+
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client.fd, nullptr);
+	close(client.fd);
+	client.fd = -1;
+
+	free_slots_.push_back(slot);
+	client_count_.fetch_sub(1, std::memory_order_relaxed);
+#else
+	(void)slot;
+#endif
+}
+
+void SpectatorServer::SendLatest(std::size_t slot)
+{
+#ifdef __linux__
+	Client& client = clients_[slot];
+
+	if (!has_latest_)
+	{
+		return;
+	}
+
+	const std::size_t length = spectator::EncodeMessage(latest_, client.has_state ? &client.last_sent : nullptr, client.pending.data());
+
+	client.last_sent = latest_;
+	client.has_state = true;
+	client.stale = false;
+	client.pending_begin = 0;
+	client.pending_end = length;
+
+	++messages_sent_;
+	bytes_sent_ += length;
+
+	FlushClient(slot);
+#else
+	(void)slot;
+#endif
+}
+
+void SpectatorServer::FlushClient(std::size_t slot)
+{
+#ifdef __linux__
+	Client& client = clients_[slot];
+
+	while (client.pending_begin != client.pending_end)
+	{
+		const ssize_t sent = send(client.fd, client.pending.data() + client.pending_begin, client.pending_end - client.pending_begin, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+		if (sent < 0)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+			{
+				CloseClient(slot);
+				return;
+			}
+
+			// Full socket: wait for EPOLLOUT before sending anything else to this client.
+			if (!client.waiting_for_output)
+			{
+				epoll_event client_event = {};
+				client_event.events = EPOLLIN | EPOLLOUT;
+				client_event.data.u64 = slot;
+				epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &client_event);
+				client.waiting_for_output = true;
+			}
+
+			return;
+		}
+
+		client.pending_begin += static_cast<std::size_t>(sent);
+	}
+
+	client.pending_begin = 0;
+	client.pending_end = 0;
+
+	if (client.waiting_for_output)
+	{
+		epoll_event client_event = {};
+		client_event.events = EPOLLIN;
+		client_event.data.u64 = slot;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &client_event);
+		client.waiting_for_output = false;
+	}
+
+	if (client.stale)
+	{
+		SendLatest(slot);
+	}
+#else
+	(void)slot;
+#endif
+}
@@ -0,0 +1,137 @@
+#include "StateChecksums.hpp"
+#include "Trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	constexpr char checksum_magic[4] = { 'P', 'S', 'U', 'M' };
+	constexpr std::uint32_t checksum_version = 1;
+}
+
+static_assert(sizeof(ChecksumHeader) == 56, "ChecksumHeader must stay tightly packed");
+
+StateChecksums::StateChecksums() :
+	recorded_(0),
+	chain_(0),
+	last_tick_(0)
+{
+	std::memset(&header_, 0, sizeof(header_));
+}
+
+void StateChecksums::Start(const Simulation& simulation, std::uint64_t seed, std::size_t capacity)
+{
+	std::size_t size = 1;
+
+	while (size < capacity)
+	{
+		size <<= 1;
+	}
+
+	entries_.assign(size, ChecksumEntry());
+	states_.resize(size);
+
+	std::memset(&header_, 0, sizeof(header_));
+	std::memcpy(header_.magic, checksum_magic, sizeof(header_.magic));
+	header_.version = checksum_version;
+	header_.seed = seed;
+	header_.game_mode = static_cast<std::uint8_t>(simulation.game_mode_);
+	header_.game_difficulty = static_cast<std::uint8_t>(simulation.game_difficulty_);
+	header_.fixed_point = PONG_FIXED_POINT;
+	header_.physics_substeps = static_cast<std::uint8_t>(simulation.physics_substeps_);
+	header_.state_size = sizeof(SimulationState);
+	header_.tick_rate = static_cast<std::uint32_t>(simulation.tick_rate_);
+	header_.arena_hash = simulation.arena_->GetHash();
+
+	recorded_ = 0;
+	chain_ = 0;
+	last_tick_ = simulation.tick_count_;
+}
+
+bool StateChecksums::IsStarted() const
+{
+	return !entries_.empty();
+}
+
+void StateChecksums::Record(const Simulation& simulation)
+{
+	if (entries_.empty() || simulation.tick_count_ != last_tick_ + 1)
+	{
+		return;
+	}
+
+	TRACE_ZONE("StateChecksums::Record");
+
+	const std::size_t slot = static_cast<std::size_t>(recorded_) & (entries_.size() - 1);
+	const std::uint64_t state_hash = simulation.GetStateHash();
+
+	chain_ = ChainHash(chain_, state_hash);
+	entries_[slot] = { simulation.tick_count_, state_hash, chain_ };
+	simulation.SaveState(states_[slot]);
+
+	last_tick_ = simulation.tick_count_;
+	++recorded_;
+}
+
+std::uint64_t StateChecksums::GetChain() const
+{
+	return chain_;
+}
+
+bool StateChecksums::Save(const char* path) const
+{
+	if (recorded_ == 0)
+	{
+		return false;
+	}
+
+	FILE* file = fopen(path, "wb");
+
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Unable to open %s for the state checksums!\n", path);
+		return false;
+	}
+
+	const std::size_t capacity = entries_.size();
+	const std::size_t count = recorded_ < capacity ? static_cast<std::size_t>(recorded_) : capacity;
+
+	// Oldest first: once the ring has wrapped, the oldest entry is the one the next tick would overwrite.
+	const std::size_t oldest = recorded_ < capacity ? 0 : static_cast<std::size_t>(recorded_) & (capacity - 1);
+
+	ChecksumHeader header = header_;
+	header.first_tick = entries_[oldest].tick;
+	header.count = count;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	// The ring is two runs at most, oldest to the end and then from the start.
+	const std::size_t first_run = capacity - oldest < count ? capacity - oldest : count;
+
+	written = written && fwrite(&entries_[oldest], sizeof(ChecksumEntry), first_run, file) == first_run;
+	written = written && fwrite(&entries_[0], sizeof(ChecksumEntry), count - first_run, file) == count - first_run;
+	written = written && fwrite(&states_[oldest], sizeof(SimulationState), first_run, file) == first_run;
+	written = written && fwrite(&states_[0], sizeof(SimulationState), count - first_run, file) == count - first_run;
+
+	if (fclose(file) != 0 || !written)
+	{
+		fprintf(stderr, "Unable to write the state checksums to %s!\n", path);
+		return false;
+	}
+
+	fprintf(stderr, "State checksums of ticks %llu to %llu saved to %s\n", static_cast<unsigned long long>(header.first_tick),
+		static_cast<unsigned long long>(last_tick_), path);
+
+	return true;
+}
+
+std::uint64_t StateChecksums::ChainHash(std::uint64_t chain, std::uint64_t state_hash)
+{
+	// splitmix64's finalizer, so any difference in any state changes every chain after it.
+	std::uint64_t hash = chain ^ (state_hash + 0x9E3779B97F4A7C15ULL + (chain << 6) + (chain >> 2));
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+
+	return hash ^ (hash >> 31);
+}
@@ -1,7 +1,8 @@
 #include "States/GameDifficultyMenuState.hpp"
 #include "States/GamePlayState.hpp"
-#include "Button.hpp"
+#include "AtlasSprites.hpp"
 #include "Constants.hpp"
+#include "Trace.hpp"
 
 #include <SDL.h>
 
@@ -12,11 +13,6 @@ std::unique_ptr<GameDifficultyMenuState> GameDifficultyMenuState::game_difficult
 
 GameDifficultyMenuState::~GameDifficultyMenuState()
 {
-	if (font_ != nullptr)
-	{
-		TTF_CloseFont(font_);
-		font_ = nullptr;
-	}
 }
 
 GameDifficultyMenuState* GameDifficultyMenuState::Instance()
@@ -26,34 +22,27 @@ GameDifficultyMenuState* GameDifficultyMenuState::Instance()
 
 bool GameDifficultyMenuState::Enter(Game* game)
 {
+	TRACE_ZONE("GameDifficultyMenuState::Enter");
+
 	game_ = game;
-	font_ = TTF_OpenFont("res/font/font.ttf", 58);
 
-	if (font_ == nullptr)
+	if (menu_ == nullptr)
 	{
-		printf("Failed to load font! SDL_ttf Error: %s\n", TTF_GetError());
-		return false;
+		menu_ = std::make_unique<Menu>(game_);
+		easy_difficulty_button_ = menu_->AddButton(atlas::easy, constants::screen_width / 2, constants::screen_height * 3 / 8);
+		medium_difficulty_button_ = menu_->AddButton(atlas::medium, constants::screen_width / 2, constants::screen_height * 4 / 8);
+		hard_difficulty_button_ = menu_->AddButton(atlas::hard, constants::screen_width / 2, constants::screen_height * 5 / 8);
+		impossible_difficulty_button_ = menu_->AddButton(atlas::impossible, constants::screen_width / 2, constants::screen_height * 6 / 8);
 	}
 
-	easy_difficulty_button_ = std::make_unique<Button>(game_, font_, "Easy");
-	easy_difficulty_button_->SetPosition((constants::screen_width / 2) - (easy_difficulty_button_->GetTexture()->width_ / 2), constants::screen_height * 3 / 8);
-	
-	medium_difficulty_button_ = std::make_unique<Button>(game_, font_, "Medium");
-	medium_difficulty_button_->SetPosition((constants::screen_width / 2) - (medium_difficulty_button_->GetTexture()->width_ / 2), constants::screen_height * 4 / 8);
-	
-	hard_difficulty_button_ = std::make_unique<Button>(game_, font_, "Hard");
-	hard_difficulty_button_->SetPosition((constants::screen_width / 2) - (hard_difficulty_button_->GetTexture()->width_ / 2), constants::screen_height * 5 / 8);
-
-	impossible_difficulty_button_ = std::make_unique<Button>(game_, font_, "Impossible");
-	impossible_difficulty_button_->SetPosition((constants::screen_width / 2) - (impossible_difficulty_button_->GetTexture()->width_ / 2), constants::screen_height * 6 / 8);
-	
+	menu_->SyncPointer();
+
 	return true;
 }
 
 void GameDifficultyMenuState::Exit()
 {
-	TTF_CloseFont(font_);
-	font_ = nullptr;
+	TRACE_ZONE("GameDifficultyMenuState::Exit");
 }
 
 void GameDifficultyMenuState::Pause()
@@ -62,77 +51,58 @@ void GameDifficultyMenuState::Pause()
 
 void GameDifficultyMenuState::Resume()
 {
-	easy_difficulty_button_->UpdateButtonFlags();
-	medium_difficulty_button_->UpdateButtonFlags();
-	hard_difficulty_button_->UpdateButtonFlags();
-	impossible_difficulty_button_->UpdateButtonFlags();
+	menu_->SyncPointer();
+}
+
+std::uint32_t GameDifficultyMenuState::GetInputEvents() const
+{
+	return input_events::pointer | input_events::buttons;
 }
 
-void GameDifficultyMenuState::HandleEvents()
+void GameDifficultyMenuState::HandleEvents(const InputFrame& input)
 {
-	SDL_Event e;
+	TRACE_ZONE("GameDifficultyMenuState::HandleEvents");
 
-	while (SDL_PollEvent(&e) != 0)
+	const int clicked = menu_->HandleInput(input);
+
+	if (clicked != Menu::none)
 	{
-		if (e.type == SDL_QUIT)
+		if (clicked == easy_difficulty_button_)
 		{
-			game_->Stop();
+			game_->game_difficulty_ = GameDifficulty::EASY;
 		}
-
-		if (e.type == SDL_MOUSEBUTTONUP)
+		else if (clicked == medium_difficulty_button_)
 		{
-			if (easy_difficulty_button_->MouseOverlapsButton())
-			{
-				game_->game_difficulty_ = GameDifficulty::EASY;
-				game_->PushState(GamePlayState::Instance());
-			}
-			else if (medium_difficulty_button_->MouseOverlapsButton())
-			{
-				game_->game_difficulty_ = GameDifficulty::MEDIUM;
-				game_->PushState(GamePlayState::Instance());
-			}
-			else if (hard_difficulty_button_->MouseOverlapsButton())
-			{
-				game_->game_difficulty_ = GameDifficulty::HARD;
-				game_->PushState(GamePlayState::Instance());
-			}
-			else if (impossible_difficulty_button_->MouseOverlapsButton())
-			{
-				game_->game_difficulty_ = GameDifficulty::IMPOSSIBLE;
-				game_->PushState(GamePlayState::Instance());
-			}
+			game_->game_difficulty_ = GameDifficulty::MEDIUM;
 		}
-		else if (e.type == SDL_MOUSEMOTION)
+		else if (clicked == hard_difficulty_button_)
 		{
-			easy_difficulty_button_->HandleEvent(&e);
-			medium_difficulty_button_->HandleEvent(&e);
-			hard_difficulty_button_->HandleEvent(&e);
-			impossible_difficulty_button_->HandleEvent(&e);
+			game_->game_difficulty_ = GameDifficulty::HARD;
 		}
-		else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)
+		else
 		{
-			game_->PopState();
+			game_->game_difficulty_ = GameDifficulty::IMPOSSIBLE;
 		}
+
+		game_->PushState(GamePlayState::Instance());
+	}
+	else if (input.WasPressed(InputAction::BACK))
+	{
+		game_->PopState();
 	}
 }
 
 void GameDifficultyMenuState::Tick()
 {
-	easy_difficulty_button_->Tick();
-	medium_difficulty_button_->Tick();
-	hard_difficulty_button_->Tick();
-	impossible_difficulty_button_->Tick();
+	TRACE_ZONE("GameDifficultyMenuState::Tick");
 }
 
 void GameDifficultyMenuState::Render()
 {
+	TRACE_ZONE("GameDifficultyMenuState::Render");
+
 	SDL_SetRenderDrawColor(game_->renderer_, 0x00, 0x00, 0x00, 0xFF);
 	SDL_RenderClear(game_->renderer_);
 
-	easy_difficulty_button_->Render();
-	medium_difficulty_button_->Render();
-	hard_difficulty_button_->Render();
-	impossible_difficulty_button_->Render();
-
-	SDL_RenderPresent(game_->renderer_);
+	menu_->Render();
 }
\ No newline at end of file
@@ -1,11 +1,11 @@
 #include "States/GameModeMenuState.hpp"
 #include "States/GamePlayState.hpp"
 #include "States/GameDifficultyMenuState.hpp"
-#include "Button.hpp"
+#include "AtlasSprites.hpp"
 #include "Constants.hpp"
+#include "Trace.hpp"
 
 #include <SDL.h>
-#include <SDL_ttf.h>
 
 #include <iostream>
 #include <memory>
@@ -14,11 +14,6 @@ std::unique_ptr<GameModeMenuState> GameModeMenuState::game_menu_state_ = std::ma
 
 GameModeMenuState::~GameModeMenuState()
 {
-	if (font_ != nullptr)
-	{
-		TTF_CloseFont(font_);
-		font_ = nullptr;
-	}
 }
 
 GameModeMenuState* GameModeMenuState::Instance()
@@ -28,31 +23,26 @@ GameModeMenuState* GameModeMenuState::Instance()
 
 bool GameModeMenuState::Enter(Game* game)
 {
+	TRACE_ZONE("GameModeMenuState::Enter");
+
 	game_ = game;
-	font_ = TTF_OpenFont("res/font/font.ttf", 58);
 
-	if (font_ == nullptr)
+	if (menu_ == nullptr)
 	{
-		printf("Failed to load font! SDL_ttf Error: %s\n", TTF_GetError());
-		return false;
+		menu_ = std::make_unique<Menu>(game_);
+		menu_->AddLabel(atlas::title, constants::screen_width / 2, constants::screen_height * 1 / 7, 5.0f);
+		single_player_button_ = menu_->AddButton(atlas::singleplayer, constants::screen_width / 2, constants::screen_height * 3 / 7);
+		multi_player_button_ = menu_->AddButton(atlas::multiplayer, constants::screen_width / 2, constants::screen_height * 4 / 7);
 	}
 
-	title_texture_ = std::make_unique<Texture>();
-	title_texture_->LoadFromPath(game_->renderer_, "res/gfx/pong_title.png");
-
-	single_player_button_ = std::make_unique<Button>(game_, font_, "Singleplayer");
-	single_player_button_->SetPosition((constants::screen_width / 2) - (single_player_button_->GetTexture()->width_ / 2), constants::screen_height * 3 / 7);
-	
-	multi_player_button_ = std::make_unique<Button>(game_, font_, "Multiplayer");
-	multi_player_button_->SetPosition((constants::screen_width / 2) - (multi_player_button_->GetTexture()->width_ / 2), constants::screen_height * 4 / 7);
+	menu_->SyncPointer();
 
 	return true;
 }
 
 void GameModeMenuState::Exit()
 {
-	TTF_CloseFont(font_);
-	font_ = nullptr;
+	TRACE_ZONE("GameModeMenuState::Exit");
 }
 
 void GameModeMenuState::Pause()
@@ -61,59 +51,43 @@ void GameModeMenuState::Pause()
 
 void GameModeMenuState::Resume()
 {
-	single_player_button_->UpdateButtonFlags();
-	multi_player_button_->UpdateButtonFlags();
+	menu_->SyncPointer();
+}
+
+std::uint32_t GameModeMenuState::GetInputEvents() const
+{
+	return input_events::pointer | input_events::buttons;
 }
 
-void GameModeMenuState::HandleEvents()
+void GameModeMenuState::HandleEvents(const InputFrame& input)
 {
-	SDL_Event e;
+	TRACE_ZONE("GameModeMenuState::HandleEvents");
 
-	while (SDL_PollEvent(&e) != 0)
+	const int clicked = menu_->HandleInput(input);
+
+	if (clicked == single_player_button_)
+	{
+		game_->game_mode_ = GameMode::SINGLE_PLAYER;
+		game_->PushState(GameDifficultyMenuState::Instance());
+	}
+	else if (clicked == multi_player_button_)
 	{
-		if (e.type == SDL_QUIT)
-		{
-			game_->Stop();
-		}
-
-		if (e.type == SDL_MOUSEBUTTONUP)
-		{
-			if (single_player_button_->MouseOverlapsButton())
-			{
-				game_->game_mode_ = GameMode::SINGLE_PLAYER;
-				game_->PushState(GameDifficultyMenuState::Instance());
-			}
-			else if (multi_player_button_->MouseOverlapsButton())
-			{
-				game_->game_mode_ = GameMode::MULTI_PLAYER;
-				game_->PushState(GamePlayState::Instance());
-			}
-		}
-		else if (e.type == SDL_MOUSEMOTION)
-		{
-			single_player_button_->HandleEvent(&e);
-			multi_player_button_->HandleEvent(&e);
-		}
+		game_->game_mode_ = GameMode::MULTI_PLAYER;
+		game_->PushState(GamePlayState::Instance());
 	}
 }
 
 void GameModeMenuState::Tick()
 {
-	single_player_button_->Tick();
-	multi_player_button_->Tick();
+	TRACE_ZONE("GameModeMenuState::Tick");
 }
 
 void GameModeMenuState::Render()
 {
+	TRACE_ZONE("GameModeMenuState::Render");
+
 	SDL_SetRenderDrawColor(game_->renderer_, 0x00, 0x00, 0x00, 0xFF);
 	SDL_RenderClear(game_->renderer_);
 
-	const float scale = 5.0;
-
-	title_texture_->Render(game_->renderer_, (constants::screen_width / 2) - ((title_texture_->width_ * scale) / 2), constants::screen_height * 1 / 7, nullptr, scale);
-
-	single_player_button_->Render();
-	multi_player_button_->Render();
-
-	SDL_RenderPresent(game_->renderer_);
+	menu_->Render();
 }
\ No newline at end of file
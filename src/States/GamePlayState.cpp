@@ -1,6 +1,14 @@
 #include "States/GamePlayState.hpp"
+#include "AiPlugin.hpp"
+#include "AllocationTracker.hpp"
+#include "AtlasSprites.hpp"
+#include "Audio.hpp"
+#include "Config.hpp"
 #include "Constants.hpp"
+#include "Input.hpp"
+#include "SpectatorServer.hpp"
 #include "Utility.hpp"
+#include "Trace.hpp"
 
 #include <SDL.h>
 #include <SDL_ttf.h>
@@ -8,29 +16,36 @@
 
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <cmath>
 #include <vector>
 #include <array>
-#include <cassert>
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
 #include <string>
 #include <optional>
-
-#define DEBUGGING 0
+#include <sys/stat.h>
+#include <chrono>
+#include <thread>
 
 std::unique_ptr<GamePlayState> GamePlayState::game_play_state_ = std::make_unique<GamePlayState>();
 	
 GamePlayState::GamePlayState() : 
 	game_(nullptr), 
-	font_(nullptr), 
-	player1_score_(0), 
-	player2_score_(0), 
-	player1_score_texture_(nullptr), 
-	player2_score_texture_(nullptr), 
-	ball_resetting_(false), 
-	ball_reset_ticks_(0)
+	applied_tuning_(nullptr), 
+	steady_state_ticks_(0), 
+	ticks_since_enter_(0), 
+	simulation_running_(false), 
+	playback_(false), 
+	playback_paused_(false), 
+	playback_speed_(1), 
+	playback_tick_credit_(0),
+	show_trajectory_(false),
+	drawn_trajectory_version_(0),
+	trajectory_point_count_(0),
+	trajectory_marker_count_(0)
 {
-	intersection_point_.x = 0.0f;
-	intersection_point_.y = 0.0f;
 }
 
 GamePlayState::~GamePlayState()
@@ -44,449 +59,686 @@ void GamePlayState::DrawDividerRects()
 	constexpr int rect_size = 20;
 	constexpr int rects_num = constants::screen_height / rect_size;
 
+	std::pmr::vector<SDL_Rect> rects(&game_->frame_arena_);
+	rects.reserve((rects_num + 1) / 2);
+
 	for (int i = 0; i < rects_num; i += 2)
 	{
-		SDL_Rect rect = { (constants::screen_width / 2) - (rect_size / 2), i * rect_size, rect_size, rect_size };
-		SDL_RenderFillRect(game_->renderer_, &rect);
-	} 
+		rects.push_back({ (constants::screen_width / 2) - (rect_size / 2), i * rect_size, rect_size, rect_size });
+	}
+
+	SDL_RenderFillRects(game_->renderer_, rects.data(), static_cast<int>(rects.size()));
 }
 
-GamePlayState* GamePlayState::Instance()
+void GamePlayState::BuildObstacleShapes()
 {
-	return game_play_state_.get();
+	const Arena& arena = game_->arena_;
+
+	obstacle_boxes_.clear();
+	obstacle_segments_.clear();
+
+	for (std::size_t i = 0; i < arena.GetObstacleCount(); ++i)
+	{
+		const Obstacle& obstacle = arena.GetObstacle(static_cast<std::int32_t>(i));
+
+		if (obstacle.type_ == ObstacleType::BOX)
+		{
+			obstacle_boxes_.push_back({ static_cast<float>(obstacle.a_.x), static_cast<float>(obstacle.a_.y), static_cast<float>(obstacle.b_.x - obstacle.a_.x),
+				static_cast<float>(obstacle.b_.y - obstacle.a_.y) });
+		}
+		else
+		{
+			obstacle_segments_.push_back(ToFPoint(obstacle.a_));
+			obstacle_segments_.push_back(ToFPoint(obstacle.b_));
+		}
+	}
 }
 
-bool GamePlayState::Enter(Game* game)
+void GamePlayState::DrawObstacles()
 {
-	game_ = game;
-	font_ = TTF_OpenFont("res/font/font.ttf", 98);
+	SDL_SetRenderDrawColor(game_->renderer_, 0xD3, 0xD3, 0xD3, 0xFF);
 
-	if (font_ == nullptr)
+	if (!obstacle_boxes_.empty())
 	{
-		printf("Failed to load font! SDL_ttf Error: %s\n", TTF_GetError());
-		return false;
+		SDL_RenderFillRectsF(game_->renderer_, obstacle_boxes_.data(), static_cast<int>(obstacle_boxes_.size()));
 	}
 
-	constexpr int ball_side_size = 14;
+	// The segments are separate, not a polyline.
+	for (std::size_t i = 0; i + 1 < obstacle_segments_.size(); i += 2)
+	{
+		SDL_RenderDrawLineF(game_->renderer_, obstacle_segments_[i].x, obstacle_segments_[i].y, obstacle_segments_[i + 1].x, obstacle_segments_[i + 1].y);
+	}
+}
 
-	ball_.game_ = game_;
-	
-	ball_.rect_.x = static_cast<float>((constants::screen_width / 2) - (ball_side_size / 2));
-	ball_.rect_.y = static_cast<float>((constants::screen_height / 2) - (ball_side_size / 2));
-	ball_.rect_.w = static_cast<float>(ball_side_size);
-	ball_.rect_.h = ball_.rect_.w;
-
-	ball_.vx_ = 5.0f;
-	ball_.vy_ = 0.0f;
-	ball_.direction_ray_.start_point.x = ball_.rect_.x + (ball_.rect_.w / 2);
-	ball_.direction_ray_.start_point.y = ball_.rect_.y + (ball_.rect_.h / 2);
-	ball_.direction_ray_.end_point.x = ball_.rect_.x + (ball_.rect_.w / 2) + ((constants::screen_width + constants::screen_height) * ball_.vx_);
-	ball_.direction_ray_.end_point.y = ball_.rect_.y + (ball_.rect_.h / 2) + ((constants::screen_width + constants::screen_height) * ball_.vy_);
-
-	player1_score_ = 0;
-	player2_score_ = 0;
-
-	constexpr float paddle_w_ = 20.0f;
-	constexpr float paddle_h_ = 100.0f;
-	constexpr int paddle_x_offset = 30;
-
-	player1_paddle_.game_ = game_;
-	player1_paddle_.rect_.x = static_cast<float>(constants::screen_width - paddle_w_ - paddle_x_offset);
-	player1_paddle_.rect_.y = static_cast<float>((constants::screen_height / 2) - (paddle_h_ / 2));
-	player1_paddle_.rect_.w = paddle_w_;
-	player1_paddle_.rect_.h = paddle_h_;
-	player1_paddle_.vy_ = 0.0f;
-	
-	player2_paddle_.game_ = game_;
-	player2_paddle_.rect_.x = static_cast<float>(paddle_x_offset);
-	player2_paddle_.rect_.y = static_cast<float>((constants::screen_height / 2) - (paddle_h_ / 2));
-	player2_paddle_.rect_.w = paddle_w_;
-	player2_paddle_.rect_.h = paddle_h_;
-	player2_paddle_.vy_ = 0.0f;
+void GamePlayState::DrawTrajectory(const SimulationSnapshot& snapshot)
+{
+	TRACE_ZONE("GamePlayState::DrawTrajectory");
 
-	const SDL_Color score_color = { 0xD3, 0xD3, 0xD3, 0xFF };
+	constexpr float marker_size = 10.0f;
 
-	player1_score_texture_ = std::make_unique<Texture>();
-	player1_score_texture_->LoadFromText(game_->renderer_, font_, std::to_string(player1_score_).c_str(), score_color);
+	if (snapshot.trajectory_version_ != drawn_trajectory_version_)
+	{
+		drawn_trajectory_version_ = snapshot.trajectory_version_;
+		trajectory_point_count_ = snapshot.trajectory_.count_;
+		trajectory_marker_count_ = 0;
 
-	player2_score_texture_ = std::make_unique<Texture>();
-	player2_score_texture_->LoadFromText(game_->renderer_, font_, std::to_string(player2_score_).c_str(), score_color);
+		for (std::size_t i = 0; i < trajectory_point_count_; ++i)
+		{
+			trajectory_points_[i] = ToFPoint(snapshot.trajectory_.points_[i]);
 
-	ball_resetting_ = false;
-	ball_reset_ticks_ = 60;
+			// Every corner after the ball's own position is a bounce, and the last one the goal line crossing.
+			if (i > 0)
+			{
+				trajectory_markers_[trajectory_marker_count_++] = { trajectory_points_[i].x - (marker_size / 2), trajectory_points_[i].y - (marker_size / 2), marker_size, marker_size };
+			}
+		}
 
-	GetEdgeIntersectionPoint();
+		// Where the AI is heading, which is not always where the ball goes.
+		const SDL_FPoint target = ToFPoint(snapshot.intersection_point_);
+		trajectory_markers_[trajectory_marker_count_++] = { target.x - marker_size, target.y - marker_size, 2 * marker_size, 2 * marker_size };
+	}
 
-	return true;
+	if (trajectory_point_count_ >= 2)
+	{
+		SDL_SetRenderDrawColor(game_->renderer_, 0xD3, 0xD3, 0xD3, 0xFF);
+		SDL_RenderDrawLinesF(game_->renderer_, trajectory_points_.data(), static_cast<int>(trajectory_point_count_));
+	}
+
+	SDL_SetRenderDrawColor(game_->renderer_, 0xFF, 0x00, 0x00, 0xFF);
+	SDL_RenderDrawRectsF(game_->renderer_, trajectory_markers_.data(), static_cast<int>(trajectory_marker_count_));
 }
 
-void GamePlayState::Exit()
+void GamePlayState::DrawRect(const Rect& rect)
 {
-	if (font_ != nullptr)
+	const SDL_FRect render_rect = ToFRect(rect);
+
+	SDL_SetRenderDrawColor(game_->renderer_, 0xD3, 0xD3, 0xD3, 0xFF);
+	SDL_RenderFillRectF(game_->renderer_, &render_rect);
+}
+
+int GamePlayState::GetScoreWidth(int score) const
+{
+	int width = 0;
+
+	do
 	{
-		TTF_CloseFont(font_);
-		font_ = nullptr;
-	}
+		width += atlas::digits[score % 10].w;
+		score /= 10;
+	} while (score > 0);
 
-	player1_score_texture_->FreeTexture();
-	player2_score_texture_->FreeTexture();
+	return width;
 }
 
-void GamePlayState::Pause()
+void GamePlayState::RenderScore(int score, int x, int y)
 {
+	// Digits come out least significant first, so they are laid down from the right edge of the number.
+	// Scores are drawn digit by digit from the atlas, so a goal never renders text or creates a texture mid-match.
+	int digit_x = x + GetScoreWidth(score);
+
+	game_->atlas_.SetColor({ 0xD3, 0xD3, 0xD3, 0xFF });
+
+	do
+	{
+		const SDL_Rect& digit = atlas::digits[score % 10];
+		digit_x -= digit.w;
+		game_->atlas_.Render(game_->renderer_, digit_x, y, &digit);
+		score /= 10;
+	} while (score > 0);
 }
 
-void GamePlayState::Resume()
+GamePlayState* GamePlayState::Instance()
 {
+	return game_play_state_.get();
 }
 
-void GamePlayState::HandleEvents()
+bool GamePlayState::Enter(Game* game)
 {
-	SDL_Event e;
+	TRACE_ZONE("GamePlayState::Enter");
+
+	game_ = game;
+
+	applied_tuning_ = Config::Instance()->GetTuning();
+	simulation_.ApplyTuning(*applied_tuning_);
+	simulation_.SetArena(&game_->arena_);
+	BuildObstacleShapes();
 
-	constexpr int speed = 10;
+	playback_ = !game_->GetOptions().replay_path.empty();
 
-	while (SDL_PollEvent(&e) != 0)
+	if (playback_)
 	{
-		if (e.type == SDL_QUIT)
+		if (!replay_reader_.Open(game_->GetOptions().replay_path.c_str()))
 		{
 			game_->Stop();
+			return false;
 		}
 
-		if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
+		// The obstacles are not in the replay, only which ones they were.
+		if (replay_reader_.GetHeader().arena_hash != game_->arena_.GetHash())
 		{
-			if (e.key.keysym.sym == SDLK_UP)
-			{
-				player1_paddle_.vy_ = -speed;
-			}
-			
-			if (e.key.keysym.sym == SDLK_DOWN)
-			{
-				player1_paddle_.vy_ = speed;
-			}
-
-			if (game_->game_mode_ == GameMode::MULTI_PLAYER)
-			{
-				if (e.key.keysym.sym == SDLK_w)
-				{
-					player2_paddle_.vy_ = -speed;
-				}
-				
-				if (e.key.keysym.sym == SDLK_s)
-				{
-					player2_paddle_.vy_ = speed;
-				}
-			}
+			fprintf(stderr, "Unable to play %s: it was recorded in a different arena!\n", game_->GetOptions().replay_path.c_str());
+			game_->Stop();
+			return false;
 		}
 
-		if (e.type == SDL_KEYUP && e.key.repeat == 0)
-		{
-			if (e.key.keysym.sym == SDLK_UP)
-			{
-				player1_paddle_.vy_ = 0;
-			}
-			
-			if (e.key.keysym.sym == SDLK_DOWN)
-			{
-				player1_paddle_.vy_ = 0;
-			}
+		game_->game_mode_ = replay_reader_.GetGameMode();
+		game_->game_difficulty_ = replay_reader_.GetGameDifficulty();
+		playback_paused_ = false;
+		playback_speed_ = 1;
+		playback_tick_credit_ = 0;
+		replay_reader_.Seek(simulation_, 0);
 
-			if (game_->game_mode_ == GameMode::MULTI_PLAYER)
-			{
-				if (e.key.keysym.sym == SDLK_w)
-				{
-					player2_paddle_.vy_ = 0;
-				}
-				
-				if (e.key.keysym.sym == SDLK_s)
-				{
-					player2_paddle_.vy_ = 0;
-				}
-			}
+		if (!game_->GetOptions().checksum_path.empty())
+		{
+			checksums_.Start(simulation_, replay_reader_.GetHeader().seed);
 		}
-
-		if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)
+	}
+	else
+	{
+		const std::uint64_t seed = static_cast<std::uint64_t>(std::time(nullptr));
+		simulation_.SetTickRate(game_->GetOptions().tick_rate, game_->GetOptions().physics_substeps);
+		simulation_.Reset(game_->game_mode_, game_->game_difficulty_, seed);
+		StartAi();
+		StartRecording(seed);
+		StartRallyLog(seed);
+
+		if (!game_->GetOptions().checksum_path.empty())
 		{
-			game_->PopState();
+			checksums_.Start(simulation_, seed);
 		}
 	}
+
+	simulation_.ball_.game_ = game_;
+	simulation_.player1_paddle_.game_ = game_;
+	simulation_.player2_paddle_.game_ = game_;
+
+	steady_state_ticks_ = 2 * game_->GetOptions().tick_rate;
+	ticks_since_enter_ = 0;
+
+	Input::Instance()->Clear();
+	Input::Instance()->SetCapturing(!playback_);
+
+	tick_stats_.Reset(game_->GetOptions().tick_rate);
+	PublishSnapshot();
+	StartSimulationThread();
+
+	return true;
 }
 
-void GamePlayState::Tick()
+void GamePlayState::Exit()
 {
-	if (game_->game_mode_ == GameMode::SINGLE_PLAYER)
+	TRACE_ZONE("GamePlayState::Exit");
+
+	const bool threaded = simulation_thread_.joinable();
+	StopSimulationThread();
+	tick_stats_.PrintReport(stderr, threaded ? "Tick timing (simulation thread)" : "Tick timing (game loop)");
+
+	if (ai_host_.IsStarted())
 	{
-		if (ball_reset_ticks_ == 0)
-		{
-			ball_reset_ticks_ = 30;
-			ball_resetting_ = false;
-			ball_.Reset();
-		}
+		ai_host_.Stop();
+		ai_host_.PrintReport(stderr);
+	}
 
-		if (ball_resetting_)
-		{
-			--ball_reset_ticks_;
-			player1_paddle_.Tick();
-			player2_paddle_.Tick();
-			return;
-		}
+	AllocationTracker::SetSteadyState(false);
+	Input::Instance()->SetCapturing(false);
 
-		ball_.Tick();
+	if (replay_writer_.IsOpen())
+	{
+		replay_writer_.Close();
+	}
 
-		if (ball_.rect_.x + ball_.rect_.w < 0)
-		{
-			++player1_score_;
-			ball_resetting_ = true;
-			const SDL_Color score_color = { 0xD3, 0xD3, 0xD3, 0xFF };
-			player1_score_texture_->LoadFromText(game_->renderer_, font_, std::to_string(player1_score_).c_str(), score_color);
+	rally_log_.Close();
 
-		}
-		else if (ball_.rect_.x > constants::screen_width)
-		{
-			++player2_score_;
-			ball_resetting_ = true;
-			const SDL_Color score_color = { 0xD3, 0xD3, 0xD3, 0xFF };
-			player2_score_texture_->LoadFromText(game_->renderer_, font_, std::to_string(player2_score_).c_str(), score_color);
-		}
+	if (checksums_.IsStarted())
+	{
+		checksums_.Save(game_->GetOptions().checksum_path.c_str());
+	}
 
-		float speed = 0.0f;
+	replay_reader_.Close();
+}
 
-		if (game_->game_difficulty_ == GameDifficulty::EASY)
-		{
-			speed = 5.0f;
-		}
-		else if (game_->game_difficulty_ == GameDifficulty::MEDIUM)
-		{
-			speed = 6.0f;
-		}
-		else if (game_->game_difficulty_ == GameDifficulty::HARD || game_->game_difficulty_ == GameDifficulty::IMPOSSIBLE)
-		{
-			speed = 7.0f;
-		}
+void GamePlayState::Pause()
+{
+	StopSimulationThread();
+	AllocationTracker::SetSteadyState(false);
+	Input::Instance()->SetCapturing(false);
+}
 
-		const float paddle_mid_point_y = player2_paddle_.rect_.y + (player2_paddle_.rect_.h / 2.0f);
-		const float dist = intersection_point_.y - paddle_mid_point_y;
+void GamePlayState::Resume()
+{
+	ticks_since_enter_ = 0;
 
-		if (!FloatingPointSame(paddle_mid_point_y, intersection_point_.y, 0.05f))
-		{
-			if (dist < 0.0f)
-			{
-				player2_paddle_.vy_ = -speed;
-			}
-			else
-			{
-				player2_paddle_.vy_ = speed;
-			}
-		}
-		else
-		{
-			player2_paddle_.vy_ = 0.0;
-		}
+	Input::Instance()->Clear();
+	Input::Instance()->SetCapturing(!playback_);
+
+	StartSimulationThread();
+}
+
+void GamePlayState::StartAi()
+{
+	if (game_->game_mode_ != GameMode::SINGLE_PLAYER)
+	{
+		return;
 	}
-	
-	player1_paddle_.Tick();
-	player2_paddle_.Tick();
+
+	// Built-in controllers are trusted and deterministic, so they stay on the ticking thread; a plugin gets its own.
+	if (game_->ai_plugin_ != nullptr)
+	{
+		game_->ai_plugin_->Restart();
+		ai_host_.Start(*game_->ai_plugin_, game_->GetOptions().ai_budget_us, true);
+	}
+	else
+	{
+		ai_host_.Start(*simulation_.ai_controller_, game_->GetOptions().ai_budget_us, false);
+	}
+
+	simulation_.ai_controller_ = &ai_host_;
 }
 
-void GamePlayState::Render()
+void GamePlayState::StartRecording(std::uint64_t seed)
 {
-	SDL_SetRenderDrawColor(game_->renderer_, 0x00, 0x00, 0x00, 0xFF);
-	SDL_RenderClear(game_->renderer_);
+	const std::string& replay_dir = game_->GetOptions().replay_dir;
 
-	DrawDividerRects();
+	if (replay_dir.empty())
+	{
+		return;
+	}
 
-	ball_.Render();
+	// Whether a plugin makes its deadline differs from run to run, so its matches cannot be replayed from inputs.
+	if (game_->ai_plugin_ != nullptr && game_->game_mode_ == GameMode::SINGLE_PLAYER)
+	{
+		fprintf(stderr, "%s\n", "Not recording a replay: matches against an AI plugin cannot be replayed.");
+		return;
+	}
 
-	player1_paddle_.Render();
-	player2_paddle_.Render();
+	// Fails harmlessly when the directory already exists; a real problem shows up when the file is opened.
+	mkdir(replay_dir.c_str(), 0755);
 
-	SDL_SetRenderDrawColor(game_->renderer_, 0xD3, 0xD3, 0xD3, 0xFF);
+	const std::time_t now = std::time(nullptr);
+	char file_name[64];
+	std::strftime(file_name, sizeof(file_name), "match-%Y%m%d-%H%M%S.pongreplay", std::localtime(&now));
 
-	constexpr int score_y_pos = 0;
-	constexpr int score_x_offset = 400;
+	const std::string path = replay_dir + "/" + file_name;
 
-	player1_score_texture_->Render(game_->renderer_, constants::screen_width - score_x_offset, score_y_pos);
-	player2_score_texture_->Render(game_->renderer_, score_x_offset - player2_score_texture_->width_, score_y_pos);
-	
-#if DEBUGGING
-	SDL_RenderDrawLineF(game_->renderer_, ball_.direction_ray_.start_point.x, ball_.direction_ray_.start_point.y, ball_.direction_ray_.end_point.x, ball_.direction_ray_.end_point.y);
+	if (replay_writer_.Open(path.c_str(), game_->game_mode_, game_->game_difficulty_, seed, simulation_.tick_rate_, simulation_.physics_substeps_,
+		game_->arena_.GetHash(), static_cast<std::uint32_t>(simulation_.ScaleTicks(ReplayWriter::default_keyframe_interval))))
+	{
+		fprintf(stderr, "Recording replay to %s\n", path.c_str());
+	}
+}
+
+void GamePlayState::StartRallyLog(std::uint64_t seed)
+{
+	const std::string& rally_dir = game_->GetOptions().rally_dir;
+
+	if (rally_dir.empty())
+	{
+		return;
+	}
 
-	SDL_FPoint intersect_copy = intersection_point_;						
-	Line reflected_line = ball_.direction_ray_;
-	SDL_FPoint reflected_vector = { intersection_point_.x - reflected_line.start_point.x, intersection_point_.y - reflected_line.start_point.y };
+	mkdir(rally_dir.c_str(), 0755);
 
-	constexpr float epsilon = 0.01f;
+	const std::time_t now = std::time(nullptr);
+	char file_name[64];
+	std::strftime(file_name, sizeof(file_name), "rallies-%Y%m%d-%H%M%S.pongrallies", std::localtime(&now));
 
-	while (!FloatingPointSame(intersect_copy.x, 0.0f, epsilon) && !FloatingPointSame(intersect_copy.x, static_cast<float>(constants::screen_width), epsilon))
+	const std::string path = rally_dir + "/" + file_name;
+
+	if (rally_log_.Open(path.c_str(), game_->game_mode_, game_->game_difficulty_, seed, simulation_.tick_count_, simulation_.tick_rate_,
+		simulation_.physics_substeps_, game_->arena_.GetHash()))
 	{
-		reflected_line.start_point = intersect_copy;
-		reflected_line.end_point = intersect_copy;
+		fprintf(stderr, "Logging rallies to %s\n", path.c_str());
+	}
+}
 
-		reflected_vector.y = -reflected_vector.y;
+void GamePlayState::StartSimulationThread()
+{
+	const GameOptions& options = game_->GetOptions();
 
-		constexpr float multiplier = 0.005f;
+	// Legacy input writes paddle velocities from HandleEvents and playback seeks from there, which is only safe
+	// while ticks run on this thread.
+	if (!options.simulation_thread || options.legacy_input || playback_ || simulation_thread_.joinable())
+	{
+		return;
+	}
 
-		reflected_line.end_point.x = reflected_line.end_point.x + ((constants::screen_width + constants::screen_height) * reflected_vector.x);
-		reflected_line.end_point.y = reflected_line.end_point.y + ((constants::screen_width + constants::screen_height) * reflected_vector.y);
+	simulation_running_ = true;
+	simulation_thread_ = std::thread(&GamePlayState::SimulationLoop, this);
+}
 
-		SDL_RenderDrawLineF(game_->renderer_, reflected_line.start_point.x, reflected_line.start_point.y, reflected_line.end_point.x, reflected_line.end_point.y);
+void GamePlayState::StopSimulationThread()
+{
+	if (!simulation_thread_.joinable())
+	{
+		return;
+	}
 
-		std::vector<SDL_FPoint> found_crosses;
-							
-		for (std::size_t i = 0; i < edges.size(); ++i)
-		{
-			const std::optional<SDL_FPoint> cross_point_opt = GetLinesIntersectionPoint(edges[i], reflected_line);
+	simulation_running_ = false;
+	simulation_thread_.join();
+}
 
-			if (cross_point_opt.has_value())
-			{
-				found_crosses.emplace_back(cross_point_opt.value());
-			}
-		}
+void GamePlayState::SimulationLoop()
+{
+	Trace::Instance()->SetThreadName("Simulation");
+
+	const std::uint64_t frequency = SDL_GetPerformanceFrequency();
+	const std::uint64_t period = frequency / static_cast<std::uint64_t>(game_->GetOptions().tick_rate);
+	std::uint64_t next_tick = SDL_GetPerformanceCounter() + period;
 
-		if (found_crosses.empty())
+	while (simulation_running_)
+	{
+		const std::uint64_t now = SDL_GetPerformanceCounter();
+
+		if (now < next_tick)
 		{
-			break;
+			std::this_thread::sleep_for(std::chrono::microseconds((next_tick - now) * 1000000 / frequency));
+			continue;
 		}
 
-		SDL_FPoint intersect = *std::min_element(found_crosses.begin(), found_crosses.end(), [this](SDL_FPoint p1, SDL_FPoint p2)
-			{
-				return PointsDistance(p1.x, p1.y, intersection_point_.x, intersection_point_.y) > PointsDistance(p2.x, p2.y, intersection_point_.x, intersection_point_.y);
-			});
+		TickSimulation();
+
+		// After a hitch of several ticks (a debugger break, a suspended machine) carry on from now instead of racing to catch up.
+		next_tick = (now - next_tick > period * 4) ? now + period : next_tick + period;
+	}
 
-		intersect_copy = intersect;
+	AllocationTracker::SetSteadyState(false);
+}
 
-		SDL_SetRenderDrawColor(game_->renderer_, 0xff, 0x00, 0x00, 0xff);
-		constexpr float box_size = 30.0f;
-		const SDL_FRect collision_box = { intersect_copy.x - (box_size / 2), intersect_copy.y - (box_size / 2), box_size, box_size };
-		SDL_RenderFillRectF(game_->renderer_, &collision_box);
-		SDL_SetRenderDrawColor(game_->renderer_, 0xff, 0xff, 0xff, 0xff);
+void GamePlayState::PublishSnapshot()
+{
+	const bool show_trajectory = show_trajectory_.load(std::memory_order_relaxed);
+
+	if (show_trajectory != simulation_.trace_trajectory_)
+	{
+		simulation_.SetTrajectoryTracing(show_trajectory);
 	}
-							
-	SDL_SetRenderDrawColor(game_->renderer_, 0xff, 0x00, 0x00, 0xff);
 
-	constexpr float box_size = 30.0f;
-	SDL_FRect collision_box = { intersection_point_.x - (box_size / 2), intersection_point_.y - (box_size / 2), box_size, box_size };
-	SDL_RenderFillRectF(game_->renderer_, &collision_box);
-	SDL_SetRenderDrawColor(game_->renderer_, 0xff, 0xff, 0xff, 0xff);
-#endif
-	
-	SDL_RenderPresent(game_->renderer_);
+	SimulationSnapshot& snapshot = snapshots_.GetWriteBuffer();
+	simulation_.TakeSnapshot(snapshot);
+
+	if (game_->spectator_server_ != nullptr)
+	{
+		game_->spectator_server_->Publish(snapshot);
+	}
+
+	snapshots_.Publish();
 }
 
-const std::optional<SDL_FPoint> GamePlayState::GetLinesIntersectionPoint(const Line& line_1, const Line& line_2) const
+std::uint32_t GamePlayState::GetInputEvents() const
 {
-	const auto line_1_coefficients = GetLinearEquationCoefficients(line_1.start_point.x, line_1.start_point.y, line_1.end_point.x, line_1.end_point.y);
-    const auto line_2_coefficients = GetLinearEquationCoefficients(line_2.start_point.x, line_2.start_point.y, line_2.end_point.x, line_2.end_point.y);
-
-    const float& A1 = std::get<0>(line_1_coefficients);
-    const float& B1 = std::get<1>(line_1_coefficients);
-    const float& C1 = std::get<2>(line_1_coefficients);
-   
-    const float& A2 = std::get<0>(line_2_coefficients);
-    const float& B2 = std::get<1>(line_2_coefficients);
-    const float& C2 = std::get<2>(line_2_coefficients);
-
-    const float det = A1 * B2 - A2 * B1;
-
-    if (det != 0)
-    {
-        const float x = (B2 * C1 - B1 * C2) / det;
-        const float y = (A1 * C2 - A2 * C1) / det;
-		const SDL_FPoint intersection_point = { x, y };
-
-        if (IsPointOnLine(intersection_point, line_1) && IsPointOnLine(intersection_point, line_2))
-        {
-			return intersection_point;
-        }
-    }
-
-	return std::nullopt;
+	// Keys only: the mouse and text input would otherwise fill the queue during a match.
+	return 0;
 }
 
-void GamePlayState::GetEdgeIntersectionPoint()
+void GamePlayState::HandleEvents(const InputFrame& input)
 {
-	std::vector<SDL_FPoint> found_crosses;
+	TRACE_ZONE("GamePlayState::HandleEvents");
 
-	for (std::size_t i = 0; i < edges.size(); ++i)
+	if (input.WasPressed(InputAction::TOGGLE_TRAJECTORY))
 	{
-		const std::optional<SDL_FPoint> cross_point_opt = GetLinesIntersectionPoint(edges[i], ball_.direction_ray_);
+		show_trajectory_.store(!show_trajectory_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 
-		if (cross_point_opt.has_value())
+		// Paused replays and serial play publish no snapshot before the next frame; this one picks the change up.
+		if (!simulation_thread_.joinable())
 		{
-			found_crosses.emplace_back(cross_point_opt.value());
+			PublishSnapshot();
 		}
 	}
 
-	if (found_crosses.empty())
+	if (playback_)
 	{
-		assert(false);
+		HandlePlaybackInput(input);
 		return;
 	}
 
-	intersection_point_ = *std::min_element(found_crosses.begin(), found_crosses.end(), [this](SDL_FPoint p1, SDL_FPoint p2)
+	// Paddle keys normally reach the simulation through the input queue; see GamePlayState::Tick.
+	if (game_->GetOptions().legacy_input)
+	{
+		// A press starts the paddle and releasing either key stops it. The frame no longer says which came first, so
+		// a key pressed this frame and still down wins over a release.
+		const auto apply_keys = [&input](Paddle& paddle, InputAction up, InputAction down)
+		{
+			if (input.WasPressed(up))
+			{
+				paddle.vy_ = -Paddle::speed;
+			}
+
+			if (input.WasPressed(down))
+			{
+				paddle.vy_ = Paddle::speed;
+			}
+
+			if (input.WasReleased(up) || input.WasReleased(down))
+			{
+				paddle.vy_ = (input.WasPressed(up) && input.IsHeld(up)) ? -Paddle::speed : (input.WasPressed(down) && input.IsHeld(down)) ? Paddle::speed : 0;
+			}
+		};
+
+		apply_keys(simulation_.player1_paddle_, InputAction::PLAYER1_UP, InputAction::PLAYER1_DOWN);
+
+		if (game_->game_mode_ == GameMode::MULTI_PLAYER)
+		{
+			apply_keys(simulation_.player2_paddle_, InputAction::PLAYER2_UP, InputAction::PLAYER2_DOWN);
+		}
+	}
+
+	if (input.WasPressed(InputAction::BACK))
+	{
+		game_->PopState();
+	}
+}
+
+void GamePlayState::ApplyPaddleCommands()
+{
+	const bool legacy_input = game_->GetOptions().legacy_input;
+
+	PaddleCommand command;
+
+	while (Input::Instance()->TryPop(command))
+	{
+		// With legacy input HandleEvents has already moved the paddle; the command only times it.
+		if (!legacy_input)
 		{
-			return PointsDistance(p1.x, p1.y, intersection_point_.x, intersection_point_.y) > PointsDistance(p2.x, p2.y, intersection_point_.x, intersection_point_.y);
-		});
+			if (command.player_ == 1)
+			{
+				simulation_.player1_paddle_.vy_ = Scalar(command.direction_ * Paddle::speed);
+			}
+			else if (game_->game_mode_ == GameMode::MULTI_PLAYER)
+			{
+				simulation_.player2_paddle_.vy_ = Scalar(command.direction_ * Paddle::speed);
+			}
+		}
+
+		Input::Instance()->RecordApplied(command);
+	}
+}
+
+void GamePlayState::Tick()
+{
+	// The simulation thread keeps its own clock at the match's tick rate; the game loop only ticks the match when it runs serially.
+	if (simulation_thread_.joinable())
+	{
+		return;
+	}
+
+	if (playback_)
+	{
+		TickPlayback();
+		return;
+	}
 
+	TickSimulation();
+}
+
+void GamePlayState::HandlePlaybackInput(const InputFrame& input)
+{
+	const std::uint64_t seek_step_ticks = static_cast<std::uint64_t>(simulation_.ScaleTicks(seek_step_reference_ticks));
 
-	if (game_->game_difficulty_ != GameDifficulty::IMPOSSIBLE)
+	if (input.WasPressed(InputAction::BACK))
 	{
+		game_->Stop();
 		return;
 	}
 
-	constexpr float epsilon = 0.01f;
-	SDL_FPoint intersect_copy = intersection_point_;
-	Line reflected_line = ball_.direction_ray_;
-	SDL_FPoint reflected_vector = { intersection_point_.x - reflected_line.start_point.x, intersection_point_.y - reflected_line.start_point.y };
+	if (input.WasPressedOrRepeated(InputAction::PLAYBACK_PAUSE))
+	{
+		playback_paused_ = !playback_paused_;
+	}
+
+	if (input.WasPressedOrRepeated(InputAction::PLAYBACK_SPEED))
+	{
+		playback_speed_ = playback_speed_ == 1 ? fast_forward_speed : 1;
+	}
 
-	while (!FloatingPointSame(intersect_copy.x, 0.0f, epsilon) && !FloatingPointSame(intersect_copy.x, static_cast<float>(constants::screen_width), epsilon))
+	// Held arrows keep seeking at the key repeat rate.
+	if (input.WasPressedOrRepeated(InputAction::SEEK_FORWARD))
 	{
-		reflected_line.start_point = intersect_copy;
-		reflected_line.end_point = intersect_copy;
+		SeekPlayback(simulation_.tick_count_ + seek_step_ticks);
+	}
+
+	if (input.WasPressedOrRepeated(InputAction::SEEK_BACK))
+	{
+		SeekPlayback(simulation_.tick_count_ > seek_step_ticks ? simulation_.tick_count_ - seek_step_ticks : 0);
+	}
+
+	if (input.WasPressed(InputAction::SEEK_START))
+	{
+		SeekPlayback(0);
+	}
+}
+
+void GamePlayState::SeekPlayback(std::uint64_t tick)
+{
+	replay_reader_.Seek(simulation_, tick);
+	PublishSnapshot();
+}
 
-		reflected_vector.y = -reflected_vector.y;
+void GamePlayState::TickPlayback()
+{
+	TRACE_ZONE("GamePlayState::TickPlayback");
 
-		constexpr float multiplier = 0.005f;
+	if (playback_paused_)
+	{
+		return;
+	}
 
-		reflected_line.end_point.x = reflected_line.end_point.x + ((constants::screen_width + constants::screen_height) * reflected_vector.x);
-		reflected_line.end_point.y = reflected_line.end_point.y + ((constants::screen_width + constants::screen_height) * reflected_vector.y);
+	playback_tick_credit_ += replay_reader_.GetTickRate();
 
-		std::vector<SDL_FPoint> found_crosses;
+	const int tick_rate = game_->GetOptions().tick_rate;
+	const int steps = (playback_tick_credit_ / tick_rate) * playback_speed_;
+	playback_tick_credit_ %= tick_rate;
 
-		for (std::size_t i = 0; i < edges.size(); ++i)
+	for (int i = 0; i < steps; ++i)
+	{
+		if (!replay_reader_.Step(simulation_))
 		{
-			const std::optional<SDL_FPoint> cross_point_opt = GetLinesIntersectionPoint(edges[i], reflected_line);
+			playback_paused_ = true;
+			break;
+		}
 
-			if (cross_point_opt.has_value())
-			{
-				found_crosses.emplace_back(cross_point_opt.value());
-			}
-			else
-			{
-				continue;
-			}
+		checksums_.Record(simulation_);
+
+		// Sounds only play at normal speed; at 100x they would be noise.
+		if (playback_speed_ == 1)
+		{
+			PostSimulationEvents();
 		}
+	}
 
-		SDL_FPoint intersect = *std::min_element(found_crosses.begin(), found_crosses.end(), [this](SDL_FPoint p1, SDL_FPoint p2)
-			{
-				return PointsDistance(p1.x, p1.y, intersection_point_.x, intersection_point_.y) > PointsDistance(p2.x, p2.y, intersection_point_.x, intersection_point_.y);
-			});
+	PublishSnapshot();
+	tick_stats_.Record(SDL_GetPerformanceCounter());
+}
+
+void GamePlayState::PostSimulationEvents()
+{
+	for (std::size_t i = 0; i < simulation_.event_count_; ++i)
+	{
+		switch (simulation_.events_[i].type_)
+		{
+		case SimulationEventType::PADDLE_HIT:
+			Audio::Instance()->Post(Sound::PADDLE_HIT, simulation_.events_[i].angle_);
+			break;
+		case SimulationEventType::WALL_BOUNCE:
+			Audio::Instance()->Post(Sound::WALL_BOUNCE);
+			break;
+		case SimulationEventType::GOAL:
+			Audio::Instance()->Post(Sound::GOAL);
+			break;
+		case SimulationEventType::SERVE:
+			break;
+		}
+	}
+}
+
+void GamePlayState::TickSimulation()
+{
+	TRACE_ZONE("GamePlayState::TickSimulation");
 
-		intersect_copy = intersect;
+	// The config watcher publishes a new pointer per reload; picking it up here keeps every tick on one set of values.
+	const Tuning* tuning = Config::Instance()->GetTuning();
+
+	if (tuning != applied_tuning_)
+	{
+		simulation_.ApplyTuning(*tuning);
+		applied_tuning_ = tuning;
+
+		// Inputs alone cannot reproduce a tuning change, so the replay takes a full keyframe here.
+		replay_writer_.RequestKeyframe();
 	}
 
-	intersection_point_ = intersect_copy;
+	ApplyPaddleCommands();
+
+	replay_writer_.Record(simulation_);
+	simulation_.Tick();
+	rally_log_.Record(simulation_);
+	checksums_.Record(simulation_);
+
+	// Two seconds in, everything a match needs has been created; from here on no tick or frame should allocate.
+	if (++ticks_since_enter_ == steady_state_ticks_)
+	{
+		AllocationTracker::SetSteadyState(true);
+	}
+
+	PostSimulationEvents();
+
+	PublishSnapshot();
+	tick_stats_.Record(SDL_GetPerformanceCounter());
 }
 
-bool GamePlayState::IsPointOnLine(const SDL_FPoint point, const Line& line) const
+void GamePlayState::Render()
 {
-	constexpr float epsilon = 0.01;
+	TRACE_ZONE("GamePlayState::Render");
+
+	SDL_SetRenderDrawColor(game_->renderer_, 0x00, 0x00, 0x00, 0xFF);
+	SDL_RenderClear(game_->renderer_);
+
+	snapshots_.Update();
+	const SimulationSnapshot& snapshot = snapshots_.GetReadBuffer();
+
+	// Render allocations count against the steady state too, even when ticks happen on another thread.
+	if (ticks_since_enter_.load(std::memory_order_relaxed) >= steady_state_ticks_)
+	{
+		AllocationTracker::SetSteadyState(true);
+	}
+
+	DrawDividerRects();
 
-	const bool x_on_line = (FloatingPointLessThan(std::min(line.start_point.x, line.end_point.x), point.x, epsilon) || FloatingPointSame(std::min(line.start_point.x, line.end_point.x), point.x, epsilon)) && 
-							(FloatingPointLessThan(point.x, std::max(line.start_point.x, line.end_point.x), epsilon) || FloatingPointSame(point.x, std::max(line.start_point.x, line.end_point.x), epsilon));
+	DrawObstacles();
 
-	const bool y_on_line = (FloatingPointLessThan(std::min(line.start_point.y, line.end_point.y), point.y, epsilon) || FloatingPointSame(std::min(line.start_point.y, line.end_point.y), point.y, epsilon)) && 
-							(FloatingPointLessThan(point.y, std::max(line.start_point.y, line.end_point.y), epsilon) || FloatingPointSame(point.y, std::max(line.start_point.y, line.end_point.y), epsilon));
+	DrawRect(snapshot.ball_rect_);
 
-	return x_on_line && y_on_line;
+	DrawRect(snapshot.player1_paddle_rect_);
+	DrawRect(snapshot.player2_paddle_rect_);
+
+	SDL_SetRenderDrawColor(game_->renderer_, 0xD3, 0xD3, 0xD3, 0xFF);
+
+	constexpr int score_y_pos = 0;
+	constexpr int score_x_offset = 400;
+
+	RenderScore(snapshot.player1_score_, constants::screen_width - score_x_offset, score_y_pos);
+	RenderScore(snapshot.player2_score_, score_x_offset - GetScoreWidth(snapshot.player2_score_), score_y_pos);
+	
+	if (show_trajectory_.load(std::memory_order_relaxed))
+	{
+		DrawTrajectory(snapshot);
+	}
 }
@@ -0,0 +1,35 @@
+#include "Synth.hpp"
+
+#include <algorithm>
+
+std::size_t BlipFrameCount(const Blip& blip, int frequency)
+{
+	return static_cast<std::size_t>(frequency) * static_cast<std::size_t>(blip.duration_ms) / 1000;
+}
+
+void SynthesizeBlip(const Blip& blip, int frequency, int channels, Sint16* output)
+{
+	const std::size_t frame_count = BlipFrameCount(blip, frequency);
+	const std::size_t attack_frames = std::max<std::size_t>(1, static_cast<std::size_t>(frequency) * 2 / 1000);
+	const float amplitude = blip.volume * 32767.0f;
+
+	float phase = 0.0f;
+
+	for (std::size_t frame = 0; frame < frame_count; ++frame)
+	{
+		const float progress = static_cast<float>(frame) / static_cast<float>(frame_count);
+		const float hz = blip.start_hz + (blip.end_hz - blip.start_hz) * progress;
+
+		// A 2 ms ramp in and a fade to zero at the end keep the edges from clicking.
+		const float envelope = frame < attack_frames ? static_cast<float>(frame) / static_cast<float>(attack_frames) : 1.0f - progress;
+		const Sint16 sample = static_cast<Sint16>((phase < 0.5f ? amplitude : -amplitude) * envelope);
+
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			*output++ = sample;
+		}
+
+		phase += hz / static_cast<float>(frequency);
+		phase -= static_cast<float>(static_cast<int>(phase));
+	}
+}
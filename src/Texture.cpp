@@ -1,4 +1,5 @@
 #include "Texture.hpp"
+#include "Trace.hpp"
 
 #include <stdio.h>
 
@@ -28,6 +29,8 @@ void Texture::FreeTexture()
 
 bool Texture::LoadFromPath(SDL_Renderer* renderer, const char* path)
 {
+	TRACE_ZONE("Texture::LoadFromPath");
+
 	FreeTexture();
 
 	SDL_Texture* tmp_texture = nullptr;
@@ -61,6 +64,8 @@ bool Texture::LoadFromPath(SDL_Renderer* renderer, const char* path)
 
 bool Texture::LoadFromText(SDL_Renderer* renderer, TTF_Font* font, const char* text, const SDL_Color& text_color, int text_length)
 {
+	TRACE_ZONE("Texture::LoadFromText");
+
 	FreeTexture();
 
 	SDL_Surface* text_surface = text_length == -1 ? TTF_RenderText_Blended(font, text, text_color) : TTF_RenderText_Blended_Wrapped(font, text, text_color, text_length);
@@ -87,7 +92,13 @@ bool Texture::LoadFromText(SDL_Renderer* renderer, TTF_Font* font, const char* t
 	return true;
 }
 
-void Texture::Render(SDL_Renderer* renderer, int x, int y, SDL_Rect* clip, double scale)
+void Texture::SetColor(const SDL_Color& color)
+{
+	SDL_SetTextureColorMod(texture_, color.r, color.g, color.b);
+	SDL_SetTextureAlphaMod(texture_, color.a);
+}
+
+void Texture::Render(SDL_Renderer* renderer, int x, int y, const SDL_Rect* clip, double scale)
 {
 	SDL_FRect render_rect = { static_cast<float>(x), static_cast<float>(y), static_cast<float>(width_ * scale), static_cast<float>(height_ * scale) };
 
@@ -0,0 +1,61 @@
+#include "TickStats.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cmath>
+
+TickStats::TickStats()
+{
+	Reset();
+}
+
+void TickStats::Reset(int tick_rate)
+{
+	tick_period_ms_ = 1000.0 / static_cast<double>(tick_rate);
+	last_counter_ = 0;
+	intervals_ = 0;
+	total_ms_ = 0.0;
+	total_squared_ms_ = 0.0;
+	max_ms_ = 0.0;
+	late_ticks_ = 0;
+	burst_ticks_ = 0;
+}
+
+void TickStats::Record(std::uint64_t counter)
+{
+	if (last_counter_ != 0)
+	{
+		const double interval_ms = static_cast<double>(counter - last_counter_) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+		++intervals_;
+		total_ms_ += interval_ms;
+		total_squared_ms_ += interval_ms * interval_ms;
+		max_ms_ = std::max(max_ms_, interval_ms);
+
+		if (interval_ms > tick_period_ms_ * 1.5)
+		{
+			++late_ticks_;
+		}
+		else if (interval_ms < tick_period_ms_ * 0.5)
+		{
+			++burst_ticks_;
+		}
+	}
+
+	last_counter_ = counter;
+}
+
+void TickStats::PrintReport(FILE* file, const char* name) const
+{
+	if (intervals_ == 0)
+	{
+		return;
+	}
+
+	const double mean_ms = total_ms_ / static_cast<double>(intervals_);
+	const double deviation_ms = std::sqrt(std::max(0.0, total_squared_ms_ / static_cast<double>(intervals_) - mean_ms * mean_ms));
+
+	fprintf(file, "%s: %llu tick intervals, mean %.2f ms, std dev %.2f ms, max %.2f ms, %llu late, %llu in catch-up bursts\n", name,
+		static_cast<unsigned long long>(intervals_), mean_ms, deviation_ms, max_ms_, static_cast<unsigned long long>(late_ticks_), static_cast<unsigned long long>(burst_ticks_));
+}
@@ -0,0 +1,119 @@
+#include "Trace.hpp"
+
+#include <cstdio>
+
+std::unique_ptr<Trace> Trace::trace_ = std::make_unique<Trace>();
+std::atomic<bool> Trace::enabled_(false);
+
+namespace
+{
+	thread_local TraceBuffer* thread_buffer = nullptr;
+	thread_local const char* thread_name = nullptr;
+}
+
+Trace::Trace() : epoch_ns_(Now())
+{
+}
+
+Trace* Trace::Instance()
+{
+	return trace_.get();
+}
+
+void Trace::SetEnabled(bool enabled)
+{
+	enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+TraceBuffer* Trace::GetThreadBuffer()
+{
+	if (thread_buffer == nullptr)
+	{
+		// Once per thread; buffers outlive their threads so late flushes still see everything they recorded.
+		std::lock_guard<std::mutex> lock(buffers_mutex_);
+
+		buffers_.emplace_back(std::make_unique<TraceBuffer>());
+		thread_buffer = buffers_.back().get();
+		thread_buffer->thread_id = static_cast<std::uint32_t>(buffers_.size());
+		thread_buffer->thread_name = thread_name;
+		thread_buffer->dropped_events = 0;
+	}
+
+	return thread_buffer;
+}
+
+void Trace::Record(const char* name, std::uint64_t start_ns, std::uint64_t end_ns)
+{
+	TraceBuffer* buffer = GetThreadBuffer();
+
+	if (!buffer->events.TryPush({ name, start_ns, end_ns - start_ns }))
+	{
+		buffer->dropped_events.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void Trace::SetThreadName(const char* name)
+{
+	// Naming a thread that never traces should not cost it a buffer, so the name waits for the first zone.
+	thread_name = name;
+
+	if (thread_buffer != nullptr)
+	{
+		thread_buffer->thread_name.store(name, std::memory_order_relaxed);
+	}
+}
+
+bool Trace::Flush(const char* path)
+{
+	FILE* file = fopen(path, "w");
+
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Unable to open %s for the trace!\n", path);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(buffers_mutex_);
+
+	std::uint64_t written_events = 0;
+	std::uint64_t dropped_events = 0;
+	bool first = true;
+
+	fprintf(file, "%s", "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	for (const std::unique_ptr<TraceBuffer>& buffer : buffers_)
+	{
+		const char* name = buffer->thread_name.load(std::memory_order_relaxed);
+
+		if (name != nullptr)
+		{
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", buffer->thread_id, name);
+			first = false;
+		}
+
+		TraceEvent event;
+
+		while (buffer->events.TryPop(event))
+		{
+			// Zones opened before the trace epoch cannot happen, but clamp rather than print a huge unsigned value.
+			const std::uint64_t start_ns = event.start_ns > epoch_ns_ ? event.start_ns - epoch_ns_ : 0;
+
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}", first ? "" : ",\n", event.name, buffer->thread_id,
+				static_cast<unsigned long long>(start_ns / 1000), static_cast<unsigned long long>(start_ns % 1000),
+				static_cast<unsigned long long>(event.duration_ns / 1000), static_cast<unsigned long long>(event.duration_ns % 1000));
+			first = false;
+			++written_events;
+		}
+
+		dropped_events += buffer->dropped_events.exchange(0, std::memory_order_relaxed);
+	}
+
+	fprintf(file, "%s", "\n]}\n");
+
+	const bool written = ferror(file) == 0;
+	fclose(file);
+
+	fprintf(stderr, "Trace: %llu zones written to %s, %llu dropped\n", static_cast<unsigned long long>(written_events), path, static_cast<unsigned long long>(dropped_events));
+
+	return written;
+}
@@ -1,14 +1,146 @@
 #include "Game.hpp"
+#include "AllocationTracker.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 
 int main(int argc, char* argv[])
 {
-	(void) argc;
-	(void) argv;
+	const char* capture_path = nullptr;
+	GameOptions options;
+	bool alloc_check = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+		{
+			capture_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc)
+		{
+			options.frame_budget_ms = static_cast<float>(std::atof(argv[++i]));
+
+			if (options.frame_budget_ms < 0.0f)
+			{
+				fprintf(stderr, "%s\n", "--frame-budget must not be negative");
+				return 1;
+			}
+		}
+		else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			options.trace_path = argv[++i];
+			options.trace_at_startup = true;
+		}
+		else if (std::strcmp(argv[i], "--alloc-check") == 0)
+		{
+			alloc_check = true;
+		}
+		else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			options.replay_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--replay-dir") == 0 && i + 1 < argc)
+		{
+			options.replay_dir = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--no-replays") == 0)
+		{
+			options.replay_dir.clear();
+		}
+		else if (std::strcmp(argv[i], "--checksums") == 0 && i + 1 < argc)
+		{
+			options.checksum_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--rally-dir") == 0 && i + 1 < argc)
+		{
+			options.rally_dir = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--ai") == 0 && i + 1 < argc)
+		{
+			options.ai_plugin_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--arena") == 0 && i + 1 < argc)
+		{
+			options.arena_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--ai-budget") == 0 && i + 1 < argc)
+		{
+			options.ai_budget_us = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--spectator") == 0 && i + 1 < argc)
+		{
+			options.spectator_address = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+		{
+			options.tick_rate = std::clamp(std::atoi(argv[++i]), 1, 1000);
+		}
+		else if (std::strcmp(argv[i], "--substeps") == 0 && i + 1 < argc)
+		{
+			options.physics_substeps = std::clamp(std::atoi(argv[++i]), 1, 64);
+		}
+		else if (std::strcmp(argv[i], "--single-thread") == 0)
+		{
+			options.simulation_thread = false;
+		}
+		else if (std::strcmp(argv[i], "--legacy-input") == 0)
+		{
+			options.legacy_input = true;
+		}
+		else if (std::strcmp(argv[i], "--render-stall") == 0 && i + 1 < argc)
+		{
+			options.render_stall_ms = std::atoi(argv[++i]);
+
+			if (options.render_stall_ms < 0)
+			{
+				fprintf(stderr, "%s\n", "--render-stall must not be negative");
+				return 1;
+			}
+		}
+		else if (std::strcmp(argv[i], "--telemetry") == 0)
+		{
+			options.telemetry = true;
+		}
+		else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc)
+		{
+			options.config_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--audio-buffer") == 0 && i + 1 < argc)
+		{
+			options.audio_buffer_size = std::atoi(argv[++i]);
+
+			if (options.audio_buffer_size < 64 || options.audio_buffer_size > 8192)
+			{
+				fprintf(stderr, "%s\n", "--audio-buffer must be between 64 and 8192 samples");
+				return 1;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--capture PATH|-] [--audio-buffer SAMPLES] [--config PATH] [--frame-budget MS] [--telemetry] [--trace PATH] [--alloc-check] [--replay PATH] [--replay-dir DIR] [--no-replays] [--rally-dir DIR] [--checksums PATH] [--ai PLUGIN] [--ai-budget US] [--arena PATH] [--spectator unix:PATH|[HOST:]PORT] [--tick-rate HZ] [--substeps N] [--single-thread] [--legacy-input] [--render-stall MS]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::unique_ptr<Game> game = std::make_unique<Game>(options);
+
+	if (capture_path != nullptr && !game->StartFrameCapture(capture_path))
+	{
+		return 1;
+	}
 
-	const std::unique_ptr<Game> game = std::make_unique<Game>();
 	game->Run();
+	game.reset();
+
+	// Needs an ALLOC_TRACKING=1 build; the report printed while the game shut down lists the offending call sites.
+	if (alloc_check && AllocationTracker::GetSteadyStateAllocations() != 0)
+	{
+		fprintf(stderr, "Steady-state gameplay allocated %llu times.\n", static_cast<unsigned long long>(AllocationTracker::GetSteadyStateAllocations()));
+		return 1;
+	}
 
 	return 0;
 }
@@ -0,0 +1,397 @@
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Packs the images and fixed UI strings of a manifest into one atlas PNG, and writes a header of constexpr sprite
+// rects into it. Text is rendered white, so the game tints one copy of a label for every state it is drawn in.
+// Usage: atlas_packer MANIFEST ATLAS_PNG HEADER. `make` runs it whenever the manifest or anything it lists changes.
+//
+// Manifest lines, with # starting a comment:
+//   font PATH                  the font of the text and glyphs lines that follow
+//   image NAME PATH            an image; magenta (FF00FF) pixels become transparent, as with Texture::LoadFromPath
+//   text NAME SIZE TEXT...     a label at SIZE points
+//   glyphs NAME SIZE CHARS     one sprite per character, as the array NAME
+
+namespace
+{
+	// Empty pixels around every sprite, so scaled or filtered draws never pick up a neighbour.
+	constexpr int padding = 2;
+	constexpr int min_atlas_width = 1024;
+
+	struct Sprite
+	{
+		std::string name_;
+
+		// Position in a glyphs array; -1 for a sprite of its own.
+		int index_;
+		SDL_Surface* surface_;
+		SDL_Rect rect_;
+	};
+
+	int NextPowerOfTwo(int value)
+	{
+		int power = 1;
+
+		while (power < value)
+		{
+			power *= 2;
+		}
+
+		return power;
+	}
+
+	std::string Trim(const std::string& text)
+	{
+		const std::size_t first = text.find_first_not_of(" \t\r");
+
+		if (first == std::string::npos)
+		{
+			return std::string();
+		}
+
+		return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+	}
+
+	// Every sprite goes into the atlas as 32-bit RGBA, with the colour key turned into alpha.
+	SDL_Surface* ToRgba(SDL_Surface* surface)
+	{
+		if (surface == nullptr)
+		{
+			return nullptr;
+		}
+
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(surface);
+
+		return converted;
+	}
+
+	class Packer
+	{
+	private:
+		std::vector<Sprite> sprites_;
+		std::map<int, TTF_Font*> fonts_;
+		std::string font_path_;
+
+		TTF_Font* GetFont(int size)
+		{
+			TTF_Font*& font = fonts_[size];
+
+			if (font == nullptr)
+			{
+				font = TTF_OpenFont(font_path_.c_str(), size);
+			}
+
+			return font;
+		}
+
+		bool AddText(const std::string& name, int index, int size, const std::string& text)
+		{
+			TTF_Font* font = GetFont(size);
+
+			if (font == nullptr)
+			{
+				printf("Unable to open font %s! SDL_ttf Error: %s\n", font_path_.c_str(), TTF_GetError());
+				return false;
+			}
+
+			const SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+			SDL_Surface* surface = ToRgba(TTF_RenderText_Blended(font, text.c_str(), white));
+
+			if (surface == nullptr)
+			{
+				printf("Unable to render \"%s\"! SDL_ttf Error: %s\n", text.c_str(), TTF_GetError());
+				return false;
+			}
+
+			sprites_.push_back({ name, index, surface, { 0, 0, surface->w, surface->h } });
+			return true;
+		}
+
+		bool AddImage(const std::string& name, const std::string& path)
+		{
+			SDL_Surface* loaded_surface = IMG_Load(path.c_str());
+
+			if (loaded_surface == nullptr)
+			{
+				printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+				return false;
+			}
+
+			SDL_SetColorKey(loaded_surface, SDL_TRUE, SDL_MapRGB(loaded_surface->format, 0xFF, 0x00, 0xFF));
+			SDL_Surface* surface = ToRgba(loaded_surface);
+
+			if (surface == nullptr)
+			{
+				printf("Unable to convert image %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+				return false;
+			}
+
+			sprites_.push_back({ name, -1, surface, { 0, 0, surface->w, surface->h } });
+			return true;
+		}
+
+	public:
+		~Packer()
+		{
+			for (Sprite& sprite : sprites_)
+			{
+				SDL_FreeSurface(sprite.surface_);
+			}
+
+			for (auto& [size, font] : fonts_)
+			{
+				if (font != nullptr)
+				{
+					TTF_CloseFont(font);
+				}
+			}
+		}
+
+		bool ReadManifest(const char* path)
+		{
+			std::ifstream file(path);
+
+			if (!file)
+			{
+				printf("Unable to open manifest %s!\n", path);
+				return false;
+			}
+
+			std::string line;
+			int line_number = 0;
+
+			while (std::getline(file, line))
+			{
+				++line_number;
+
+				line = Trim(line.substr(0, line.find('#')));
+
+				if (line.empty())
+				{
+					continue;
+				}
+
+				std::istringstream fields(line);
+				std::string kind;
+				std::string name;
+				fields >> kind >> name;
+
+				if (kind == "font")
+				{
+					font_path_ = name;
+					continue;
+				}
+
+				bool added = false;
+
+				if (kind == "image")
+				{
+					std::string image_path;
+					fields >> image_path;
+					added = !fields.fail() && AddImage(name, image_path);
+				}
+				else if (kind == "text" || kind == "glyphs")
+				{
+					int size = 0;
+					std::string text;
+					fields >> size;
+					std::getline(fields, text);
+					text = Trim(text);
+
+					if (!fields.fail() && size > 0 && !text.empty())
+					{
+						added = true;
+
+						if (kind == "text")
+						{
+							added = AddText(name, -1, size, text);
+						}
+
+						for (std::size_t i = 0; kind == "glyphs" && i < text.size() && added; ++i)
+						{
+							added = AddText(name, static_cast<int>(i), size, std::string(1, text[i]));
+						}
+					}
+				}
+
+				if (!added)
+				{
+					printf("%s:%d: unable to add \"%s\"\n", path, line_number, line.c_str());
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Shelves, tallest sprites first: plenty for a few dozen sprites and the same layout from the same manifest.
+		void Pack(int& width, int& height)
+		{
+			std::vector<Sprite*> order;
+
+			width = min_atlas_width;
+
+			for (Sprite& sprite : sprites_)
+			{
+				order.push_back(&sprite);
+				width = std::max(width, NextPowerOfTwo(sprite.rect_.w + (2 * padding)));
+			}
+
+			std::stable_sort(order.begin(), order.end(), [](const Sprite* a, const Sprite* b) { return a->rect_.h > b->rect_.h; });
+
+			int x = 0;
+			int shelf_y = 0;
+			int shelf_height = 0;
+
+			for (Sprite* sprite : order)
+			{
+				const int w = sprite->rect_.w + (2 * padding);
+				const int h = sprite->rect_.h + (2 * padding);
+
+				if (x + w > width)
+				{
+					shelf_y += shelf_height;
+					x = 0;
+					shelf_height = 0;
+				}
+
+				sprite->rect_.x = x + padding;
+				sprite->rect_.y = shelf_y + padding;
+
+				x += w;
+				shelf_height = std::max(shelf_height, h);
+			}
+
+			height = NextPowerOfTwo(shelf_y + shelf_height);
+		}
+
+		bool WriteAtlas(const char* path, int width, int height)
+		{
+			SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+
+			if (atlas == nullptr)
+			{
+				printf("Unable to create the atlas surface! SDL Error: %s\n", SDL_GetError());
+				return false;
+			}
+
+			SDL_FillRect(atlas, nullptr, 0);
+
+			for (Sprite& sprite : sprites_)
+			{
+				// Copied as is, alpha included, instead of blended onto the empty atlas.
+				SDL_SetSurfaceBlendMode(sprite.surface_, SDL_BLENDMODE_NONE);
+				SDL_Rect destination = sprite.rect_;
+				SDL_BlitSurface(sprite.surface_, nullptr, atlas, &destination);
+			}
+
+			const bool saved = IMG_SavePNG(atlas, path) == 0;
+
+			if (!saved)
+			{
+				printf("Unable to save %s! SDL_image Error: %s\n", path, IMG_GetError());
+			}
+
+			SDL_FreeSurface(atlas);
+			return saved;
+		}
+
+		bool WriteHeader(const char* path, const char* manifest_path, const char* atlas_path, int width, int height)
+		{
+			FILE* file = fopen(path, "w");
+
+			if (file == nullptr)
+			{
+				printf("Unable to open %s for writing!\n", path);
+				return false;
+			}
+
+			fprintf(file, "// Generated by tools/AtlasPacker.cpp from %s; do not edit.\n", manifest_path);
+			fprintf(file, "#ifndef ATLAS_SPRITES_HPP\n#define ATLAS_SPRITES_HPP\n\n#include <SDL.h>\n\nnamespace atlas\n{\n");
+			fprintf(file, "\tinline constexpr char path[] = \"%s\";\n", atlas_path);
+			fprintf(file, "\tinline constexpr int width = %d;\n", width);
+			fprintf(file, "\tinline constexpr int height = %d;\n\n", height);
+
+			for (std::size_t i = 0; i < sprites_.size(); ++i)
+			{
+				const Sprite& sprite = sprites_[i];
+				const SDL_Rect& rect = sprite.rect_;
+
+				if (sprite.index_ < 0)
+				{
+					fprintf(file, "\tinline constexpr SDL_Rect %s = { %d, %d, %d, %d };\n", sprite.name_.c_str(), rect.x, rect.y, rect.w, rect.h);
+					continue;
+				}
+
+				// Glyphs of one line are added one after another, so an array runs until the next sprite with index 0 or -1.
+				if (sprite.index_ == 0)
+				{
+					fprintf(file, "\tinline constexpr SDL_Rect %s[] =\n\t{\n", sprite.name_.c_str());
+				}
+
+				fprintf(file, "\t\t{ %d, %d, %d, %d },\n", rect.x, rect.y, rect.w, rect.h);
+
+				if (i + 1 == sprites_.size() || sprites_[i + 1].index_ <= 0)
+				{
+					fprintf(file, "\t};\n");
+				}
+			}
+
+			fprintf(file, "}\n\n#endif\n");
+
+			const bool written = ferror(file) == 0;
+			fclose(file);
+
+			return written;
+		}
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 4)
+	{
+		printf("Usage: %s MANIFEST ATLAS_PNG HEADER\n", argv[0]);
+		return 1;
+	}
+
+	if (SDL_Init(0) < 0 || !(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) || TTF_Init() == -1)
+	{
+		printf("Unable to initialize SDL! SDL Error: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	int width = 0;
+	int height = 0;
+	bool packed = false;
+
+	{
+		Packer packer;
+
+		if (packer.ReadManifest(argv[1]))
+		{
+			packer.Pack(width, height);
+			packed = packer.WriteAtlas(argv[2], width, height) && packer.WriteHeader(argv[3], argv[1], argv[2], width, height);
+		}
+	}
+
+	TTF_Quit();
+	IMG_Quit();
+	SDL_Quit();
+
+	if (packed)
+	{
+		printf("Packed %s into %s (%dx%d) and %s\n", argv[1], argv[2], width, height, argv[3]);
+	}
+
+	return packed ? 0 : 1;
+}
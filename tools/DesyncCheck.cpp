@@ -0,0 +1,268 @@
+#include "StateChecksums.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Compares two checksum files saved with --checksums (or by bench_output --checksums) and finds the first tick their
+// simulations differ at, by bisecting over the chained checksums both hold. Then prints both states of that tick
+// field by field, marking the fields that differ.
+// Usage: desync_check A B. Exits with 0 when the streams agree, 1 when they diverge and 2 on errors.
+
+namespace
+{
+	struct ChecksumFile
+	{
+		std::string path;
+		std::vector<unsigned char> data;
+		ChecksumHeader header;
+
+		const ChecksumEntry& GetEntry(std::uint64_t tick) const
+		{
+			return reinterpret_cast<const ChecksumEntry*>(data.data() + sizeof(ChecksumHeader))[tick - header.first_tick];
+		}
+
+		SimulationState GetState(std::uint64_t tick) const
+		{
+			SimulationState state;
+			const std::size_t offset = sizeof(ChecksumHeader) + (sizeof(ChecksumEntry) * header.count) + (sizeof(SimulationState) * (tick - header.first_tick));
+			std::memcpy(static_cast<void*>(&state), data.data() + offset, sizeof(state));
+			return state;
+		}
+
+		std::uint64_t GetLastTick() const
+		{
+			return header.first_tick + header.count - 1;
+		}
+	};
+
+	bool Load(const char* path, ChecksumFile& file)
+	{
+		FILE* handle = fopen(path, "rb");
+
+		if (handle == nullptr)
+		{
+			printf("Unable to open %s!\n", path);
+			return false;
+		}
+
+		file.path = path;
+		file.data.clear();
+
+		unsigned char buffer[1 << 16];
+		std::size_t read;
+
+		while ((read = fread(buffer, 1, sizeof(buffer), handle)) > 0)
+		{
+			file.data.insert(file.data.end(), buffer, buffer + read);
+		}
+
+		fclose(handle);
+
+		if (file.data.size() < sizeof(ChecksumHeader))
+		{
+			printf("Unable to read %s: it is too short!\n", path);
+			return false;
+		}
+
+		std::memcpy(&file.header, file.data.data(), sizeof(file.header));
+
+		if (std::memcmp(file.header.magic, "PSUM", 4) != 0 || file.header.version != 1 || file.header.count == 0)
+		{
+			printf("Unable to read %s: it is not a checksum file of this version!\n", path);
+			return false;
+		}
+
+		const std::uint64_t entries_size = sizeof(ChecksumEntry) * file.header.count;
+		const std::uint64_t states_size = static_cast<std::uint64_t>(file.header.state_size) * file.header.count;
+
+		if (file.data.size() - sizeof(ChecksumHeader) < entries_size + states_size)
+		{
+			printf("Unable to read %s: it is cut short!\n", path);
+			return false;
+		}
+
+		return true;
+	}
+
+	void PrintRow(const char* name, const std::string& a, const std::string& b)
+	{
+		printf("%c %-28s %-32s %s\n", a == b ? ' ' : '*', name, a.c_str(), b.c_str());
+	}
+
+	std::string FormatScalar(Scalar value)
+	{
+		char text[64];
+
+#if PONG_FIXED_POINT
+		std::snprintf(text, sizeof(text), "%.6f (%" PRId64 ")", static_cast<double>(value), static_cast<std::int64_t>(value.raw_));
+#else
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		std::snprintf(text, sizeof(text), "%.9g (0x%08" PRIx32 ")", static_cast<double>(value), bits);
+#endif
+
+		return text;
+	}
+
+	std::string FormatFloat(float value)
+	{
+		char text[32];
+		std::snprintf(text, sizeof(text), "%.9g", static_cast<double>(value));
+		return text;
+	}
+
+	std::string FormatInteger(std::uint64_t value)
+	{
+		return std::to_string(value);
+	}
+
+	void PrintScalar(const char* name, Scalar a, Scalar b)
+	{
+		PrintRow(name, FormatScalar(a), FormatScalar(b));
+	}
+
+	void PrintInteger(const char* name, std::uint64_t a, std::uint64_t b)
+	{
+		PrintRow(name, FormatInteger(a), FormatInteger(b));
+	}
+
+	void PrintRect(const char* name, const Rect& a, const Rect& b)
+	{
+		const std::string prefix = name;
+
+		PrintScalar((prefix + ".x").c_str(), a.x, b.x);
+		PrintScalar((prefix + ".y").c_str(), a.y, b.y);
+		PrintScalar((prefix + ".w").c_str(), a.w, b.w);
+		PrintScalar((prefix + ".h").c_str(), a.h, b.h);
+	}
+
+	void PrintVec2(const char* name, const Vec2& a, const Vec2& b)
+	{
+		const std::string prefix = name;
+
+		PrintScalar((prefix + ".x").c_str(), a.x, b.x);
+		PrintScalar((prefix + ".y").c_str(), a.y, b.y);
+	}
+
+	void PrintStates(const SimulationState& a, const SimulationState& b)
+	{
+		PrintInteger("tick_count_", a.tick_count_, b.tick_count_);
+		PrintRect("ball_rect_", a.ball_rect_, b.ball_rect_);
+		PrintScalar("ball_vx_", a.ball_vx_, b.ball_vx_);
+		PrintScalar("ball_vy_", a.ball_vy_, b.ball_vy_);
+		PrintVec2("ball_direction_ray_.start", a.ball_direction_ray_.start_point, b.ball_direction_ray_.start_point);
+		PrintVec2("ball_direction_ray_.end", a.ball_direction_ray_.end_point, b.ball_direction_ray_.end_point);
+		PrintRect("player1_paddle_rect_", a.player1_paddle_rect_, b.player1_paddle_rect_);
+		PrintScalar("player1_paddle_vy_", a.player1_paddle_vy_, b.player1_paddle_vy_);
+		PrintRect("player2_paddle_rect_", a.player2_paddle_rect_, b.player2_paddle_rect_);
+		PrintScalar("player2_paddle_vy_", a.player2_paddle_vy_, b.player2_paddle_vy_);
+		PrintInteger("player1_score_", static_cast<std::uint64_t>(a.player1_score_), static_cast<std::uint64_t>(b.player1_score_));
+		PrintInteger("player2_score_", static_cast<std::uint64_t>(a.player2_score_), static_cast<std::uint64_t>(b.player2_score_));
+		PrintInteger("ball_resetting_", static_cast<std::uint64_t>(a.ball_resetting_), static_cast<std::uint64_t>(b.ball_resetting_));
+		PrintInteger("ball_reset_ticks_", static_cast<std::uint64_t>(a.ball_reset_ticks_), static_cast<std::uint64_t>(b.ball_reset_ticks_));
+		PrintVec2("intersection_point_", a.intersection_point_, b.intersection_point_);
+		PrintVec2("ball_edge_crossing_", a.ball_edge_crossing_, b.ball_edge_crossing_);
+		PrintInteger("has_ball_edge_crossing_", static_cast<std::uint64_t>(a.has_ball_edge_crossing_), static_cast<std::uint64_t>(b.has_ball_edge_crossing_));
+		PrintInteger("random_state_", a.random_state_, b.random_state_);
+		PrintInteger("random_increment_", a.random_increment_, b.random_increment_);
+		PrintInteger("tuning_.paddle_width", static_cast<std::uint64_t>(a.tuning_.paddle_width), static_cast<std::uint64_t>(b.tuning_.paddle_width));
+		PrintInteger("tuning_.paddle_height", static_cast<std::uint64_t>(a.tuning_.paddle_height), static_cast<std::uint64_t>(b.tuning_.paddle_height));
+		PrintRow("tuning_.speed_multiple", FormatFloat(a.tuning_.speed_multiple), FormatFloat(b.tuning_.speed_multiple));
+		PrintRow("tuning_.initial_speed", FormatFloat(a.tuning_.initial_speed), FormatFloat(b.tuning_.initial_speed));
+	}
+
+	void PrintDivergence(const ChecksumFile& a, const ChecksumFile& b, std::uint64_t tick)
+	{
+		printf("State hashes at tick %llu: %016llx and %016llx\n\n", static_cast<unsigned long long>(tick),
+			static_cast<unsigned long long>(a.GetEntry(tick).state_hash), static_cast<unsigned long long>(b.GetEntry(tick).state_hash));
+
+		// States of another physics build have another layout; the chains still compare, the fields do not.
+		if (a.header.fixed_point != PONG_FIXED_POINT || b.header.fixed_point != PONG_FIXED_POINT || a.header.state_size != sizeof(SimulationState) ||
+			b.header.state_size != sizeof(SimulationState))
+		{
+			printf("%s\n", "The states were saved by a build with other physics; rebuild desync_check with its FIXED_POINT to see them.");
+			return;
+		}
+
+		printf("  %-28s %-32s %s\n", "field", a.path.c_str(), b.path.c_str());
+		PrintStates(a.GetState(tick), b.GetState(tick));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: %s A B\n", argv[0]);
+		return 2;
+	}
+
+	ChecksumFile a;
+	ChecksumFile b;
+
+	if (!Load(argv[1], a) || !Load(argv[2], b))
+	{
+		return 2;
+	}
+
+	if (a.header.seed != b.header.seed || a.header.game_mode != b.header.game_mode || a.header.game_difficulty != b.header.game_difficulty ||
+		a.header.tick_rate != b.header.tick_rate || a.header.physics_substeps != b.header.physics_substeps || a.header.arena_hash != b.header.arena_hash)
+	{
+		printf("%s\n", "Warning: the streams are of matches with different seeds, modes, rates or arenas.");
+	}
+
+	const std::uint64_t first = std::max(a.header.first_tick, b.header.first_tick);
+	const std::uint64_t last = std::min(a.GetLastTick(), b.GetLastTick());
+
+	if (first > last)
+	{
+		printf("The streams share no ticks: %s holds %llu to %llu, %s holds %llu to %llu.\n", a.path.c_str(), static_cast<unsigned long long>(a.header.first_tick),
+			static_cast<unsigned long long>(a.GetLastTick()), b.path.c_str(), static_cast<unsigned long long>(b.header.first_tick), static_cast<unsigned long long>(b.GetLastTick()));
+		return 2;
+	}
+
+	if (a.GetEntry(first).chain != b.GetEntry(first).chain)
+	{
+		printf("The streams diverge at or before tick %llu, the first tick both hold.\n", static_cast<unsigned long long>(first));
+		PrintDivergence(a, b, first);
+		return 1;
+	}
+
+	if (a.GetEntry(last).chain == b.GetEntry(last).chain)
+	{
+		printf("The streams agree on all %llu ticks from %llu to %llu.\n", static_cast<unsigned long long>(last - first + 1),
+			static_cast<unsigned long long>(first), static_cast<unsigned long long>(last));
+		return 0;
+	}
+
+	// The chains agree at low and differ at high; halve the gap until they are neighbours.
+	std::uint64_t low = first;
+	std::uint64_t high = last;
+	int steps = 0;
+
+	while (high - low > 1)
+	{
+		const std::uint64_t middle = low + ((high - low) / 2);
+
+		if (a.GetEntry(middle).chain == b.GetEntry(middle).chain)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+
+		++steps;
+	}
+
+	printf("The streams agree up to tick %llu and diverge at tick %llu (%d bisection steps over %llu ticks).\n", static_cast<unsigned long long>(low),
+		static_cast<unsigned long long>(high), steps, static_cast<unsigned long long>(last - first + 1));
+	PrintDivergence(a, b, high);
+
+	return 1;
+}
@@ -0,0 +1,257 @@
+#include "RallyLog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Aggregates rally logs written with --rally-dir (or by bench_output --rally-log) into balancing statistics.
+// Usage: rally_stats LOG...
+// Every aggregate is a histogram or a sum filled in one pass over the columns it needs, so memory stays constant and
+// the columns a statistic does not use are never touched.
+
+namespace
+{
+	constexpr std::size_t position_bins = 10;
+
+	// Histogram of small non-negative integers, with everything from the last bin on counted in it.
+	class Histogram
+	{
+	private:
+		std::vector<std::uint64_t> bins_;
+		std::uint64_t count_;
+		double sum_;
+		std::uint64_t max_;
+
+	public:
+		explicit Histogram(std::size_t bins) : bins_(bins, 0), count_(0), sum_(0.0), max_(0)
+		{
+		}
+
+		void Add(std::uint64_t value)
+		{
+			++bins_[std::min<std::uint64_t>(value, bins_.size() - 1)];
+			++count_;
+			sum_ += static_cast<double>(value);
+			max_ = std::max(max_, value);
+		}
+
+		std::uint64_t GetCount() const
+		{
+			return count_;
+		}
+
+		double GetMean() const
+		{
+			return count_ > 0 ? sum_ / static_cast<double>(count_) : 0.0;
+		}
+
+		std::uint64_t GetMax() const
+		{
+			return max_;
+		}
+
+		// The smallest value at least fraction of the values are at or below.
+		std::uint64_t GetPercentile(double fraction) const
+		{
+			const std::uint64_t target = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count_)));
+			std::uint64_t seen = 0;
+
+			for (std::size_t i = 0; i < bins_.size(); ++i)
+			{
+				seen += bins_[i];
+
+				if (seen >= target && seen > 0)
+				{
+					return i;
+				}
+			}
+
+			return bins_.size() - 1;
+		}
+	};
+
+	struct Stats
+	{
+		std::uint64_t files = 0;
+		std::uint64_t bytes = 0;
+
+		Histogram rally_hits{ 1024 };
+		double rally_seconds = 0.0;
+		std::array<std::uint64_t, 3> goals = {};
+		std::array<double, 3> max_speed_sum = {};
+
+		std::uint64_t hits = 0;
+		std::array<std::uint64_t, 3> player_hits = {};
+		std::array<std::array<std::uint64_t, position_bins>, 3> positions = {};
+		double speed_sum = 0.0;
+		float max_speed = 0.0f;
+
+		// Absolute AI error in whole pixels, where the AI returned the ball and where it let it through.
+		Histogram ai_return_error{ 1024 };
+		Histogram ai_miss_error{ 1024 };
+		double ai_return_signed_sum = 0.0;
+	};
+
+	void AddHits(Stats& stats, const RallyLogBlock& block)
+	{
+		const float* position = block.GetFloat(rally_log::hit_position);
+		const float* speed = block.GetFloat(rally_log::hit_speed);
+		const float* ai_error = block.GetFloat(rally_log::hit_ai_error);
+		const std::uint8_t* player = block.GetUint8(rally_log::hit_player);
+
+		double speed_sum = 0.0;
+		float max_speed = stats.max_speed;
+
+		for (std::uint32_t i = 0; i < block.rows_; ++i)
+		{
+			speed_sum += speed[i];
+			max_speed = std::max(max_speed, speed[i]);
+		}
+
+		stats.speed_sum += speed_sum;
+		stats.max_speed = max_speed;
+		stats.hits += block.rows_;
+
+		for (std::uint32_t i = 0; i < block.rows_; ++i)
+		{
+			const std::size_t p = std::min<std::size_t>(player[i], 2);
+			const std::size_t bin = std::min(static_cast<std::size_t>(std::clamp(position[i], 0.0f, 1.0f) * position_bins), position_bins - 1);
+
+			++stats.player_hits[p];
+			++stats.positions[p][bin];
+		}
+
+		for (std::uint32_t i = 0; i < block.rows_; ++i)
+		{
+			if (!std::isnan(ai_error[i]))
+			{
+				stats.ai_return_error.Add(static_cast<std::uint64_t>(std::fabs(ai_error[i])));
+				stats.ai_return_signed_sum += ai_error[i];
+			}
+		}
+	}
+
+	void AddRallies(Stats& stats, const RallyLogBlock& block, std::uint32_t tick_rate)
+	{
+		const std::uint32_t* hits = block.GetUint32(rally_log::rally_hits);
+		const std::uint32_t* ticks = block.GetUint32(rally_log::rally_ticks);
+		const float* max_speed = block.GetFloat(rally_log::rally_max_speed);
+		const float* ai_error = block.GetFloat(rally_log::rally_ai_error);
+		const std::uint8_t* scorer = block.GetUint8(rally_log::rally_scorer);
+
+		std::uint64_t tick_sum = 0;
+
+		for (std::uint32_t i = 0; i < block.rows_; ++i)
+		{
+			stats.rally_hits.Add(hits[i]);
+			tick_sum += ticks[i];
+		}
+
+		stats.rally_seconds += static_cast<double>(tick_sum) / static_cast<double>(std::max<std::uint32_t>(tick_rate, 1));
+
+		for (std::uint32_t i = 0; i < block.rows_; ++i)
+		{
+			const std::size_t s = std::min<std::size_t>(scorer[i], 2);
+
+			++stats.goals[s];
+			stats.max_speed_sum[s] += max_speed[i];
+
+			if (!std::isnan(ai_error[i]))
+			{
+				stats.ai_miss_error.Add(static_cast<std::uint64_t>(std::fabs(ai_error[i])));
+			}
+		}
+	}
+
+	double Share(std::uint64_t part, std::uint64_t whole)
+	{
+		return whole > 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+	}
+
+	void PrintHistogram(const char* name, const Histogram& histogram)
+	{
+		printf("%-24s %12llu %10.2f %8llu %8llu %8llu %8llu\n", name, static_cast<unsigned long long>(histogram.GetCount()), histogram.GetMean(),
+			static_cast<unsigned long long>(histogram.GetPercentile(0.5)), static_cast<unsigned long long>(histogram.GetPercentile(0.9)),
+			static_cast<unsigned long long>(histogram.GetPercentile(0.99)), static_cast<unsigned long long>(histogram.GetMax()));
+	}
+
+	void Print(const Stats& stats, double elapsed_s)
+	{
+		const std::uint64_t rallies = stats.rally_hits.GetCount();
+
+		printf("%llu rallies and %llu hits from %llu files (%.1f MB) in %.1f ms\n\n", static_cast<unsigned long long>(rallies), static_cast<unsigned long long>(stats.hits),
+			static_cast<unsigned long long>(stats.files), static_cast<double>(stats.bytes) / 1e6, elapsed_s * 1e3);
+
+		printf("%-24s %12s %10s %8s %8s %8s %8s\n", "", "count", "mean", "p50", "p90", "p99", "max");
+		PrintHistogram("rally length (hits)", stats.rally_hits);
+		PrintHistogram("AI return error (px)", stats.ai_return_error);
+		PrintHistogram("AI miss error (px)", stats.ai_miss_error);
+
+		printf("\nmean rally duration      %.2f s\n", rallies > 0 ? stats.rally_seconds / static_cast<double>(rallies) : 0.0);
+		printf("mean signed return error %.2f px (positive: below the aim)\n", stats.ai_return_error.GetCount() > 0 ? stats.ai_return_signed_sum / static_cast<double>(stats.ai_return_error.GetCount()) : 0.0);
+		printf("ball speed at hits       mean %.2f, max %.2f px per 1/60 s\n\n", stats.hits > 0 ? stats.speed_sum / static_cast<double>(stats.hits) : 0.0, stats.max_speed);
+
+		for (std::size_t player = 1; player <= 2; ++player)
+		{
+			printf("player %zu: %5.1f%% of goals (mean top speed %.2f), %5.1f%% of hits, hit positions top to bottom:", player, Share(stats.goals[player], rallies),
+				stats.goals[player] > 0 ? stats.max_speed_sum[player] / static_cast<double>(stats.goals[player]) : 0.0, Share(stats.player_hits[player], stats.hits));
+
+			for (std::size_t bin = 0; bin < position_bins; ++bin)
+			{
+				printf(" %4.1f", Share(stats.positions[player][bin], stats.player_hits[player]));
+			}
+
+			printf("%s\n", "");
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s LOG...\n", argv[0]);
+		return 1;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	Stats stats;
+	RallyLogReader reader;
+	RallyLogBlock block;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!reader.Open(argv[i]))
+		{
+			return 1;
+		}
+
+		++stats.files;
+		stats.bytes += sizeof(RallyLogHeader);
+
+		while (reader.Next(block))
+		{
+			stats.bytes += rally_log::GetBlockSize(block.rows_);
+
+			if (block.table_ == RallyLogTable::HITS)
+			{
+				AddHits(stats, block);
+			}
+			else
+			{
+				AddRallies(stats, block, reader.GetHeader().tick_rate);
+			}
+		}
+
+		reader.Close();
+	}
+
+	Print(stats, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+	return 0;
+}